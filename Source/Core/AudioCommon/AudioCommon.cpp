@@ -180,4 +180,17 @@ namespace AudioCommon
 
 		soundStream->Update();
 	}
+
+	void SendStreamingBuffer(short *samples, unsigned int num_samples)
+	{
+		if (!soundStream)
+			return;
+
+		CMixer* pMixer = soundStream->GetMixer();
+
+		if (pMixer && samples)
+		{
+			pMixer->PushStreamingSamples(samples, num_samples);
+		}
+	}
 }
@@ -21,4 +21,5 @@ namespace AudioCommon
 	void UpdateSoundStream();
 	void ClearAudioBuffer(bool mute);
 	void SendAIBuffer(short* samples, unsigned int num_samples);
+	void SendStreamingBuffer(short* samples, unsigned int num_samples);
 }
@@ -2,10 +2,14 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cmath>
+
 #include "AudioCommon/AudioCommon.h"
 #include "AudioCommon/Mixer.h"
 #include "Common/Atomic.h"
 #include "Common/CPUDetect.h"
+#include "Common/MathUtil.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/HW/AudioInterface.h"
@@ -14,94 +18,286 @@
 // UGLINESS
 #include "Core/PowerPC/PowerPC.h"
 
-#if _M_SSE >= 0x301 && !(defined __GNUC__ && !defined __SSSE3__)
-#include <tmmintrin.h>
+#ifdef _M_X86
+#include <emmintrin.h>
 #endif
 
-// Executed from sound stream thread
-unsigned int CMixer::Mix(short* samples, unsigned int numSamples, bool consider_framelimit)
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Kaiser window shape, trades the width of the transition band for
+// stopband attenuation (around 60 dB here).
+static const double KAISER_BETA = 6.0;
+
+// Per output sample while a FIFO is empty; fades the last sample out in about 30 ms.
+static const float PADDING_DECAY = 0.995f;
+
+// Zeroth order modified Bessel function of the first kind
+static double BesselI0(double x)
 {
-	if (!samples)
-		return 0;
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 32; ++k)
+	{
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	return sum;
+}
 
-	std::lock_guard<std::mutex> lk(m_csMixing);
+CMixer::MixerFifo::MixerFifo(CMixer* mixer, unsigned int sample_rate)
+	: m_mixer(mixer)
+	, m_input_sample_rate(sample_rate)
+	, m_indexW(0)
+	, m_indexR(0)
+	, m_numLeftI(0.0f)
+	, m_frac(0)
+	, m_filter_cutoff(0.0f)
+{
+	memset(m_buffer, 0, sizeof(m_buffer));
+	m_last_sample[0] = m_last_sample[1] = 0.0f;
+}
 
-	if (PowerPC::GetState() != PowerPC::CPU_RUNNING)
+// cutoff is relative to the input sample rate, 0.5 being its Nyquist frequency.
+void CMixer::MixerFifo::UpdateFilter(float cutoff)
+{
+	m_filter_cutoff = cutoff;
+
+	const int half = RESAMPLER_TAPS / 2;
+	const double i0_beta = BesselI0(KAISER_BETA);
+
+	for (int phase = 0; phase <= RESAMPLER_PHASES; ++phase)
 	{
-		// Silence
-		memset(samples, 0, numSamples * 4);
-		return numSamples;
+		// The output sample lies between taps half - 1 and half.
+		const double frac = (double)phase / RESAMPLER_PHASES;
+		double taps[RESAMPLER_TAPS];
+		double sum = 0.0;
+		for (int i = 0; i < RESAMPLER_TAPS; ++i)
+		{
+			const double x = i - (half - 1) - frac;
+			const double t = x / half;
+			const double window = (t <= -1.0 || t >= 1.0) ? 0.0 : BesselI0(KAISER_BETA * sqrt(1.0 - t * t)) / i0_beta;
+			const double arg = M_PI * 2.0 * cutoff * x;
+			const double sinc = (x == 0.0) ? 1.0 : sin(arg) / arg;
+			taps[i] = sinc * window;
+			sum += taps[i];
+		}
+
+		// Keep the DC gain at exactly 1 for every phase.
+		float* row = &m_coefficients[phase * RESAMPLER_TAPS * 2];
+		for (int i = 0; i < RESAMPLER_TAPS; ++i)
+			row[i * 2] = row[i * 2 + 1] = (float)(taps[i] / sum);
 	}
+}
 
-	unsigned int currentSample = 0;
+unsigned int CMixer::MixerFifo::FreeSamples() const
+{
+	// indexW == indexR means the ring is empty, so it can never be entirely full.
+	return MAX_SAMPLES - 1 - (Common::AtomicLoad(m_indexW) - Common::AtomicLoad(m_indexR));
+}
+
+void CMixer::MixerFifo::PushSamples(const short* samples, unsigned int num_samples, bool big_endian)
+{
+	if (num_samples > FreeSamples())
+		return;
+
+	// Only the audio thread changes m_indexR, so the free space can only grow
+	// while the samples are written.
+	u32 indexW = Common::AtomicLoad(m_indexW);
+	for (unsigned int i = 0; i < num_samples; ++i, ++indexW)
+	{
+		u32 sample;
+		memcpy(&sample, &samples[i * 2], sizeof(sample));
+		// Swapping the whole stereo sample also puts the right channel second.
+		if (big_endian)
+			sample = Common::swap32(sample);
+
+		const u32 pos = indexW & INDEX_MASK;
+		memcpy(&m_buffer[pos * 2], &sample, sizeof(sample));
+		if (pos < RESAMPLER_TAPS)
+			memcpy(&m_buffer[(MAX_SAMPLES + pos) * 2], &sample, sizeof(sample));
+	}
+
+	Common::AtomicStore(m_indexW, indexW);
+}
 
+// Filters the RESAMPLER_TAPS samples starting at window into m_last_sample, for an
+// output sample frac / 65536 of the way between taps RESAMPLER_TAPS / 2 - 1 and
+// RESAMPLER_TAPS / 2.
+void CMixer::MixerFifo::FilterSample(const short* window, u32 frac)
+{
+	const u32 phase_shift = 16 - RESAMPLER_PHASE_BITS;
+	const float* row = &m_coefficients[(frac >> phase_shift) * RESAMPLER_TAPS * 2];
+	const float t = (frac & ((1 << phase_shift) - 1)) * (1.0f / (1 << phase_shift));
+
+#ifdef _M_X86
+	// Both channels are filtered at once: the samples stay interleaved
+	// and the coefficients are stored twice.
+	const __m128 vt = _mm_set1_ps(t);
+	__m128 acc = _mm_setzero_ps();
+	for (int i = 0; i < RESAMPLER_TAPS / 4; ++i)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i*)window + i);
+		const __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+		const __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16));
+
+		const float* c = row + i * 8;
+		const float* n = c + RESAMPLER_TAPS * 2;
+		__m128 c_lo = _mm_loadu_ps(c);
+		__m128 c_hi = _mm_loadu_ps(c + 4);
+		c_lo = _mm_add_ps(c_lo, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(n), c_lo), vt));
+		c_hi = _mm_add_ps(c_hi, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(n + 4), c_hi), vt));
+
+		acc = _mm_add_ps(acc, _mm_mul_ps(lo, c_lo));
+		acc = _mm_add_ps(acc, _mm_mul_ps(hi, c_hi));
+	}
+	acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+	_mm_storel_pi((__m64*)m_last_sample, acc);
+#else
+	float l = 0.0f, r = 0.0f;
+	for (int i = 0; i < RESAMPLER_TAPS; ++i)
+	{
+		const float c = row[i * 2] + (row[(RESAMPLER_TAPS + i) * 2] - row[i * 2]) * t;
+		l += window[i * 2] * c;
+		r += window[i * 2 + 1] * c;
+	}
+	m_last_sample[0] = l;
+	m_last_sample[1] = r;
+#endif
+}
+
+void CMixer::MixerFifo::Mix(float* samples, unsigned int numSamples, bool consider_framelimit)
+{
 	// Cache access in non-volatile variable
 	// This is the only function changing the read value, so it's safe to
 	// cache it locally although it's written here.
 	// The writing pointer will be modified outside, but it will only increase,
 	// so we will just ignore new written data while interpolating.
-	// Without this cache, the compiler wouldn't be allowed to optimize the
-	// interpolation loop.
 	u32 indexR = Common::AtomicLoad(m_indexR);
 	u32 indexW = Common::AtomicLoad(m_indexW);
 
-	float numLeft = ((indexW - indexR) & INDEX_MASK) / 2;
+	float numLeft = (float)(indexW - indexR);
 	m_numLeftI = (numLeft + m_numLeftI*(CONTROL_AVG-1)) / CONTROL_AVG;
 	float offset = (m_numLeftI - LOW_WATERMARK) * CONTROL_FACTOR;
 	if (offset > MAX_FREQ_SHIFT) offset = MAX_FREQ_SHIFT;
 	if (offset < -MAX_FREQ_SHIFT) offset = -MAX_FREQ_SHIFT;
 
-	//render numleft sample pairs to samples[]
-	//advance indexR with sample position
-	//remember fractional offset
-
 	u32 framelimit = SConfig::GetInstance().m_Framelimit;
-	float aid_sample_rate = AudioInterface::GetAIDSampleRate() + offset;
+	float input_sample_rate = m_input_sample_rate + offset;
 	if (consider_framelimit && framelimit > 2)
 	{
-		aid_sample_rate = aid_sample_rate * (framelimit - 1) * 5 / VideoInterface::TargetRefreshRate;
+		input_sample_rate = input_sample_rate * (framelimit - 1) * 5 / VideoInterface::TargetRefreshRate;
 	}
 
-	static u32 frac = 0;
-	const u32 ratio = (u32)( 65536.0f * aid_sample_rate / (float)m_sampleRate );
+	const u32 ratio = (u32)( 65536.0f * input_sample_rate / (float)m_mixer->m_sampleRate );
 
-	if (ratio > 0x10000)
-		ERROR_LOG(AUDIO, "ratio out of range");
+	// Leave some room for the transition band below the lower Nyquist frequency.
+	// Small changes of the rate from the fill level control aren't worth a new filter.
+	const float cutoff = 0.45f * std::min(1.0f, (float)m_mixer->m_sampleRate / m_input_sample_rate);
+	if (cutoff != m_filter_cutoff)
+		UpdateFilter(cutoff);
 
-	for (; currentSample < numSamples*2 && ((indexW-indexR) & INDEX_MASK) > 2; currentSample+=2) {
-		u32 indexR2 = indexR + 2; //next sample
+	unsigned int currentSample = 0;
+	for (; currentSample < numSamples && indexW - indexR > RESAMPLER_TAPS; ++currentSample)
+	{
+		FilterSample(&m_buffer[(indexR & INDEX_MASK) * 2], m_frac);
 
-		s16 l1 = Common::swap16(m_buffer[indexR & INDEX_MASK]); //current
-		s16 l2 = Common::swap16(m_buffer[indexR2 & INDEX_MASK]); //next
-		int sampleL = ((l1 << 16) + (l2 - l1) * (u16)frac)  >> 16;
-		samples[currentSample+1] = sampleL;
+		samples[currentSample * 2] += m_last_sample[0];
+		samples[currentSample * 2 + 1] += m_last_sample[1];
 
-		s16 r1 = Common::swap16(m_buffer[(indexR + 1) & INDEX_MASK]); //current
-		s16 r2 = Common::swap16(m_buffer[(indexR2 + 1) & INDEX_MASK]); //next
-		int sampleR = ((r1 << 16) + (r2 - r1) * (u16)frac)  >> 16;
-		samples[currentSample] = sampleR;
+		m_frac += ratio;
+		indexR += m_frac >> 16;
+		m_frac &= 0xffff;
+	}
 
-		frac += ratio;
-		indexR += 2 * (u16)(frac >> 16);
-		frac &= 0xffff;
+	// The filter looks RESAMPLER_TAPS / 2 samples ahead, so the last ones before the
+	// FIFO runs dry are played out against zeroes. indexR stops where the output has
+	// reached the last sample, so that more input later carries on seamlessly.
+	if (currentSample < numSamples && indexW != indexR)
+	{
+		const u32 available = indexW - indexR;
+		short tail[RESAMPLER_TAPS * 2 * 2] = {};
+		memcpy(tail, &m_buffer[(indexR & INDEX_MASK) * 2], available * 2 * sizeof(short));
+
+		u32 pos = 0;
+		for (; currentSample < numSamples && pos + RESAMPLER_TAPS / 2 - 1 < available; ++currentSample)
+		{
+			FilterSample(&tail[pos * 2], m_frac);
+
+			samples[currentSample * 2] += m_last_sample[0];
+			samples[currentSample * 2 + 1] += m_last_sample[1];
+
+			m_frac += ratio;
+			pos += m_frac >> 16;
+			m_frac &= 0xffff;
+		}
+		indexR += std::min(pos, available);
 	}
 
-	// Padding
-	unsigned short s[2];
-	s[0] = Common::swap16(m_buffer[(indexR - 1) & INDEX_MASK]);
-	s[1] = Common::swap16(m_buffer[(indexR - 2) & INDEX_MASK]);
-	for (; currentSample < numSamples*2; currentSample+=2)
+	// Padding. Holding the last sample would leave a DC offset for as long as the
+	// FIFO stays empty, so let it die away instead.
+	for (; currentSample < numSamples; ++currentSample)
 	{
-		samples[currentSample] = s[0];
-		samples[currentSample+1] = s[1];
+		m_last_sample[0] *= PADDING_DECAY;
+		m_last_sample[1] *= PADDING_DECAY;
+		if (fabsf(m_last_sample[0]) < 0.5f && fabsf(m_last_sample[1]) < 0.5f)
+			m_last_sample[0] = m_last_sample[1] = 0.0f;
+
+		samples[currentSample * 2] += m_last_sample[0];
+		samples[currentSample * 2 + 1] += m_last_sample[1];
 	}
 
 	// Flush cached variable
 	Common::AtomicStore(m_indexR, indexR);
+}
+
+// Executed from sound stream thread
+unsigned int CMixer::Mix(short* samples, unsigned int numSamples, bool consider_framelimit)
+{
+	if (!samples)
+		return 0;
+
+	std::lock_guard<std::mutex> lk(m_csMixing);
+
+	if (PowerPC::GetState() != PowerPC::CPU_RUNNING)
+	{
+		// Silence
+		memset(samples, 0, numSamples * 4);
+		return numSamples;
+	}
+
+	m_dma_mixer.SetInputSampleRate(AudioInterface::GetAIDSampleRate());
+	m_streaming_mixer.SetInputSampleRate(AudioInterface::GetAISSampleRate());
+
+	// Both sources are added up at full precision and only clamped once.
+	const unsigned int CHUNK_SIZE = 256;
+	GC_ALIGNED16(float mix_buffer[CHUNK_SIZE * 2]);
+	for (unsigned int done = 0; done < numSamples; done += CHUNK_SIZE)
+	{
+		const unsigned int count = std::min(numSamples - done, CHUNK_SIZE);
+		memset(mix_buffer, 0, count * 2 * sizeof(float));
+
+		m_dma_mixer.Mix(mix_buffer, count, consider_framelimit);
+		m_streaming_mixer.Mix(mix_buffer, count, consider_framelimit);
+
+		short* out = &samples[done * 2];
+		unsigned int i = 0;
+#ifdef _M_X86
+		// cvtps rounds, packs saturates to the s16 range.
+		for (; i + 4 <= count * 2; i += 4)
+		{
+			const __m128i v = _mm_cvtps_epi32(_mm_load_ps(&mix_buffer[i]));
+			_mm_storel_epi64((__m128i*)&out[i], _mm_packs_epi32(v, v));
+		}
+#endif
+		for (; i < count * 2; ++i)
+		{
+			int sample = (int)lrintf(mix_buffer[i]);
+			MathUtil::Clamp(&sample, -32768, 32767);
+			out[i] = sample;
+		}
+	}
 
-	// Add the DTK Music
-	// Re-sampling is done inside
-	AudioInterface::Callback_GetStreaming(samples, numSamples, m_sampleRate);
 	if (m_logAudio)
 		g_wave_writer.AddStereoSamples(samples, numSamples);
 
@@ -111,15 +307,10 @@ unsigned int CMixer::Mix(short* samples, unsigned int numSamples, bool consider_
 
 void CMixer::PushSamples(const short *samples, unsigned int num_samples)
 {
-	// Cache access in non-volatile variable
-	// indexR isn't allowed to cache in the audio throttling loop as it
-	// needs to get updates to not deadlock.
-	u32 indexW = Common::AtomicLoad(m_indexW);
-
 	if (m_throttle)
 	{
 		// The auto throttle function. This loop will put a ceiling on the CPU MHz.
-		while (num_samples * 2 + ((indexW - Common::AtomicLoad(m_indexR)) & INDEX_MASK) >= MAX_SAMPLES * 2)
+		while (num_samples > m_dma_mixer.FreeSamples())
 		{
 			if (*PowerPC::GetStatePtr() != PowerPC::CPU_RUNNING || soundStream->IsMuted())
 				break;
@@ -131,27 +322,13 @@ void CMixer::PushSamples(const short *samples, unsigned int num_samples)
 		}
 	}
 
-	// Check if we have enough free space
-	// indexW == m_indexR results in empty buffer, so indexR must always be smaller than indexW
-	if (num_samples * 2 + ((indexW - Common::AtomicLoad(m_indexR)) & INDEX_MASK) >= MAX_SAMPLES * 2)
-		return;
-
 	// AyuanX: Actual re-sampling work has been moved to sound thread
 	// to alleviate the workload on main thread
 	// and we simply store raw data here to make fast mem copy
-	int over_bytes = num_samples * 4 - (MAX_SAMPLES * 2 - (indexW & INDEX_MASK)) * sizeof(short);
-	if (over_bytes > 0)
-	{
-		memcpy(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 4 - over_bytes);
-		memcpy(&m_buffer[0], samples + (num_samples * 4 - over_bytes) / sizeof(short), over_bytes);
-	}
-	else
-	{
-		memcpy(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 4);
-	}
-
-	Common::AtomicAdd(m_indexW, num_samples * 2);
-
-	return;
+	m_dma_mixer.PushSamples(samples, num_samples, true);
 }
 
+void CMixer::PushStreamingSamples(const short *samples, unsigned int num_samples)
+{
+	m_streaming_mixer.PushSamples(samples, num_samples, false);
+}
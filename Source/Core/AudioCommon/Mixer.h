@@ -11,13 +11,19 @@
 
 // 16 bit Stereo
 #define MAX_SAMPLES     (1024 * 2) // 64ms
-#define INDEX_MASK      (MAX_SAMPLES * 2 - 1)
+#define INDEX_MASK      (MAX_SAMPLES - 1)
 
 #define LOW_WATERMARK   1280 // 40 ms
 #define MAX_FREQ_SHIFT  200  // per 32000 Hz
 #define CONTROL_FACTOR  0.2  // in freq_shift per fifo size offset
 #define CONTROL_AVG     32
 
+// Length of the resampling filter in input samples, and the number of
+// fractional positions its coefficients are precomputed for.
+#define RESAMPLER_TAPS       16
+#define RESAMPLER_PHASE_BITS 8
+#define RESAMPLER_PHASES     (1 << RESAMPLER_PHASE_BITS)
+
 class CMixer {
 
 public:
@@ -26,17 +32,14 @@ public:
 		, m_dacSampleRate(DACSampleRate)
 		, m_bits(16)
 		, m_channels(2)
+		, m_dma_mixer(this, DACSampleRate)
+		, m_streaming_mixer(this, AISampleRate)
 		, m_logAudio(0)
-		, m_indexW(0)
-		, m_indexR(0)
-		, m_numLeftI(0.0f)
 	{
 		// AyuanX: The internal (Core & DSP) sample rate is fixed at 32KHz
 		// So when AI/DAC sample rate differs than 32KHz, we have to do re-sampling
 		m_sampleRate = BackendSampleRate;
 
-		memset(m_buffer, 0, sizeof(m_buffer));
-
 		INFO_LOG(AUDIO_INTERFACE, "Mixer is initialized (AISampleRate:%i, DACSampleRate:%i)", AISampleRate, DACSampleRate);
 	}
 
@@ -46,7 +49,10 @@ public:
 	virtual unsigned int Mix(short* samples, unsigned int numSamples, bool consider_framelimit = true);
 
 	// Called from main thread
+	// Audio DMA samples, big endian with the right channel first.
 	virtual void PushSamples(const short* samples, unsigned int num_samples);
+	// Disc streaming samples, native endian with the left channel first.
+	virtual void PushStreamingSamples(const short* samples, unsigned int num_samples);
 	unsigned int GetSampleRate() const {return m_sampleRate;}
 
 	void SetThrottle(bool use) { m_throttle = use;}
@@ -87,24 +93,64 @@ public:
 	void UpdateSpeed(volatile float val) { m_speed = val; }
 
 protected:
+	// A ring of stereo samples written by the emulation thread and read by
+	// the audio thread, which resamples them to the output rate with a
+	// windowed sinc filter. Each source has its own ring so each can keep its
+	// own input rate and fill level.
+	class MixerFifo
+	{
+	public:
+		MixerFifo(CMixer* mixer, unsigned int sample_rate);
+
+		// Called from main thread. The samples are stored with the channels
+		// in output order.
+		void PushSamples(const short* samples, unsigned int num_samples, bool big_endian);
+		// Called from audio thread. Adds the resampled input to samples.
+		void Mix(float* samples, unsigned int numSamples, bool consider_framelimit);
+
+		void SetInputSampleRate(unsigned int rate) { m_input_sample_rate = rate; }
+		unsigned int FreeSamples() const;
+
+	private:
+		void UpdateFilter(float cutoff);
+		void FilterSample(const short* window, u32 frac);
+
+		CMixer* m_mixer;
+		unsigned int m_input_sample_rate;
+
+		// The first RESAMPLER_TAPS samples are repeated at the end, so the
+		// filter never has to deal with the ring wrapping around.
+		short m_buffer[(MAX_SAMPLES + RESAMPLER_TAPS) * 2];
+		volatile u32 m_indexW;
+		volatile u32 m_indexR;
+
+		float m_numLeftI;
+		u32 m_frac;
+		float m_last_sample[2];
+
+		// One row of RESAMPLER_TAPS coefficients, each repeated for both
+		// channels, per phase plus one so neighboring phases can always be
+		// interpolated between.
+		float m_filter_cutoff;
+		float m_coefficients[(RESAMPLER_PHASES + 1) * RESAMPLER_TAPS * 2];
+	};
+
 	unsigned int m_sampleRate;
 	unsigned int m_aiSampleRate;
 	unsigned int m_dacSampleRate;
 	int m_bits;
 	int m_channels;
 
+	MixerFifo m_dma_mixer;
+	MixerFifo m_streaming_mixer;
+
 	WaveFileWriter g_wave_writer;
 
 	bool m_logAudio;
 
 	bool m_throttle;
 
-	short m_buffer[MAX_SAMPLES * 2];
-	volatile u32 m_indexW;
-	volatile u32 m_indexR;
-
 	std::mutex m_csMixing;
-	float m_numLeftI;
 
 	volatile float m_speed; // Current rate of the emulation (1.0 = 100% speed)
 private:
@@ -42,6 +42,7 @@ struct CPUInfo
 	bool bAVX;
 	bool bFMA;
 	bool bAES;
+	bool bSHA;
 	// FXSAVE/FXRSTOR
 	bool bFXSR;
 	bool bMOVBE;
@@ -37,6 +37,15 @@ extern const char *netplay_dolphin_ver;
 #define UNUSED
 #endif
 
+// Compiles a single function for an instruction set extension the rest of the
+// build doesn't assume, e.g. FUNCTION_TARGET("aes"). Only call it after checking
+// cpu_info. MSVC allows the intrinsics anywhere and needs nothing.
+#if defined(__GNUC__) || __clang__
+#define FUNCTION_TARGET(x) __attribute__((target(x)))
+#else
+#define FUNCTION_TARGET(x)
+#endif
+
 #define STACKALIGN
 
 #if __cplusplus >= 201103 || defined(_MSC_VER) || defined(__GXX_EXPERIMENTAL_CXX0X__)
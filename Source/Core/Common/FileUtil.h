@@ -81,6 +81,9 @@ u64 GetSize(const int fd);
 // Overloaded GetSize, accepts FILE*
 u64 GetSize(FILE *f);
 
+// Returns the last modification time of filename, or 0 if it can't be read
+u64 GetModifiedTime(const std::string &filename);
+
 // Returns true if successful, or path already exists.
 bool CreateDir(const std::string &filename);
 
@@ -0,0 +1,229 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <ctime>
+#include <elf.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include "Common/Common.h"
+#include "Common/FileUtil.h"
+#include "Common/JitRegister.h"
+#include "Common/StdMutex.h"
+#include "Common/StringUtil.h"
+
+#ifdef _WIN32
+#define getpid _getpid
+#endif
+
+namespace JitRegister
+{
+
+static std::mutex s_lock;
+static bool s_enabled;
+static File::IOFile s_perf_map_file;
+
+#ifdef __linux__
+// The jitdump format, see tools/perf/Documentation/jitdump-specification.txt in the kernel tree.
+enum
+{
+	JITDUMP_MAGIC = 0x4A695444,
+	JITDUMP_VERSION = 1,
+	JIT_CODE_LOAD = 0,
+};
+
+struct JitDumpHeader
+{
+	u32 magic;
+	u32 version;
+	u32 total_size;
+	u32 elf_mach;
+	u32 pad1;
+	u32 pid;
+	u64 timestamp;
+	u64 flags;
+};
+
+struct JitDumpCodeLoad
+{
+	u32 id;
+	u32 total_size;
+	u64 timestamp;
+	u32 pid;
+	u32 tid;
+	u64 vma;
+	u64 code_addr;
+	u64 code_size;
+	u64 code_index;
+	// Followed by the name, nul terminated, and then the code.
+};
+
+static File::IOFile s_jitdump_file;
+static void* s_jitdump_marker;
+static u64 s_code_index;
+
+// perf has to be told to use the same clock, with "perf record -k mono".
+static u64 GetTimestamp()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static u32 GetElfMachine()
+{
+#if _M_X86_64
+	return EM_X86_64;
+#elif _M_X86_32
+	return EM_386;
+#elif _M_ARM_64
+	return EM_AARCH64;
+#else
+	return EM_ARM;
+#endif
+}
+
+static void OpenJitDump(const std::string& dir)
+{
+	const std::string filename = StringFromFormat("%s/jit-%d.dump", dir.c_str(), getpid());
+	if (!s_jitdump_file.Open(filename, "w+b"))
+	{
+		ERROR_LOG(COMMON, "Failed to open %s", filename.c_str());
+		return;
+	}
+
+	// perf only finds the file through an executable mapping of it.
+	s_jitdump_marker = mmap(nullptr, sysconf(_SC_PAGESIZE), PROT_READ | PROT_EXEC, MAP_PRIVATE, fileno(s_jitdump_file.GetHandle()), 0);
+	if (s_jitdump_marker == MAP_FAILED)
+	{
+		ERROR_LOG(COMMON, "Failed to map %s", filename.c_str());
+		s_jitdump_marker = nullptr;
+		s_jitdump_file.Close();
+		return;
+	}
+
+	JitDumpHeader header = {};
+	header.magic = JITDUMP_MAGIC;
+	header.version = JITDUMP_VERSION;
+	header.total_size = sizeof(header);
+	header.elf_mach = GetElfMachine();
+	header.pid = getpid();
+	header.timestamp = GetTimestamp();
+	s_jitdump_file.WriteBytes(&header, sizeof(header));
+	s_code_index = 0;
+}
+
+static void CloseJitDump()
+{
+	if (s_jitdump_marker)
+		munmap(s_jitdump_marker, sysconf(_SC_PAGESIZE));
+	s_jitdump_marker = nullptr;
+	s_jitdump_file.Close();
+}
+
+static void WriteJitDumpRecord(const void* base_address, u32 code_size, const char* name)
+{
+	const u32 name_size = (u32)strlen(name) + 1;
+
+	JitDumpCodeLoad record = {};
+	record.id = JIT_CODE_LOAD;
+	record.total_size = sizeof(record) + name_size + code_size;
+	record.timestamp = GetTimestamp();
+	record.pid = getpid();
+	record.tid = (u32)syscall(SYS_gettid);
+	record.vma = (u64)base_address;
+	record.code_addr = (u64)base_address;
+	record.code_size = code_size;
+	record.code_index = s_code_index++;
+
+	s_jitdump_file.WriteBytes(&record, sizeof(record));
+	s_jitdump_file.WriteBytes(name, name_size);
+	s_jitdump_file.WriteBytes(base_address, code_size);
+}
+#endif
+
+void Init()
+{
+	std::lock_guard<std::mutex> lk(s_lock);
+	if (s_enabled)
+		return;
+
+	// perf record sets PERF_BUILDID_DIR for the programs it runs.
+	const char* perf_dir = getenv("DOLPHIN_PERF_DIR");
+	if (!perf_dir && !getenv("PERF_BUILDID_DIR"))
+		return;
+	const std::string dir = perf_dir && *perf_dir ? perf_dir : "/tmp";
+
+	const std::string filename = StringFromFormat("%s/perf-%d.map", dir.c_str(), getpid());
+	if (!s_perf_map_file.Open(filename, "w"))
+	{
+		ERROR_LOG(COMMON, "Failed to open %s", filename.c_str());
+		return;
+	}
+	// Lines have to be there when perf looks, which may be after a crash.
+	setvbuf(s_perf_map_file.GetHandle(), nullptr, _IOLBF, 0);
+
+#ifdef __linux__
+	if (getenv("DOLPHIN_JITDUMP"))
+		OpenJitDump(dir);
+#endif
+
+	s_enabled = true;
+}
+
+void Shutdown()
+{
+	std::lock_guard<std::mutex> lk(s_lock);
+	s_enabled = false;
+	s_perf_map_file.Close();
+#ifdef __linux__
+	CloseJitDump();
+#endif
+}
+
+bool IsEnabled()
+{
+	return s_enabled;
+}
+
+void Register(const void* base_address, u32 code_size, const char* format, ...)
+{
+	if (!s_enabled || !code_size)
+		return;
+
+	char name[256];
+	va_list args;
+	va_start(args, format);
+	CharArrayFromFormatV(name, sizeof(name), format, args);
+	va_end(args);
+
+	std::lock_guard<std::mutex> lk(s_lock);
+	if (!s_enabled)
+		return;
+
+	// Everything after the size is the name, spaces and all.
+	fprintf(s_perf_map_file.GetHandle(), "%" PRIx64 " %x %s\n", (u64)base_address, code_size, name);
+
+#ifdef __linux__
+	if (s_jitdump_file)
+		WriteJitDumpRecord(base_address, code_size, name);
+#endif
+}
+
+}  // namespace
@@ -0,0 +1,28 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+// Tells host profilers which function a piece of generated code belongs to.
+//
+// Writes /tmp/perf-<pid>.map, which Linux perf reads for symbols of code that
+// isn't backed by a file, when Dolphin is started by "perf record" or the
+// DOLPHIN_PERF_DIR environment variable names a directory to write it to.
+// With DOLPHIN_JITDUMP set, it also writes a jitdump file with the code bytes,
+// which "perf inject --jit" turns into something perf annotate can disassemble.
+namespace JitRegister
+{
+
+void Init();
+void Shutdown();
+
+// Whether Register does anything, for callers that have to work to find a name.
+bool IsEnabled();
+
+// Code has to be finished, as the jitdump record copies it.
+void Register(const void* base_address, u32 code_size, const char* format, ...);
+
+}  // namespace
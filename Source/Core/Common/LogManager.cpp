@@ -2,13 +2,20 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <atomic>
+#include <chrono>
 #include <cstdarg>
 #include <cstring>
+#include <ctime>
 #include <mutex>
 #include <ostream>
 #include <set>
 #include <string>
 
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
 #ifdef ANDROID
 #include "Core/Host.h"
 #endif
@@ -17,7 +24,212 @@
 #include "Common/Log.h"
 #include "Common/LogManager.h"
 #include "Common/StringUtil.h"
-#include "Common/Timer.h"
+#include "Common/Thread.h"
+
+namespace
+{
+
+enum
+{
+	// Per thread, has to be a power of two.
+	LOG_RING_SIZE = 128 * 1024,
+	MAX_LOG_RINGS = 64,
+	PADDING_LENGTH = 0xFFFF,
+};
+
+// Followed by the text of the message and a nul.
+struct LogRecord
+{
+	u32 sequence;
+	u32 line;
+	u64 time_ms;
+	const char *file;
+	// PADDING_LENGTH for the unused space at the end of the ring.
+	u16 length;
+	u8 level;
+	u8 type;
+};
+
+// Messages one thread has logged that the log thread hasn't written yet. Only
+// the thread that owns the ring adds to it and only the log thread takes from
+// it, so neither has to lock.
+class LogRing
+{
+public:
+	LogRing() : in_use(true), dropped(0), m_write(0), m_read(0) {}
+
+	bool Push(const LogRecord& record, const char *text)
+	{
+		const u32 size = AlignUp(sizeof(LogRecord) + record.length + 1);
+		const u32 write = m_write.load(std::memory_order_relaxed);
+		const u32 read = m_read.load(std::memory_order_acquire);
+
+		// Records don't wrap around, the end of the ring is skipped if one doesn't fit.
+		u32 offset = write & (LOG_RING_SIZE - 1);
+		const u32 to_end = LOG_RING_SIZE - offset;
+		const u32 skip = size > to_end ? to_end : 0;
+		if (write - read + skip + size > LOG_RING_SIZE)
+			return false;
+		if (skip)
+		{
+			if (skip >= sizeof(LogRecord))
+				((LogRecord*)&m_buffer[offset])->length = PADDING_LENGTH;
+			offset = 0;
+		}
+
+		memcpy(&m_buffer[offset], &record, sizeof(LogRecord));
+		memcpy(&m_buffer[offset + sizeof(LogRecord)], text, record.length);
+		m_buffer[offset + sizeof(LogRecord) + record.length] = 0;
+		// Sequentially consistent, see LogManager::LogThread.
+		m_write.store(write + skip + size);
+		return true;
+	}
+
+	// The oldest record in the ring, or nullptr if it's empty.
+	const LogRecord* Peek()
+	{
+		u32 read = m_read.load(std::memory_order_relaxed);
+		const u32 write = m_write.load();
+		while (read != write)
+		{
+			const u32 offset = read & (LOG_RING_SIZE - 1);
+			const u32 to_end = LOG_RING_SIZE - offset;
+			const LogRecord* record = (const LogRecord*)&m_buffer[offset];
+			if (to_end >= sizeof(LogRecord) && record->length != PADDING_LENGTH)
+				return record;
+			read += to_end;
+			m_read.store(read, std::memory_order_release);
+		}
+		return nullptr;
+	}
+
+	void Pop(const LogRecord* record)
+	{
+		const u32 size = AlignUp(sizeof(LogRecord) + record->length + 1);
+		m_read.store(m_read.load(std::memory_order_relaxed) + size, std::memory_order_release);
+	}
+
+	// Cleared when the owning thread exits, so the next new thread can take the ring over.
+	std::atomic<bool> in_use;
+	// Messages that didn't fit.
+	std::atomic<u32> dropped;
+
+private:
+	static u32 AlignUp(size_t size) { return (u32)((size + 7) & ~7); }
+
+	GC_ALIGNED16(u8 m_buffer[LOG_RING_SIZE]);
+	std::atomic<u32> m_write;
+	std::atomic<u32> m_read;
+};
+
+// Rings are never freed, as threads may still be logging while the log manager
+// goes away.
+LogRing* s_rings[MAX_LOG_RINGS];
+std::atomic<u32> s_num_rings;
+std::mutex s_rings_lock;
+
+// Orders the messages of different threads.
+std::atomic<u32> s_sequence;
+// Set while the log thread may be about to wait, see LogManager::LogThread.
+std::atomic<bool> s_log_thread_idle;
+// Threads that saw the log thread running and may still be pushing a message.
+// Shutdown waits for them before the final drain.
+std::atomic<u32> s_num_pushing;
+
+#ifdef _WIN32
+DWORD s_ring_key = FLS_OUT_OF_INDEXES;
+
+void WINAPI ReleaseRing(void *ring)
+#else
+pthread_key_t s_ring_key;
+bool s_ring_key_created;
+
+void ReleaseRing(void *ring)
+#endif
+{
+	if (ring)
+		((LogRing*)ring)->in_use.store(false);
+}
+
+void CreateRingKey()
+{
+#ifdef _WIN32
+	if (s_ring_key == FLS_OUT_OF_INDEXES)
+		s_ring_key = FlsAlloc(ReleaseRing);
+#else
+	if (!s_ring_key_created)
+		s_ring_key_created = pthread_key_create(&s_ring_key, ReleaseRing) == 0;
+#endif
+}
+
+// The ring of the calling thread, or nullptr if there are no more.
+LogRing* GetThreadRing()
+{
+#ifdef _WIN32
+	if (s_ring_key == FLS_OUT_OF_INDEXES)
+		return nullptr;
+	LogRing* ring = (LogRing*)FlsGetValue(s_ring_key);
+#else
+	if (!s_ring_key_created)
+		return nullptr;
+	LogRing* ring = (LogRing*)pthread_getspecific(s_ring_key);
+#endif
+	if (ring)
+		return ring;
+
+	const u32 num_rings = s_num_rings.load();
+	for (u32 i = 0; i < num_rings && !ring; i++)
+	{
+		bool expected = false;
+		if (s_rings[i]->in_use.compare_exchange_strong(expected, true))
+			ring = s_rings[i];
+	}
+
+	if (!ring)
+	{
+		std::lock_guard<std::mutex> lk(s_rings_lock);
+		const u32 index = s_num_rings.load();
+		if (index == MAX_LOG_RINGS)
+			return nullptr;
+		ring = new LogRing();
+		s_rings[index] = ring;
+		s_num_rings.store(index + 1);
+	}
+
+#ifdef _WIN32
+	FlsSetValue(s_ring_key, ring);
+#else
+	pthread_setspecific(s_ring_key, ring);
+#endif
+	return ring;
+}
+
+bool AreRingsEmpty()
+{
+	const u32 num_rings = s_num_rings.load();
+	for (u32 i = 0; i < num_rings; i++)
+	{
+		if (s_rings[i]->Peek())
+			return false;
+	}
+	return true;
+}
+
+u64 GetTimeMs()
+{
+	using namespace std::chrono;
+	return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+std::string FormatTime(u64 time_ms)
+{
+	const time_t seconds = (time_t)(time_ms / 1000);
+	char tmp[13];
+	strftime(tmp, 6, "%M:%S", localtime(&seconds));
+	return StringFromFormat("%s:%03i", tmp, (int)(time_ms % 1000));
+}
+
+}
 
 void GenericLog(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type,
 		const char *file, int line, const char* fmt, ...)
@@ -82,6 +294,8 @@ LogManager::LogManager()
 	m_Log[LogTypes::MEMCARD_MANAGER]    = new LogContainer("MemCard Manager", "MemCard Manager");
 	m_Log[LogTypes::NETPLAY]            = new LogContainer("NETPLAY",         "Netplay");
 
+	CreateRingKey();
+
 	m_fileLog = new FileLogListener(File::GetUserPath(F_MAINLOG_IDX).c_str());
 	m_consoleLog = new ConsoleListener();
 	m_debuggerLog = new DebuggerLogListener();
@@ -96,10 +310,23 @@ LogManager::LogManager()
 			container->AddListener(m_debuggerLog);
 #endif
 	}
+
+	m_log_thread_running.Set();
+	m_log_thread = std::thread(&LogManager::LogThread, this);
 }
 
 LogManager::~LogManager()
 {
+	// Anything logged from here on is written right away. Messages that are
+	// being pushed are waited for, so the last drain finds them.
+	m_log_thread_running.Clear();
+	while (s_num_pushing.load())
+		Common::YieldCPU();
+	m_log_thread_quit.Set();
+	m_log_event.Set();
+	m_log_thread.join();
+	DrainQueues();
+
 	for (int i = 0; i < LogTypes::NUMBER_OF_LOGS; ++i)
 	{
 		m_logManager->RemoveListener((LogTypes::LOG_TYPE)i, m_fileLog);
@@ -125,18 +352,107 @@ void LogManager::Log(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type,
 		return;
 
 	CharArrayFromFormatV(temp, MAX_MSGLEN, format, args);
+	const u64 time_ms = GetTimeMs();
+
+	s_num_pushing.fetch_add(1);
+	LogRing* ring = m_log_thread_running.IsSet() ? GetThreadRing() : nullptr;
+	if (!ring)
+	{
+		s_num_pushing.fetch_sub(1);
+		Write(level, type, file, line, time_ms, temp);
+		return;
+	}
+
+	LogRecord record;
+	record.sequence = s_sequence.fetch_add(1, std::memory_order_relaxed);
+	record.line = line;
+	record.time_ms = time_ms;
+	record.file = file;
+	record.length = (u16)strlen(temp);
+	record.level = (u8)level;
+	record.type = (u8)type;
+	if (!ring->Push(record, temp))
+		ring->dropped.fetch_add(1, std::memory_order_relaxed);
+	else if (s_log_thread_idle.load())
+		m_log_event.Set();
+	s_num_pushing.fetch_sub(1);
+}
 
+void LogManager::Write(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type,
+	const char *file, int line, u64 time_ms, const char *text)
+{
+	LogContainer *log = m_Log[type];
 	std::string msg = StringFromFormat("%s %s:%u %c[%s]: %s\n",
-	                                   Common::Timer::GetTimeFormatted().c_str(),
+	                                   FormatTime(time_ms).c_str(),
 	                                   file, line,
 	                                   LogTypes::LOG_LEVEL_TO_CHAR[(int)level],
-	                                   log->GetShortName(), temp);
+	                                   log->GetShortName(), text);
 #ifdef ANDROID
 	Host_SysMessage(msg.c_str());
 #endif
 	log->Trigger(level, msg.c_str());
 }
 
+// Writes out everything in the rings, oldest first.
+void LogManager::DrainQueues()
+{
+	const u32 num_rings = s_num_rings.load();
+	while (true)
+	{
+		LogRing* oldest_ring = nullptr;
+		const LogRecord* oldest = nullptr;
+		for (u32 i = 0; i < num_rings; i++)
+		{
+			const LogRecord* record = s_rings[i]->Peek();
+			if (record && (!oldest || (s32)(record->sequence - oldest->sequence) < 0))
+			{
+				oldest_ring = s_rings[i];
+				oldest = record;
+			}
+		}
+		if (!oldest)
+			break;
+
+		Write((LogTypes::LOG_LEVELS)oldest->level, (LogTypes::LOG_TYPE)oldest->type,
+		      oldest->file, oldest->line, oldest->time_ms, (const char*)(oldest + 1));
+		oldest_ring->Pop(oldest);
+	}
+
+	u32 dropped = 0;
+	for (u32 i = 0; i < num_rings; i++)
+		dropped += s_rings[i]->dropped.exchange(0);
+	if (dropped)
+	{
+		std::string text = StringFromFormat("%u messages were dropped, the log thread couldn't keep up", dropped);
+		Write(LogTypes::LWARNING, LogTypes::MASTER_LOG, __FILE__, __LINE__, GetTimeMs(), text.c_str());
+	}
+}
+
+void LogManager::LogThread()
+{
+	Common::SetCurrentThreadName("Log thread");
+
+	while (true)
+	{
+		DrainQueues();
+
+		// A message pushed after the check below sees the flag and wakes us up,
+		// one pushed before it is found by the check.
+		s_log_thread_idle.store(true);
+		if (!AreRingsEmpty())
+		{
+			s_log_thread_idle.store(false);
+			continue;
+		}
+		if (m_log_thread_quit.IsSet())
+			break;
+
+		m_log_event.Wait();
+		s_log_thread_idle.store(false);
+	}
+	s_log_thread_idle.store(false);
+}
+
 void LogManager::Init()
 {
 	m_logManager = new LogManager();
@@ -9,7 +9,10 @@
 #include <set>
 
 #include "Common/Common.h"
+#include "Common/Event.h"
+#include "Common/Flag.h"
 #include "Common/StdMutex.h"
+#include "Common/StdThread.h"
 
 #define MAX_MESSAGES 8000
 #define MAX_MSGLEN  1024
@@ -91,8 +94,20 @@ private:
 	DebuggerLogListener *m_debuggerLog;
 	static LogManager *m_logManager;  // Singleton. Ugh.
 
+	// Threads queue their messages without taking any lock, and this thread
+	// formats them and passes them to the listeners.
+	std::thread m_log_thread;
+	Common::Event m_log_event;
+	Common::Flag m_log_thread_running;
+	Common::Flag m_log_thread_quit;
+
 	LogManager();
 	~LogManager();
+
+	void LogThread();
+	void DrainQueues();
+	void Write(LogTypes::LOG_LEVELS level, LogTypes::LOG_TYPE type,
+	           const char *file, int line, u64 time_ms, const char *text);
 public:
 
 	static u32 GetMaxLevel() { return MAX_LOGLEVEL; }
@@ -0,0 +1,166 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "Common/MappedFile.h"
+#include "Common/StringUtil.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace File
+{
+
+// Leaves room in a 32-bit address space for everything else.
+static const u64 MAX_MAPPING_SIZE_32BIT = 0x40000000;
+
+MappedFile::MappedFile()
+	: m_data(nullptr), m_size(0), m_next_offset(0), m_sequential_reads(0), m_read_ahead_end(0)
+#ifdef _WIN32
+	, m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& filename)
+{
+	Close();
+
+#ifdef _WIN32
+	m_file = CreateFile(UTF8ToTStr(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+	                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart <= 0 ||
+	    (sizeof(void*) < 8 && (u64)size.QuadPart > MAX_MAPPING_SIZE_32BIT))
+	{
+		Close();
+		return false;
+	}
+
+	m_mapping = CreateFileMapping(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_mapping)
+	{
+		Close();
+		return false;
+	}
+
+	m_data = (u8*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_data)
+	{
+		Close();
+		return false;
+	}
+	m_size = size.QuadPart;
+#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0 ||
+	    (sizeof(void*) < 8 && (u64)st.st_size > MAX_MAPPING_SIZE_32BIT))
+	{
+		close(fd);
+		return false;
+	}
+
+	void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps its own reference to the file.
+	close(fd);
+	if (data == MAP_FAILED)
+		return false;
+
+	m_data = (u8*)data;
+	m_size = st.st_size;
+
+	// Disc reads jump around a lot, the kernel's default readahead around every
+	// fault would mostly read data that never gets used. Runs of sequential reads
+	// are read ahead explicitly instead.
+	madvise(m_data, m_size, MADV_RANDOM);
+#endif
+
+	m_next_offset = 0;
+	m_sequential_reads = 0;
+	m_read_ahead_end = 0;
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_data)
+		munmap(m_data, m_size);
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
+
+bool MappedFile::Read(u64 offset, u64 size, void* out_ptr)
+{
+	if (!m_data || offset > m_size || size > m_size - offset)
+		return false;
+
+	if (offset == m_next_offset)
+	{
+		if (++m_sequential_reads >= SEQUENTIAL_THRESHOLD)
+			ReadAhead(offset, size);
+	}
+	else
+	{
+		m_sequential_reads = 0;
+		m_read_ahead_end = 0;
+	}
+	m_next_offset = offset + size;
+
+	memcpy(out_ptr, m_data + offset, (size_t)size);
+	return true;
+}
+
+void MappedFile::ReadAhead(u64 offset, u64 size)
+{
+	const u64 end = offset + size;
+	// Only ask again once the reads have eaten into the previous window.
+	if (end + READ_AHEAD_SIZE / 2 <= m_read_ahead_end)
+		return;
+
+	const u64 start = std::max(end, m_read_ahead_end);
+	const u64 window_end = std::min(end + READ_AHEAD_SIZE, m_size);
+	m_read_ahead_end = window_end;
+	if (start >= window_end)
+		return;
+
+#ifndef _WIN32
+	static const u64 page_size = sysconf(_SC_PAGESIZE);
+	const u64 aligned_start = start & ~(page_size - 1);
+	madvise(m_data + aligned_start, (size_t)(window_end - aligned_start), MADV_WILLNEED);
+#endif
+	// PrefetchVirtualMemory would do the same on Windows, but it only exists
+	// from Windows 8 on. The memory manager's own readahead has to do there.
+}
+
+}  // namespace
@@ -0,0 +1,63 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "Common/Common.h"
+
+namespace File
+{
+
+// A read only memory mapping of a whole file. Reading from it is a memcpy out of
+// the page cache instead of a seek and read syscall per request.
+//
+// Read also watches the access pattern: the mapping starts out advised as random
+// access so that scattered reads don't pull in readahead they never use, and runs
+// of reads that continue each other get the pages ahead of them requested early.
+class MappedFile : NonCopyable
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	// Fails for empty files and, on 32-bit hosts, for files too big to map.
+	bool Open(const std::string& filename);
+	void Close();
+
+	bool IsOpen() const { return m_data != nullptr; }
+	u64 GetSize() const { return m_size; }
+	const u8* GetData() const { return m_data; }
+
+	bool Read(u64 offset, u64 size, void* out_ptr);
+
+private:
+	enum
+	{
+		// How many reads in a row have to continue each other before reading ahead.
+		SEQUENTIAL_THRESHOLD = 2,
+		READ_AHEAD_SIZE = 2 * 1024 * 1024,
+	};
+
+	void ReadAhead(u64 offset, u64 size);
+
+	u8* m_data;
+	u64 m_size;
+
+	u64 m_next_offset;
+	int m_sequential_reads;
+	u64 m_read_ahead_end;
+
+#ifdef _WIN32
+	HANDLE m_file;
+	HANDLE m_mapping;
+#endif
+};
+
+}  // namespace
@@ -32,6 +32,21 @@ u32 Timer::GetTimeMs()
 #endif
 }
 
+// Higher resolution counterpart of GetTimeMs, meant for measuring short intervals
+u64 Timer::GetTimeUs()
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, count;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (u64)(count.QuadPart / freq.QuadPart * 1000000 + count.QuadPart % freq.QuadPart * 1000000 / freq.QuadPart);
+#else
+	struct timeval t;
+	(void)gettimeofday(&t, nullptr);
+	return ((u64)t.tv_sec * 1000000 + t.tv_usec);
+#endif
+}
+
 // --------------------------------------------
 // Initiate, Start, Stop, and Update the time
 // --------------------------------------------
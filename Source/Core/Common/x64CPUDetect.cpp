@@ -29,8 +29,9 @@
 #include <sys/types.h>
 #include <machine/cpufunc.h>
 #else
-static inline void do_cpuid(unsigned int *eax, unsigned int *ebx,
-							unsigned int *ecx, unsigned int *edx)
+// *ecx selects the subleaf for the leaves that have them.
+static inline void do_cpuidex(unsigned int *eax, unsigned int *ebx,
+							  unsigned int *ecx, unsigned int *edx)
 {
 #if defined _M_GENERIC
 	(*eax) = (*ebx) = (*ecx) = (*edx) = 0;
@@ -44,7 +45,8 @@ static inline void do_cpuid(unsigned int *eax, unsigned int *ebx,
 		  "=S" (*ebx),
 		  "=c" (*ecx),
 		  "=d" (*edx)
-		: "a"  (*eax)
+		: "a"  (*eax),
+		  "c"  (*ecx)
 		: "rbx"
 		);
 #else
@@ -55,20 +57,21 @@ static inline void do_cpuid(unsigned int *eax, unsigned int *ebx,
 		  "=S" (*ebx),
 		  "=c" (*ecx),
 		  "=d" (*edx)
-		: "a"  (*eax)
+		: "a"  (*eax),
+		  "c"  (*ecx)
 		: "ebx"
 		);
 #endif
 }
 #endif /* defined __FreeBSD__ */
 
-static void __cpuid(int info[4], int x)
+static void __cpuidex(int info[4], int x, int subleaf)
 {
 #if defined __FreeBSD__
-	do_cpuid((unsigned int)x, (unsigned int*)info);
+	cpuid_count((unsigned int)x, (unsigned int)subleaf, (unsigned int*)info);
 #else
-	unsigned int eax = x, ebx = 0, ecx = 0, edx = 0;
-	do_cpuid(&eax, &ebx, &ecx, &edx);
+	unsigned int eax = x, ebx = 0, ecx = subleaf, edx = 0;
+	do_cpuidex(&eax, &ebx, &ecx, &edx);
 	info[0] = eax;
 	info[1] = ebx;
 	info[2] = ecx;
@@ -76,6 +79,11 @@ static void __cpuid(int info[4], int x)
 #endif
 }
 
+static void __cpuid(int info[4], int x)
+{
+	__cpuidex(info, x, 0);
+}
+
 #define _XCR_XFEATURE_ENABLED_MASK 0
 static unsigned long long _xgetbv(unsigned int index)
 {
@@ -204,6 +212,12 @@ void CPUInfo::Detect()
 			}
 		}
 	}
+	if (max_std_fn >= 7)
+	{
+		// Structured extended feature flags live in subleaf 0.
+		__cpuidex(cpu_id, 0x00000007, 0);
+		if ((cpu_id[1] >> 29) & 1) bSHA = true;
+	}
 	if (max_ex_fn >= 0x80000004) {
 		// Extract brand string
 		__cpuid(cpu_id, 0x80000002);
@@ -264,6 +278,7 @@ std::string CPUInfo::Summarize()
 	if (bAVX) sum += ", AVX";
 	if (bFMA) sum += ", FMA";
 	if (bAES) sum += ", AES";
+	if (bSHA) sum += ", SHA";
 	if (bMOVBE) sum += ", MOVBE";
 	if (bLongMode) sum += ", 64-bit support";
 	return sum;
@@ -597,6 +597,8 @@ void XEmitter::SAHF() {Write8(0x9E);}
 void XEmitter::PUSHF() {Write8(0x9C);}
 void XEmitter::POPF()  {Write8(0x9D);}
 
+void XEmitter::RDTSC()  {Write8(0x0F); Write8(0x31);}
+
 void XEmitter::LFENCE() {Write8(0x0F); Write8(0xAE); Write8(0xE8);}
 void XEmitter::MFENCE() {Write8(0x0F); Write8(0xAE); Write8(0xF0);}
 void XEmitter::SFENCE() {Write8(0x0F); Write8(0xAE); Write8(0xF8);}
@@ -1302,8 +1304,9 @@ void XEmitter::MOVQ_xmm(OpArg arg, X64Reg src) {
 		arg.WriteRest(this, 0);
 	} else {
 		arg.operandReg = src;
-		arg.WriteRex(this, 0, 0);
+		// The REX prefix has to come after the operand size prefix
 		Write8(0x66);
+		arg.WriteRex(this, 0, 0);
 		Write8(0x0f);
 		Write8(0xD6);
 		arg.WriteRest(this, 0);
@@ -339,6 +339,9 @@ public:
 	// Note: CMOV brings small if any benefit on current cpus.
 	void CMOVcc(int bits, X64Reg dest, OpArg src, CCFlags flag);
 
+	// Time stamp counter, to EDX:EAX
+	void RDTSC();
+
 	// Fences
 	void LFENCE();
 	void MFENCE();
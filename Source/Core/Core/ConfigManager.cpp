@@ -8,6 +8,7 @@
 #include "Common/IniFile.h"
 #include "Core/ConfigManager.h"
 #include "Core/HW/SI.h"
+#include "DiscIO/Blob.h"
 #include "DiscIO/NANDContentLoader.h"
 
 SConfig* SConfig::m_Instance;
@@ -110,6 +111,7 @@ static const struct
 	{ "UndoSaveState",       351 /* WXK_F12 */,   4 /* wxMOD_SHIFT */ },
 	{ "SaveStateFile",       0,                   0 /* wxMOD_NONE */ },
 	{ "LoadStateFile",       0,                   0 /* wxMOD_NONE */ },
+	{ "Rewind",              0,                   0 /* wxMOD_NONE */ },
 };
 
 SConfig::SConfig()
@@ -164,6 +166,7 @@ void SConfig::SaveSettings()
 	}
 
 	ini.Set("General", "RecursiveGCMPaths", m_RecursiveISOFolder);
+	ini.Set("General", "MappedDiscReads",   m_MappedDiscReads);
 	ini.Set("General", "NANDRootPath",      m_NANDPath);
 	ini.Set("General", "WirelessMac",       m_WirelessMac);
 	#ifdef USE_GDBSTUB
@@ -230,6 +233,10 @@ void SConfig::SaveSettings()
 	ini.Set("Core", "HLE_BS2",          m_LocalCoreStartupParameter.bHLE_BS2);
 	ini.Set("Core", "CPUCore",          m_LocalCoreStartupParameter.iCPUCore);
 	ini.Set("Core", "Fastmem",          m_LocalCoreStartupParameter.bFastmem);
+	ini.Set("Core", "JITBlockDiskCache", m_LocalCoreStartupParameter.bJITBlockDiskCache);
+	ini.Set("Core", "Rewind",           m_LocalCoreStartupParameter.bRewind);
+	ini.Set("Core", "RewindInterval",   m_LocalCoreStartupParameter.iRewindInterval);
+	ini.Set("Core", "RewindMemory",     m_LocalCoreStartupParameter.iRewindMemoryMB);
 	ini.Set("Core", "CPUThread",        m_LocalCoreStartupParameter.bCPUThread);
 	ini.Set("Core", "DSPThread",        m_LocalCoreStartupParameter.bDSPThread);
 	ini.Set("Core", "DSPHLE",           m_LocalCoreStartupParameter.bDSPHLE);
@@ -309,6 +316,8 @@ void SConfig::LoadSettings()
 		}
 
 		ini.Get("General", "RecursiveGCMPaths", &m_RecursiveISOFolder, false);
+		ini.Get("General", "MappedDiscReads", &m_MappedDiscReads, true);
+		DiscIO::SetMappedReads(m_MappedDiscReads);
 
 		ini.Get("General", "NANDRootPath", &m_NANDPath);
 		m_NANDPath = File::GetUserPath(D_WIIROOT_IDX, m_NANDPath);
@@ -386,6 +395,10 @@ void SConfig::LoadSettings()
 		ini.Get("Core", "CPUCore",      &m_LocalCoreStartupParameter.iCPUCore, 0);
 #endif
 		ini.Get("Core", "Fastmem",           &m_LocalCoreStartupParameter.bFastmem,      true);
+		ini.Get("Core", "JITBlockDiskCache", &m_LocalCoreStartupParameter.bJITBlockDiskCache, false);
+		ini.Get("Core", "Rewind",            &m_LocalCoreStartupParameter.bRewind,       false);
+		ini.Get("Core", "RewindInterval",    &m_LocalCoreStartupParameter.iRewindInterval, 60);
+		ini.Get("Core", "RewindMemory",      &m_LocalCoreStartupParameter.iRewindMemoryMB, 256);
 		ini.Get("Core", "DSPThread",         &m_LocalCoreStartupParameter.bDSPThread,    false);
 		ini.Get("Core", "DSPHLE",            &m_LocalCoreStartupParameter.bDSPHLE,       true);
 		ini.Get("Core", "CPUThread",         &m_LocalCoreStartupParameter.bCPUThread,    true);
@@ -36,6 +36,8 @@ struct SConfig : NonCopyable
 	// gcm folder
 	std::vector<std::string> m_ISOFolder;
 	bool m_RecursiveISOFolder;
+	// read plain and WBFS images through a memory mapping
+	bool m_MappedDiscReads;
 
 	SCoreStartupParameter m_LocalCoreStartupParameter;
 	std::string m_NANDPath;
@@ -15,6 +15,7 @@
 #include "Common/Common.h"
 #include "Common/CommonPaths.h"
 #include "Common/CPUDetect.h"
+#include "Common/JitRegister.h"
 #include "Common/LogManager.h"
 #include "Common/MathUtil.h"
 #include "Common/MemoryUtil.h"
@@ -384,6 +385,7 @@ void EmuThread()
 		PanicAlertT("Warning: Netplay/movies will desync because your CPU does not support DAZ and Dolphin does not emulate it anymore.");
 	}
 
+	JitRegister::Init();
 	Movie::Init();
 
 	HW::Init();
@@ -520,6 +522,7 @@ void EmuThread()
 	Wiimote::Shutdown();
 	g_video_backend->Shutdown();
 	AudioCommon::ShutdownSoundStream();
+	JitRegister::Shutdown();
 }
 
 // Set or get the running state
@@ -23,7 +23,7 @@
 SCoreStartupParameter::SCoreStartupParameter()
 : hInstance(nullptr),
   bEnableDebugging(false), bAutomaticStart(false), bBootToPause(false),
-  bJITNoBlockCache(false), bJITBlockLinking(true),
+  bJITNoBlockCache(false), bJITBlockLinking(true), bJITBlockDiskCache(false),
   bJITOff(false),
   bJITLoadStoreOff(false), bJITLoadStorelXzOff(false),
   bJITLoadStorelwzOff(false), bJITLoadStorelbzxOff(false),
@@ -41,6 +41,7 @@ SCoreStartupParameter::SCoreStartupParameter()
   bRunCompareServer(false), bRunCompareClient(false),
   bMMU(false), bDCBZOFF(false), bTLBHack(false), iBBDumpPort(0), bVBeamSpeedHack(false),
   bSyncGPU(false), bFastDiscSpeed(false),
+  bRewind(false), iRewindInterval(60), iRewindMemoryMB(256),
   SelectedLanguage(0), bWii(false),
   bConfirmStop(false), bHideCursor(false),
   bAutoHideCursor(false), bUsePanicHandlers(true), bOnScreenDisplayMessages(true),
@@ -72,6 +73,7 @@ void SCoreStartupParameter::LoadDefaults()
 	bDSPHLE = true;
 	bDSPThread = true;
 	bFastmem = true;
+	bJITBlockDiskCache = false;
 	bEnableFPRF = false;
 	bMMU = false;
 	bDCBZOFF = false;
@@ -79,6 +79,7 @@ enum Hotkey
 	HK_UNDO_SAVE_STATE,
 	HK_SAVE_STATE_FILE,
 	HK_LOAD_STATE_FILE,
+	HK_REWIND,
 
 	NUM_HOTKEYS,
 };
@@ -103,6 +104,8 @@ struct SCoreStartupParameter
 
 	// JIT (shared between JIT and JITIL)
 	bool bJITNoBlockCache, bJITBlockLinking;
+	// Remember compiled block addresses per game and recompile them up front on the next boot
+	bool bJITBlockDiskCache;
 	bool bJITOff;
 	bool bJITLoadStoreOff, bJITLoadStorelXzOff, bJITLoadStorelwzOff, bJITLoadStorelbzxOff;
 	bool bJITLoadStoreFloatingOff;
@@ -143,6 +146,12 @@ struct SCoreStartupParameter
 	bool bSyncGPU;
 	bool bFastDiscSpeed;
 
+	// In-memory rewind history: a snapshot every iRewindInterval VI fields,
+	// kept within iRewindMemoryMB megabytes
+	bool bRewind;
+	int iRewindInterval;
+	int iRewindMemoryMB;
+
 	int SelectedLanguage;
 
 	bool bWii;
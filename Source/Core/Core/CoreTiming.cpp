@@ -2,6 +2,7 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
 #include <string>
 #include <vector>
@@ -36,16 +37,41 @@ struct BaseEvent
 	int type;
 };
 
-typedef LinkedListItem<BaseEvent> Event;
+struct Event : public BaseEvent
+{
+	// Events scheduled for the same cycle fire in the order they were scheduled.
+	u64 fifo_order;
+};
+
+// Orders the event queue as a min-heap on (time, fifo_order).
+static bool operator>(const Event& left, const Event& right)
+{
+	if (left.time != right.time)
+		return left.time > right.time;
+	return left.fifo_order > right.fifo_order;
+}
+
+// Events live in slots that stay put while the heap moves slot indices around,
+// so a handle can find its event. A slot's generation changes whenever it is
+// freed, which makes the handles of events that are gone stale.
+struct EventSlot
+{
+	Event ev;
+	u32 heap_pos;
+	u32 generation;
+};
 
 // STATE_TO_SAVE
-static Event *first;
+// The event queue is a binary min-heap of slot indices, so scheduling, dispatching
+// and cancelling are O(log n). Only the front element is in sorted position; use
+// GetSortedEvents() to walk it in order.
+static std::vector<u32> eventQueue;
+static std::vector<EventSlot> eventSlots;
+static std::vector<u32> freeEventSlots;
+static u64 eventFifoId;
 static std::mutex tsWriteLock;
 Common::FifoQueue<BaseEvent, false> tsQueue;
 
-// event pools
-Event *eventPool = nullptr;
-
 int downcount, slicelength;
 int maxSliceLength = MAX_SLICE_LENGTH;
 
@@ -62,20 +88,116 @@ int ev_lost;
 
 void (*advanceCallback)(int cyclesExecuted) = nullptr;
 
-Event* GetNewEvent()
+static const Event& QueuedEvent(size_t pos)
+{
+	return eventSlots[eventQueue[pos]].ev;
+}
+
+static void SetHeapPos(size_t pos, u32 slot)
+{
+	eventQueue[pos] = slot;
+	eventSlots[slot].heap_pos = (u32)pos;
+}
+
+static void SiftUp(size_t pos)
 {
-	if (!eventPool)
-		return new Event;
+	const u32 slot = eventQueue[pos];
+	while (pos > 0)
+	{
+		const size_t parent = (pos - 1) / 2;
+		if (!(QueuedEvent(parent) > eventSlots[slot].ev))
+			break;
+		SetHeapPos(pos, eventQueue[parent]);
+		pos = parent;
+	}
+	SetHeapPos(pos, slot);
+}
 
-	Event* ev = eventPool;
-	eventPool = ev->next;
+static void SiftDown(size_t pos)
+{
+	const u32 slot = eventQueue[pos];
+	const size_t size = eventQueue.size();
+	while (true)
+	{
+		size_t child = pos * 2 + 1;
+		if (child >= size)
+			break;
+		if (child + 1 < size && QueuedEvent(child) > QueuedEvent(child + 1))
+			child++;
+		if (!(eventSlots[slot].ev > QueuedEvent(child)))
+			break;
+		SetHeapPos(pos, eventQueue[child]);
+		pos = child;
+	}
+	SetHeapPos(pos, slot);
+}
+
+static void FreeSlot(u32 slot)
+{
+	eventSlots[slot].generation++;
+	freeEventSlots.push_back(slot);
+}
+
+static EventHandle PushEvent(const BaseEvent& ev)
+{
+	u32 slot;
+	if (freeEventSlots.empty())
+	{
+		slot = (u32)eventSlots.size();
+		eventSlots.emplace_back();
+		eventSlots[slot].generation = 1;
+	}
+	else
+	{
+		slot = freeEventSlots.back();
+		freeEventSlots.pop_back();
+	}
+
+	Event& ne = eventSlots[slot].ev;
+	ne.time = ev.time;
+	ne.userdata = ev.userdata;
+	ne.type = ev.type;
+	ne.fifo_order = eventFifoId++;
+
+	eventQueue.push_back(slot);
+	SiftUp(eventQueue.size() - 1);
+	return ((u64)eventSlots[slot].generation << 32) | slot;
+}
+
+// Takes the event at pos out of the queue.
+static Event RemoveQueuedEvent(size_t pos)
+{
+	const u32 slot = eventQueue[pos];
+	const u32 last = eventQueue.back();
+	eventQueue.pop_back();
+	if (pos < eventQueue.size())
+	{
+		SetHeapPos(pos, last);
+		if (pos > 0 && QueuedEvent((pos - 1) / 2) > QueuedEvent(pos))
+			SiftUp(pos);
+		else
+			SiftDown(pos);
+	}
+
+	Event ev = eventSlots[slot].ev;
+	FreeSlot(slot);
 	return ev;
 }
 
-void FreeEvent(Event* ev)
+static Event PopEvent()
 {
-	ev->next = eventPool;
-	eventPool = ev;
+	return RemoveQueuedEvent(0);
+}
+
+static std::vector<Event> GetSortedEvents()
+{
+	std::vector<Event> events;
+	events.reserve(eventQueue.size());
+	for (u32 slot : eventQueue)
+		events.push_back(eventSlots[slot].ev);
+	std::sort(events.begin(), events.end(),
+		[](const Event& left, const Event& right) { return right > left; });
+	return events;
 }
 
 static void EmptyTimedCallback(u64 userdata, int cyclesLate) {}
@@ -106,7 +228,7 @@ int RegisterEvent(const std::string& name, TimedCallback callback)
 
 void UnregisterAllEvents()
 {
-	if (first)
+	if (!eventQueue.empty())
 		PanicAlertT("Cannot unregister events with events pending");
 	event_types.clear();
 }
@@ -127,13 +249,6 @@ void Shutdown()
 	MoveEvents();
 	ClearPendingEvents();
 	UnregisterAllEvents();
-
-	while (eventPool)
-	{
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		delete ev;
-	}
 }
 
 void EventDoState(PointerWrap &p, BaseEvent* ev)
@@ -185,7 +300,35 @@ void DoState(PointerWrap &p)
 
 	MoveEvents();
 
-	p.DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, EventDoState>(first);
+	// The events are stored in ascending time order, laid out the same way the old
+	// linked-list queue was (a nonzero byte before each event, a zero byte at the end),
+	// so savestates from before the queue became a heap still load.
+	if (p.GetMode() == PointerWrap::MODE_READ)
+	{
+		ClearPendingEvents();
+		while (true)
+		{
+			u8 shouldExist = 0;
+			p.Do(shouldExist);
+			if (!shouldExist)
+				break;
+
+			BaseEvent ev;
+			EventDoState(p, &ev);
+			PushEvent(ev);
+		}
+	}
+	else
+	{
+		for (Event& ev : GetSortedEvents())
+		{
+			u8 shouldExist = 1;
+			p.Do(shouldExist);
+			EventDoState(p, &ev);
+		}
+		u8 shouldExist = 0;
+		p.Do(shouldExist);
+	}
 	p.DoMarker("CoreTimingEvents");
 }
 
@@ -204,7 +347,7 @@ u64 GetIdleTicks()
 void ScheduleEvent_Threadsafe(int cyclesIntoFuture, int event_type, u64 userdata)
 {
 	std::lock_guard<std::mutex> lk(tsWriteLock);
-	Event ne;
+	BaseEvent ne;
 	ne.time = globalTimer + cyclesIntoFuture;
 	ne.type = event_type;
 	ne.userdata = userdata;
@@ -227,42 +370,31 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata)
 
 void ClearPendingEvents()
 {
-	while (first)
-	{
-		Event *e = first->next;
-		FreeEvent(first);
-		first = e;
-	}
-}
-
-void AddEventToQueue(Event* ne)
-{
-	Event* prev = nullptr;
-	Event** pNext = &first;
-	for (;;)
-	{
-		Event*& next = *pNext;
-		if (!next || ne->time < next->time)
-		{
-			ne->next = next;
-			next = ne;
-			break;
-		}
-		prev = next;
-		pNext = &prev->next;
-	}
+	for (u32 slot : eventQueue)
+		FreeSlot(slot);
+	eventQueue.clear();
 }
 
 // This must be run ONLY from within the cpu thread
 // cyclesIntoFuture may be VERY inaccurate if called from anything else
 // than Advance
-void ScheduleEvent(int cyclesIntoFuture, int event_type, u64 userdata)
+EventHandle ScheduleEvent(int cyclesIntoFuture, int event_type, u64 userdata)
 {
-	Event *ne = GetNewEvent();
-	ne->userdata = userdata;
-	ne->type = event_type;
-	ne->time = globalTimer + cyclesIntoFuture;
-	AddEventToQueue(ne);
+	BaseEvent ne;
+	ne.userdata = userdata;
+	ne.type = event_type;
+	ne.time = globalTimer + cyclesIntoFuture;
+	return PushEvent(ne);
+}
+
+bool CancelEvent(EventHandle handle)
+{
+	const u32 slot = (u32)handle;
+	if (slot >= eventSlots.size() || eventSlots[slot].generation != (u32)(handle >> 32))
+		return false;
+
+	RemoveQueuedEvent(eventSlots[slot].heap_pos);
+	return true;
 }
 
 void RegisterAdvanceCallback(void (*callback)(int cyclesExecuted))
@@ -272,55 +404,26 @@ void RegisterAdvanceCallback(void (*callback)(int cyclesExecuted))
 
 bool IsScheduled(int event_type)
 {
-	if (!first)
-		return false;
-	Event *e = first;
-	while (e) {
-		if (e->type == event_type)
-			return true;
-		e = e->next;
-	}
-	return false;
+	return std::any_of(eventQueue.begin(), eventQueue.end(),
+		[event_type](u32 slot) { return eventSlots[slot].ev.type == event_type; });
 }
 
 void RemoveEvent(int event_type)
 {
-	if (!first)
+	auto it = std::partition(eventQueue.begin(), eventQueue.end(),
+		[event_type](u32 slot) { return eventSlots[slot].ev.type != event_type; });
+	if (it == eventQueue.end())
 		return;
 
-	while (first)
-	{
-		if (first->type == event_type)
-		{
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-
-	if (!first)
-		return;
+	for (auto removed = it; removed != eventQueue.end(); ++removed)
+		FreeSlot(*removed);
+	eventQueue.erase(it, eventQueue.end());
 
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type)
-		{
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
-	}
+	// Removing events can break the heap property, so rebuild it.
+	for (size_t pos = 0; pos < eventQueue.size(); pos++)
+		eventSlots[eventQueue[pos]].heap_pos = (u32)pos;
+	for (size_t pos = eventQueue.size() / 2; pos-- > 0;)
+		SiftDown(pos);
 }
 
 void RemoveAllEvents(int event_type)
@@ -354,22 +457,10 @@ void ProcessFifoWaitEvents()
 {
 	MoveEvents();
 
-	if (!first)
-		return;
-
-	while (first)
+	while (!eventQueue.empty() && QueuedEvent(0).time <= globalTimer)
 	{
-		if (first->time <= globalTimer)
-		{
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(globalTimer - evt->time));
-			FreeEvent(evt);
-		}
-		else
-		{
-			break;
-		}
+		Event evt = PopEvent();
+		event_types[evt.type].callback(evt.userdata, (int)(globalTimer - evt.time));
 	}
 }
 
@@ -377,13 +468,7 @@ void MoveEvents()
 {
 	BaseEvent sevt;
 	while (tsQueue.Pop(sevt))
-	{
-		Event *evt = GetNewEvent();
-		evt->time = sevt.time;
-		evt->userdata = sevt.userdata;
-		evt->type = sevt.type;
-		AddEventToQueue(evt);
-	}
+		PushEvent(sevt);
 }
 
 void Advance()
@@ -394,31 +479,22 @@ void Advance()
 	globalTimer += cyclesExecuted;
 	downcount = slicelength;
 
-	while (first)
+	while (!eventQueue.empty() && QueuedEvent(0).time <= globalTimer)
 	{
-		if (first->time <= globalTimer)
-		{
-			//LOG(POWERPC, "[Scheduler] %s     (%lld, %lld) ",
-			//             event_types[first->type].name ? event_types[first->type].name : "?", (u64)globalTimer, (u64)first->time);
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(globalTimer - evt->time));
-			FreeEvent(evt);
-		}
-		else
-		{
-			break;
-		}
+		//LOG(POWERPC, "[Scheduler] %s     (%lld, %lld) ",
+		//             event_types[QueuedEvent(0).type].name ? event_types[QueuedEvent(0).type].name : "?", (u64)globalTimer, (u64)QueuedEvent(0).time);
+		Event evt = PopEvent();
+		event_types[evt.type].callback(evt.userdata, (int)(globalTimer - evt.time));
 	}
 
-	if (!first)
+	if (eventQueue.empty())
 	{
 		WARN_LOG(POWERPC, "WARNING - no events in queue. Setting downcount to 10000");
 		downcount += 10000;
 	}
 	else
 	{
-		slicelength = (int)(first->time - globalTimer);
+		slicelength = (int)(QueuedEvent(0).time - globalTimer);
 		if (slicelength > maxSliceLength)
 			slicelength = maxSliceLength;
 		downcount = slicelength;
@@ -430,12 +506,8 @@ void Advance()
 
 void LogPendingEvents()
 {
-	Event *ptr = first;
-	while (ptr)
-	{
-		INFO_LOG(POWERPC, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %d", globalTimer, ptr->time, ptr->type);
-		ptr = ptr->next;
-	}
+	for (const Event& ev : GetSortedEvents())
+		INFO_LOG(POWERPC, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %d", globalTimer, ev.time, ev.type);
 }
 
 void Idle()
@@ -459,19 +531,17 @@ void Idle()
 
 std::string GetScheduledEventsSummary()
 {
-	Event *ptr = first;
 	std::string text = "Scheduled events\n";
 	text.reserve(1000);
-	while (ptr)
+	for (const Event& ev : GetSortedEvents())
 	{
-		unsigned int t = ptr->type;
+		unsigned int t = ev.type;
 		if (t >= event_types.size())
 			PanicAlertT("Invalid event type %i", t);
 
-		const std::string& name = event_types[ptr->type].name;
+		const std::string& name = event_types[ev.type].name;
 
-		text += StringFromFormat("%s : %" PRIi64 " %016" PRIx64 "\n", name.c_str(), ptr->time, ptr->userdata);
-		ptr = ptr->next;
+		text += StringFromFormat("%s : %" PRIi64 " %016" PRIx64 "\n", name.c_str(), ev.time, ev.userdata);
 	}
 	return text;
 }
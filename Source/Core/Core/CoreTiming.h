@@ -39,12 +39,20 @@ void DoState(PointerWrap &p);
 int RegisterEvent(const std::string& name, TimedCallback callback);
 void UnregisterAllEvents();
 
+// Identifies one scheduled event, so that it can be cancelled without touching
+// the other events of its type. Handles don't survive loading a savestate, so
+// events that have to be cancelled after a load should use RemoveEvent.
+typedef u64 EventHandle;
+
 // userdata MAY NOT CONTAIN POINTERS. userdata might get written and reloaded from disk,
 // when we implement state saves.
-void ScheduleEvent(int cyclesIntoFuture, int event_type, u64 userdata=0);
+EventHandle ScheduleEvent(int cyclesIntoFuture, int event_type, u64 userdata=0);
 void ScheduleEvent_Threadsafe(int cyclesIntoFuture, int event_type, u64 userdata=0);
 void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata=0);
 
+// Returns false if the event has already run or been cancelled.
+bool CancelEvent(EventHandle handle);
+
 // We only permit one event of each type in the queue at a time.
 void RemoveEvent(int event_type);
 void RemoveAllEvents(int event_type);
@@ -370,23 +370,6 @@ void DSPCore_Step()
 void CompileCurrent()
 {
 	dspjit->Compile(g_dsp.pc);
-
-	bool retry = true;
-
-	while (retry)
-	{
-		retry = false;
-		for (u16 i = 0x0000; i < 0xffff; ++i)
-		{
-			if (!dspjit->unresolvedJumps[i].empty())
-			{
-				u16 addrToCompile = dspjit->unresolvedJumps[i].front();
-				dspjit->Compile(addrToCompile);
-				if (!dspjit->unresolvedJumps[i].empty())
-					retry = true;
-			}
-		}
-	}
 }
 
 u16 DSPCore_ReadRegister(int reg)
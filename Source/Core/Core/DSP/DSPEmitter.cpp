@@ -2,8 +2,12 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <cinttypes>
 #include <cstring>
 
+#include "Common/Hash.h"
+#include "Common/JitRegister.h"
+
 #include "Core/DSP/DSPAnalyzer.h"
 #include "Core/DSP/DSPCore.h"
 #include "Core/DSP/DSPEmitter.h"
@@ -14,6 +18,11 @@
 #define MAX_BLOCK_SIZE 250
 #define DSP_IDLE_SKIP_CYCLES 0x1000
 
+// Free code space below which the cached ucodes are thrown away when a new one
+// is loaded, and below which a compile asks for the code space to be reset.
+#define UCODE_CACHE_MIN_SPACE 0x40000
+#define COMPILE_MIN_SPACE     0x10000
+
 using namespace Gen;
 
 DSPEmitter::DSPEmitter() : gpr(*this), storeIndex(-1), storeIndex2(-1)
@@ -32,14 +41,13 @@ DSPEmitter::DSPEmitter() : gpr(*this), storeIndex(-1), storeIndex2(-1)
 
 	CompileDispatcher();
 	stubEntryPoint = CompileStub();
+	linkStubEntryPoint = CompileLinkStub();
 
 	//clear all of the block references
-	for (int i = 0x0000; i < MAX_BLOCKS; i++)
-	{
-		blocks[i] = (DSPCompiledCode)stubEntryPoint;
-		blockLinks[i] = nullptr;
-		blockSize[i] = 0;
-	}
+	ResetBlocks();
+
+	m_iram.assign(g_dsp.iram, g_dsp.iram + DSP_IRAM_SIZE);
+	m_iram_hash = GetMurmurHash3((const u8*)g_dsp.iram, DSP_IRAM_BYTE_SIZE, 0);
 }
 
 DSPEmitter::~DSPEmitter()
@@ -50,31 +58,86 @@ DSPEmitter::~DSPEmitter()
 	FreeCodeSpace();
 }
 
-void DSPEmitter::ClearIRAM()
+void DSPEmitter::ResetBlocks(int first, int last)
 {
-	for (int i = 0x0000; i < 0x1000; i++)
+	for (int i = first; i <= last; i++)
 	{
 		blocks[i] = (DSPCompiledCode)stubEntryPoint;
-		blockLinks[i] = nullptr;
+		blockLinks[i] = linkStubEntryPoint;
 		blockSize[i] = 0;
-		unresolvedJumps[i].clear();
 	}
-	g_dsp.reset_dspjit_codespace = true;
 }
 
+// Blocks outside IRAM stay valid, and as links go through blockLinks they
+// reach whichever IRAM blocks are current.
+void DSPEmitter::SaveBlocks(CachedUCode* ucode)
+{
+	ucode->iram = m_iram;
+	ucode->blocks.clear();
+	for (int i = 0x0000; i < DSP_IRAM_SIZE; i++)
+	{
+		if (blocks[i] == (DSPCompiledCode)stubEntryPoint)
+			continue;
+
+		CachedBlock block;
+		block.addr = (u16)i;
+		block.size = blockSize[i];
+		block.code = blocks[i];
+		block.link = blockLinks[i];
+		ucode->blocks.push_back(block);
+	}
+}
+
+void DSPEmitter::LoadBlocks(const CachedUCode& ucode)
+{
+	ResetBlocks(0x0000, DSP_IRAM_SIZE - 1);
+	for (const CachedBlock& block : ucode.blocks)
+	{
+		blocks[block.addr] = block.code;
+		blockLinks[block.addr] = block.link;
+		blockSize[block.addr] = block.size;
+	}
+}
+
+// Called when new code has been copied to IRAM, possibly from a block that is
+// still running. Only the tables are switched; the code of the old ucode stays
+// where it is until the next ClearIRAMandDSPJITCodespaceReset.
+void DSPEmitter::ClearIRAM()
+{
+	const u64 hash = GetMurmurHash3((const u8*)g_dsp.iram, DSP_IRAM_BYTE_SIZE, 0);
+	if (hash == m_iram_hash && !memcmp(m_iram.data(), g_dsp.iram, DSP_IRAM_BYTE_SIZE))
+		return;
+
+	SaveBlocks(&m_ucode_cache[m_iram_hash]);
+
+	auto cached = m_ucode_cache.find(hash);
+	if (cached != m_ucode_cache.end() && !memcmp(cached->second.iram.data(), g_dsp.iram, DSP_IRAM_BYTE_SIZE))
+	{
+		INFO_LOG(DSPLLE, "Reusing %u compiled blocks of ucode %016" PRIx64, (u32)cached->second.blocks.size(), hash);
+		LoadBlocks(cached->second);
+	}
+	else
+	{
+		ResetBlocks(0x0000, DSP_IRAM_SIZE - 1);
+	}
+
+	m_iram.assign(g_dsp.iram, g_dsp.iram + DSP_IRAM_SIZE);
+	m_iram_hash = hash;
+
+	if (GetSpaceLeft() < UCODE_CACHE_MIN_SPACE)
+		g_dsp.reset_dspjit_codespace = true;
+}
+
+// Only safe while no compiled code is running.
 void DSPEmitter::ClearIRAMandDSPJITCodespaceReset()
 {
 	ClearCodeSpace();
 	CompileDispatcher();
 	stubEntryPoint = CompileStub();
+	linkStubEntryPoint = CompileLinkStub();
 
-	for (int i = 0x0000; i < 0x10000; i++)
-	{
-		blocks[i] = (DSPCompiledCode)stubEntryPoint;
-		blockLinks[i] = nullptr;
-		blockSize[i] = 0;
-		unresolvedJumps[i].clear();
-	}
+	ResetBlocks();
+	m_ucode_cache.clear();
 	g_dsp.reset_dspjit_codespace = false;
 }
 
@@ -200,9 +263,12 @@ void DSPEmitter::EmitInstruction(UDSPInstruction inst)
 
 void DSPEmitter::Compile(u16 start_addr)
 {
+	// The code space can't be reset while blocks run, so ask for it in time.
+	if (GetSpaceLeft() < COMPILE_MIN_SPACE)
+		g_dsp.reset_dspjit_codespace = true;
+
 	// Remember the current block address for later
 	startAddr = start_addr;
-	unresolvedJumps[start_addr].clear();
 
 	const u8 *entryPoint = AlignCode16();
 
@@ -236,9 +302,6 @@ void DSPEmitter::Compile(u16 start_addr)
 		blockSize[start_addr]++;
 		compilePC += opcode->size;
 
-		// If the block was trying to link into itself, remove the link
-		unresolvedJumps[start_addr].remove(compilePC);
-
 		fixup_pc = true;
 
 		// Handle loop condition, only if current instruction was flagged as a loop destination
@@ -324,33 +387,15 @@ void DSPEmitter::Compile(u16 start_addr)
 	if (fixup_pc)
 	{
 		MOV(16, M(&(g_dsp.pc)), Imm16(compilePC));
+		// Go on with the next block without a trip through the dispatcher, unless
+		// that would run off the end of IRAM or IROM.
+		if ((compilePC & 0xF000) == (start_addr & 0xF000))
+			WriteBlockLink(compilePC);
 	}
 
 	blocks[start_addr] = (DSPCompiledCode)entryPoint;
 
-	// Mark this block as a linkable destination if it does not contain
-	// any unresolved CALL's
-	if (unresolvedJumps[start_addr].empty())
-	{
-		blockLinks[start_addr] = blockLinkEntry;
-
-		for (u16 i = 0x0000; i < 0xffff; ++i)
-		{
-			if (!unresolvedJumps[i].empty())
-			{
-				// Check if there were any blocks waiting for this block to be linkable
-				size_t size = unresolvedJumps[i].size();
-				unresolvedJumps[i].remove(start_addr);
-				if (unresolvedJumps[i].size() < size)
-				{
-					// Mark the block to be recompiled again
-					blocks[i] = (DSPCompiledCode)stubEntryPoint;
-					blockLinks[i] = nullptr;
-					blockSize[i] = 0;
-				}
-			}
-		}
-	}
+	blockLinks[start_addr] = blockLinkEntry;
 
 	if (blockSize[start_addr] == 0)
 	{
@@ -370,6 +415,8 @@ void DSPEmitter::Compile(u16 start_addr)
 		MOV(16, R(EAX), Imm16(blockSize[start_addr]));
 	}
 	JMP(returnDispatcher, true);
+
+	JitRegister::Register(entryPoint, (u32)(GetCodePtr() - entryPoint), "JIT_DSP_%04x", start_addr);
 }
 
 const u8 *DSPEmitter::CompileStub()
@@ -378,6 +425,20 @@ const u8 *DSPEmitter::CompileStub()
 	ABI_CallFunction((void *)&CompileCurrent);
 	XOR(32, R(EAX), R(EAX)); // Return 0 cycles executed
 	JMP(returnDispatcher);
+	JitRegister::Register(entryPoint, (u32)(GetCodePtr() - entryPoint), "JIT_DSP_CompileStub");
+	return entryPoint;
+}
+
+// Entered like a linked block, with the registers loaded and g_dsp.pc set to the
+// destination, which the dispatcher then compiles.
+const u8 *DSPEmitter::CompileLinkStub()
+{
+	const u8 *entryPoint = AlignCode16();
+	gpr.loadRegs(false);
+	gpr.saveRegs();
+	XOR(32, R(EAX), R(EAX)); // The cycles were taken off by the link
+	JMP(returnDispatcher);
+	JitRegister::Register(entryPoint, (u32)(GetCodePtr() - entryPoint), "JIT_DSP_LinkStub");
 	return entryPoint;
 }
 
@@ -427,4 +488,6 @@ void DSPEmitter::CompileDispatcher()
 	//MOV(32, M(&cyclesLeft), Imm32(0));
 	ABI_PopAllCalleeSavedRegsAndAdjustStack();
 	RET();
+
+	JitRegister::Register(enterDispatcher, (u32)(GetCodePtr() - enterDispatcher), "JIT_DSP_Dispatcher");
 }
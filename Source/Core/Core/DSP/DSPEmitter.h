@@ -4,7 +4,8 @@
 
 #pragma once
 
-#include <list>
+#include <map>
+#include <vector>
 
 #include "Common/x64ABI.h"
 #include "Common/x64Emitter.h"
@@ -32,8 +33,10 @@ public:
 
 	void CompileDispatcher();
 	Block CompileStub();
+	Block CompileLinkStub();
 	void Compile(u16 start_addr);
 	void ClearCallFlag();
+	void WriteBlockLink(u16 dest);
 
 	bool FlagsNeeded();
 
@@ -245,19 +248,45 @@ public:
 	const u8 *enterDispatcher;
 	const u8 *reenterDispatcher;
 	const u8 *stubEntryPoint;
+	// Where links to blocks that haven't been compiled yet go.
+	const u8 *linkStubEntryPoint;
 	const u8 *returnDispatcher;
 	u16 compilePC;
 	u16 startAddr;
 	Block *blockLinks;
 	u16 *blockSize;
-	std::list<u16> unresolvedJumps[MAX_BLOCKS];
 
 	DSPJitRegCache gpr;
 private:
+	// The compiled blocks of one IRAM ucode. Games switch between a few ucodes,
+	// so when one comes back its blocks are reused instead of compiled again.
+	struct CachedBlock
+	{
+		u16 addr;
+		u16 size;
+		DSPCompiledCode code;
+		Block link;
+	};
+	struct CachedUCode
+	{
+		// Compared on a hit, so a hash collision can't run the wrong code.
+		std::vector<u16> iram;
+		std::vector<CachedBlock> blocks;
+	};
+
+	void ResetBlocks(int first = 0x0000, int last = MAX_BLOCKS - 1);
+	void SaveBlocks(CachedUCode* ucode);
+	void LoadBlocks(const CachedUCode& ucode);
+
 	DSPCompiledCode *blocks;
 	Block blockLinkEntry;
 	u16 compileSR;
 
+	std::map<u64, CachedUCode> m_ucode_cache;
+	// The IRAM the blocks in the tables were compiled from.
+	std::vector<u16> m_iram;
+	u64 m_iram_hash;
+
 	// The index of the last stored ext value (compile time).
 	int storeIndex;
 	int storeIndex2;
@@ -90,42 +90,53 @@ static void WriteBranchExit(DSPEmitter& emitter)
 	emitter.gpr.flushRegs(c,false);
 }
 
-static void WriteBlockLink(DSPEmitter& emitter, u16 dest)
+// Jump to the block at dest without going through the dispatcher. The jump goes
+// through blockLinks, so dest doesn't have to be compiled yet and may be
+// replaced later. g_dsp.pc has to be set to dest already.
+void DSPEmitter::WriteBlockLink(u16 dest)
 {
-	// Jump directly to the called block if it has already been compiled.
-	if (!(dest >= emitter.startAddr && dest <= emitter.compilePC))
-	{
-		if (emitter.blockLinks[dest] != nullptr )
-		{
-			emitter.gpr.flushRegs();
-			// Check if we have enough cycles to execute the next block
-			emitter.MOV(16, R(ECX), M(&cyclesLeft));
-			emitter.CMP(16, R(ECX), Imm16(emitter.blockSize[emitter.startAddr] + emitter.blockSize[dest]));
-			FixupBranch notEnoughCycles = emitter.J_CC(CC_BE);
-
-			emitter.SUB(16, R(ECX), Imm16(emitter.blockSize[emitter.startAddr]));
-			emitter.MOV(16, M(&cyclesLeft), R(ECX));
-			emitter.JMP(emitter.blockLinks[dest], true);
-			emitter.SetJumpTarget(notEnoughCycles);
-		}
-		else
-		{
-			// The destination has not been compiled yet.  Add it to the list
-			// of blocks that this block is waiting on.
-			emitter.unresolvedJumps[emitter.startAddr].push_back(dest);
-		}
-	}
+	// Idle skipping blocks have to go back to the dispatcher to be charged for it.
+	if (DSPAnalyzer::code_flags[startAddr] & DSPAnalyzer::CODE_IDLE_SKIP)
+		return;
+
+	gpr.flushRegs();
+	// Check if we have enough cycles to execute the next block
+	MOV(16, R(ECX), M(&cyclesLeft));
+	SUB(16, R(ECX), Imm16(blockSize[startAddr]));
+	FixupBranch noCyclesLeft = J_CC(CC_BE);
+#if _M_X86_32
+	CMP(16, R(ECX), M(&blockSize[dest]));
+#else
+	MOV(64, R(RAX), ImmPtr(&blockSize[dest]));
+	CMP(16, R(ECX), MatR(RAX));
+#endif
+	FixupBranch notEnoughCycles = J_CC(CC_BE);
+
+	MOV(16, M(&cyclesLeft), R(ECX));
+#if _M_X86_32
+	JMPptr(M(&blockLinks[dest]));
+#else
+	MOV(64, R(RAX), ImmPtr(&blockLinks[dest]));
+	JMPptr(MatR(RAX));
+#endif
+	SetJumpTarget(noCyclesLeft);
+	SetJumpTarget(notEnoughCycles);
+}
+
+static bool IsInCurrentBlock(DSPEmitter& emitter, u16 dest)
+{
+	return dest >= emitter.startAddr && dest <= emitter.compilePC;
 }
 
 void r_jcc(const UDSPInstruction opc, DSPEmitter& emitter)
 {
 	u16 dest = dsp_imem_read(emitter.compilePC + 1);
-	const DSPOPCTemplate *opcode = GetOpTemplate(opc);
 
-	// If the block is unconditional, attempt to link block
-	if (opcode->uncond_branch)
-		WriteBlockLink(emitter, dest);
+	// Conditional jumps are only linked on the taken path, the other one
+	// carries on with the block.
 	emitter.MOV(16, M(&(g_dsp.pc)), Imm16(dest));
+	if (!IsInCurrentBlock(emitter, dest))
+		emitter.WriteBlockLink(dest);
 	WriteBranchExit(emitter);
 }
 // Generic jmp implementation
@@ -166,12 +177,10 @@ void r_call(const UDSPInstruction opc, DSPEmitter& emitter)
 	emitter.MOV(16, R(DX), Imm16(emitter.compilePC + 2));
 	emitter.dsp_reg_store_stack(DSP_STACK_C);
 	u16 dest = dsp_imem_read(emitter.compilePC + 1);
-	const DSPOPCTemplate *opcode = GetOpTemplate(opc);
 
-	// If the block is unconditional, attempt to link block
-	if (opcode->uncond_branch)
-		WriteBlockLink(emitter, dest);
 	emitter.MOV(16, M(&(g_dsp.pc)), Imm16(dest));
+	if (!IsInCurrentBlock(emitter, dest))
+		emitter.WriteBlockLink(dest);
 	WriteBranchExit(emitter);
 }
 // Generic call implementation
@@ -50,12 +50,15 @@ This file mainly deals with the [Drive I/F], however [AIDFR] controls
   TODO maybe the files should be merged?
 */
 
+#include <algorithm>
+
+#include "AudioCommon/AudioCommon.h"
+
 #include "Common/Common.h"
 #include "Common/MathUtil.h"
 
 #include "Core/CoreTiming.h"
 #include "Core/HW/AudioInterface.h"
-#include "Core/HW/CPU.h"
 #include "Core/HW/DVDInterface.h"
 #include "Core/HW/MMIO.h"
 #include "Core/HW/ProcessorInterface.h"
@@ -130,6 +133,9 @@ static u64 g_CPUCyclesPerSample = 0xFFFFFFFFFFFULL;
 static unsigned int g_AISSampleRate = 48000;
 static unsigned int g_AIDSampleRate = 32000;
 
+// Most samples sent to the mixer at once while streaming
+static const u64 STREAMING_UPDATE_SAMPLES = 256;
+
 void DoState(PointerWrap &p)
 {
 	p.DoPOD(m_Control);
@@ -145,8 +151,9 @@ void DoState(PointerWrap &p)
 static void GenerateAudioInterrupt();
 static void UpdateInterrupts();
 static void IncreaseSampleCount(const u32 _uAmount);
-void ReadStreamBlock(s16* _pPCM);
+static void SendStreamingSamples(u32 num_samples);
 u64 GetAIPeriod();
+static int GetAIUpdatePeriod();
 int et_AI;
 
 void Init()
@@ -209,7 +216,7 @@ void RegisterMMIO(MMIO::Mapping* mmio, u32 base)
 				DVDInterface::g_bStream = tmpAICtrl.PSTAT;
 
 				CoreTiming::RemoveEvent(et_AI);
-				CoreTiming::ScheduleEvent(((int)GetAIPeriod() / 2), et_AI);
+				CoreTiming::ScheduleEvent(GetAIUpdatePeriod(), et_AI);
 			}
 
 			// AI Interrupt
@@ -250,7 +257,7 @@ void RegisterMMIO(MMIO::Mapping* mmio, u32 base)
 		MMIO::ComplexWrite<u32>([](u32, u32 val) {
 			m_InterruptTiming = val;
 			CoreTiming::RemoveEvent(et_AI);
-			CoreTiming::ScheduleEvent(((int)GetAIPeriod() / 2), et_AI);
+			CoreTiming::ScheduleEvent(GetAIUpdatePeriod(), et_AI);
 		})
 	);
 }
@@ -278,125 +285,47 @@ void Callback_GetSampleRate(unsigned int &_AISampleRate, unsigned int &_DACSampl
 	_DACSampleRate = g_AIDSampleRate;
 }
 
-// Callback for the disc streaming
-// WARNING - called from audio thread
-unsigned int Callback_GetStreaming(short* _pDestBuffer, unsigned int _numSamples, unsigned int _sampleRate)
+static void ReadStreamBlock(s16 *_pPCM)
 {
-	if (m_Control.PSTAT && !CCPU::IsStepping())
+	u8 tempADPCM[NGCADPCM::ONE_BLOCK_SIZE];
+	if (DVDInterface::DVDReadADPCM(tempADPCM, NGCADPCM::ONE_BLOCK_SIZE))
 	{
-		static int pos = 0;
-		static short pcm[NGCADPCM::SAMPLES_PER_BLOCK*2];
-		const int lvolume = m_Volume.left;
-		const int rvolume = m_Volume.right;
-
-		if (g_AISSampleRate == 48000 && _sampleRate == 32000)
-		{
-			_dbg_assert_msg_(AUDIO_INTERFACE, !(_numSamples & 1), "Number of Samples: %i must be even!", _numSamples);
-			_numSamples = _numSamples * 3 / 2;
-		}
-
-		int pcm_l = 0, pcm_r = 0;
-		for (unsigned int i = 0; i < _numSamples; i++)
-		{
-			if (pos == 0)
-				ReadStreamBlock(pcm);
-
-			if (g_AISSampleRate == 48000 && _sampleRate == 32000) //downsample 48>32
-			{
-				if (i % 3)
-				{
-					pcm_l = (((pcm_l + (int)pcm[pos*2]) / 2  * lvolume) >> 8) + (int)(*_pDestBuffer);
-					MathUtil::Clamp(&pcm_l, -32767, 32767);
-					*_pDestBuffer++ = pcm_l;
-
-					pcm_r = (((pcm_r + (int)pcm[pos*2+1]) / 2 * rvolume) >> 8) + (int)(*_pDestBuffer);
-					MathUtil::Clamp(&pcm_r, -32767, 32767);
-					*_pDestBuffer++ = pcm_r;
-				}
-				pcm_l = pcm[pos*2];
-				pcm_r = pcm[pos*2+1];
-
-				pos++;
-			}
-			else if (g_AISSampleRate == 32000 && _sampleRate == 48000) //upsample 32>48
-			{
-				//starts with one sample of 0
-				const u32 ratio = (u32)( 65536.0f * 32000.0f / (float)_sampleRate );
-				static u32 frac = 0;
-
-				static s16 l1 = 0;
-				static s16 l2 = 0;
-
-				if (frac >= 0x10000 || frac == 0)
-				{
-					frac &= 0xffff;
-
-					l1 = l2;           //current
-					l2 = pcm[pos * 2]; //next
-				}
-
-				pcm_l = ((l1 << 16) + (l2 - l1) * (u16)frac)  >> 16;
-				pcm_r = ((l1 << 16) + (l2 - l1) * (u16)frac)  >> 16;
-
-
-				pcm_l = (pcm_l * lvolume >> 8) + (int)(*_pDestBuffer);
-				MathUtil::Clamp(&pcm_l, -32767, 32767);
-				*_pDestBuffer++ = pcm_l;
-
-				pcm_r = (pcm_r * lvolume >> 8) + (int)(*_pDestBuffer);
-				MathUtil::Clamp(&pcm_r, -32767, 32767);
-				*_pDestBuffer++ = pcm_r;
-
-				frac += ratio;
-				pos += frac >> 16;
-
-			}
-			else //1:1 no resampling
-			{
-				pcm_l = (((int)pcm[pos*2] * lvolume) >> 8) + (int)(*_pDestBuffer);
-				MathUtil::Clamp(&pcm_l, -32767, 32767);
-				*_pDestBuffer++ = pcm_l;
-
-				pcm_r = (((int)pcm[pos*2+1] * rvolume) >> 8) + (int)(*_pDestBuffer);
-				MathUtil::Clamp(&pcm_r, -32767, 32767);
-				*_pDestBuffer++ = pcm_r;
-
-				pos++;
-			}
-
-			if (pos == NGCADPCM::SAMPLES_PER_BLOCK)
-				pos = 0;
-		}
+		NGCADPCM::DecodeBlock(_pPCM, tempADPCM);
 	}
 	else
 	{
-		// Don't overwrite existed sample data
-		/*
-		for (unsigned int i = 0; i < _numSamples * 2; i++)
-		{
-			_pDestBuffer[i] = 0; //silence!
-		}
-		*/
+		memset(_pPCM, 0, NGCADPCM::SAMPLES_PER_BLOCK * 2 * sizeof(s16));
 	}
 
-	return _numSamples;
 }
 
-// WARNING - called from audio thread
-void ReadStreamBlock(s16 *_pPCM)
+// Decodes as many streamed samples as the sample counter advanced by and
+// hands them to the mixer with the volume applied.
+static void SendStreamingSamples(u32 num_samples)
 {
-	u8 tempADPCM[NGCADPCM::ONE_BLOCK_SIZE];
-	if (DVDInterface::DVDReadADPCM(tempADPCM, NGCADPCM::ONE_BLOCK_SIZE))
-	{
-		NGCADPCM::DecodeBlock(_pPCM, tempADPCM);
-	}
-	else
+	static short pcm[NGCADPCM::SAMPLES_PER_BLOCK * 2];
+	static u32 pos = 0;
+
+	const int lvolume = m_Volume.left;
+	const int rvolume = m_Volume.right;
+
+	short buffer[NGCADPCM::SAMPLES_PER_BLOCK * 2];
+	while (num_samples)
 	{
-		memset(_pPCM, 0, NGCADPCM::SAMPLES_PER_BLOCK*2);
-	}
+		if (pos == 0)
+			ReadStreamBlock(pcm);
 
-	// our whole streaming code is "faked" ... so it shouldn't increase the sample counter
-	// streaming will never work correctly this way, but at least the program will think all is alright.
+		const u32 count = std::min<u32>(num_samples, NGCADPCM::SAMPLES_PER_BLOCK - pos);
+		for (u32 i = 0; i < count; ++i)
+		{
+			buffer[i * 2] = (pcm[(pos + i) * 2] * lvolume) >> 8;
+			buffer[i * 2 + 1] = (pcm[(pos + i) * 2 + 1] * rvolume) >> 8;
+		}
+		AudioCommon::SendStreamingBuffer(buffer, count);
+
+		pos = (pos + count) % NGCADPCM::SAMPLES_PER_BLOCK;
+		num_samples -= count;
+	}
 }
 
 static void IncreaseSampleCount(const u32 _iAmount)
@@ -416,6 +345,11 @@ unsigned int GetAIDSampleRate()
 	return g_AIDSampleRate;
 }
 
+unsigned int GetAISSampleRate()
+{
+	return g_AISSampleRate;
+}
+
 void Update(u64 userdata, int cyclesLate)
 {
 	if (m_Control.PSTAT)
@@ -426,8 +360,9 @@ void Update(u64 userdata, int cyclesLate)
 			const u32 Samples = static_cast<u32>(Diff / g_CPUCyclesPerSample);
 			g_LastCPUTime += Samples * g_CPUCyclesPerSample;
 			IncreaseSampleCount(Samples);
+			SendStreamingSamples(Samples);
 		}
-		CoreTiming::ScheduleEvent(((int)GetAIPeriod() / 2) - cyclesLate, et_AI);
+		CoreTiming::ScheduleEvent(GetAIUpdatePeriod() - cyclesLate, et_AI);
 	}
 }
 
@@ -439,4 +374,11 @@ u64 GetAIPeriod()
 	return period;
 }
 
+static int GetAIUpdatePeriod()
+{
+	// The streamed samples are sent to the mixer from Update, so it has to
+	// run often enough to keep the mixer's buffer filled.
+	return (int)std::min(GetAIPeriod() / 2, STREAMING_UPDATE_SAMPLES * g_CPUCyclesPerSample);
+}
+
 } // end of namespace AudioInterface
@@ -0,0 +1,108 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include "Common/Common.h"
+#include "Core/HW/DSPHLE/UCodes/AXMix.h"
+
+#ifdef _M_X86
+#include <emmintrin.h>
+#endif
+
+namespace AXMix
+{
+
+static inline s16 ScaleSample(s16 sample, u16 volume)
+{
+	return (s16)(((s32)sample * volume) >> 15);
+}
+
+#ifdef _M_X86
+
+// The volumes of the next 8 samples, and how much they go up by every 8.
+static inline void VolumeVectors(u16 volume, u16 volume_delta, __m128i* volumes, __m128i* step)
+{
+	const __m128i delta = _mm_set1_epi16(volume_delta);
+	*volumes = _mm_add_epi16(_mm_set1_epi16(volume), _mm_mullo_epi16(delta, _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7)));
+	*step = _mm_slli_epi16(delta, 3);
+}
+
+// ScaleSample on 8 samples. The full product fits in 32 bits, and only bits 15 to 30
+// are kept. mulhi takes the volume as signed, which leaves the high half short by
+// the sample when the volume is 0x8000 or more.
+static inline __m128i ScaleSamples(__m128i samples, __m128i volumes)
+{
+	const __m128i lo = _mm_mullo_epi16(samples, volumes);
+	const __m128i hi = _mm_add_epi16(_mm_mulhi_epi16(samples, volumes),
+	                                 _mm_and_si128(samples, _mm_srai_epi16(volumes, 15)));
+	return _mm_or_si128(_mm_srli_epi16(lo, 15), _mm_slli_epi16(hi, 1));
+}
+
+#endif
+
+void ApplyVolume(s16* samples, u32 count, u16* volume, u16 volume_delta)
+{
+	u16 vol = *volume;
+	u32 i = 0;
+
+#ifdef _M_X86
+	__m128i volumes, step;
+	VolumeVectors(vol, volume_delta, &volumes, &step);
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i in = _mm_loadu_si128((const __m128i*)(samples + i));
+		_mm_storeu_si128((__m128i*)(samples + i), ScaleSamples(in, volumes));
+		volumes = _mm_add_epi16(volumes, step);
+	}
+	vol += (u16)(i * volume_delta);
+#endif
+
+	for (; i < count; ++i)
+	{
+		samples[i] = ScaleSample(samples[i], vol);
+		vol += volume_delta;
+	}
+
+	*volume = vol;
+}
+
+void MixAdd(int* out, const s16* input, u32 count, u16* volume, u16 volume_delta, s16* last_sample)
+{
+	u16 vol = *volume;
+	u32 i = 0;
+
+#ifdef _M_X86
+	if (count >= 8)
+	{
+		__m128i volumes, step;
+		VolumeVectors(vol, volume_delta, &volumes, &step);
+		__m128i scaled = _mm_setzero_si128();
+		for (; i + 8 <= count; i += 8)
+		{
+			scaled = ScaleSamples(_mm_loadu_si128((const __m128i*)(input + i)), volumes);
+			volumes = _mm_add_epi16(volumes, step);
+
+			// Sign extend to 32 bits, by putting each sample in the top half first.
+			const __m128i scaled_lo = _mm_srai_epi32(_mm_unpacklo_epi16(scaled, scaled), 16);
+			const __m128i scaled_hi = _mm_srai_epi32(_mm_unpackhi_epi16(scaled, scaled), 16);
+			__m128i* dst = (__m128i*)(out + i);
+			_mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), scaled_lo));
+			_mm_storeu_si128(dst + 1, _mm_add_epi32(_mm_loadu_si128(dst + 1), scaled_hi));
+		}
+		*last_sample = (s16)_mm_extract_epi16(scaled, 7);
+		vol += (u16)(i * volume_delta);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		const s16 sample = ScaleSample(input[i], vol);
+		out[i] += sample;
+		vol += volume_delta;
+		*last_sample = sample;
+	}
+
+	*volume = vol;
+}
+
+}  // namespace
@@ -0,0 +1,23 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+// The per-sample volume loops of AX voice processing, shared by AX GC and AX
+// Wii. A sample is scaled as (sample * volume) >> 15 truncated to 16 bits, with
+// the volume going up by volume_delta (wrapping) after each sample, exactly
+// like the DSP does it.
+namespace AXMix
+{
+
+// Scales samples in place. volume is updated to the volume after the last sample.
+void ApplyVolume(s16* samples, u32 count, u16* volume, u16 volume_delta);
+
+// Adds the scaled input to out. last_sample gets the last scaled sample,
+// which is what AX keeps for depopping.
+void MixAdd(int* out, const s16* input, u32 count, u16* volume, u16 volume_delta, s16* last_sample);
+
+}  // namespace
@@ -12,6 +12,7 @@
 #include "Core/VolumeHandler.h"
 #include "Core/HW/AudioInterface.h"
 #include "Core/HW/DVDInterface.h"
+#include "Core/HW/DVDThread.h"
 #include "Core/HW/Memmap.h"
 #include "Core/HW/MMIO.h"
 #include "Core/HW/ProcessorInterface.h"
@@ -252,6 +253,8 @@ void DoState(PointerWrap &p)
 
 	p.Do(g_last_read_offset);
 	p.Do(g_last_read_time);
+
+	DVDThread::DoState(p);
 }
 
 void TransferComplete(u64 userdata, int cyclesLate)
@@ -286,10 +289,13 @@ void Init()
 	insertDisc = CoreTiming::RegisterEvent("InsertDisc", InsertDiscCallback);
 
 	tc = CoreTiming::RegisterEvent("TransferComplete", TransferComplete);
+
+	DVDThread::Start();
 }
 
 void Shutdown()
 {
+	DVDThread::Stop();
 }
 
 void SetDiscInside(bool _DiscInside)
@@ -309,6 +315,7 @@ bool IsDiscInside()
 void EjectDiscCallback(u64 userdata, int cyclesLate)
 {
 	// Empty the drive
+	DVDThread::WaitUntilIdle();
 	SetDiscInside(false);
 	SetLidOpen();
 	VolumeHandler::EjectVolume();
@@ -319,6 +326,7 @@ void InsertDiscCallback(u64 userdata, int cyclesLate)
 	std::string& SavedFileName = SConfig::GetInstance().m_LocalCoreStartupParameter.m_strFilename;
 	std::string *_FileName = (std::string *)userdata;
 
+	DVDThread::WaitUntilIdle();
 	if (!VolumeHandler::SetVolumeName(*_FileName))
 	{
 		// Put back the old one
@@ -734,6 +742,9 @@ void ExecuteCommand()
 						ticksUntilTC /= 8;
 					}
 
+					// The data is read on the DVD thread in the meantime and copied to
+					// memory right before the transfer complete event.
+					DVDThread::StartRead(iDVDOffset, m_DIMAR.Address, m_DILENGTH.Length, true, (int)ticksUntilTC);
 					CoreTiming::ScheduleEvent((int)ticksUntilTC, tc);
 
 					// Early return; we'll finish executing the command in FinishExecuteRead.
@@ -1046,12 +1057,7 @@ void ExecuteCommand()
 
 void FinishExecuteRead()
 {
-	u32 iDVDOffset = m_DICMDBUF[1].Hex << 2;
-
-	if (!DVDRead(iDVDOffset, m_DIMAR.Address, m_DILENGTH.Length))
-	{
-		PanicAlertT("Can't read from DVD_Plugin - DVD-Interface: Fatal Error");
-	}
+	// The data was already copied by the DVD thread's event, which ran just before.
 
 	// transfer is done
 	m_DICR.TSTART = 0;
@@ -0,0 +1,208 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include "Common/ChunkFile.h"
+#include "Common/Common.h"
+#include "Common/StdConditionVariable.h"
+#include "Common/StdMutex.h"
+#include "Common/StdThread.h"
+#include "Common/Thread.h"
+
+#include "Core/CoreTiming.h"
+#include "Core/VolumeHandler.h"
+#include "Core/HW/DVDThread.h"
+#include "Core/HW/Memmap.h"
+
+namespace DVDThread
+{
+
+struct ReadRequest
+{
+	u64 id;
+	u64 dvd_offset;
+	u32 output_address;
+	u32 length;
+	bool decrypt;
+
+	// Set by the DVD thread once the data is in buffer.
+	bool done;
+	bool result;
+	std::vector<u8> buffer;
+
+	void DoState(PointerWrap &p)
+	{
+		p.Do(id);
+		p.Do(dvd_offset);
+		p.Do(output_address);
+		p.Do(length);
+		p.Do(decrypt);
+		p.Do(done);
+		p.Do(result);
+		p.Do(buffer);
+	}
+};
+
+static int s_finish_read;
+
+// Requests stay in here from StartRead until their finish event has copied the
+// data out. The DVD thread works through them in order.
+static std::deque<ReadRequest> s_requests;
+static u64 s_next_id;
+
+static std::mutex s_lock;
+static std::condition_variable s_request_cond;
+static std::condition_variable s_done_cond;
+static std::thread s_thread;
+static bool s_quit;
+
+static ReadRequest* FindRequest(u64 id)
+{
+	for (ReadRequest& request : s_requests)
+	{
+		if (request.id == id)
+			return &request;
+	}
+	return nullptr;
+}
+
+static ReadRequest* FindPendingRequest()
+{
+	for (ReadRequest& request : s_requests)
+	{
+		if (!request.done)
+			return &request;
+	}
+	return nullptr;
+}
+
+static void DVDThreadFunc()
+{
+	Common::SetCurrentThreadName("DVD thread");
+
+	std::vector<u8> buffer;
+	std::unique_lock<std::mutex> lk(s_lock);
+	while (true)
+	{
+		s_request_cond.wait(lk, [] { return s_quit || FindPendingRequest(); });
+		if (s_quit)
+			return;
+
+		ReadRequest* request = FindPendingRequest();
+		const u64 id = request->id;
+		const u64 dvd_offset = request->dvd_offset;
+		const u32 length = request->length;
+		const bool decrypt = request->decrypt;
+
+		lk.unlock();
+		buffer.resize(length);
+		bool result;
+		if (decrypt)
+			result = VolumeHandler::ReadToPtr(buffer.data(), dvd_offset, length);
+		else
+			result = VolumeHandler::RAWReadToPtr(buffer.data(), dvd_offset, length);
+		lk.lock();
+
+		// Only the finish event removes requests, and it waits for this one.
+		request = FindRequest(id);
+		request->buffer.swap(buffer);
+		request->result = result;
+		request->done = true;
+		s_done_cond.notify_all();
+	}
+}
+
+static void FinishRead(u64 id, int cyclesLate)
+{
+	std::unique_lock<std::mutex> lk(s_lock);
+
+	auto request = std::find_if(s_requests.begin(), s_requests.end(),
+		[id](const ReadRequest& r) { return r.id == id; });
+	if (request == s_requests.end())
+	{
+		ERROR_LOG(DVDINTERFACE, "Finishing unknown DVD read %" PRIu64, id);
+		return;
+	}
+
+	s_done_cond.wait(lk, [request] { return request->done; });
+
+	u8* dest = Memory::GetPointer(request->output_address);
+	if (request->result && dest)
+		memcpy(dest, request->buffer.data(), request->length);
+	else
+		PanicAlertT("Can't read from DVD_Plugin - DVD-Interface: Fatal Error");
+
+	s_requests.erase(request);
+}
+
+void Start()
+{
+	s_finish_read = CoreTiming::RegisterEvent("DVDReadFinished", FinishRead);
+
+	s_requests.clear();
+	s_next_id = 0;
+	s_quit = false;
+	s_thread = std::thread(DVDThreadFunc);
+}
+
+void Stop()
+{
+	{
+		std::lock_guard<std::mutex> lk(s_lock);
+		s_quit = true;
+	}
+	s_request_cond.notify_one();
+	if (s_thread.joinable())
+		s_thread.join();
+
+	s_requests.clear();
+}
+
+void DoState(PointerWrap &p)
+{
+	WaitUntilIdle();
+
+	std::lock_guard<std::mutex> lk(s_lock);
+	p.Do(s_next_id);
+
+	u32 count = (u32)s_requests.size();
+	p.Do(count);
+	s_requests.resize(count);
+	for (ReadRequest& request : s_requests)
+		request.DoState(p);
+}
+
+void StartRead(u64 dvd_offset, u32 output_address, u32 length, bool decrypt, int ticks_until_completion)
+{
+	ReadRequest request;
+	request.dvd_offset = dvd_offset;
+	request.output_address = output_address;
+	request.length = length;
+	request.decrypt = decrypt;
+	request.done = false;
+	request.result = false;
+
+	u64 id;
+	{
+		std::lock_guard<std::mutex> lk(s_lock);
+		id = request.id = s_next_id++;
+		s_requests.push_back(std::move(request));
+	}
+	s_request_cond.notify_one();
+
+	CoreTiming::ScheduleEvent(ticks_until_completion, s_finish_read, id);
+}
+
+void WaitUntilIdle()
+{
+	std::unique_lock<std::mutex> lk(s_lock);
+	s_done_cond.wait(lk, [] { return !FindPendingRequest(); });
+}
+
+}
@@ -0,0 +1,37 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+
+// Reads from the disc on a thread of its own, so a slow decompress or decrypt
+// overlaps with emulation instead of stalling the CPU thread.
+//
+// A read is handed to the thread as soon as the emulated drive starts it, but its
+// data only lands in emulated memory from a CoreTiming event at the emulated
+// completion time. If the host read hasn't finished by then, that event waits for
+// it, so timing stays the same no matter how fast the host is.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+class PointerWrap;
+
+namespace DVDThread
+{
+
+void Start();
+void Stop();
+void DoState(PointerWrap &p);
+
+// Reads length bytes at dvd_offset of the current volume and copies them to
+// output_address ticks_until_completion ticks from now. Events the caller schedules
+// for the same tick afterwards run after the data has been copied.
+// decrypt selects between VolumeHandler::ReadToPtr and RAWReadToPtr.
+void StartRead(u64 dvd_offset, u32 output_address, u32 length, bool decrypt, int ticks_until_completion);
+
+// Blocks until every started read has been read from the host. Needed before
+// anything touches the volume without going through VolumeHandler.
+void WaitUntilIdle();
+
+}
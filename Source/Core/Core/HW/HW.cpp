@@ -7,6 +7,7 @@
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
+#include "Core/Rewind.h"
 #include "Core/State.h"
 #include "Core/HW/AudioInterface.h"
 #include "Core/HW/CPU.h"
@@ -33,6 +34,7 @@ namespace HW
 		SystemTimers::PreInit();
 
 		State::Init();
+		Rewind::Init();
 
 		// Init the whole Hardware
 		AudioInterface::Init();
@@ -71,6 +73,7 @@ namespace HW
 			WII_IPC_HLE_Interface::Shutdown();
 		}
 
+		Rewind::Shutdown();
 		State::Shutdown();
 		CoreTiming::Shutdown();
 	}
@@ -8,6 +8,9 @@
 // However, if a JITed instruction (for example lwz) wants to access a bad memory area that call
 // may be redirected here (for example to Read_U32()).
 
+#include <memory>
+#include <vector>
+
 #include "Common/ChunkFile.h"
 #include "Common/Common.h"
 #include "Common/MemArena.h"
@@ -87,6 +90,72 @@ u8 *m_pVirtualFakeVMEM;
 // MMIO mapping object.
 MMIO::Mapping* mmio_mapping;
 
+u8** host_page_table[1 << (32 - HOST_PAGE_TABLE_SHIFT)];
+static std::vector<std::unique_ptr<u8*[]>> s_host_page_tables;
+
+// Second level tables for size bytes of memory, one per 16 MiB.
+static std::vector<u8**> CreateHostPageTables(u8* memory, u32 size)
+{
+	std::vector<u8**> tables;
+	for (u32 table_start = 0; table_start < size; table_start += 1 << HOST_PAGE_TABLE_SHIFT)
+	{
+		s_host_page_tables.emplace_back(new u8*[HOST_PAGES_PER_TABLE]());
+		u8** pages = s_host_page_tables.back().get();
+		for (u32 i = 0; i < HOST_PAGES_PER_TABLE; i++)
+		{
+			u32 offset = table_start + (i << HOST_PAGE_SHIFT);
+			if (offset < size)
+				pages[i] = memory + offset;
+		}
+		tables.push_back(pages);
+	}
+	return tables;
+}
+
+// Maps the memory behind tables over [start, end), repeating it as often as it fits.
+static void MapHostPageTables(u32 start, u64 end, const std::vector<u8**>& tables)
+{
+	for (u64 address = start; address < end; address += 1 << HOST_PAGE_TABLE_SHIFT)
+	{
+		u32 index = (u32)(address >> HOST_PAGE_TABLE_SHIFT);
+		host_page_table[index] = tables[(index - (start >> HOST_PAGE_TABLE_SHIFT)) % tables.size()];
+	}
+}
+
+// Follows the address decoding of ReadFromHardware and WriteToHardware: the EFB and
+// the hardware registers at 0xC8000000 and up (and their mirrors with the same bits
+// set) are never in here.
+static void InitHostPageTable(bool wii)
+{
+	std::vector<u8**> ram = CreateHostPageTables(m_pRAM, RAM_SIZE);
+	MapHostPageTables(0x00000000, 0x10000000, ram);
+	MapHostPageTables(0x80000000, 0x90000000, ram);
+	MapHostPageTables(0xC0000000, 0xC8000000, ram);
+
+	if (wii)
+	{
+		std::vector<u8**> exram = CreateHostPageTables(m_pEXRAM, EXRAM_SIZE);
+		MapHostPageTables(0x10000000, 0x20000000, exram);
+		MapHostPageTables(0x90000000, 0xA0000000, exram);
+		MapHostPageTables(0xD0000000, 0xD8000000, exram);
+	}
+
+	MapHostPageTables(0xE0000000, 0xE1000000, CreateHostPageTables(m_pL1Cache, L1_CACHE_SIZE));
+
+	if (bFakeVMEM)
+	{
+		std::vector<u8**> fake_vmem = CreateHostPageTables(m_pFakeVMEM, FAKEVMEM_SIZE);
+		MapHostPageTables(0x40000000, 0x50000000, fake_vmem);
+		MapHostPageTables(0x70000000, 0x80000000, fake_vmem);
+	}
+}
+
+static void ShutdownHostPageTable()
+{
+	memset(host_page_table, 0, sizeof(host_page_table));
+	s_host_page_tables.clear();
+}
+
 void InitMMIO(MMIO::Mapping* mmio)
 {
 	g_video_backend->RegisterCPMMIO(mmio, 0xCC000000);
@@ -150,6 +219,7 @@ void Init()
 	if (wii) flags |= MV_WII_ONLY;
 	if (bFakeVMEM) flags |= MV_FAKE_VMEM;
 	base = MemoryMap_Setup(views, num_views, flags, &g_arena);
+	InitHostPageTable(wii);
 
 	mmio_mapping = new MMIO::Mapping();
 
@@ -184,6 +254,7 @@ void Shutdown()
 	u32 flags = 0;
 	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bWii) flags |= MV_WII_ONLY;
 	if (bFakeVMEM) flags |= MV_FAKE_VMEM;
+	ShutdownHostPageTable();
 	MemoryMap_Shutdown(views, num_views, flags, &g_arena);
 	g_arena.ReleaseSpace();
 	base = nullptr;
@@ -299,49 +370,11 @@ void GetString(std::string& _string, const u32 em_address)
 // TODO re-think with respect to other BAT setups...
 u8 *GetPointer(const u32 _Address)
 {
-	switch (_Address >> 28)
-	{
-	case 0x0:
-	case 0x8:
-		if ((_Address & 0xfffffff) < REALRAM_SIZE)
-			return m_pPhysicalRAM + (_Address & RAM_MASK);
-	case 0xc:
-		switch (_Address >> 24)
-		{
-		case 0xcc:
-		case 0xcd:
-			_dbg_assert_msg_(MEMMAP, 0, "GetPointer from IO Bridge doesnt work");
-		case 0xc8:
-			// EFB. We don't want to return a pointer here since we have no memory mapped for it.
-			break;
-
-		default:
-			if ((_Address & 0xfffffff) < REALRAM_SIZE)
-				return m_pPhysicalRAM + (_Address & RAM_MASK);
-		}
-
-	case 0x1:
-	case 0x9:
-	case 0xd:
-		if (SConfig::GetInstance().m_LocalCoreStartupParameter.bWii)
-		{
-			if ((_Address & 0xfffffff) < EXRAM_SIZE)
-				return m_pPhysicalEXRAM + (_Address & EXRAM_MASK);
-		}
-		else
-			break;
-
-	case 0xe:
-		if (_Address < (0xE0000000 + L1_CACHE_SIZE))
-			return GetCachePtr() + (_Address & L1_CACHE_MASK);
-		else
-			break;
-
-	default:
-		if (bFakeVMEM)
-			return m_pVirtualFakeVMEM + (_Address & FAKEVMEM_MASK);
-	}
+	u8* ptr = GetHostPointer(_Address);
+	if (ptr)
+		return ptr;
 
+	_dbg_assert_msg_(MEMMAP, (_Address >> 24) != 0xcc && (_Address >> 24) != 0xcd, "GetPointer from IO Bridge doesnt work");
 	ERROR_LOG(MEMMAP, "Unknown Pointer %#8x PC %#8x LR %#8x", _Address, PC, LR);
 
 	return nullptr;
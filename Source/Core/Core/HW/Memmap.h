@@ -77,6 +77,28 @@ enum
 // MMIO mapping object.
 extern MMIO::Mapping* mmio_mapping;
 
+// Host pointers to every 4 KiB page of the emulated address space that is plain
+// memory (RAM, EXRAM, the locked L1 cache, fake VMEM and all their mirrors), and
+// nullptr for everything else. The second level covers 16 MiB, and mirrors of
+// the same memory share their second level tables.
+enum
+{
+	HOST_PAGE_SHIFT       = 12,
+	HOST_PAGE_MASK        = (1 << HOST_PAGE_SHIFT) - 1,
+	HOST_PAGE_TABLE_SHIFT = 24,
+	HOST_PAGES_PER_TABLE  = 1 << (HOST_PAGE_TABLE_SHIFT - HOST_PAGE_SHIFT),
+};
+extern u8** host_page_table[1 << (32 - HOST_PAGE_TABLE_SHIFT)];
+
+inline u8* GetHostPointer(const u32 _Address)
+{
+	u8** pages = host_page_table[_Address >> HOST_PAGE_TABLE_SHIFT];
+	if (!pages)
+		return nullptr;
+	u8* page = pages[(_Address >> HOST_PAGE_SHIFT) & (HOST_PAGES_PER_TABLE - 1)];
+	return page ? page + (_Address & HOST_PAGE_MASK) : nullptr;
+}
+
 // Init and Shutdown
 bool IsInitialized();
 void Init();
@@ -169,6 +191,8 @@ enum XCheckTLBFlag
 };
 u32 TranslateAddress(u32 _Address, XCheckTLBFlag _Flag);
 void InvalidateTLBEntry(u32 _Address);
+// Drops every cached translation, for when the BATs or segment registers change.
+void InvalidateTLB();
 void GenerateDSIException(u32 _EffectiveAdress, bool _bWrite);
 void GenerateISIException(u32 _EffectiveAdress);
 extern u32 pagetable_base;
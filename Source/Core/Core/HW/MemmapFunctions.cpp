@@ -54,13 +54,10 @@ GXPeekZ
 // ----------------
 
 // Pointers to low memory
-extern u8 *m_pFakeVMEM;
-extern u8 *m_pEXRAM;  // Wii
 extern u8 *m_pEFB;
 
 // Init
 extern bool m_IsInitialized;
-extern bool bFakeVMEM;
 
 // Overloaded byteswap functions, for use within the templated functions below.
 inline u8 bswap(u8 val)   {return val;}
@@ -93,36 +90,18 @@ u32 EFB_Read(const u32 addr)
 template <typename T>
 inline void ReadFromHardware(T &_var, const u32 em_address, const u32 effective_address, Memory::XCheckTLBFlag flag)
 {
-	// TODO: Figure out the fastest order of tests for both read and write (they are probably different).
-	if ((em_address & 0xC8000000) == 0xC8000000)
+	// Plain memory, wherever it's mapped, is a single page table lookup.
+	if (const u8* ptr = GetHostPointer(em_address))
+	{
+		_var = bswap(*(const T*)ptr);
+	}
+	else if ((em_address & 0xC8000000) == 0xC8000000)
 	{
 		if (em_address < 0xcc000000)
 			_var = EFB_Read(em_address);
 		else
 			mmio_mapping->Read(em_address, &_var);
 	}
-	else if (((em_address & 0xF0000000) == 0x80000000) ||
-		((em_address & 0xF0000000) == 0xC0000000) ||
-		((em_address & 0xF0000000) == 0x00000000))
-	{
-		_var = bswap((*(const T*)&m_pRAM[em_address & RAM_MASK]));
-	}
-	else if (m_pEXRAM && (((em_address & 0xF0000000) == 0x90000000) ||
-		((em_address & 0xF0000000) == 0xD0000000) ||
-		((em_address & 0xF0000000) == 0x10000000)))
-	{
-		_var = bswap((*(const T*)&m_pEXRAM[em_address & EXRAM_MASK]));
-	}
-	else if ((em_address >= 0xE0000000) && (em_address < (0xE0000000+L1_CACHE_SIZE)))
-	{
-		_var = bswap((*(const T*)&m_pL1Cache[em_address & L1_CACHE_MASK]));
-	}
-	else if ((bFakeVMEM && ((em_address &0xF0000000) == 0x70000000)) ||
-		(bFakeVMEM && ((em_address &0xF0000000) == 0x40000000)))
-	{
-		// fake VMEM
-		_var = bswap((*(const T*)&m_pFakeVMEM[em_address & FAKEVMEM_MASK]));
-	}
 	else
 	{
 		// MMU
@@ -134,6 +113,10 @@ inline void ReadFromHardware(T &_var, const u32 em_address, const u32 effective_
 				GenerateDSIException(em_address, false);
 			}
 		}
+		else if (const u8* ptr = GetHostPointer(tlb_addr))
+		{
+			_var = bswap(*(const T*)ptr);
+		}
 		else
 		{
 			_var = bswap((*(const T*)&m_pRAM[tlb_addr & RAM_MASK]));
@@ -157,7 +140,12 @@ inline void WriteToHardware(u32 em_address, const T data, u32 effective_address,
 		case 8: GPFifo::Write64((u64)data, em_address); return;
 		}
 	}
-	if ((em_address & 0xC8000000) == 0xC8000000)
+	if (u8* ptr = GetHostPointer(em_address))
+	{
+		*(T*)ptr = bswap(data);
+		return;
+	}
+	else if ((em_address & 0xC8000000) == 0xC8000000)
 	{
 		if (em_address < 0xcc000000)
 		{
@@ -183,31 +171,6 @@ inline void WriteToHardware(u32 em_address, const T data, u32 effective_address,
 			return;
 		}
 	}
-	else if (((em_address & 0xF0000000) == 0x80000000) ||
-		((em_address & 0xF0000000) == 0xC0000000) ||
-		((em_address & 0xF0000000) == 0x00000000))
-	{
-		*(T*)&m_pRAM[em_address & RAM_MASK] = bswap(data);
-		return;
-	}
-	else if (((em_address & 0xF0000000) == 0x90000000) ||
-		((em_address & 0xF0000000) == 0xD0000000) ||
-		((em_address & 0xF0000000) == 0x10000000))
-	{
-		*(T*)&m_pEXRAM[em_address & EXRAM_MASK] = bswap(data);
-		return;
-	}
-	else if ((em_address >= 0xE0000000) && (em_address < (0xE0000000+L1_CACHE_SIZE)))
-	{
-		*(T*)&m_pL1Cache[em_address & L1_CACHE_MASK] = bswap(data);
-		return;
-	}
-	else if ((bFakeVMEM && ((em_address &0xF0000000) == 0x70000000)) ||
-		(bFakeVMEM && ((em_address &0xF0000000) == 0x40000000)))
-	{
-		// fake VMEM
-		*(T*)&m_pFakeVMEM[em_address & FAKEVMEM_MASK] = bswap(data);
-	}
 	else
 	{
 		// MMU
@@ -219,6 +182,10 @@ inline void WriteToHardware(u32 em_address, const T data, u32 effective_address,
 				GenerateDSIException(em_address, true);
 			}
 		}
+		else if (u8* ptr = GetHostPointer(tlb_addr))
+		{
+			*(T*)ptr = bswap(data);
+		}
 		else
 		{
 			*(T*)&m_pRAM[tlb_addr & RAM_MASK] = bswap(data);
@@ -595,170 +562,66 @@ void SDRUpdated()
 	}
 	PowerPC::ppcState.pagetable_base = htaborg<<16;
 	PowerPC::ppcState.pagetable_hashmask = ((xx<<10)|0x3ff);
+	InvalidateTLB();
 }
 
 
 // TLB cache
-//#define FAST_TLB_CACHE
-
-#define TLB_SIZE 128
-#define TLB_WAYS 2
-#define NUM_TLBS 2
+// Holds the result of TranslateAddress, from the BATs or the page table, for recently
+// used pages. It's direct mapped, with separate sets for instruction fetches and data
+// accesses and for user and supervisor mode, since the BATs can differ between them.
+// Anything that changes translations flushes it: tlbie, and BAT, segment register and
+// SDR1 writes. It lives in ppcState so savestates keep it.
 
-#define HW_PAGE_SIZE 4096
 #define HW_PAGE_INDEX_SHIFT 12
-#define HW_PAGE_INDEX_MASK 0x3f
-#define HW_PAGE_TAG_SHIFT 18
+#define HW_PAGE_MASK 0xfffff000
 
-#define TLB_FLAG_MOST_RECENT 0x01
-#define TLB_FLAG_INVALID 0x02
+#define TLB_FLAG_VALID 0x01
+// The page table entry has its changed bit set already, so writes can use this entry.
+#define TLB_FLAG_CHANGED 0x02
 
-typedef struct tlb_entry
+static PowerPC::TLBEntry& GetTLBEntry(const XCheckTLBFlag _Flag, const u32 vpa)
 {
-	u32 tag;
-	u32 paddr;
-	u8 flags;
-} tlb_entry;
-
-// TODO: tlb needs to be in ppcState for save-state purposes.
-#ifdef FAST_TLB_CACHE
-static tlb_entry tlb[NUM_TLBS][TLB_SIZE/TLB_WAYS][TLB_WAYS];
-#endif
+	UReg_MSR& m_MSR = ((UReg_MSR&)PowerPC::ppcState.msr);
+	return PowerPC::ppcState.tlb[_Flag == FLAG_OPCODE][m_MSR.PR][(vpa >> HW_PAGE_INDEX_SHIFT) & (PowerPC::TLB_SIZE - 1)];
+}
 
-u32 LookupTLBPageAddress(const XCheckTLBFlag _Flag, const u32 vpa, u32 *paddr)
+static bool LookupTLBPageAddress(const XCheckTLBFlag _Flag, const u32 vpa, u32 *paddr)
 {
-#ifdef FAST_TLB_CACHE
-	tlb_entry *tlbe = tlb[_Flag == FLAG_OPCODE][(vpa>>HW_PAGE_INDEX_SHIFT)&HW_PAGE_INDEX_MASK];
-	if (tlbe[0].tag == (vpa & ~0xfff) && !(tlbe[0].flags & TLB_FLAG_INVALID))
-	{
-		tlbe[0].flags |= TLB_FLAG_MOST_RECENT;
-		tlbe[1].flags &= ~TLB_FLAG_MOST_RECENT;
-		*paddr = tlbe[0].paddr | (vpa & 0xfff);
-		return 1;
-	}
-	if (tlbe[1].tag == (vpa & ~0xfff) && !(tlbe[1].flags & TLB_FLAG_INVALID))
-	{
-		tlbe[1].flags |= TLB_FLAG_MOST_RECENT;
-		tlbe[0].flags &= ~TLB_FLAG_MOST_RECENT;
-		*paddr = tlbe[1].paddr | (vpa & 0xfff);
-		return 1;
-	}
-	return 0;
-#else
-	u32 _Address = vpa;
-	if (_Flag == FLAG_OPCODE)
-	{
-		for (u32 i = (PowerPC::ppcState.itlb_last); i > (PowerPC::ppcState.itlb_last - 128); i--)
-		{
-			if ((_Address & ~0xfff) == (PowerPC::ppcState.itlb_va[i & 127]))
-			{
-				*paddr = PowerPC::ppcState.itlb_pa[i & 127] | (_Address & 0xfff);
-				PowerPC::ppcState.itlb_last = i;
-				return 1;
-			}
-		}
-	}
-	else
-	{
-		for (u32 i = (PowerPC::ppcState.dtlb_last); i > (PowerPC::ppcState.dtlb_last - 128); i--)
-		{
-			if ((_Address & ~0xfff) == (PowerPC::ppcState.dtlb_va[i & 127]))
-			{
-				*paddr = PowerPC::ppcState.dtlb_pa[i & 127] | (_Address & 0xfff);
-				PowerPC::ppcState.dtlb_last = i;
-				return 1;
-			}
-		}
-	}
-	return 0;
-#endif
+	const PowerPC::TLBEntry& tlbe = GetTLBEntry(_Flag, vpa);
+	if (!(tlbe.tag & TLB_FLAG_VALID) || (tlbe.tag & HW_PAGE_MASK) != (vpa & HW_PAGE_MASK))
+		return false;
+	if (_Flag == FLAG_WRITE && !(tlbe.tag & TLB_FLAG_CHANGED))
+		return false;
+
+	*paddr = tlbe.paddr | (vpa & ~HW_PAGE_MASK);
+	return true;
 }
 
-void UpdateTLBEntry(const XCheckTLBFlag _Flag, UPTE2 PTE2, const u32 vpa)
+static void UpdateTLBEntry(const XCheckTLBFlag _Flag, const u32 vpa, const u32 paddr, bool changed)
 {
-#ifdef FAST_TLB_CACHE
-	tlb_entry *tlbe = tlb[_Flag == FLAG_OPCODE][(vpa>>HW_PAGE_INDEX_SHIFT)&HW_PAGE_INDEX_MASK];
-	if ((tlbe[0].flags & TLB_FLAG_MOST_RECENT) == 0)
-	{
-		tlbe[0].flags = TLB_FLAG_MOST_RECENT;
-		tlbe[1].flags &= ~TLB_FLAG_MOST_RECENT;
-		tlbe[0].paddr = PTE2.RPN << HW_PAGE_INDEX_SHIFT;
-		tlbe[0].tag = vpa & ~0xfff;
-	}
-	else
-	{
-		tlbe[1].flags = TLB_FLAG_MOST_RECENT;
-		tlbe[0].flags &= ~TLB_FLAG_MOST_RECENT;
-		tlbe[1].paddr = PTE2.RPN << HW_PAGE_INDEX_SHIFT;
-		tlbe[1].tag = vpa & ~0xfff;
-	}
-#else
-	if (_Flag == FLAG_OPCODE)
-	{
-		// ITLB cache
-		PowerPC::ppcState.itlb_last++;
-		PowerPC::ppcState.itlb_last &= 127;
-		PowerPC::ppcState.itlb_pa[PowerPC::ppcState.itlb_last] = PTE2.RPN << HW_PAGE_INDEX_SHIFT;
-		PowerPC::ppcState.itlb_va[PowerPC::ppcState.itlb_last] = vpa & ~0xfff;
-	}
-	else
-	{
-		// DTLB cache
-		PowerPC::ppcState.dtlb_last++;
-		PowerPC::ppcState.dtlb_last &= 127;
-		PowerPC::ppcState.dtlb_pa[PowerPC::ppcState.dtlb_last] = PTE2.RPN << HW_PAGE_INDEX_SHIFT;
-		PowerPC::ppcState.dtlb_va[PowerPC::ppcState.dtlb_last] = vpa & ~0xfff;
-	}
-#endif
+	PowerPC::TLBEntry& tlbe = GetTLBEntry(_Flag, vpa);
+	tlbe.tag = (vpa & HW_PAGE_MASK) | TLB_FLAG_VALID | (changed ? TLB_FLAG_CHANGED : 0);
+	tlbe.paddr = paddr & HW_PAGE_MASK;
 }
 
 void InvalidateTLBEntry(u32 vpa)
 {
-#ifdef FAST_TLB_CACHE
-	tlb_entry *tlbe = tlb[0][(vpa>>HW_PAGE_INDEX_SHIFT)&HW_PAGE_INDEX_MASK];
-	if (tlbe[0].tag == (vpa & ~0xfff))
-	{
-		tlbe[0].flags |= TLB_FLAG_INVALID;
-	}
-	if (tlbe[1].tag == (vpa & ~0xfff))
-	{
-		tlbe[1].flags |= TLB_FLAG_INVALID;
-	}
-	tlb_entry *tlbe_i = tlb[1][(vpa>>HW_PAGE_INDEX_SHIFT)&HW_PAGE_INDEX_MASK];
-	if (tlbe_i[0].tag == (vpa & ~0xfff))
-	{
-		tlbe_i[0].flags |= TLB_FLAG_INVALID;
-	}
-	if (tlbe_i[1].tag == (vpa & ~0xfff))
-	{
-		tlbe_i[1].flags |= TLB_FLAG_INVALID;
-	}
-#else
-	u32 _Address = vpa;
-	for (int i = 0; i < 128; i++)
-	{
-		if ((_Address & ~0xfff) == (PowerPC::ppcState.dtlb_va[(PowerPC::ppcState.dtlb_last + i) & 127]))
-		{
-			PowerPC::ppcState.dtlb_pa[(PowerPC::ppcState.dtlb_last + i) & 127] = 0;
-			PowerPC::ppcState.dtlb_va[(PowerPC::ppcState.dtlb_last + i) & 127] = 0;
-		}
-		if ((_Address & ~0xfff) == (PowerPC::ppcState.itlb_va[(PowerPC::ppcState.itlb_last + i) & 127]))
-		{
-			PowerPC::ppcState.itlb_pa[(PowerPC::ppcState.itlb_last + i) & 127] = 0;
-			PowerPC::ppcState.itlb_va[(PowerPC::ppcState.itlb_last + i) & 127] = 0;
-		}
-	}
-#endif
+	// Like tlbie on the real thing, this drops whatever is cached at the index of vpa.
+	const u32 index = (vpa >> HW_PAGE_INDEX_SHIFT) & (PowerPC::TLB_SIZE - 1);
+	for (auto& tlbs : PowerPC::ppcState.tlb)
+		for (auto& tlb : tlbs)
+			tlb[index].tag = 0;
+}
+
+void InvalidateTLB()
+{
+	memset(PowerPC::ppcState.tlb, 0, sizeof(PowerPC::ppcState.tlb));
 }
 
 // Page Address Translation
 u32 TranslatePageAddress(const u32 _Address, const XCheckTLBFlag _Flag)
 {
-	// TLB cache
-	u32 translatedAddress = 0;
-	if (LookupTLBPageAddress(_Flag, _Address, &translatedAddress))
-		return translatedAddress;
-
 	u32 sr = PowerPC::ppcState.sr[EA_SR(_Address)];
 
 	u32 offset = EA_Offset(_Address);        // 12 bit
@@ -785,8 +648,6 @@ u32 TranslatePageAddress(const u32 _Address, const XCheckTLBFlag _Flag)
 				UPTE2 PTE2;
 				PTE2.Hex = bswap((*(u32*)&pRAM[(pteg_addr + 4)]));
 
-				UpdateTLBEntry(_Flag, PTE2, _Address);
-
 				// set the access bits
 				switch (_Flag)
 				{
@@ -797,6 +658,8 @@ u32 TranslatePageAddress(const u32 _Address, const XCheckTLBFlag _Flag)
 				}
 				*(u32*)&pRAM[(pteg_addr + 4)] = bswap(PTE2.Hex);
 
+				UpdateTLBEntry(_Flag, _Address, PTE2.RPN << 12, PTE2.C);
+
 				return ((PTE2.RPN << 12) | offset);
 			}
 		}
@@ -816,8 +679,6 @@ u32 TranslatePageAddress(const u32 _Address, const XCheckTLBFlag _Flag)
 				UPTE2 PTE2;
 				PTE2.Hex = bswap((*(u32*)&pRAM[(pteg_addr + 4)]));
 
-				UpdateTLBEntry(_Flag, PTE2, _Address);
-
 				switch (_Flag)
 				{
 				case FLAG_READ:     PTE2.R = 1; break;
@@ -827,6 +688,8 @@ u32 TranslatePageAddress(const u32 _Address, const XCheckTLBFlag _Flag)
 				}
 				*(u32*)&pRAM[(pteg_addr + 4)] = bswap(PTE2.Hex);
 
+				UpdateTLBEntry(_Flag, _Address, PTE2.RPN << 12, PTE2.C);
+
 				return ((PTE2.RPN << 12) | offset);
 			}
 		}
@@ -913,20 +776,18 @@ u32 TranslateAddress(const u32 _Address, const XCheckTLBFlag _Flag)
 	// Check MSR[DR] bit before translating data addresses
 	//if (((_Flag == FLAG_READ) || (_Flag == FLAG_WRITE)) && !(MSR & (1 << (31 - 27)))) return _Address;
 
-	u32 tlb_addr = TranslateBlockAddress(_Address, _Flag);
-	if (tlb_addr == 0)
-	{
-		tlb_addr = TranslatePageAddress(_Address, _Flag);
-		if (tlb_addr != 0)
-		{
-			return tlb_addr;
-		}
-	}
-	else
+	u32 tlb_addr;
+	if (LookupTLBPageAddress(_Flag, _Address, &tlb_addr))
+		return tlb_addr;
+
+	tlb_addr = TranslateBlockAddress(_Address, _Flag);
+	if (tlb_addr != 0)
 	{
+		// BAT translations have no referenced or changed bits to keep up to date.
+		UpdateTLBEntry(_Flag, _Address, tlb_addr, true);
 		return tlb_addr;
 	}
 
-	return 0;
+	return TranslatePageAddress(_Address, _Flag);
 }
 } // namespace
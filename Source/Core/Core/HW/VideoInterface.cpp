@@ -8,6 +8,7 @@
 
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
+#include "Core/Rewind.h"
 #include "Core/State.h"
 #include "Core/HW/Memmap.h"
 #include "Core/HW/MMIO.h"
@@ -557,6 +558,7 @@ static void EndField()
 {
 	g_video_backend->Video_EndField();
 	Core::VideoThrottle();
+	Rewind::FieldUpdate();
 }
 
 // Purpose: Send VI interrupt when triggered
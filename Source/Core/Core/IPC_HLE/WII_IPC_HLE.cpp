@@ -536,14 +536,10 @@ void ExecuteCommand(u32 _Address)
 
 		// Ensure replies happen in order, fairly ugly
 		// Without this, tons of games fail now that DI commands have different reply delays
-		int reply_delay = pDevice ? pDevice->GetCmdDelay(_Address) : 0;
-
+		const int cmd_delay = pDevice ? pDevice->GetCmdDelay(_Address) : 0;
+		const int min_delay = pDevice ? pDevice->GetCmdMinDelay(_Address) : 0;
 		const s64 ticks_til_last_reply = last_reply_time - CoreTiming::GetTicks();
-
-		if (ticks_til_last_reply > 0)
-		{
-			reply_delay = (int)ticks_til_last_reply;
-		}
+		const int reply_delay = GetReplyDelay(cmd_delay, min_delay, ticks_til_last_reply);
 
 		last_reply_time = CoreTiming::GetTicks() + reply_delay;
 
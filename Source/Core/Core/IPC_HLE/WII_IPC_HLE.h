@@ -67,4 +67,16 @@ void ExecuteCommand(u32 _Address);
 void EnqRequest(u32 _Address);
 void EnqReply(u32 _Address, int cycles_in_future = 0);
 
+// Replies go out in the order their commands came in, which can make one come sooner
+// or later than the device asked for, but never sooner than min_delay.
+inline int GetReplyDelay(int cmd_delay, int min_delay, s64 ticks_til_last_reply)
+{
+	int reply_delay = cmd_delay;
+	if (ticks_til_last_reply > 0)
+		reply_delay = (int)ticks_til_last_reply;
+	if (reply_delay < min_delay)
+		reply_delay = min_delay;
+	return reply_delay;
+}
+
 } // end of namespace WII_IPC_HLE_Interface
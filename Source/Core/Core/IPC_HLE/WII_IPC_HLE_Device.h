@@ -146,6 +146,9 @@ public:
 #undef UNIMPLEMENTED_CMD
 
 	virtual int GetCmdDelay(u32) { return 0; }
+	// For commands that keep writing to memory after they return, so that keeping
+	// replies in order never makes their reply come before the data.
+	virtual int GetCmdMinDelay(u32) { return 0; }
 
 	virtual u32 Update() { return 0; }
 
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <cinttypes>
+#include <vector>
 
 #include "Common/Common.h"
 #include "Common/LogManager.h"
@@ -11,6 +12,7 @@
 #include "Core/VolumeHandler.h"
 #include "Core/HW/CPU.h"
 #include "Core/HW/DVDInterface.h"
+#include "Core/HW/DVDThread.h"
 #include "Core/HW/Memmap.h"
 #include "Core/HW/SystemTimers.h"
 
@@ -27,6 +29,14 @@ using namespace DVDInterface;
 #define DI_COVER_REG_INITIALIZED  0 // Should be 4, but doesn't work correctly...
 #define DI_COVER_REG_NO_DISC      1
 
+static int GetReadDelay(u32 size)
+{
+	// Delay depends on size of read, that makes sense, right?
+	// More than ~1150K "bytes / sec" hangs NSMBWii on boot.
+	// Less than ~800K "bytes / sec" hangs DKCR randomly (ok, probably not true)
+	return SystemTimers::GetTicksPerSecond() / 975000 * size;
+}
+
 CWII_IPC_HLE_Device_di::CWII_IPC_HLE_Device_di(u32 _DeviceID, const std::string& _rDeviceName )
 	: IWII_IPC_HLE_Device(_DeviceID, _rDeviceName)
 	, m_pFileSystem(nullptr)
@@ -47,7 +57,7 @@ bool CWII_IPC_HLE_Device_di::Open(u32 _CommandAddress, u32 _Mode)
 {
 	if (VolumeHandler::IsValid())
 	{
-		m_pFileSystem = DiscIO::CreateFileSystem(VolumeHandler::GetVolume());
+		CreateFileSystem();
 		m_CoverStatus |= DI_COVER_REG_INITIALIZED;
 		m_CoverStatus &= ~DI_COVER_REG_NO_DISC;
 	}
@@ -56,6 +66,20 @@ bool CWII_IPC_HLE_Device_di::Open(u32 _CommandAddress, u32 _Mode)
 	return true;
 }
 
+// The file system reads the volume directly, not through VolumeHandler, and
+// reads its file table lazily. Read it all now, while the DVD thread is idle,
+// so that the DVDLowRead and DVDLowSeek logging never touches the volume.
+void CWII_IPC_HLE_Device_di::CreateFileSystem()
+{
+	DVDThread::WaitUntilIdle();
+	m_pFileSystem = DiscIO::CreateFileSystem(VolumeHandler::GetVolume());
+	if (m_pFileSystem)
+	{
+		std::vector<const DiscIO::SFileInfo*> files;
+		m_pFileSystem->GetFileList(files);
+	}
+}
+
 bool CWII_IPC_HLE_Device_di::Close(u32 _CommandAddress, bool _bForce)
 {
 	if (m_pFileSystem)
@@ -150,7 +174,7 @@ u32 CWII_IPC_HLE_Device_di::ExecuteCommand(u32 _BufferIn, u32 _BufferInSize, u32
 	// Initializing a filesystem if it was just loaded
 	if (!m_pFileSystem && VolumeHandler::IsValid())
 	{
-		m_pFileSystem = DiscIO::CreateFileSystem(VolumeHandler::GetVolume());
+		CreateFileSystem();
 		m_CoverStatus |= DI_COVER_REG_INITIALIZED;
 		m_CoverStatus &= ~DI_COVER_REG_NO_DISC;
 	}
@@ -221,10 +245,8 @@ u32 CWII_IPC_HLE_Device_di::ExecuteCommand(u32 _BufferIn, u32 _BufferInSize, u32
 				Size = _BufferOutSize;
 			}
 
-			if (!VolumeHandler::ReadToPtr(Memory::GetPointer(_BufferOut), DVDAddress, Size))
-			{
-				PanicAlertT("DVDLowRead - Fatal Error: failed to read from volume");
-			}
+			// GetCmdMinDelay keeps the reply from coming before this lands in memory.
+			DVDThread::StartRead(DVDAddress, _BufferOut, Size, true, GetReadDelay(Size));
 		}
 		break;
 
@@ -314,10 +336,7 @@ u32 CWII_IPC_HLE_Device_di::ExecuteCommand(u32 _BufferIn, u32 _BufferInSize, u32
 				PanicAlertT("Detected attempt to read more data from the DVD than fit inside the out buffer. Clamp.");
 				Size = _BufferOutSize;
 			}
-			if (!VolumeHandler::RAWReadToPtr(Memory::GetPointer(_BufferOut), DVDAddress, Size))
-			{
-				PanicAlertT("DVDLowUnencryptedRead - Fatal Error: failed to read from volume");
-			}
+			DVDThread::StartRead(DVDAddress, _BufferOut, Size, false, GetReadDelay(Size));
 		}
 		break;
 
@@ -447,6 +466,19 @@ u32 CWII_IPC_HLE_Device_di::ExecuteCommand(u32 _BufferIn, u32 _BufferInSize, u32
 	return 1;
 }
 
+// DVD reads are copied to memory GetReadDelay ticks after the command, see DVDThread::StartRead.
+// Reads clamped to the output buffer only finish sooner.
+int CWII_IPC_HLE_Device_di::GetCmdMinDelay(u32 _CommandAddress)
+{
+	u32 BufferIn = Memory::Read_U32(_CommandAddress + 0x10);
+	u32 Command  = Memory::Read_U32(BufferIn) >> 24;
+
+	if (Command == DVDLowRead || Command == DVDLowUnencryptedRead)
+		return GetReadDelay(Memory::Read_U32(BufferIn + 0x04));
+
+	return 0;
+}
+
 int CWII_IPC_HLE_Device_di::GetCmdDelay(u32 _CommandAddress)
 {
 	u32 BufferIn = Memory::Read_U32(_CommandAddress + 0x10);
@@ -460,10 +492,7 @@ int CWII_IPC_HLE_Device_di::GetCmdDelay(u32 _CommandAddress)
 	case DVDLowUnencryptedRead:
 	{
 		u32 const Size = Memory::Read_U32(BufferIn + 0x04);
-		// Delay depends on size of read, that makes sense, right?
-		// More than ~1150K "bytes / sec" hangs NSMBWii on boot.
-		// Less than ~800K "bytes / sec" hangs DKCR randomly (ok, probably not true)
-		return SystemTimers::GetTicksPerSecond() / 975000 * Size;
+		return GetReadDelay(Size);
 	}
 
 	case DVDLowClearCoverInterrupt:
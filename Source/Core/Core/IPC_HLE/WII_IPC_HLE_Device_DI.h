@@ -27,9 +27,11 @@ public:
 	bool IOCtlV(u32 _CommandAddress) override;
 
 	int GetCmdDelay(u32) override;
+	int GetCmdMinDelay(u32) override;
 
 private:
 
+	void CreateFileSystem();
 	u32 ExecuteCommand(u32 BufferIn, u32 BufferInSize, u32 _BufferOut, u32 BufferOutSize);
 
 	DiscIO::IFileSystem* m_pFileSystem;
@@ -114,7 +114,7 @@ void CWII_IPC_HLE_Device_es::OpenInternal()
 	{
 		// blindly grab the titleID from the disc - it's unencrypted at:
 		// offset 0x0F8001DC and 0x0F80044C
-		VolumeHandler::GetVolume()->GetTitleID((u8*)&m_TitleID);
+		VolumeHandler::GetTitleID((u8*)&m_TitleID);
 		m_TitleID = Common::swap64(m_TitleID);
 	}
 	else
@@ -1096,7 +1096,7 @@ u32 CWII_IPC_HLE_Device_es::ES_DIVerify(u8* _pTMD, u32 _sz)
 {
 	u64 titleID = 0xDEADBEEFDEADBEEFull;
 	u64 tmdTitleID = Common::swap64(*(u64*)(_pTMD+0x18c));
-	VolumeHandler::GetVolume()->GetTitleID((u8*)&titleID);
+	VolumeHandler::GetTitleID((u8*)&titleID);
 	if (Common::swap64(titleID) != tmdTitleID)
 	{
 		return -1;
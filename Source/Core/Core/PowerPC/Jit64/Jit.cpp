@@ -10,6 +10,9 @@
 #endif
 
 #include "Common/Common.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
+#include "Common/StringUtil.h"
 #include "Core/PatchEngine.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HW/ProcessorInterface.h"
@@ -186,6 +189,8 @@ void Jit64::Init()
 	code_block.m_gpa = &js.gpa;
 	code_block.m_fpa = &js.fpa;
 	analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE);
+
+	OpenBlockDiskCache();
 }
 
 void Jit64::ClearCache()
@@ -197,6 +202,7 @@ void Jit64::ClearCache()
 
 void Jit64::Shutdown()
 {
+	CloseBlockDiskCache();
 	FreeCodeSpace();
 
 	blocks.Shutdown();
@@ -392,6 +398,10 @@ void Jit64::Trace()
 
 void STACKALIGN Jit64::Jit(u32 em_address)
 {
+	// Precompile first so the check below also covers whatever it used up.
+	if (!blocks_to_precompile.empty())
+		PrecompileCachedBlocks();
+
 	if (GetSpaceLeft() < 0x10000 || blocks.IsFull() || Core::g_CoreStartupParameter.bJITNoBlockCache)
 	{
 		ClearCache();
@@ -400,6 +410,115 @@ void STACKALIGN Jit64::Jit(u32 em_address)
 	int block_num = blocks.AllocateBlock(em_address);
 	JitBlock *b = blocks.GetBlock(block_num);
 	blocks.FinalizeBlock(block_num, jo.enableBlocklink, DoJit(em_address, &code_buffer, b));
+
+	if (use_block_disk_cache)
+		AddBlockToDiskCache(*b);
+}
+
+// Hashes the guest code of a block. Returns false if the block isn't entirely in RAM.
+static bool HashGuestCode(u32 address, u32 num_instructions, u32 *hash)
+{
+	if (num_instructions == 0 || (address & JIT_ICACHE_VMEM_BIT) ||
+	    !Memory::IsRAMAddress(address) || !Memory::IsRAMAddress(address + 4 * num_instructions - 1))
+		return false;
+
+	*hash = HashFletcher(Memory::GetPointer(address), 4 * num_instructions);
+	return true;
+}
+
+class JitBlockCacheInserter : public LinearDiskCacheReader<u64, u32>
+{
+public:
+	JitBlockCacheInserter(std::set<u64> &keys, std::vector<std::pair<u64, u32>> &entries)
+		: m_keys(keys), m_entries(entries) {}
+
+	void Read(const u64 &key, const u32 *value, u32 value_size) override
+	{
+		if (value_size != 1 || !m_keys.insert(key).second)
+			return;
+		m_entries.push_back(std::make_pair(key, *value));
+	}
+
+private:
+	std::set<u64> &m_keys;
+	std::vector<std::pair<u64, u32>> &m_entries;
+};
+
+void Jit64::OpenBlockDiskCache()
+{
+	// The MMU and debugging paths don't compile the same code for the same address every
+	// time, so only the plain fast path takes part.
+	const SCoreStartupParameter &StartUp = Core::g_CoreStartupParameter;
+	use_block_disk_cache = StartUp.bJITBlockDiskCache && !StartUp.bMMU &&
+	                       !StartUp.bEnableDebugging && !StartUp.bJITNoBlockCache;
+	if (!use_block_disk_cache)
+		return;
+
+	std::string cache_dir = File::GetUserPath(D_CACHE_IDX);
+	if (!File::Exists(cache_dir))
+		File::CreateDir(cache_dir);
+
+	std::string filename = StringFromFormat("%sjit64-%s-blocks.cache", cache_dir.c_str(),
+		SConfig::GetInstance().m_LocalCoreStartupParameter.GetUniqueID().c_str());
+
+	JitBlockCacheInserter inserter(block_disk_cache_keys, blocks_to_precompile);
+	u32 num_entries = block_disk_cache.OpenAndRead(filename, inserter);
+	NOTICE_LOG(DYNA_REC, "Loaded %u block addresses from %s", num_entries, filename.c_str());
+}
+
+void Jit64::CloseBlockDiskCache()
+{
+	if (use_block_disk_cache)
+	{
+		block_disk_cache.Sync();
+		block_disk_cache.Close();
+	}
+	block_disk_cache_keys.clear();
+	blocks_to_precompile.clear();
+	use_block_disk_cache = false;
+}
+
+// Called on the first dispatcher miss, once the boot code has loaded the game into RAM.
+// Blocks whose guest code no longer matches (or isn't loaded yet) are skipped; they'll be
+// compiled on demand as usual.
+void Jit64::PrecompileCachedBlocks()
+{
+	std::vector<std::pair<u64, u32>> entries;
+	entries.swap(blocks_to_precompile);
+
+	int num_compiled = 0;
+	for (const auto &entry : entries)
+	{
+		// Leave half the code space and block slots for blocks compiled on demand, so
+		// precompiling never forces a cache flush that would throw its own work away.
+		if (GetSpaceLeft() < CODE_SIZE / 2 || blocks.GetNumBlocks() >= JitBaseBlockCache::MAX_NUM_BLOCKS / 2)
+			break;
+
+		u32 address = (u32)(entry.first >> 32);
+		u32 hash;
+		if (!HashGuestCode(address, entry.second, &hash) || hash != (u32)entry.first)
+			continue;
+		if (blocks.GetBlockNumberFromStartAddress(address) != -1)
+			continue;
+
+		int block_num = blocks.AllocateBlock(address);
+		JitBlock *b = blocks.GetBlock(block_num);
+		blocks.FinalizeBlock(block_num, jo.enableBlocklink, DoJit(address, &code_buffer, b));
+		num_compiled++;
+	}
+
+	NOTICE_LOG(DYNA_REC, "Precompiled %d of %d cached blocks", num_compiled, (int)entries.size());
+}
+
+void Jit64::AddBlockToDiskCache(const JitBlock &b)
+{
+	u32 hash;
+	if (!HashGuestCode(b.originalAddress, b.originalSize, &hash))
+		return;
+
+	u64 key = ((u64)b.originalAddress << 32) | hash;
+	if (block_disk_cache_keys.insert(key).second)
+		block_disk_cache.Append(key, &b.originalSize, 1);
 }
 
 const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBlock *b)
@@ -473,13 +592,9 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 	// Conditionally add profiling code.
 	if (Profiler::g_ProfileBlocks) {
 		ADD(32, M(&b->runCount), Imm8(1));
-#ifdef _WIN32
 		b->ticCounter = 0;
 		b->ticStart = 0;
 		b->ticStop = 0;
-#else
-//TODO
-#endif
 		// get start tic
 		PROFILER_QUERY_PERFORMANCE_COUNTER(&b->ticStart);
 	}
@@ -18,6 +18,11 @@
 // ----------
 #pragma once
 
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "Common/LinearDiskCache.h"
 #include "Common/x64ABI.h"
 #include "Common/x64Analyzer.h"
 #include "Common/x64Emitter.h"
@@ -48,8 +53,22 @@ private:
 	PPCAnalyst::CodeBuffer code_buffer;
 	Jit64AsmRoutineManager asm_routines;
 
+	// Block disk cache: the entry address and a hash of the guest code of every block we
+	// compile is remembered per game, so that the next boot can recompile all of them up
+	// front instead of rediscovering hot code one stutter at a time.
+	// Key is (address << 32) | code hash, value is the block size in instructions.
+	LinearDiskCache<u64, u32> block_disk_cache;
+	std::set<u64> block_disk_cache_keys;
+	std::vector<std::pair<u64, u32>> blocks_to_precompile;
+	bool use_block_disk_cache;
+
+	void OpenBlockDiskCache();
+	void CloseBlockDiskCache();
+	void PrecompileCachedBlocks();
+	void AddBlockToDiskCache(const JitBlock &b);
+
 public:
-	Jit64() : code_buffer(32000) {}
+	Jit64() : code_buffer(32000), use_block_disk_cache(false) {}
 	~Jit64() {}
 
 	void Init() override;
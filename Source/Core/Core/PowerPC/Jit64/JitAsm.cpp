@@ -2,6 +2,7 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include "Common/JitRegister.h"
 #include "Common/MemoryUtil.h"
 
 #include "Core/PowerPC/Jit64/Jit.h"
@@ -181,6 +182,8 @@ void Jit64AsmRoutineManager::Generate()
 	ABI_PopAllCalleeSavedRegsAndAdjustStack();
 	RET();
 
+	JitRegister::Register(enterCode, (u32)(GetCodePtr() - enterCode), "JIT_Loop");
+
 	GenerateCommon();
 }
 
@@ -196,6 +199,7 @@ void Jit64AsmRoutineManager::GenerateCommon()
 	GenFifoFloatWrite();
 	fifoDirectWriteXmm64 = AlignCode4();
 	GenFifoXmm64Write();
+	JitRegister::Register(fifoDirectWrite8, (u32)(GetCodePtr() - fifoDirectWrite8), "JIT_FifoWrite");
 
 	GenQuantizedLoads();
 	GenQuantizedStores();
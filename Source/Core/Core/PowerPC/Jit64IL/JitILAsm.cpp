@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include "Common/CPUDetect.h"
+#include "Common/JitRegister.h"
 #include "Common/MemoryUtil.h"
 
 #include "Core/PowerPC/Jit64IL/JitIL.h"
@@ -194,6 +195,8 @@ void JitILAsmRoutineManager::Generate()
 	ABI_PopAllCalleeSavedRegsAndAdjustStack();
 	RET();
 
+	JitRegister::Register(enterCode, (u32)(GetCodePtr() - enterCode), "JIT_Loop");
+
 	GenerateCommon();
 }
 
@@ -209,6 +212,7 @@ void JitILAsmRoutineManager::GenerateCommon()
 	GenFifoFloatWrite();
 	fifoDirectWriteXmm64 = AlignCode4();
 	GenFifoXmm64Write();
+	JitRegister::Register(fifoDirectWrite8, (u32)(GetCodePtr() - fifoDirectWrite8), "JIT_FifoWrite");
 
 	GenQuantizedLoads();
 	GenQuantizedStores();
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include "Common/CPUDetect.h"
+#include "Common/JitRegister.h"
 #include "Common/MemoryUtil.h"
 
 #include "Core/PowerPC/JitCommon/JitAsmCommon.h"
@@ -258,6 +259,8 @@ void CommonAsmRoutines::GenQuantizedStores()
 
 	RET();
 
+	JitRegister::Register(storePairedIllegal, (u32)(GetCodePtr() - storePairedIllegal), "JIT_QuantizedStore");
+
 	pairedStoreQuantized = reinterpret_cast<const u8**>(const_cast<u8*>(AlignCode16()));
 	ReserveCodeSpace(8 * sizeof(u8*));
 
@@ -336,6 +339,8 @@ void CommonAsmRoutines::GenQuantizedSingleStores()
 	SafeWriteRegToReg(EAX, ECX, 16, 0, QUANTIZED_REGS_TO_SAVE, SAFE_LOADSTORE_NO_PROLOG | SAFE_LOADSTORE_NO_FASTMEM);
 	RET();
 
+	JitRegister::Register(storeSingleIllegal, (u32)(GetCodePtr() - storeSingleIllegal), "JIT_QuantizedSingleStore");
+
 	singleStoreQuantized = reinterpret_cast<const u8**>(const_cast<u8*>(AlignCode16()));
 	ReserveCodeSpace(8 * sizeof(u8*));
 
@@ -515,6 +520,8 @@ void CommonAsmRoutines::GenQuantizedLoads()
 	UNPCKLPS(XMM0, M((void*)m_one));
 	RET();
 
+	JitRegister::Register(loadPairedIllegal, (u32)(GetCodePtr() - loadPairedIllegal), "JIT_QuantizedLoad");
+
 	pairedLoadQuantized = reinterpret_cast<const u8**>(const_cast<u8*>(AlignCode16()));
 	ReserveCodeSpace(16 * sizeof(u8*));
 
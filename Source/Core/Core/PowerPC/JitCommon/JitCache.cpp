@@ -9,11 +9,15 @@
 // performance hit, it's not enabled by default, but it's useful for
 // locating performance issues.
 
+#include <algorithm>
+
 #include "disasm.h"
 
 #include "Common/Common.h"
+#include "Common/JitRegister.h"
 #include "Common/MemoryUtil.h"
 #include "Core/PowerPC/JitInterface.h"
+#include "Core/PowerPC/PPCSymbolDB.h"
 #include "Core/PowerPC/JitCommon/JitBase.h"
 
 #ifdef _WIN32
@@ -46,6 +50,7 @@ using namespace Gen;
 #endif
 		blocks = new JitBlock[MAX_NUM_BLOCKS];
 		blockCodePointers = new const u8*[MAX_NUM_BLOCKS];
+		links_to = new JitBlock::LinkData*[LINKS_TO_SIZE];
 		if (iCache == nullptr && iCacheEx == nullptr && iCacheVMEM == nullptr)
 		{
 			iCache = new u8[JIT_ICACHE_SIZE];
@@ -70,6 +75,7 @@ using namespace Gen;
 	{
 		delete[] blocks;
 		delete[] blockCodePointers;
+		delete[] links_to;
 		if (iCache != nullptr)
 			delete[] iCache;
 		iCache = nullptr;
@@ -81,6 +87,7 @@ using namespace Gen;
 		iCacheVMEM = nullptr;
 		blocks = nullptr;
 		blockCodePointers = nullptr;
+		links_to = nullptr;
 		num_blocks = 0;
 #if defined USE_OPROFILE && USE_OPROFILE
 		op_close_agent(agent);
@@ -106,8 +113,8 @@ using namespace Gen;
 		{
 			DestroyBlock(i, false);
 		}
-		links_to.clear();
-		block_map.clear();
+		memset(links_to, 0, sizeof(JitBlock::LinkData*)*LINKS_TO_SIZE);
+		block_range_map.clear();
 		valid_block.reset();
 		num_blocks = 0;
 		memset(blockCodePointers, 0, sizeof(u8*)*MAX_NUM_BLOCKS);
@@ -182,18 +189,33 @@ using namespace Gen;
 		for (u32 i = 0; i < (b.originalSize + 7) / 8; ++i)
 			valid_block[pAddr / 32 + i] = true;
 
-		block_map[std::make_pair(pAddr + 4 * b.originalSize - 1, pAddr)] = block_num;
-		if (block_link)
+		AddBlockToRangeMap(block_num);
+		for (auto& e : b.linkData)
 		{
-			for (const auto& e : b.linkData)
-			{
-				links_to.insert(std::pair<u32, int>(e.exitAddress, block_num));
-			}
+			e.next_link = nullptr;
+			e.prev_link = nullptr;
+			if (block_link)
+				AddLink(e);
+		}
 
+		if (block_link)
+		{
 			LinkBlock(block_num);
 			LinkBlockExits(block_num);
 		}
 
+		if (JitRegister::IsEnabled())
+		{
+			// codeSize starts at the normal entry, the checked one is in front of it.
+			u32 size = (u32)(b.normalEntry + b.codeSize - b.checkedEntry);
+			Symbol* symbol = g_symbolDB.GetSymbolFromAddr(b.originalAddress);
+			if (symbol)
+				JitRegister::Register(b.checkedEntry, size, "JIT_PPC_%08x %s+0x%x",
+				                      b.originalAddress, symbol->name.c_str(), b.originalAddress - symbol->address);
+			else
+				JitRegister::Register(b.checkedEntry, size, "JIT_PPC_%08x", b.originalAddress);
+		}
+
 #if defined USE_OPROFILE && USE_OPROFILE
 		char buf[100];
 		sprintf(buf, "EmuCode%x", b.originalAddress);
@@ -225,11 +247,11 @@ using namespace Gen;
 	u32* JitBaseBlockCache::GetICachePtr(u32 addr)
 	{
 		if (addr & JIT_ICACHE_VMEM_BIT)
-			return (u32*)(jit->GetBlockCache()->iCacheVMEM + (addr & JIT_ICACHE_MASK));
+			return (u32*)(iCacheVMEM + (addr & JIT_ICACHE_MASK));
 		else if (addr & JIT_ICACHE_EXRAM_BIT)
-			return (u32*)(jit->GetBlockCache()->iCacheEx + (addr & JIT_ICACHEEX_MASK));
+			return (u32*)(iCacheEx + (addr & JIT_ICACHEEX_MASK));
 		else
-			return (u32*)(jit->GetBlockCache()->iCache + (addr & JIT_ICACHE_MASK));
+			return (u32*)(iCache + (addr & JIT_ICACHE_MASK));
 	}
 
 	int JitBaseBlockCache::GetBlockNumberFromStartAddress(u32 addr)
@@ -280,40 +302,90 @@ using namespace Gen;
 		}
 	}
 
-	using namespace std;
+	static u32 LinksToBucket(u32 address)
+	{
+		return (address >> 2) & (JitBaseBlockCache::LINKS_TO_SIZE - 1);
+	}
+
+	// The exits of live blocks are chained into links_to through their LinkData, so
+	// linking and unlinking never allocate. A block's linkData doesn't change between
+	// FinalizeBlock and DestroyBlock, which keeps the pointers into it valid.
+	void JitBaseBlockCache::AddLink(JitBlock::LinkData &e)
+	{
+		JitBlock::LinkData **head = &links_to[LinksToBucket(e.exitAddress)];
+		e.next_link = *head;
+		e.prev_link = head;
+		if (*head)
+			(*head)->prev_link = &e.next_link;
+		*head = &e;
+	}
+
+	void JitBaseBlockCache::RemoveLink(JitBlock::LinkData &e)
+	{
+		if (!e.prev_link)
+			return;
+		*e.prev_link = e.next_link;
+		if (e.next_link)
+			e.next_link->prev_link = e.prev_link;
+		e.next_link = nullptr;
+		e.prev_link = nullptr;
+	}
 
 	void JitBaseBlockCache::LinkBlock(int i)
 	{
 		LinkBlockExits(i);
 		JitBlock &b = blocks[i];
-		pair<multimap<u32, int>::iterator, multimap<u32, int>::iterator> ppp;
-		// equal_range(b) returns pair<iterator,iterator> representing the range
-		// of element with key b
-		ppp = links_to.equal_range(b.originalAddress);
-		if (ppp.first == ppp.second)
-			return;
-		for (multimap<u32, int>::iterator iter = ppp.first; iter != ppp.second; ++iter) {
-			// PanicAlert("Linking block %i to block %i", iter->second, i);
-			LinkBlockExits(iter->second);
+		for (JitBlock::LinkData *e = links_to[LinksToBucket(b.originalAddress)]; e; e = e->next_link)
+		{
+			if (e->exitAddress == b.originalAddress && !e->linkStatus)
+			{
+				WriteLinkBlock(e->exitPtrs, b.checkedEntry);
+				e->linkStatus = true;
+			}
 		}
 	}
 
+	// The exits stay chained, so they get linked again if the block is recompiled.
 	void JitBaseBlockCache::UnlinkBlock(int i)
 	{
 		JitBlock &b = blocks[i];
-		pair<multimap<u32, int>::iterator, multimap<u32, int>::iterator> ppp;
-		ppp = links_to.equal_range(b.originalAddress);
-		if (ppp.first == ppp.second)
-			return;
-		for (multimap<u32, int>::iterator iter = ppp.first; iter != ppp.second; ++iter) {
-			JitBlock &sourceBlock = blocks[iter->second];
-			for (auto& e : sourceBlock.linkData)
+		for (JitBlock::LinkData *e = links_to[LinksToBucket(b.originalAddress)]; e; e = e->next_link)
+		{
+			if (e->exitAddress == b.originalAddress)
+				e->linkStatus = false;
+		}
+	}
+
+	// Every block is listed in the bucket of each physical page it overlaps, so invalidating
+	// a range only has to look at the blocks living on the pages it touches.
+	void JitBaseBlockCache::AddBlockToRangeMap(int i)
+	{
+		const JitBlock &b = blocks[i];
+		u32 pAddr = b.originalAddress & 0x1FFFFFFF;
+		u32 pEnd = pAddr + 4 * std::max<u32>(b.originalSize, 1) - 1;
+		for (u32 page = pAddr >> BLOCK_RANGE_MAP_SHIFT; page <= pEnd >> BLOCK_RANGE_MAP_SHIFT; ++page)
+			block_range_map[page].push_back(i);
+	}
+
+	// Leaves empty buckets behind, so that callers iterating over the map stay valid.
+	void JitBaseBlockCache::RemoveBlockFromRangeMap(int i)
+	{
+		const JitBlock &b = blocks[i];
+		u32 pAddr = b.originalAddress & 0x1FFFFFFF;
+		u32 pEnd = pAddr + 4 * std::max<u32>(b.originalSize, 1) - 1;
+		for (u32 page = pAddr >> BLOCK_RANGE_MAP_SHIFT; page <= pEnd >> BLOCK_RANGE_MAP_SHIFT; ++page)
+		{
+			auto it = block_range_map.find(page);
+			if (it == block_range_map.end())
+				continue;
+			std::vector<int> &bucket = it->second;
+			auto pos = std::find(bucket.begin(), bucket.end(), i);
+			if (pos != bucket.end())
 			{
-				if (e.exitAddress == b.originalAddress)
-					e.linkStatus = false;
+				*pos = bucket.back();
+				bucket.pop_back();
 			}
 		}
-		links_to.erase(b.originalAddress);
 	}
 
 	void JitBaseBlockCache::DestroyBlock(int block_num, bool invalidate)
@@ -334,6 +406,8 @@ using namespace Gen;
 		*GetICachePtr(b.originalAddress) = JIT_ICACHE_INVALID_WORD;
 
 		UnlinkBlock(block_num);
+		for (auto& e : b.linkData)
+			RemoveLink(e);
 
 		// Send anyone who tries to run this block back to the dispatcher.
 		// Not entirely ideal, but .. pretty good.
@@ -357,20 +431,37 @@ using namespace Gen;
 		}
 
 		// destroy JIT blocks
-		// !! this works correctly under assumption that any two overlapping blocks end at the same address
-		if (destroy_block)
+		if (destroy_block && length != 0)
 		{
-			std::map<pair<u32,u32>, u32>::iterator it1 = block_map.lower_bound(std::make_pair(pAddr, 0)), it2 = it1;
-			while (it2 != block_map.end() && it2->first.second < pAddr + length)
-		{
-				JitBlock &b = blocks[it2->second];
-				*GetICachePtr(b.originalAddress) = JIT_ICACHE_INVALID_WORD;
-				DestroyBlock(it2->second, true);
-				++it2;
-			}
-			if (it1 != it2)
+			u32 pEnd = pAddr + length - 1;
+			for (u32 page = pAddr >> BLOCK_RANGE_MAP_SHIFT; page <= pEnd >> BLOCK_RANGE_MAP_SHIFT; ++page)
 			{
-				block_map.erase(it1, it2);
+				auto it = block_range_map.find(page);
+				if (it == block_range_map.end())
+					continue;
+
+				std::vector<int> &bucket = it->second;
+				size_t j = 0;
+				while (j < bucket.size())
+				{
+					int block_num = bucket[j];
+					JitBlock &b = blocks[block_num];
+					u32 bStart = b.originalAddress & 0x1FFFFFFF;
+					u32 bEnd = bStart + 4 * std::max<u32>(b.originalSize, 1) - 1;
+					if (bStart <= pEnd && bEnd >= pAddr)
+					{
+						// This also removes the block from bucket[j], so don't advance.
+						if (!b.invalid)
+							DestroyBlock(block_num, true);
+						RemoveBlockFromRangeMap(block_num);
+					}
+					else
+					{
+						++j;
+					}
+				}
+				if (bucket.empty())
+					block_range_map.erase(it);
 			}
 		}
 
@@ -5,7 +5,7 @@
 #pragma once
 
 #include <bitset>
-#include <map>
+#include <unordered_map>
 #include <vector>
 
 #include "Core/PowerPC/Gekko.h"
@@ -46,16 +46,17 @@ struct JitBlock
 		u8 *exitPtrs;    // to be able to rewrite the exit jum
 		u32 exitAddress;
 		bool linkStatus; // is it already linked?
+		// Chains the exits jumping into the same links_to bucket. Set up by the block cache.
+		LinkData *next_link;
+		LinkData **prev_link;
 	};
 	std::vector<LinkData> linkData;
 
-#ifdef _WIN32
 	// we don't really need to save start and stop
 	// TODO (mb2): ticStart and ticStop -> "local var" mean "in block" ... low priority ;)
 	u64 ticStart;   // for profiling - time.
 	u64 ticStop;    // for profiling - time.
 	u64 ticCounter; // for profiling - time.
-#endif
 
 #ifdef USE_VTUNE
 	char blockName[32];
@@ -70,26 +71,36 @@ class JitBaseBlockCache
 	const u8 **blockCodePointers;
 	JitBlock *blocks;
 	int num_blocks;
-	std::multimap<u32, int> links_to;
-	std::map<std::pair<u32,u32>, u32> block_map; // (end_addr, start_addr) -> number
+	JitBlock::LinkData **links_to; // hashed exit address -> exits jumping there
+	std::unordered_map<u32, std::vector<int>> block_range_map; // physical page -> blocks overlapping it
 	std::bitset<0x20000000 / 32> valid_block;
 	enum
 	{
-		MAX_NUM_BLOCKS = 65536*2
+		BLOCK_RANGE_MAP_SHIFT = 12, // 4 KiB pages
 	};
 
 	bool RangeIntersect(int s1, int e1, int s2, int e2) const;
 	void LinkBlockExits(int i);
 	void LinkBlock(int i);
 	void UnlinkBlock(int i);
+	void AddLink(JitBlock::LinkData &e);
+	void RemoveLink(JitBlock::LinkData &e);
+	void AddBlockToRangeMap(int i);
+	void RemoveBlockFromRangeMap(int i);
 
 	// Virtual for overloaded
 	virtual void WriteLinkBlock(u8* location, const u8* address) = 0;
 	virtual void WriteDestroyBlock(const u8* location, u32 address) = 0;
 
 public:
+	enum
+	{
+		MAX_NUM_BLOCKS = 65536*2,
+		LINKS_TO_SIZE = 0x10000,
+	};
+
 	JitBaseBlockCache() :
-		blockCodePointers(nullptr), blocks(nullptr), num_blocks(0),
+		blockCodePointers(nullptr), blocks(nullptr), num_blocks(0), links_to(nullptr),
 		iCache(nullptr), iCacheEx(nullptr), iCacheVMEM(nullptr) {}
 	int AllocateBlock(u32 em_address);
 	void FinalizeBlock(int block_num, bool block_link, const u8 *code_ptr);
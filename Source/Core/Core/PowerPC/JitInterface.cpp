@@ -124,63 +124,33 @@ namespace JitInterface
 		return jit;
 	}
 
-	void WriteProfileResults(const std::string& filename)
+	void GetProfileResults(ProfileStats* prof_stats)
 	{
+		prof_stats->block_stats.clear();
+		prof_stats->cost_sum = 0;
+		prof_stats->timecost_sum = 0;
+		prof_stats->countsPerSec = 0;
+
 		// Can't really do this with no jit core available
 		#if _M_X86
 
-		std::vector<BlockStat> stats;
-		stats.reserve(jit->GetBlockCache()->GetNumBlocks());
-		u64 cost_sum = 0;
-	#ifdef _WIN32
-		u64 timecost_sum = 0;
-		u64 countsPerSec;
-		QueryPerformanceFrequency((LARGE_INTEGER *)&countsPerSec);
-	#endif
+		prof_stats->countsPerSec = Profiler::GetTimerFrequency();
+		prof_stats->block_stats.reserve(jit->GetBlockCache()->GetNumBlocks());
 		for (int i = 0; i < jit->GetBlockCache()->GetNumBlocks(); i++)
 		{
 			const JitBlock *block = jit->GetBlockCache()->GetBlock(i);
 			// Rough heuristic.  Mem instructions should cost more.
 			u64 cost = block->originalSize * (block->runCount / 4);
-	#ifdef _WIN32
 			u64 timecost = block->ticCounter;
-	#endif
 			// Todo: tweak.
 			if (block->runCount >= 1)
-				stats.push_back(BlockStat(i, cost));
-			cost_sum += cost;
-	#ifdef _WIN32
-			timecost_sum += timecost;
-	#endif
+				prof_stats->block_stats.emplace_back(i, block->originalAddress, cost, timecost,
+				                                     block->runCount, block->codeSize);
+			prof_stats->cost_sum += cost;
+			prof_stats->timecost_sum += timecost;
 		}
 
-		sort(stats.begin(), stats.end());
-		File::IOFile f(filename, "w");
-		if (!f)
-		{
-			PanicAlert("Failed to open %s", filename.c_str());
-			return;
-		}
-		fprintf(f.GetHandle(), "origAddr\tblkName\tcost\ttimeCost\tpercent\ttimePercent\tOvAllinBlkTime(ms)\tblkCodeSize\n");
-		for (auto& stat : stats)
-		{
-			const JitBlock *block = jit->GetBlockCache()->GetBlock(stat.blockNum);
-			if (block)
-			{
-				std::string name = g_symbolDB.GetDescription(block->originalAddress);
-				double percent = 100.0 * (double)stat.cost / (double)cost_sum;
-	#ifdef _WIN32
-				double timePercent = 100.0 * (double)block->ticCounter / (double)timecost_sum;
-				fprintf(f.GetHandle(), "%08x\t%s\t%" PRIu64 "\t%" PRIu64 "\t%.2lf\t%llf\t%lf\t%i\n",
-						block->originalAddress, name.c_str(), stat.cost,
-						block->ticCounter, percent, timePercent,
-						(double)block->ticCounter*1000.0/(double)countsPerSec, block->codeSize);
-	#else
-				fprintf(f.GetHandle(), "%08x\t%s\t%" PRIu64 "\t???\t%.2lf\t???\t???\t%i\n",
-						block->originalAddress, name.c_str(), stat.cost,  percent, block->codeSize);
-	#endif
-			}
-		}
+		sort(prof_stats->block_stats.begin(), prof_stats->block_stats.end());
 		#endif
 	}
 	bool IsInCodeSpace(u8 *ptr)
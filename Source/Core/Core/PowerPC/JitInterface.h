@@ -7,6 +7,7 @@
 #include <string>
 #include "Common/ChunkFile.h"
 #include "Core/PowerPC/CPUCoreBase.h"
+#include "Core/PowerPC/Profiler.h"
 
 namespace JitInterface
 {
@@ -17,7 +18,7 @@ namespace JitInterface
 	CPUCoreBase *GetCore();
 
 	// Debugging
-	void WriteProfileResults(const std::string& filename);
+	void GetProfileResults(ProfileStats* prof_stats);
 
 	// Memory Utilities
 	bool IsInCodeSpace(u8 *ptr);
@@ -25,6 +25,18 @@ enum CoreMode
 	MODE_JIT,
 };
 
+enum
+{
+	TLB_SIZE = 128,
+};
+
+// One cached translation of an effective page to a physical one.
+struct TLBEntry
+{
+	u32 tag;    // The effective page address, with flags in the low bits.
+	u32 paddr;  // The physical page address.
+};
+
 // This contains the entire state of the emulated PowerPC "Gekko" CPU.
 struct GC_ALIGNED64(PowerPCState)
 {
@@ -56,13 +68,9 @@ struct GC_ALIGNED64(PowerPCState)
 	// also for power management, but we don't care about that.
 	u32 spr[1024];
 
-	u32 dtlb_last;
-	u32 dtlb_va[128];
-	u32 dtlb_pa[128];
-
-	u32 itlb_last;
-	u32 itlb_va[128];
-	u32 itlb_pa[128];
+	// Cached address translations, indexed by [instruction fetch][user mode][page].
+	// See Memory::TranslateAddress.
+	TLBEntry tlb[2][2][TLB_SIZE];
 
 	u32 pagetable_base;
 	u32 pagetable_hashmask;
@@ -2,8 +2,30 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cctype>
+#include <cinttypes>
+#include <map>
 #include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <intrin.h>
+#elif _M_X86
+#include <x86intrin.h>
+#endif
+
+#include "Common/Common.h"
+#include "Common/FileUtil.h"
+#include "Common/StringUtil.h"
+#include "Common/SymbolDB.h"
+#include "Common/Thread.h"
+#include "Common/Timer.h"
+
 #include "Core/PowerPC/JitInterface.h"
+#include "Core/PowerPC/PPCSymbolDB.h"
+#include "Core/PowerPC/Profiler.h"
 
 namespace Profiler
 {
@@ -11,9 +33,195 @@ namespace Profiler
 bool g_ProfileBlocks;
 bool g_ProfileInstructions;
 
+u64 GetTimerFrequency()
+{
+#if defined(_WIN32) && _M_X86_32
+	u64 countsPerSec;
+	QueryPerformanceFrequency((LARGE_INTEGER *)&countsPerSec);
+	return countsPerSec;
+#elif _M_X86_64
+	// There's no portable way to ask for the TSC rate, so time it against the clock.
+	static u64 s_tsc_frequency;
+	if (!s_tsc_frequency)
+	{
+		const u64 start_us = Common::Timer::GetTimeUs();
+		const u64 start_tsc = __rdtsc();
+		Common::SleepCurrentThread(50);
+		const u64 elapsed_tsc = __rdtsc() - start_tsc;
+		const u64 elapsed_us = Common::Timer::GetTimeUs() - start_us;
+		s_tsc_frequency = elapsed_tsc * 1000000 / std::max<u64>(elapsed_us, 1);
+	}
+	return s_tsc_frequency;
+#else
+	return 0;
+#endif
+}
+
+// All the blocks of one guest function, or one block if there's no symbol for it.
+struct FunctionStat
+{
+	u32 address;
+	std::string name;
+	u32 num_blocks;
+	u64 run_count;
+	u64 cost;
+	u64 tick_counter;
+};
+
+static std::vector<FunctionStat> GetFunctionStats(const ProfileStats& prof_stats)
+{
+	std::map<u32, FunctionStat> functions;
+	for (const BlockStat& stat : prof_stats.block_stats)
+	{
+		Symbol* symbol = g_symbolDB.GetSymbolFromAddr(stat.addr);
+		u32 address = symbol ? symbol->address : stat.addr;
+
+		auto it = functions.find(address);
+		if (it == functions.end())
+		{
+			FunctionStat function = { address, symbol ? symbol->name : StringFromFormat("(%08x)", stat.addr), 0, 0, 0, 0 };
+			it = functions.insert(std::make_pair(address, function)).first;
+		}
+		it->second.num_blocks++;
+		it->second.cost += stat.cost;
+		it->second.tick_counter += stat.tick_counter;
+		// Only entries into the function itself count as calls.
+		if (stat.addr == address)
+			it->second.run_count += stat.run_count;
+	}
+
+	std::vector<FunctionStat> result;
+	for (auto& function : functions)
+		result.push_back(function.second);
+	std::sort(result.begin(), result.end(), [](const FunctionStat& a, const FunctionStat& b) {
+		return a.tick_counter != b.tick_counter ? a.tick_counter > b.tick_counter : a.cost > b.cost;
+	});
+	return result;
+}
+
+static double Percent(u64 part, u64 total)
+{
+	return total ? 100.0 * (double)part / (double)total : 0.0;
+}
+
+static double Milliseconds(u64 ticks, u64 countsPerSec)
+{
+	return countsPerSec ? (double)ticks * 1000.0 / (double)countsPerSec : 0.0;
+}
+
+static std::string QuoteCSV(const std::string& str)
+{
+	std::string result = "\"";
+	for (char c : str)
+	{
+		if (c == '"')
+			result += '"';
+		result += c;
+	}
+	return result + "\"";
+}
+
+static std::string QuoteJSON(const std::string& str)
+{
+	std::string result = "\"";
+	for (char c : str)
+	{
+		if (c == '"' || c == '\\')
+			result += '\\';
+		if ((unsigned char)c < 0x20)
+			result += StringFromFormat("\\u%04x", c);
+		else
+			result += c;
+	}
+	return result + "\"";
+}
+
+static void WriteText(FILE* f, const ProfileStats& prof_stats)
+{
+	fprintf(f, "origAddr\tblkName\tcost\ttimeCost\tpercent\ttimePercent\tOvAllinBlkTime(ms)\tblkCodeSize\n");
+	for (const BlockStat& stat : prof_stats.block_stats)
+	{
+		std::string name = g_symbolDB.GetDescription(stat.addr);
+		double percent = Percent(stat.cost, prof_stats.cost_sum);
+		if (prof_stats.countsPerSec)
+		{
+			fprintf(f, "%08x\t%s\t%" PRIu64 "\t%" PRIu64 "\t%.2lf\t%.2lf\t%lf\t%i\n",
+			        stat.addr, name.c_str(), stat.cost, stat.tick_counter, percent,
+			        Percent(stat.tick_counter, prof_stats.timecost_sum),
+			        Milliseconds(stat.tick_counter, prof_stats.countsPerSec), stat.block_size);
+		}
+		else
+		{
+			fprintf(f, "%08x\t%s\t%" PRIu64 "\t???\t%.2lf\t???\t???\t%i\n",
+			        stat.addr, name.c_str(), stat.cost, percent, stat.block_size);
+		}
+	}
+}
+
+static void WriteCSV(FILE* f, const ProfileStats& prof_stats)
+{
+	fprintf(f, "address,name,blocks,calls,cost,cycles,cost_percent,time_percent,time_ms\n");
+	for (const FunctionStat& function : GetFunctionStats(prof_stats))
+	{
+		fprintf(f, "%08x,%s,%u,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%.2f,%.2f,%f\n",
+		        function.address, QuoteCSV(function.name).c_str(), function.num_blocks,
+		        function.run_count, function.cost, function.tick_counter,
+		        Percent(function.cost, prof_stats.cost_sum),
+		        Percent(function.tick_counter, prof_stats.timecost_sum),
+		        Milliseconds(function.tick_counter, prof_stats.countsPerSec));
+	}
+}
+
+static void WriteJSON(FILE* f, const ProfileStats& prof_stats)
+{
+	fprintf(f, "{\n\t\"timer_frequency\": %" PRIu64 ",\n\t\"total_cost\": %" PRIu64 ",\n\t\"total_cycles\": %" PRIu64 ",\n",
+	        prof_stats.countsPerSec, prof_stats.cost_sum, prof_stats.timecost_sum);
+
+	fprintf(f, "\t\"functions\": [");
+	const char* separator = "\n";
+	for (const FunctionStat& function : GetFunctionStats(prof_stats))
+	{
+		fprintf(f, "%s\t\t{\"address\": %u, \"name\": %s, \"blocks\": %u, \"calls\": %" PRIu64 ", \"cost\": %" PRIu64 ", \"cycles\": %" PRIu64 "}",
+		        separator, function.address, QuoteJSON(function.name).c_str(), function.num_blocks,
+		        function.run_count, function.cost, function.tick_counter);
+		separator = ",\n";
+	}
+	fprintf(f, "\n\t],\n");
+
+	fprintf(f, "\t\"blocks\": [");
+	separator = "\n";
+	for (const BlockStat& stat : prof_stats.block_stats)
+	{
+		fprintf(f, "%s\t\t{\"address\": %u, \"symbol\": %s, \"runs\": %" PRIu64 ", \"cost\": %" PRIu64 ", \"cycles\": %" PRIu64 ", \"code_size\": %u}",
+		        separator, stat.addr, QuoteJSON(g_symbolDB.GetDescription(stat.addr)).c_str(),
+		        stat.run_count, stat.cost, stat.tick_counter, stat.block_size);
+		separator = ",\n";
+	}
+	fprintf(f, "\n\t]\n}\n");
+}
+
 void WriteProfileResults(const std::string& filename)
 {
-	JitInterface::WriteProfileResults(filename);
+	ProfileStats prof_stats;
+	JitInterface::GetProfileResults(&prof_stats);
+
+	File::IOFile f(filename, "w");
+	if (!f)
+	{
+		PanicAlert("Failed to open %s", filename.c_str());
+		return;
+	}
+
+	std::string extension;
+	SplitPath(filename, nullptr, nullptr, &extension);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+	if (extension == ".csv")
+		WriteCSV(f.GetHandle(), prof_stats);
+	else if (extension == ".json")
+		WriteJSON(f.GetHandle(), prof_stats);
+	else
+		WriteText(f.GetHandle(), prof_stats);
 }
 
 }  // namespace
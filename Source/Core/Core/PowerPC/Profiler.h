@@ -6,10 +6,11 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
-#ifdef _WIN32
+#include "Common/CommonTypes.h"
 
-#if _M_X86_32
+#if defined(_WIN32) && _M_X86_32
 #define PROFILER_QUERY_PERFORMANCE_COUNTER(pt)      \
                     LEA(32, EAX, M(pt)); PUSH(EAX); \
                     CALL(QueryPerformanceCounter)
@@ -29,13 +30,22 @@
 #define PROFILER_VPUSH  PUSH(EAX);PUSH(ECX);PUSH(EDX)
 #define PROFILER_VPOP   POP(EDX);POP(ECX);POP(EAX)
 
-#else
+#elif _M_X86_64
+// The time stamp counter, which counts at a fixed rate on anything recent.
+// Both clobber RAX and RDX (and the flags).
+#define PROFILER_QUERY_PERFORMANCE_COUNTER(pt)      \
+                    RDTSC();                        \
+                    SHL(64, R(RDX), Imm8(32));      \
+                    OR(64, R(RAX), R(RDX));         \
+                    MOV(64, M(pt), R(RAX))
+// asm write : (u64) dt += t1-t0
+#define PROFILER_ADD_DIFF_LARGE_INTEGER(pdt, pt1, pt0)  \
+                    MOV(64, R(RAX), M(pt1));            \
+                    SUB(64, R(RAX), M(pt0));            \
+                    ADD(64, M(pdt), R(RAX))
 
-#define PROFILER_QUERY_PERFORMANCE_COUNTER(pt)
-#define PROFILER_ADD_DIFF_LARGE_INTEGER(pdt, pt1, pt0)
-#define PROFILER_VPUSH
-#define PROFILER_VPOP
-#endif
+#define PROFILER_VPUSH  PUSH(RAX);PUSH(RCX);PUSH(RDX)
+#define PROFILER_VPOP   POP(RDX);POP(RCX);POP(RAX)
 
 #else
 // TODO
@@ -47,18 +57,36 @@
 
 struct BlockStat
 {
-	BlockStat(int bn, u64 c) : blockNum(bn), cost(c) {}
+	BlockStat(int bn, u32 _addr, u64 c, u64 ticks, u64 run, u32 size) :
+		blockNum(bn), addr(_addr), cost(c), tick_counter(ticks), run_count(run), block_size(size) {}
 	int blockNum;
+	u32 addr;
 	u64 cost;
+	u64 tick_counter;
+	u64 run_count;
+	u32 block_size;
 
 	bool operator <(const BlockStat &other) const
 	{ return cost > other.cost; }
 };
 
+struct ProfileStats
+{
+	std::vector<BlockStat> block_stats;
+	u64 cost_sum;
+	u64 timecost_sum;
+	u64 countsPerSec;
+};
+
 namespace Profiler
 {
 extern bool g_ProfileBlocks;
 extern bool g_ProfileInstructions;
 
+// Ticks per second of the counter the JIT profiles blocks with, or 0 if it doesn't.
+u64 GetTimerFrequency();
+
+// The format follows the extension: per-function costs for .csv, blocks and
+// functions for .json, and the old per-block table for anything else.
 void WriteProfileResults(const std::string& filename);
 }
@@ -0,0 +1,242 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <vector>
+
+#include "Common/Common.h"
+#include "Common/StdConditionVariable.h"
+#include "Common/StdMutex.h"
+#include "Common/StdThread.h"
+#include "Common/StringUtil.h"
+#include "Common/Thread.h"
+
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/Rewind.h"
+#include "Core/RewindDelta.h"
+#include "Core/State.h"
+
+namespace Rewind
+{
+
+// The history is a chain of snapshots in time order. Only the newest one is kept
+// as-is, every older one is a Delta against the snapshot that followed it.
+
+static int s_capture_event;
+static bool s_enabled;
+static u32 s_interval;
+static size_t s_memory_limit;
+static u32 s_fields_since_capture;
+
+static std::mutex s_history_lock;
+static std::vector<u8> s_newest;
+static std::vector<u8> s_pending;
+static std::vector<u8> s_scratch;
+static DeltaEncoder s_encoder;
+static std::deque<Delta> s_deltas;
+static size_t s_delta_bytes;
+
+// Compressing a delta takes far longer than serializing the state, so it happens on
+// a worker thread that lives as long as the emulation. A capture that comes due
+// while the previous one is still being compressed is postponed rather than
+// stalling the CPU thread.
+static std::thread s_compress_thread;
+static std::mutex s_compress_lock;
+static std::condition_variable s_compress_cond;
+static std::atomic<bool> s_compressing(false);
+static bool s_compress_quit;
+
+static void TrimHistory()
+{
+	while (!s_deltas.empty() && s_newest.size() + s_delta_bytes > s_memory_limit)
+	{
+		s_delta_bytes -= s_deltas.front().data.size();
+		s_deltas.pop_front();
+	}
+}
+
+// Turns the current newest snapshot into a delta against s_pending, then makes
+// s_pending the newest snapshot.
+static void PushPendingSnapshot()
+{
+	std::lock_guard<std::mutex> lk(s_history_lock);
+
+	if (!s_newest.empty())
+	{
+		Delta delta;
+		if (s_encoder.Encode(s_newest, s_pending, delta))
+		{
+			s_delta_bytes += delta.data.size();
+			s_deltas.push_back(std::move(delta));
+		}
+		else
+		{
+			// The chain is broken, older snapshots can't be reached anymore.
+			ERROR_LOG(COMMON, "Rewind: compressing snapshot failed, dropping history");
+			s_deltas.clear();
+			s_delta_bytes = 0;
+		}
+	}
+
+	// Reuse the old buffer for the next capture.
+	s_newest.swap(s_pending);
+	TrimHistory();
+}
+
+static void CompressThreadFunc()
+{
+	Common::SetCurrentThreadName("Rewind thread");
+
+	std::unique_lock<std::mutex> lk(s_compress_lock);
+	while (true)
+	{
+		s_compress_cond.wait(lk, [] { return s_compress_quit || s_compressing; });
+		if (s_compress_quit)
+			return;
+
+		lk.unlock();
+		PushPendingSnapshot();
+		lk.lock();
+
+		s_compressing = false;
+		s_compress_cond.notify_all();
+	}
+}
+
+// Waits for the snapshot being compressed, if any.
+static void Flush()
+{
+	std::unique_lock<std::mutex> lk(s_compress_lock);
+	s_compress_cond.wait(lk, [] { return !s_compressing; });
+}
+
+static void CaptureCallback(u64 userdata, int cyclesLate)
+{
+	if (!s_enabled || s_compressing)
+		return;
+
+	State::SaveToBuffer(s_pending);
+
+	std::lock_guard<std::mutex> lk(s_compress_lock);
+	s_compressing = true;
+	s_compress_cond.notify_all();
+}
+
+void Init()
+{
+	const SCoreStartupParameter& StartUp = SConfig::GetInstance().m_LocalCoreStartupParameter;
+
+	// Always registered so savestates don't depend on whether rewind is enabled.
+	s_capture_event = CoreTiming::RegisterEvent("RewindCapture", CaptureCallback);
+
+	s_enabled = StartUp.bRewind;
+	s_interval = std::max(StartUp.iRewindInterval, 1);
+	s_memory_limit = (size_t)std::max(StartUp.iRewindMemoryMB, 1) * 1024 * 1024;
+	s_fields_since_capture = 0;
+
+	if (s_enabled)
+	{
+		s_compress_quit = false;
+		s_compress_thread = std::thread(CompressThreadFunc);
+	}
+}
+
+void Shutdown()
+{
+	Clear();
+	s_enabled = false;
+
+	if (s_compress_thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lk(s_compress_lock);
+			s_compress_quit = true;
+		}
+		s_compress_cond.notify_all();
+		s_compress_thread.join();
+	}
+}
+
+void FieldUpdate()
+{
+	if (!s_enabled)
+		return;
+
+	if (++s_fields_since_capture >= s_interval && !s_compressing)
+	{
+		s_fields_since_capture = 0;
+		// Snapshot from a scheduler event of its own rather than from inside the VI
+		// event, which hasn't rescheduled itself yet at this point.
+		CoreTiming::ScheduleEvent(0, s_capture_event);
+	}
+}
+
+void StepBack()
+{
+	if (!s_enabled)
+		return;
+
+	// Keeps the CPU thread from starting a capture while the history is rewritten.
+	bool wasUnpaused = Core::PauseAndLock(true);
+	Flush();
+
+	std::lock_guard<std::mutex> lk(s_history_lock);
+
+	if (s_newest.empty())
+	{
+		Core::DisplayMessage("No rewind history", 2000);
+		Core::PauseAndLock(false, wasUnpaused);
+		return;
+	}
+
+	State::LoadFromBuffer(s_newest);
+	s_fields_since_capture = 0;
+
+	if (s_deltas.empty())
+	{
+		s_newest.clear();
+	}
+	else
+	{
+		Delta& delta = s_deltas.back();
+		if (!DecodeDelta(delta, s_newest, s_scratch))
+		{
+			ERROR_LOG(COMMON, "Rewind: decompressing snapshot failed, dropping history");
+			s_newest.clear();
+			s_deltas.clear();
+			s_delta_bytes = 0;
+		}
+		else
+		{
+			s_newest.swap(s_scratch);
+			s_delta_bytes -= delta.data.size();
+			s_deltas.pop_back();
+		}
+	}
+
+	Core::DisplayMessage(StringFromFormat("Rewound (%u snapshots left)",
+		(u32)(s_deltas.size() + !s_newest.empty())), 1000);
+
+	Core::PauseAndLock(false, wasUnpaused);
+}
+
+void Clear()
+{
+	Flush();
+
+	std::lock_guard<std::mutex> lk(s_history_lock);
+	std::vector<u8>().swap(s_newest);
+	std::vector<u8>().swap(s_pending);
+	std::vector<u8>().swap(s_scratch);
+	s_encoder.Clear();
+	s_deltas.clear();
+	s_delta_bytes = 0;
+	s_fields_since_capture = 0;
+}
+
+}
@@ -0,0 +1,28 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+
+// In-memory rewind history built on top of State::SaveToBuffer.
+
+#pragma once
+
+namespace Rewind
+{
+
+void Init();
+
+void Shutdown();
+
+// Called from the CPU thread at the end of every VI field. Schedules a snapshot
+// once every configured number of fields.
+void FieldUpdate();
+
+// Loads the newest snapshot in the history and drops it, so calling this
+// repeatedly keeps stepping further back.
+void StepBack();
+
+// Throws away the whole history.
+void Clear();
+
+}
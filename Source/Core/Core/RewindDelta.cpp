@@ -0,0 +1,74 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <lzo/lzo1x.h>
+
+#include "Common/Common.h"
+
+#include "Core/RewindDelta.h"
+
+namespace Rewind
+{
+
+static void XorInto(u8* dst, const u8* src, size_t size)
+{
+	size_t i = 0;
+	for (; i + sizeof(u64) <= size; i += sizeof(u64))
+	{
+		u64 a, b;
+		memcpy(&a, dst + i, sizeof(u64));
+		memcpy(&b, src + i, sizeof(u64));
+		a ^= b;
+		memcpy(dst + i, &a, sizeof(u64));
+	}
+	for (; i < size; ++i)
+		dst[i] ^= src[i];
+}
+
+bool DeltaEncoder::Encode(std::vector<u8>& older, const std::vector<u8>& newer, Delta& delta)
+{
+	const size_t size = older.size();
+	if (size == 0)
+		return false;
+
+	XorInto(&older[0], newer.data(), std::min(size, newer.size()));
+
+	// operator new memory is aligned enough for lzo_align_t.
+	m_wrkmem.resize(LZO1X_1_MEM_COMPRESS);
+	m_scratch.resize(size + size / 16 + 64 + 3);
+	lzo_uint out_len = 0;
+	if (lzo1x_1_compress(&older[0], size, &m_scratch[0], &out_len, &m_wrkmem[0]) != LZO_E_OK)
+		return false;
+
+	delta.size = size;
+	delta.data.assign(m_scratch.begin(), m_scratch.begin() + out_len);
+	return true;
+}
+
+void DeltaEncoder::Clear()
+{
+	std::vector<u8>().swap(m_scratch);
+	std::vector<u8>().swap(m_wrkmem);
+}
+
+bool DecodeDelta(const Delta& delta, const std::vector<u8>& newer, std::vector<u8>& older)
+{
+	older.resize(delta.size);
+	if (delta.size == 0 || delta.data.empty())
+		return false;
+
+	lzo_uint new_len = delta.size;
+	if (lzo1x_decompress_safe(&delta.data[0], delta.data.size(), &older[0], &new_len, nullptr) != LZO_E_OK ||
+	    new_len != delta.size)
+	{
+		return false;
+	}
+
+	XorInto(&older[0], newer.data(), std::min(delta.size, newer.size()));
+	return true;
+}
+
+} // namespace Rewind
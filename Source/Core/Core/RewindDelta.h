@@ -0,0 +1,45 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// The snapshot encoding of the rewind history, shared by Rewind and its tests.
+
+#pragma once
+
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace Rewind
+{
+
+// An older snapshot, stored as the LZO-compressed XOR of itself against the
+// snapshot that followed it. Consecutive snapshots only differ in a small part of
+// RAM, so the XOR is mostly zeros and compresses to a fraction of a full state.
+struct Delta
+{
+	// size of the older state this delta reconstructs
+	size_t size;
+	std::vector<u8> data;
+};
+
+// Keeps the compression buffers around between snapshots.
+class DeltaEncoder
+{
+public:
+	// Encodes older against newer into delta. older is left holding the XOR of the two.
+	bool Encode(std::vector<u8>& older, const std::vector<u8>& newer, Delta& delta);
+
+	// Frees the buffers until the next Encode.
+	void Clear();
+
+private:
+	std::vector<u8> m_scratch;
+	std::vector<u8> m_wrkmem;
+};
+
+// Rebuilds the snapshot delta was encoded from, given the newer snapshot it was
+// encoded against.
+bool DecodeDelta(const Delta& delta, const std::vector<u8>& newer, std::vector<u8>& older);
+
+} // namespace Rewind
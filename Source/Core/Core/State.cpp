@@ -6,6 +6,7 @@
 
 #include "Common/Common.h"
 #include "Common/Event.h"
+#include "Common/FileUtil.h"
 #include "Common/StdMutex.h"
 #include "Common/StdThread.h"
 #include "Common/StringUtil.h"
@@ -16,6 +17,7 @@
 #include "Core/CoreTiming.h"
 #include "Core/Movie.h"
 #include "Core/State.h"
+#include "Core/StateCompression.h"
 #include "Core/HW/CPU.h"
 #include "Core/HW/DSP.h"
 #include "Core/HW/HW.h"
@@ -30,23 +32,6 @@
 namespace State
 {
 
-#if defined(__LZO_STRICT_16BIT)
-static const u32 IN_LEN = 8 * 1024u;
-#elif defined(LZO_ARCH_I086) && !defined(LZO_HAVE_MM_HUGE_ARRAY)
-static const u32 IN_LEN = 60 * 1024u;
-#else
-static const u32 IN_LEN = 128 * 1024u;
-#endif
-
-static const u32 OUT_LEN = IN_LEN + (IN_LEN / 16) + 64 + 3;
-
-static unsigned char __LZO_MMODEL out[OUT_LEN];
-
-#define HEAP_ALLOC(var, size) \
-	lzo_align_t __LZO_MMODEL var[((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t)]
-
-static HEAP_ALLOC(wrkmem, LZO1X_1_MEM_COMPRESS);
-
 static std::string g_last_filename;
 
 static CallbackFunc g_onAfterLoadCb = nullptr;
@@ -63,7 +48,7 @@ static Common::Event g_compressAndDumpStateSyncEvent;
 static std::thread g_save_thread;
 
 // Don't forget to increase this after doing changes on the savestate system
-static const u32 STATE_VERSION = 22;
+static const u32 STATE_VERSION = 24;
 
 enum
 {
@@ -259,32 +244,11 @@ void CompressAndDumpState(CompressAndDumpState_args save_args)
 
 	if (header.size != 0) // non-zero header size means the state is compressed
 	{
-		lzo_uint i = 0;
-		while (true)
+		if (!CompressStateChunks(f, buffer_data, buffer_size))
 		{
-			lzo_uint32 cur_len = 0;
-			lzo_uint out_len = 0;
-
-			if ((i + IN_LEN) >= buffer_size)
-			{
-				cur_len = (lzo_uint32)(buffer_size - i);
-			}
-			else
-			{
-				cur_len = IN_LEN;
-			}
-
-			if (lzo1x_1_compress(buffer_data + i, cur_len, out, &out_len, wrkmem) != LZO_E_OK)
-				PanicAlertT("Internal LZO Error - compression failed");
-
-			// The size of the data to write is 'out_len'
-			f.WriteArray((lzo_uint32*)&out_len, 1);
-			f.WriteBytes(out, out_len);
-
-			if (cur_len != IN_LEN)
-				break;
-
-			i += cur_len;
+			Core::DisplayMessage("Could not save state", 2000);
+			g_compressAndDumpStateSyncEvent.Set();
+			return;
 		}
 	}
 	else // uncompressed
@@ -384,27 +348,8 @@ void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_data)
 
 		buffer.resize(header.size);
 
-		lzo_uint i = 0;
-		while (true)
-		{
-			lzo_uint32 cur_len = 0;  // number of bytes to read
-			lzo_uint new_len = 0;  // number of bytes to write
-
-			if (!f.ReadArray(&cur_len, 1))
-				break;
-
-			f.ReadBytes(out, cur_len);
-			const int res = lzo1x_decompress(out, cur_len, &buffer[i], &new_len, nullptr);
-			if (res != LZO_E_OK)
-			{
-				// This doesn't seem to happen anymore.
-				PanicAlertT("Internal LZO Error - decompression failed (%d) (%li, %li) \n"
-					"Try loading the state again", res, i, new_len);
-				return;
-			}
-
-			i += new_len;
-		}
+		if (!DecompressState(f, buffer))
+			return;
 	}
 	else // uncompressed
 	{
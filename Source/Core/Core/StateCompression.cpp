@@ -0,0 +1,279 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <lzo/lzo1x.h>
+
+#include "Common/Common.h"
+#include "Common/FileUtil.h"
+#include "Common/StdConditionVariable.h"
+#include "Common/StdMutex.h"
+#include "Common/StdThread.h"
+
+#include "Core/StateCompression.h"
+
+namespace State
+{
+
+#if defined(__LZO_STRICT_16BIT)
+static const u32 IN_LEN = 8 * 1024u;
+#elif defined(LZO_ARCH_I086) && !defined(LZO_HAVE_MM_HUGE_ARRAY)
+static const u32 IN_LEN = 60 * 1024u;
+#else
+static const u32 IN_LEN = 128 * 1024u;
+#endif
+
+static const u32 OUT_LEN = IN_LEN + (IN_LEN / 16) + 64 + 3;
+
+// Compressed states are split into IN_LEN chunks that are compressed as independent
+// frames, so saving and loading can spread the work over several threads. The frame
+// header starts with a value no legacy LZO chunk length can have, which is how states
+// written before the frame header existed are told apart and still loaded.
+static const u32 STATE_FRAME_MAGIC = 0xFFFFFFFF;
+static const u32 STATE_FRAME_VERSION = 1;
+
+enum
+{
+	STATE_CODEC_LZO1X_1 = 1,
+};
+
+// Set in a chunk's size table entry when the chunk didn't shrink and is stored as-is.
+static const u32 STATE_CHUNK_STORED = 0x80000000;
+
+struct StateFrameHeader
+{
+	u32 magic;
+	u32 version;
+	u32 codec;
+	u32 chunk_size;
+	u32 num_chunks;
+};
+
+static u32 GetNumChunkWorkers(u32 num_chunks)
+{
+	const u32 num_cores = std::max(std::thread::hardware_concurrency(), 1u);
+	return std::max(std::min(num_cores, num_chunks), 1u);
+}
+
+// Compresses the state in IN_LEN chunks on a pool of worker threads. Chunks are
+// written out in order as soon as they are done, and the size table in front of
+// them is filled in once everything has been written.
+bool CompressStateChunks(File::IOFile& f, const u8* data, size_t size)
+{
+	const u32 num_chunks = (u32)((size + IN_LEN - 1) / IN_LEN);
+
+	StateFrameHeader frame_header;
+	frame_header.magic = STATE_FRAME_MAGIC;
+	frame_header.version = STATE_FRAME_VERSION;
+	frame_header.codec = STATE_CODEC_LZO1X_1;
+	frame_header.chunk_size = IN_LEN;
+	frame_header.num_chunks = num_chunks;
+
+	std::vector<u32> chunk_sizes(num_chunks);
+	std::vector<std::vector<u8>> chunks(num_chunks);
+	std::vector<u8> chunk_ready(num_chunks);
+	std::mutex chunk_mutex;
+	std::condition_variable chunk_done;
+	std::atomic<u32> next_chunk(0);
+
+	auto worker = [&]()
+	{
+		std::vector<lzo_align_t> wrkmem((LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t));
+		std::vector<u8> out(OUT_LEN);
+
+		u32 chunk;
+		while ((chunk = next_chunk++) < num_chunks)
+		{
+			const u8* in = data + (size_t)chunk * IN_LEN;
+			const lzo_uint in_len = (lzo_uint)std::min<size_t>(IN_LEN, size - (size_t)chunk * IN_LEN);
+			lzo_uint out_len = 0;
+
+			std::vector<u8> frame;
+			u32 entry;
+			if (lzo1x_1_compress(in, in_len, &out[0], &out_len, &wrkmem[0]) == LZO_E_OK && out_len < in_len)
+			{
+				frame.assign(out.begin(), out.begin() + out_len);
+				entry = (u32)out_len;
+			}
+			else
+			{
+				frame.assign(in, in + in_len);
+				entry = (u32)in_len | STATE_CHUNK_STORED;
+			}
+
+			std::lock_guard<std::mutex> lk(chunk_mutex);
+			chunks[chunk].swap(frame);
+			chunk_sizes[chunk] = entry;
+			chunk_ready[chunk] = 1;
+			chunk_done.notify_all();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (u32 i = 0; i < GetNumChunkWorkers(num_chunks); ++i)
+		workers.emplace_back(worker);
+
+	bool ok = f.WriteArray(&frame_header, 1);
+	const u64 table_offset = f.Tell();
+	ok &= f.WriteArray(chunk_sizes.data(), num_chunks);
+
+	for (u32 chunk = 0; chunk < num_chunks; ++chunk)
+	{
+		std::vector<u8> frame;
+		{
+			std::unique_lock<std::mutex> lk(chunk_mutex);
+			chunk_done.wait(lk, [&] { return chunk_ready[chunk] != 0; });
+			frame.swap(chunks[chunk]);
+		}
+
+		ok &= f.WriteBytes(frame.data(), frame.size());
+	}
+
+	for (std::thread& thread : workers)
+		thread.join();
+
+	ok &= f.Seek(table_offset, SEEK_SET);
+	ok &= f.WriteArray(chunk_sizes.data(), num_chunks);
+	ok &= f.Seek(0, SEEK_END);
+	return ok;
+}
+
+// Loads a state compressed by CompressStateChunks, decompressing its chunks in parallel.
+static bool DecompressStateChunks(File::IOFile& f, std::vector<u8>& buffer)
+{
+	StateFrameHeader frame_header;
+	if (!f.ReadArray(&frame_header, 1))
+		return false;
+
+	if (frame_header.version > STATE_FRAME_VERSION || frame_header.codec != STATE_CODEC_LZO1X_1 ||
+	    frame_header.chunk_size == 0 ||
+	    frame_header.num_chunks != (buffer.size() + frame_header.chunk_size - 1) / frame_header.chunk_size)
+	{
+		PanicAlertT("Unsupported savestate compression (version %u, codec %u)",
+			frame_header.version, frame_header.codec);
+		return false;
+	}
+
+	const u32 num_chunks = frame_header.num_chunks;
+	const u32 chunk_size = frame_header.chunk_size;
+
+	std::vector<u32> chunk_sizes(num_chunks);
+	if (!f.ReadArray(chunk_sizes.data(), num_chunks))
+		return false;
+
+	std::vector<size_t> chunk_offsets(num_chunks);
+	size_t compressed_size = 0;
+	for (u32 chunk = 0; chunk < num_chunks; ++chunk)
+	{
+		chunk_offsets[chunk] = compressed_size;
+		compressed_size += chunk_sizes[chunk] & ~STATE_CHUNK_STORED;
+	}
+
+	std::vector<u8> compressed(compressed_size);
+	if (!f.ReadBytes(compressed.data(), compressed_size))
+	{
+		PanicAlertT("Savestate is truncated");
+		return false;
+	}
+
+	std::atomic<u32> next_chunk(0);
+	std::atomic<bool> failed(false);
+
+	auto worker = [&]()
+	{
+		u32 chunk;
+		while ((chunk = next_chunk++) < num_chunks && !failed)
+		{
+			const u8* in = &compressed[chunk_offsets[chunk]];
+			const lzo_uint in_len = chunk_sizes[chunk] & ~STATE_CHUNK_STORED;
+			u8* out = &buffer[(size_t)chunk * chunk_size];
+			const lzo_uint expected_len = (lzo_uint)std::min<size_t>(chunk_size, buffer.size() - (size_t)chunk * chunk_size);
+
+			if (chunk_sizes[chunk] & STATE_CHUNK_STORED)
+			{
+				if (in_len != expected_len)
+					failed = true;
+				else
+					memcpy(out, in, in_len);
+				continue;
+			}
+
+			lzo_uint new_len = expected_len;
+			const int res = lzo1x_decompress_safe(in, in_len, out, &new_len, nullptr);
+			if (res != LZO_E_OK || new_len != expected_len)
+				failed = true;
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (u32 i = 1; i < GetNumChunkWorkers(num_chunks); ++i)
+		workers.emplace_back(worker);
+	worker();
+	for (std::thread& thread : workers)
+		thread.join();
+
+	if (failed)
+	{
+		PanicAlertT("Internal LZO Error - decompression failed\nTry loading the state again");
+		return false;
+	}
+
+	return true;
+}
+
+// Loads a state written before chunks were compressed as independent frames.
+static bool DecompressLegacyState(File::IOFile& f, std::vector<u8>& buffer)
+{
+	std::vector<u8> in(OUT_LEN);
+
+	lzo_uint i = 0;
+	while (true)
+	{
+		lzo_uint32 cur_len = 0;  // number of bytes to read
+		lzo_uint new_len = 0;  // number of bytes to write
+
+		if (!f.ReadArray(&cur_len, 1))
+			break;
+
+		if (cur_len > OUT_LEN)
+			return false;
+
+		// Older writers end with an empty chunk when the state is a multiple of IN_LEN.
+		// Such a chunk decompresses to nothing, so it's fine even once the buffer is full;
+		// anything else past the end fails with LZO_E_OUTPUT_OVERRUN below.
+		if (cur_len == 0)
+			continue;
+
+		if (!f.ReadBytes(&in[0], cur_len))
+			return false;
+		new_len = buffer.size() - i;
+		const int res = lzo1x_decompress_safe(&in[0], cur_len, buffer.data() + i, &new_len, nullptr);
+		if (res != LZO_E_OK)
+		{
+			// This doesn't seem to happen anymore.
+			PanicAlertT("Internal LZO Error - decompression failed (%d) (%li, %li) \n"
+				"Try loading the state again", res, i, new_len);
+			return false;
+		}
+
+		i += new_len;
+	}
+
+	return true;
+}
+
+bool DecompressState(File::IOFile& f, std::vector<u8>& buffer)
+{
+	u32 first_word = 0;
+	if (!f.ReadArray(&first_word, 1) || !f.Seek(-(s64)sizeof(first_word), SEEK_CUR))
+		return false;
+
+	if (first_word == STATE_FRAME_MAGIC)
+		return DecompressStateChunks(f, buffer);
+	else
+		return DecompressLegacyState(f, buffer);
+}
+
+} // namespace State
@@ -0,0 +1,25 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Compression of the savestate body, shared by State and its tests.
+
+#pragma once
+
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace File { class IOFile; }
+
+namespace State
+{
+
+// Writes size bytes of data to f as a chunked, LZO-compressed frame.
+bool CompressStateChunks(File::IOFile& f, const u8* data, size_t size);
+
+// Reads a compressed state body from f into buffer, which must already be sized to the
+// uncompressed size. Both framed states and ones from before the frame header are read.
+bool DecompressState(File::IOFile& f, std::vector<u8>& buffer);
+
+} // namespace State
@@ -2,6 +2,7 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include "Common/StdMutex.h"
 #include "Core/VolumeHandler.h"
 #include "DiscIO/VolumeCreator.h"
 
@@ -10,6 +11,9 @@ namespace VolumeHandler
 
 DiscIO::IVolume* g_pVolume = nullptr;
 
+// Reads also come from the DVD thread, volumes can't be read from two threads at once.
+static std::mutex s_volume_lock;
+
 DiscIO::IVolume *GetVolume()
 {
 	return g_pVolume;
@@ -17,6 +21,7 @@ DiscIO::IVolume *GetVolume()
 
 void EjectVolume()
 {
+	std::lock_guard<std::mutex> lk(s_volume_lock);
 	if (g_pVolume)
 	{
 		// This code looks scary. Can the try/catch stuff be removed?
@@ -30,6 +35,7 @@ void EjectVolume()
 
 bool SetVolumeName(const std::string& _rFullPath)
 {
+	std::lock_guard<std::mutex> lk(s_volume_lock);
 	if (g_pVolume)
 	{
 		delete g_pVolume;
@@ -43,6 +49,7 @@ bool SetVolumeName(const std::string& _rFullPath)
 
 void SetVolumeDirectory(const std::string& _rFullPath, bool _bIsWii, const std::string& _rApploader, const std::string& _rDOL)
 {
+	std::lock_guard<std::mutex> lk(s_volume_lock);
 	if (g_pVolume)
 	{
 		delete g_pVolume;
@@ -54,6 +61,7 @@ void SetVolumeDirectory(const std::string& _rFullPath, bool _bIsWii, const std::
 
 u32 Read32(u64 _Offset)
 {
+	std::lock_guard<std::mutex> lk(s_volume_lock);
 	if (g_pVolume != nullptr)
 	{
 		u32 Temp;
@@ -65,6 +73,7 @@ u32 Read32(u64 _Offset)
 
 bool ReadToPtr(u8* ptr, u64 _dwOffset, u64 _dwLength)
 {
+	std::lock_guard<std::mutex> lk(s_volume_lock);
 	if (g_pVolume != nullptr && ptr)
 	{
 		g_pVolume->Read(_dwOffset, _dwLength, ptr);
@@ -75,6 +84,7 @@ bool ReadToPtr(u8* ptr, u64 _dwOffset, u64 _dwLength)
 
 bool RAWReadToPtr( u8* ptr, u64 _dwOffset, u64 _dwLength )
 {
+	std::lock_guard<std::mutex> lk(s_volume_lock);
 	if (g_pVolume != nullptr && ptr)
 	{
 		g_pVolume->RAWRead(_dwOffset, _dwLength, ptr);
@@ -83,6 +93,15 @@ bool RAWReadToPtr( u8* ptr, u64 _dwOffset, u64 _dwLength )
 	return false;
 }
 
+// Reads the ticket off the disc, so it needs the lock like any other read.
+bool GetTitleID(u8* _pBuffer)
+{
+	std::lock_guard<std::mutex> lk(s_volume_lock);
+	if (g_pVolume != nullptr)
+		return g_pVolume->GetTitleID(_pBuffer);
+	return false;
+}
+
 bool IsValid()
 {
 	return (g_pVolume != nullptr);
@@ -22,6 +22,7 @@ void SetVolumeDirectory(const std::string& _rFullPath, bool _bIsWii, const std::
 u32 Read32(u64 _Offset);
 bool ReadToPtr(u8* ptr, u64 _dwOffset, u64 _dwLength);
 bool RAWReadToPtr(u8* ptr, u64 _dwOffset, u64 _dwLength);
+bool GetTitleID(u8* _pBuffer);
 
 bool IsValid();
 bool IsWii();
@@ -0,0 +1,142 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <polarssl/aes.h>
+
+#include "Common/Common.h"
+#include "Common/CPUDetect.h"
+#include "DiscIO/AESCBC.h"
+
+// The AES-NI functions are compiled with FUNCTION_TARGET, the decryptor only calls
+// them after checking cpu_info at runtime.
+#if _M_X86
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+namespace DiscIO
+{
+
+#if _M_X86
+
+static __m128i ExpandKeyStep(__m128i key, __m128i keygened)
+{
+	keygened = _mm_shuffle_epi32(keygened, _MM_SHUFFLE(3, 3, 3, 3));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	return _mm_xor_si128(key, keygened);
+}
+
+FUNCTION_TARGET("aes")
+static void ExpandDecryptionKeyAESNI(const u8* key, u8* round_keys)
+{
+	__m128i enc[11];
+	enc[0] = _mm_loadu_si128((const __m128i*)key);
+	// The round constant has to be an immediate.
+#define EXPAND_KEY(i, rcon) enc[i] = ExpandKeyStep(enc[i - 1], _mm_aeskeygenassist_si128(enc[i - 1], rcon))
+	EXPAND_KEY(1, 0x01);
+	EXPAND_KEY(2, 0x02);
+	EXPAND_KEY(3, 0x04);
+	EXPAND_KEY(4, 0x08);
+	EXPAND_KEY(5, 0x10);
+	EXPAND_KEY(6, 0x20);
+	EXPAND_KEY(7, 0x40);
+	EXPAND_KEY(8, 0x80);
+	EXPAND_KEY(9, 0x1B);
+	EXPAND_KEY(10, 0x36);
+#undef EXPAND_KEY
+
+	// The equivalent inverse cipher walks the schedule backwards, with InvMixColumns
+	// applied to all the inner round keys.
+	_mm_storeu_si128((__m128i*)round_keys, enc[10]);
+	for (int i = 1; i < 10; i++)
+		_mm_storeu_si128((__m128i*)(round_keys + i * 16), _mm_aesimc_si128(enc[10 - i]));
+	_mm_storeu_si128((__m128i*)(round_keys + 10 * 16), enc[0]);
+}
+
+FUNCTION_TARGET("aes")
+static void DecryptCBCAESNI(const u8* round_keys, const u8* iv, const u8* in, u8* out, size_t size)
+{
+	__m128i k[11];
+	for (int i = 0; i < 11; i++)
+		k[i] = _mm_loadu_si128((const __m128i*)(round_keys + i * 16));
+
+	__m128i prev = _mm_loadu_si128((const __m128i*)iv);
+
+	// CBC decryption has no dependency between blocks, so keep four of them in flight
+	// to hide the latency of AESDEC.
+	for (; size >= 64; size -= 64, in += 64, out += 64)
+	{
+		__m128i c0 = _mm_loadu_si128((const __m128i*)in);
+		__m128i c1 = _mm_loadu_si128((const __m128i*)(in + 16));
+		__m128i c2 = _mm_loadu_si128((const __m128i*)(in + 32));
+		__m128i c3 = _mm_loadu_si128((const __m128i*)(in + 48));
+		__m128i x0 = _mm_xor_si128(c0, k[0]);
+		__m128i x1 = _mm_xor_si128(c1, k[0]);
+		__m128i x2 = _mm_xor_si128(c2, k[0]);
+		__m128i x3 = _mm_xor_si128(c3, k[0]);
+		for (int r = 1; r < 10; r++)
+		{
+			x0 = _mm_aesdec_si128(x0, k[r]);
+			x1 = _mm_aesdec_si128(x1, k[r]);
+			x2 = _mm_aesdec_si128(x2, k[r]);
+			x3 = _mm_aesdec_si128(x3, k[r]);
+		}
+		x0 = _mm_aesdeclast_si128(x0, k[10]);
+		x1 = _mm_aesdeclast_si128(x1, k[10]);
+		x2 = _mm_aesdeclast_si128(x2, k[10]);
+		x3 = _mm_aesdeclast_si128(x3, k[10]);
+		_mm_storeu_si128((__m128i*)out, _mm_xor_si128(x0, prev));
+		_mm_storeu_si128((__m128i*)(out + 16), _mm_xor_si128(x1, c0));
+		_mm_storeu_si128((__m128i*)(out + 32), _mm_xor_si128(x2, c1));
+		_mm_storeu_si128((__m128i*)(out + 48), _mm_xor_si128(x3, c2));
+		prev = c3;
+	}
+
+	for (; size >= 16; size -= 16, in += 16, out += 16)
+	{
+		__m128i c = _mm_loadu_si128((const __m128i*)in);
+		__m128i x = _mm_xor_si128(c, k[0]);
+		for (int r = 1; r < 10; r++)
+			x = _mm_aesdec_si128(x, k[r]);
+		x = _mm_aesdeclast_si128(x, k[10]);
+		_mm_storeu_si128((__m128i*)out, _mm_xor_si128(x, prev));
+		prev = c;
+	}
+}
+
+#endif
+
+AESCBCDecryptor::AESCBCDecryptor(const u8* key)
+{
+	aes_setkey_dec(&m_ctx, key, 128);
+
+#if _M_X86
+	m_use_aesni = cpu_info.bAES;
+	if (m_use_aesni)
+		ExpandDecryptionKeyAESNI(key, m_round_keys);
+#else
+	m_use_aesni = false;
+#endif
+}
+
+void AESCBCDecryptor::Decrypt(const u8* iv, const u8* in, u8* out, size_t size) const
+{
+#if _M_X86
+	if (m_use_aesni)
+	{
+		DecryptCBCAESNI(m_round_keys, iv, in, out, size);
+		return;
+	}
+#endif
+
+	// PolarSSL updates the IV in place.
+	u8 iv_copy[16];
+	memcpy(iv_copy, iv, 16);
+	aes_crypt_cbc(&m_ctx, AES_DECRYPT, size, iv_copy, in, out);
+}
+
+}  // namespace
@@ -0,0 +1,33 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <polarssl/aes.h>
+
+#include "Common/CommonTypes.h"
+
+namespace DiscIO
+{
+
+// AES-128-CBC decryption, as used for Wii disc clusters.
+// Uses AES-NI when the host CPU has it, and PolarSSL otherwise.
+class AESCBCDecryptor
+{
+public:
+	explicit AESCBCDecryptor(const u8* key);
+
+	// Decrypts size bytes (a multiple of 16). in and out must not overlap.
+	void Decrypt(const u8* iv, const u8* in, u8* out, size_t size) const;
+
+private:
+	mutable aes_context m_ctx;
+
+	// Decryption key schedule in the order AESDEC consumes it.
+	u8 m_round_keys[11 * 16];
+	bool m_use_aesni;
+};
+
+}  // namespace
@@ -5,10 +5,12 @@
 #include <cstddef>
 #include <cstring>
 #include <string>
+#include <utility>
 
 #include "Common/CDUtils.h"
 #include "Common/CommonTypes.h"
 #include "Common/FileUtil.h"
+#include "Common/Thread.h"
 
 #include "DiscIO/Blob.h"
 #include "DiscIO/CISOBlob.h"
@@ -23,36 +25,176 @@ namespace DiscIO
 // Provides caching and split-operation-to-block-operations facilities.
 // Used for compressed blob reading and direct drive reading.
 
+SectorReader::SectorReader()
+	: m_blocksize(0), m_cache_clock(0), m_mru_slot(-1),
+	  m_read_ahead_enabled(false), m_read_ahead_exit(false), m_read_ahead_pending(false),
+	  m_read_ahead_start(0), m_read_ahead_block((u64)(s64) - 1), m_read_ahead_buffer(nullptr),
+	  m_last_block((u64)(s64) - 1), m_sequential_reads(0)
+{
+	for (int i = 0; i < CACHE_SIZE; i++)
+	{
+		cache[i] = nullptr;
+		cache_tags[i] = (u64)(s64) - 1;
+		cache_age[i] = 0;
+	}
+}
+
 void SectorReader::SetSectorSize(int blocksize)
 {
 	for (int i = 0; i < CACHE_SIZE; i++)
 	{
+		delete [] cache[i];
 		cache[i] = new u8[blocksize];
 		cache_tags[i] = (u64)(s64) - 1;
+		cache_age[i] = 0;
 	}
+	delete [] m_read_ahead_buffer;
+	m_read_ahead_buffer = new u8[blocksize];
 	m_blocksize = blocksize;
 }
 
 SectorReader::~SectorReader()
 {
+	StopReadAhead();
+
 	for (u8*& block : cache)
 	{
 		delete [] block;
 	}
+	delete [] m_read_ahead_buffer;
+}
+
+int SectorReader::FindCachedBlock(u64 block_num) const
+{
+	for (int i = 0; i < CACHE_SIZE; i++)
+	{
+		if (cache_tags[i] == block_num)
+			return i;
+	}
+	return -1;
+}
+
+// Picks the least recently used slot, except for the one whose pointer was last returned.
+int SectorReader::GetVictimSlot() const
+{
+	int victim = -1;
+	for (int i = 0; i < CACHE_SIZE; i++)
+	{
+		if (i == m_mru_slot)
+			continue;
+		if (victim == -1 || cache_age[i] < cache_age[victim])
+			victim = i;
+	}
+	return victim;
 }
 
 const u8 *SectorReader::GetBlockData(u64 block_num)
 {
-	// TODO : Expand usage of the cache to more than one block :P
-	if (cache_tags[0] == block_num)
+	std::unique_lock<std::mutex> lk(m_lock);
+
+	int slot = FindCachedBlock(block_num);
+	// Rather than decoding it a second time, wait for the read-ahead thread to finish it.
+	while (slot == -1 && m_read_ahead_block == block_num)
 	{
-		return cache[0];
+		m_read_ahead_done_cond.wait(lk);
+		slot = FindCachedBlock(block_num);
 	}
-	else
+	if (slot == -1)
 	{
-		GetBlock(block_num, cache[0]);
-		cache_tags[0] = block_num;
-		return cache[0];
+		slot = GetVictimSlot();
+		std::lock_guard<std::mutex> block_lk(m_block_lock);
+		GetBlock(block_num, cache[slot]);
+		cache_tags[slot] = block_num;
+	}
+	cache_age[slot] = ++m_cache_clock;
+	m_mru_slot = slot;
+
+	// Streaming access (DTK audio, FMVs, big file loads) asks for one block after the
+	// other, so let the read-ahead thread decode the next few while emulation carries on.
+	if (block_num == m_last_block + 1)
+		m_sequential_reads++;
+	else if (block_num != m_last_block)
+		m_sequential_reads = 0;
+	m_last_block = block_num;
+
+	if (m_read_ahead_enabled && m_sequential_reads >= READ_AHEAD_THRESHOLD)
+	{
+		if (!m_read_ahead_thread.joinable())
+			m_read_ahead_thread = std::thread(&SectorReader::ReadAheadThread, this);
+		m_read_ahead_start = block_num + 1;
+		m_read_ahead_pending = true;
+		m_read_ahead_cond.notify_one();
+	}
+
+	return cache[slot];
+}
+
+void SectorReader::EnableReadAhead()
+{
+	std::lock_guard<std::mutex> lk(m_lock);
+	m_read_ahead_enabled = true;
+	m_read_ahead_exit = false;
+}
+
+void SectorReader::StopReadAhead()
+{
+	if (m_read_ahead_thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lk(m_lock);
+			m_read_ahead_exit = true;
+			m_read_ahead_cond.notify_one();
+		}
+		m_read_ahead_thread.join();
+	}
+	m_read_ahead_enabled = false;
+}
+
+void SectorReader::ReadAheadThread()
+{
+	Common::SetCurrentThreadName("Disc read-ahead");
+
+	const u64 num_blocks = (GetDataSize() + m_blocksize - 1) / m_blocksize;
+
+	std::unique_lock<std::mutex> lk(m_lock);
+	while (true)
+	{
+		m_read_ahead_cond.wait(lk, [this]{ return m_read_ahead_exit || m_read_ahead_pending; });
+		if (m_read_ahead_exit)
+			return;
+
+		m_read_ahead_pending = false;
+		const u64 start = m_read_ahead_start;
+		for (u64 block_num = start; block_num < start + READ_AHEAD_BLOCKS && block_num < num_blocks; block_num++)
+		{
+			// A newer request (or shutdown) supersedes this one.
+			if (m_read_ahead_exit || m_read_ahead_pending)
+				break;
+
+			if (FindCachedBlock(block_num) != -1)
+				continue;
+
+			// Decode without m_lock, so that the emulator can keep hitting the cache,
+			// and only take it again to swap the block in.
+			m_read_ahead_block = block_num;
+			lk.unlock();
+			{
+				std::lock_guard<std::mutex> block_lk(m_block_lock);
+				GetBlock(block_num, m_read_ahead_buffer);
+			}
+			lk.lock();
+			m_read_ahead_block = (u64)(s64) - 1;
+
+			// The emulator may have read the block itself in the meantime.
+			if (FindCachedBlock(block_num) == -1)
+			{
+				int slot = GetVictimSlot();
+				std::swap(cache[slot], m_read_ahead_buffer);
+				cache_tags[slot] = block_num;
+				cache_age[slot] = ++m_cache_clock;
+			}
+			m_read_ahead_done_cond.notify_all();
+		}
 	}
 }
 
@@ -118,6 +260,18 @@ bool SectorReader::ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8 *
 	return true;
 }
 
+static bool s_mapped_reads = true;
+
+void SetMappedReads(bool enable)
+{
+	s_mapped_reads = enable;
+}
+
+bool GetMappedReads()
+{
+	return s_mapped_reads;
+}
+
 IBlobReader* CreateBlobReader(const std::string& filename)
 {
 	if (cdio_is_cdrom(filename))
@@ -136,6 +290,11 @@ IBlobReader* CreateBlobReader(const std::string& filename)
 		return CISOFileReader::Create(filename);
 
 	// Still here? Assume plain file - since we know it exists due to the File::Exists check above.
+	if (s_mapped_reads)
+	{
+		if (IBlobReader* reader = MappedFileReader::Create(filename))
+			return reader;
+	}
 	return PlainFileReader::Create(filename);
 }
 
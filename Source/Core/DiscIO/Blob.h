@@ -16,6 +16,9 @@
 
 #include <string>
 #include "Common/CommonTypes.h"
+#include "Common/StdConditionVariable.h"
+#include "Common/StdMutex.h"
+#include "Common/StdThread.h"
 
 namespace DiscIO
 {
@@ -37,23 +40,63 @@ protected:
 
 // Provides caching and split-operation-to-block-operations facilities.
 // Used for compressed blob reading and direct drive reading.
-// Currently only uses a single entry cache.
+// Keeps an LRU cache of the last CACHE_SIZE blocks, and can optionally read ahead
+// on a background thread when it sees blocks being requested sequentially.
 // Multi-block reads are not cached.
 class SectorReader : public IBlobReader
 {
 private:
-	enum { CACHE_SIZE = 32 };
+	enum
+	{
+		CACHE_SIZE = 32,
+		READ_AHEAD_BLOCKS = 4,
+		// How many consecutive sequential block requests trigger read-ahead.
+		READ_AHEAD_THRESHOLD = 2,
+	};
 	int m_blocksize;
 	u8* cache[CACHE_SIZE];
 	u64 cache_tags[CACHE_SIZE];
-	int cache_age[CACHE_SIZE];
+	u64 cache_age[CACHE_SIZE];
+	u64 m_cache_clock;
+	// The slot last handed out by GetBlockData. Read-ahead never evicts it.
+	int m_mru_slot;
+
+	// Guards the cache and the read-ahead state below.
+	std::mutex m_lock;
+	// Serializes GetBlock calls. Taken after m_lock, never the other way around, so the
+	// read-ahead thread can decode a block without holding up cache hits.
+	std::mutex m_block_lock;
+	std::condition_variable m_read_ahead_cond;
+	std::condition_variable m_read_ahead_done_cond;
+	std::thread m_read_ahead_thread;
+	bool m_read_ahead_enabled;
+	bool m_read_ahead_exit;
+	bool m_read_ahead_pending;
+	u64 m_read_ahead_start;
+	// The block the read-ahead thread is decoding into m_read_ahead_buffer, or -1.
+	u64 m_read_ahead_block;
+	u8* m_read_ahead_buffer;
+	u64 m_last_block;
+	int m_sequential_reads;
+
+	int FindCachedBlock(u64 block_num) const;
+	int GetVictimSlot() const;
+	void ReadAheadThread();
 
 protected:
+	SectorReader();
+
 	void SetSectorSize(int blocksize);
 	virtual void GetBlock(u64 block_num, u8 *out) = 0;
 	// This one is uncached. The default implementation is to simply call GetBlockData multiple times and memcpy.
 	virtual bool ReadMultipleAlignedBlocks(u64 block_num, u64 num_blocks, u8 *out_ptr);
 
+	// Only for readers whose GetBlock is the sole way they touch their backing file.
+	// The thread is started on the first streaming read. Such a reader must call
+	// StopReadAhead() at the start of its destructor, as the read-ahead thread calls GetBlock.
+	void EnableReadAhead();
+	void StopReadAhead();
+
 public:
 	virtual ~SectorReader();
 
@@ -63,6 +106,11 @@ public:
 	friend class DriveReader;
 };
 
+// Whether plain and WBFS images are read through a memory mapping where the host
+// allows it. Only affects readers created afterwards.
+void SetMappedReads(bool enable);
+bool GetMappedReads();
+
 // Factory function - examines the path to choose the right type of IBlobReader, and returns one.
 IBlobReader* CreateBlobReader(const std::string& filename);
 
@@ -0,0 +1,115 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "Common/Common.h"
+#include "Common/StdConditionVariable.h"
+#include "Common/StdMutex.h"
+#include "Common/StdThread.h"
+#include "DiscIO/BlockPipeline.h"
+
+namespace DiscIO
+{
+
+bool RunBlockPipeline(u32 num_blocks, u32 block_size, int num_workers,
+                      std::function<bool(u32, PipelineSlot&)> read,
+                      std::function<bool(int, u32, PipelineSlot&)> process,
+                      std::function<bool(u32, PipelineSlot&)> write)
+{
+	enum SlotState { SLOT_FREE, SLOT_READY, SLOT_DONE, SLOT_FAILED };
+
+	// Enough slots that reading and writing on this thread don't starve the workers.
+	const u32 num_slots = 4 * num_workers;
+	std::vector<PipelineSlot> slots(num_slots);
+	std::vector<SlotState> states(num_slots, SLOT_FREE);
+	for (PipelineSlot& slot : slots)
+	{
+		slot.in_buf.resize(block_size);
+		slot.out_buf.resize(block_size);
+	}
+
+	std::mutex lock;
+	std::condition_variable work_cond, done_cond;
+	std::deque<u32> queue;
+	bool exit = false;
+
+	std::vector<std::thread> workers;
+	for (int worker = 0; worker < num_workers; worker++)
+	{
+		workers.emplace_back([&, worker]
+		{
+			std::unique_lock<std::mutex> lk(lock);
+			while (true)
+			{
+				work_cond.wait(lk, [&]{ return exit || !queue.empty(); });
+				if (exit)
+					return;
+
+				u32 block = queue.front();
+				queue.pop_front();
+				lk.unlock();
+				bool ok = process(worker, block, slots[block % num_slots]);
+				lk.lock();
+				states[block % num_slots] = ok ? SLOT_DONE : SLOT_FAILED;
+				done_cond.notify_one();
+			}
+		});
+	}
+
+	bool success = true;
+	u32 next_read = 0;
+	for (u32 next_write = 0; success && next_write < num_blocks; next_write++)
+	{
+		while (next_read < num_blocks && next_read - next_write < num_slots)
+		{
+			if (!read(next_read, slots[next_read % num_slots]))
+			{
+				success = false;
+				break;
+			}
+
+			std::lock_guard<std::mutex> lk(lock);
+			states[next_read % num_slots] = SLOT_READY;
+			queue.push_back(next_read);
+			work_cond.notify_one();
+			next_read++;
+		}
+		if (!success)
+			break;
+
+		const u32 slot = next_write % num_slots;
+		{
+			std::unique_lock<std::mutex> lk(lock);
+			done_cond.wait(lk, [&]{ return states[slot] == SLOT_DONE || states[slot] == SLOT_FAILED; });
+			if (states[slot] == SLOT_FAILED)
+				success = false;
+			states[slot] = SLOT_FREE;
+		}
+
+		if (success && !write(next_write, slots[slot]))
+			success = false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		exit = true;
+		queue.clear();
+		work_cond.notify_all();
+	}
+	for (std::thread& worker : workers)
+		worker.join();
+
+	return success;
+}
+
+int GetNumPipelineWorkers()
+{
+	return std::max<int>(1, std::thread::hardware_concurrency());
+}
+
+}  // namespace
@@ -0,0 +1,39 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace DiscIO
+{
+
+// One block's worth of buffers travelling through RunBlockPipeline.
+struct PipelineSlot
+{
+	std::vector<u8> in_buf;
+	std::vector<u8> out_buf;
+	u32 out_size;
+	u32 hash;
+	bool stored;
+	// Free for process to hand a result to write.
+	int status;
+};
+
+// Runs per-block work on a pool of worker threads.
+// read is called on the calling thread in block order, process on any worker thread,
+// and write back on the calling thread in block order, so the output is the same as if
+// everything ran serially. Any callback returning false aborts the whole operation.
+bool RunBlockPipeline(u32 num_blocks, u32 block_size, int num_workers,
+                      std::function<bool(u32, PipelineSlot&)> read,
+                      std::function<bool(int, u32, PipelineSlot&)> process,
+                      std::function<bool(u32, PipelineSlot&)> write);
+
+// One worker per host thread.
+int GetNumPipelineWorkers();
+
+}  // namespace
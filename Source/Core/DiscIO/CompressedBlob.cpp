@@ -11,13 +11,16 @@
 #include <cinttypes>
 #include <cstdio>
 #include <cstring>
+#include <memory>
 #include <string>
+#include <vector>
 #include <zlib.h>
 
 #include "Common/Common.h"
 #include "Common/FileUtil.h"
 #include "Common/Hash.h"
 #include "DiscIO/Blob.h"
+#include "DiscIO/BlockPipeline.h"
 #include "DiscIO/CompressedBlob.h"
 #include "DiscIO/DiscScrubber.h"
 
@@ -25,7 +28,7 @@
 namespace DiscIO
 {
 
-CompressedBlobReader::CompressedBlobReader(const std::string& filename) : file_name(filename)
+CompressedBlobReader::CompressedBlobReader(const std::string& filename, bool read_ahead) : file_name(filename)
 {
 	m_file.Open(filename, "rb");
 	file_size = File::GetSize(filename);
@@ -48,18 +51,23 @@ CompressedBlobReader::CompressedBlobReader(const std::string& filename) : file_n
 	zlib_buffer_size = header.block_size + 64;
 	zlib_buffer = new u8[zlib_buffer_size];
 	memset(zlib_buffer, 0, zlib_buffer_size);
+
+	if (read_ahead)
+		EnableReadAhead();
 }
 
-CompressedBlobReader* CompressedBlobReader::Create(const std::string& filename)
+CompressedBlobReader* CompressedBlobReader::Create(const std::string& filename, bool read_ahead)
 {
 	if (IsCompressedBlob(filename))
-		return new CompressedBlobReader(filename);
+		return new CompressedBlobReader(filename, read_ahead);
 	else
 		return nullptr;
 }
 
 CompressedBlobReader::~CompressedBlobReader()
 {
+	StopReadAhead();
+
 	delete [] zlib_buffer;
 	delete [] block_pointers;
 	delete [] hashes;
@@ -179,10 +187,8 @@ bool CompressFileToBlob(const std::string& infile, const std::string& outfile, u
 	// round upwards!
 	header.num_blocks = (u32)((header.data_size + (block_size - 1)) / block_size);
 
-	u64* offsets = new u64[header.num_blocks];
-	u32* hashes = new u32[header.num_blocks];
-	u8* out_buf = new u8[block_size];
-	u8* in_buf = new u8[block_size];
+	std::vector<u64> offsets(header.num_blocks);
+	std::vector<u32> hashes(header.num_blocks);
 
 	// seek past the header (we will write it at the end)
 	f.Seek(sizeof(CompressedBlobHeader), SEEK_CUR);
@@ -190,92 +196,110 @@ bool CompressFileToBlob(const std::string& infile, const std::string& outfile, u
 	f.Seek((sizeof(u64) + sizeof(u32)) * header.num_blocks, SEEK_CUR);
 
 	// Now we are ready to write compressed data!
+	// Every block is deflated on its own, so compressing them in parallel gives exactly the
+	// same file as compressing them one after the other.
 	u64 position = 0;
 	int num_compressed = 0;
 	int num_stored = 0;
 	int progress_monitor = max<int>(1, header.num_blocks / 1000);
 
-	for (u32 i = 0; i < header.num_blocks; i++)
+	auto read_block = [&](u32 i, PipelineSlot& slot)
 	{
-		if (i % progress_monitor == 0)
-		{
-			const u64 inpos = inf.Tell();
-			int ratio = 0;
-			if (inpos != 0)
-				ratio = (int)(100 * position / inpos);
-			char temp[512];
-			sprintf(temp, "%i of %i blocks. Compression ratio %i%%", i, header.num_blocks, ratio);
-			callback(temp, (float)i / (float)header.num_blocks, arg);
-		}
-
-		offsets[i] = position;
-		// u64 start = i * header.block_size;
-		// u64 size = header.block_size;
-		std::fill(in_buf, in_buf + header.block_size, 0);
+		std::fill(slot.in_buf.begin(), slot.in_buf.end(), 0);
 		if (scrubbing)
-			DiscScrubber::GetNextBlock(inf, in_buf);
+			DiscScrubber::GetNextBlock(inf, slot.in_buf.data());
 		else
-			inf.ReadBytes(in_buf, header.block_size);
+			inf.ReadBytes(slot.in_buf.data(), header.block_size);
+		return true;
+	};
+
+	auto compress_block = [&](int worker, u32 i, PipelineSlot& slot)
+	{
 		z_stream z;
 		memset(&z, 0, sizeof(z));
 		z.zalloc = Z_NULL;
 		z.zfree  = Z_NULL;
 		z.opaque = Z_NULL;
-		z.next_in   = in_buf;
+		z.next_in   = slot.in_buf.data();
 		z.avail_in  = header.block_size;
-		z.next_out  = out_buf;
+		z.next_out  = slot.out_buf.data();
 		z.avail_out = block_size;
 		int retval = deflateInit(&z, 9);
 
 		if (retval != Z_OK)
 		{
 			ERROR_LOG(DISCIO, "Deflate failed");
-			goto cleanup;
+			return false;
 		}
 
 		int status = deflate(&z, Z_FINISH);
 		int comp_size = block_size - z.avail_out;
 		if ((status != Z_STREAM_END) || (z.avail_out < 10))
 		{
-			//PanicAlert("%i %i Store %i", i*block_size, position, comp_size);
 			// let's store uncompressed
-			offsets[i] |= 0x8000000000000000ULL;
-			f.WriteBytes(in_buf, block_size);
-			hashes[i] = HashAdler32(in_buf, block_size);
-			position += block_size;
-			num_stored++;
+			slot.stored = true;
+			slot.out_size = block_size;
+			slot.hash = HashAdler32(slot.in_buf.data(), block_size);
 		}
 		else
 		{
 			// let's store compressed
-			//PanicAlert("Comp %i to %i", block_size, comp_size);
-			f.WriteBytes(out_buf, comp_size);
-			hashes[i] = HashAdler32(out_buf, comp_size);
-			position += comp_size;
-			num_compressed++;
+			slot.stored = false;
+			slot.out_size = comp_size;
+			slot.hash = HashAdler32(slot.out_buf.data(), comp_size);
 		}
 
 		deflateEnd(&z);
-	}
+		return true;
+	};
 
-	header.compressed_data_size = position;
+	auto write_block = [&](u32 i, PipelineSlot& slot)
+	{
+		if (i % progress_monitor == 0)
+		{
+			const u64 inpos = (u64)i * block_size;
+			int ratio = 0;
+			if (inpos != 0)
+				ratio = (int)(100 * position / inpos);
+			char temp[512];
+			sprintf(temp, "%i of %i blocks. Compression ratio %i%%", i, header.num_blocks, ratio);
+			callback(temp, (float)i / (float)header.num_blocks, arg);
+		}
+
+		offsets[i] = position;
+		hashes[i] = slot.hash;
+		if (slot.stored)
+		{
+			offsets[i] |= 0x8000000000000000ULL;
+			f.WriteBytes(slot.in_buf.data(), slot.out_size);
+			num_stored++;
+		}
+		else
+		{
+			f.WriteBytes(slot.out_buf.data(), slot.out_size);
+			num_compressed++;
+		}
+		position += slot.out_size;
+		return true;
+	};
 
-	// Okay, go back and fill in headers
-	f.Seek(0, SEEK_SET);
-	f.WriteArray(&header, 1);
-	f.WriteArray(offsets, header.num_blocks);
-	f.WriteArray(hashes, header.num_blocks);
+	bool success = RunBlockPipeline(header.num_blocks, block_size, GetNumPipelineWorkers(),
+	                                read_block, compress_block, write_block);
 
-cleanup:
-	// Cleanup
-	delete[] in_buf;
-	delete[] out_buf;
-	delete[] offsets;
-	delete[] hashes;
+	if (success)
+	{
+		header.compressed_data_size = position;
+
+		// Okay, go back and fill in headers
+		f.Seek(0, SEEK_SET);
+		f.WriteArray(&header, 1);
+		f.WriteArray(offsets.data(), header.num_blocks);
+		f.WriteArray(hashes.data(), header.num_blocks);
+	}
 
 	DiscScrubber::Cleanup();
 	callback("Done compressing disc image.", 1.0f, arg);
-	return true;
+	return success;
 }
 
 bool DecompressBlobToFile(const std::string& infile, const std::string& outfile, CompressCB callback, void* arg)
@@ -286,38 +310,50 @@ bool DecompressBlobToFile(const std::string& infile, const std::string& outfile,
 		return false;
 	}
 
-	CompressedBlobReader* reader = CompressedBlobReader::Create(infile);
-	if (!reader)
-		return false;
+	// Each worker gets its own reader, as they each need a file handle and zlib buffer.
+	const int num_workers = GetNumPipelineWorkers();
+	std::vector<std::unique_ptr<CompressedBlobReader>> readers;
+	for (int i = 0; i < num_workers; i++)
+	{
+		readers.emplace_back(CompressedBlobReader::Create(infile, false));
+		if (!readers.back())
+			return false;
+	}
 
 	File::IOFile f(outfile, "wb");
 	if (!f)
-	{
-		delete reader;
 		return false;
-	}
 
-	const CompressedBlobHeader &header = reader->GetHeader();
-	u8* buffer = new u8[header.block_size];
+	const CompressedBlobHeader &header = readers[0]->GetHeader();
 	int progress_monitor = max<int>(1, header.num_blocks / 100);
 
-	for (u64 i = 0; i < header.num_blocks; i++)
+	auto read_block = [](u32 i, PipelineSlot& slot)
+	{
+		return true;
+	};
+
+	auto decompress_block = [&](int worker, u32 i, PipelineSlot& slot)
+	{
+		readers[worker]->GetBlock(i, slot.out_buf.data());
+		return true;
+	};
+
+	auto write_block = [&](u32 i, PipelineSlot& slot)
 	{
 		if (i % progress_monitor == 0)
 		{
 			callback("Unpacking", (float)i / (float)header.num_blocks, arg);
 		}
-		reader->Read(i * header.block_size, header.block_size, buffer);
-		f.WriteBytes(buffer, header.block_size);
-	}
-
-	delete[] buffer;
+		return f.WriteBytes(slot.out_buf.data(), header.block_size);
+	};
 
-	f.Resize(header.data_size);
+	bool success = RunBlockPipeline(header.num_blocks, header.block_size, num_workers,
+	                                read_block, decompress_block, write_block);
 
-	delete reader;
+	if (success)
+		f.Resize(header.data_size);
 
-	return true;
+	return success;
 }
 
 bool IsCompressedBlob(const std::string& filename)
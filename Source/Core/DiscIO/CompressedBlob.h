@@ -46,7 +46,9 @@ struct CompressedBlobHeader // 32 bytes
 class CompressedBlobReader : public SectorReader
 {
 public:
-	static CompressedBlobReader* Create(const std::string& filename);
+	// Readers that only ever get GetBlock calls, like the DecompressBlobToFile workers,
+	// don't need read-ahead.
+	static CompressedBlobReader* Create(const std::string& filename, bool read_ahead = true);
 	~CompressedBlobReader();
 	const CompressedBlobHeader &GetHeader() const { return header; }
 	u64 GetDataSize() const override { return header.data_size; }
@@ -54,7 +56,7 @@ public:
 	u64 GetBlockCompressedSize(u64 block_num) const;
 	void GetBlock(u64 block_num, u8* out_ptr) override;
 private:
-	CompressedBlobReader(const std::string& filename);
+	CompressedBlobReader(const std::string& filename, bool read_ahead);
 
 	CompressedBlobHeader header;
 	u64* block_pointers;
@@ -29,4 +29,19 @@ bool PlainFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
 	return m_file.ReadBytes(out_ptr, nbytes);
 }
 
+MappedFileReader* MappedFileReader::Create(const std::string& filename)
+{
+	MappedFileReader* reader = new MappedFileReader();
+	if (reader->m_file.Open(filename))
+		return reader;
+
+	delete reader;
+	return nullptr;
+}
+
+bool MappedFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
+{
+	return m_file.Read(offset, nbytes, out_ptr);
+}
+
 }  // namespace
@@ -9,6 +9,7 @@
 
 #include "Common/CommonTypes.h"
 #include "Common/FileUtil.h"
+#include "Common/MappedFile.h"
 #include "DiscIO/Blob.h"
 
 namespace DiscIO
@@ -29,4 +30,20 @@ public:
 	bool Read(u64 offset, u64 nbytes, u8* out_ptr) override;
 };
 
+// Reads a plain image through a memory mapping of the whole file, see File::MappedFile.
+class MappedFileReader : public IBlobReader
+{
+	MappedFileReader() {}
+
+	File::MappedFile m_file;
+
+public:
+	// Returns nullptr if the file can't be mapped, callers fall back to PlainFileReader.
+	static MappedFileReader* Create(const std::string& filename);
+
+	u64 GetDataSize() const override { return m_file.GetSize(); }
+	u64 GetRawSize() const override { return m_file.GetSize(); }
+	bool Read(u64 offset, u64 nbytes, u8* out_ptr) override;
+};
+
 }  // namespace
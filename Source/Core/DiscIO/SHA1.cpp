@@ -0,0 +1,137 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <polarssl/sha1.h>
+
+#include "Common/Common.h"
+#include "Common/CPUDetect.h"
+#include "DiscIO/SHA1.h"
+
+// The SHA extension functions are compiled with FUNCTION_TARGET, ComputeSHA1 only
+// calls them after checking cpu_info at runtime.
+#if _M_X86
+#include <immintrin.h>
+#endif
+
+namespace DiscIO
+{
+
+#if _M_X86
+
+// Hashes whole 64 byte blocks into state, which holds A-E in that order.
+FUNCTION_TARGET("sha,sse4.1")
+static void SHA1TransformSHANI(u32* state, const u8* data, size_t num_blocks)
+{
+	const __m128i byteswap = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+	// The instructions want A in the top lane and E on its own in the top lane.
+	__m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1B);
+	__m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+	__m128i e1;
+	__m128i msg[4];
+
+	for (; num_blocks; num_blocks--, data += 64)
+	{
+		const __m128i abcd_save = abcd;
+		const __m128i e0_save = e0;
+
+		for (int i = 0; i < 4; i++)
+			msg[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + i * 16)), byteswap);
+
+		// Rounds 0-15 still have the message words straight from the block.
+		e0 = _mm_add_epi32(e0, msg[0]);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+		e1 = _mm_sha1nexte_epu32(e1, msg[1]);
+		e0 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+		msg[0] = _mm_sha1msg1_epu32(msg[0], msg[1]);
+
+		e0 = _mm_sha1nexte_epu32(e0, msg[2]);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+		msg[1] = _mm_sha1msg1_epu32(msg[1], msg[2]);
+		msg[0] = _mm_xor_si128(msg[0], msg[2]);
+
+		// From here on every group of four rounds finishes the message schedule for
+		// the groups after it. The last few compute words that are never used.
+#define SHA1_ROUNDS(k, e_in, e_out) \
+		e_in = _mm_sha1nexte_epu32(e_in, msg[(k) % 4]); \
+		e_out = abcd; \
+		msg[((k) + 1) % 4] = _mm_sha1msg2_epu32(msg[((k) + 1) % 4], msg[(k) % 4]); \
+		abcd = _mm_sha1rnds4_epu32(abcd, e_in, (k) / 5); \
+		msg[((k) + 3) % 4] = _mm_sha1msg1_epu32(msg[((k) + 3) % 4], msg[(k) % 4]); \
+		msg[((k) + 2) % 4] = _mm_xor_si128(msg[((k) + 2) % 4], msg[(k) % 4]);
+
+		SHA1_ROUNDS(3, e1, e0);
+		SHA1_ROUNDS(4, e0, e1);
+		SHA1_ROUNDS(5, e1, e0);
+		SHA1_ROUNDS(6, e0, e1);
+		SHA1_ROUNDS(7, e1, e0);
+		SHA1_ROUNDS(8, e0, e1);
+		SHA1_ROUNDS(9, e1, e0);
+		SHA1_ROUNDS(10, e0, e1);
+		SHA1_ROUNDS(11, e1, e0);
+		SHA1_ROUNDS(12, e0, e1);
+		SHA1_ROUNDS(13, e1, e0);
+		SHA1_ROUNDS(14, e0, e1);
+		SHA1_ROUNDS(15, e1, e0);
+		SHA1_ROUNDS(16, e0, e1);
+		SHA1_ROUNDS(17, e1, e0);
+		SHA1_ROUNDS(18, e0, e1);
+		SHA1_ROUNDS(19, e1, e0);
+#undef SHA1_ROUNDS
+
+		e0 = _mm_sha1nexte_epu32(e0, e0_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+	}
+
+	_mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1B));
+	state[4] = _mm_extract_epi32(e0, 3);
+}
+
+FUNCTION_TARGET("sha,sse4.1")
+static void SHA1SHANI(const u8* data, size_t size, u8* hash)
+{
+	u32 state[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+	const size_t whole_blocks = size / 64;
+	SHA1TransformSHANI(state, data, whole_blocks);
+
+	// The rest of the data, the 0x80 terminator and the bit length, in one or two blocks.
+	u8 tail[128] = {};
+	const size_t rest = size % 64;
+	memcpy(tail, data + whole_blocks * 64, rest);
+	tail[rest] = 0x80;
+	const size_t tail_size = rest < 56 ? 64 : 128;
+	const u64 bit_length = (u64)size * 8;
+	for (int i = 0; i < 8; i++)
+		tail[tail_size - 1 - i] = (u8)(bit_length >> (i * 8));
+	SHA1TransformSHANI(state, tail, tail_size / 64);
+
+	for (int i = 0; i < 5; i++)
+	{
+		u32 word = Common::swap32(state[i]);
+		memcpy(hash + i * 4, &word, 4);
+	}
+}
+
+#endif
+
+void ComputeSHA1(const u8* data, size_t size, u8* hash)
+{
+#if _M_X86
+	if (cpu_info.bSHA && cpu_info.bSSE4_1)
+	{
+		SHA1SHANI(data, size, hash);
+		return;
+	}
+#endif
+
+	sha1(data, size, hash);
+}
+
+}  // namespace
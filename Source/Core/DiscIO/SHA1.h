@@ -0,0 +1,18 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+
+#include "Common/CommonTypes.h"
+
+namespace DiscIO
+{
+
+// SHA-1 of size bytes, as used for the hash tree of Wii disc clusters.
+// Uses the x86 SHA extensions when the host CPU has them, and PolarSSL otherwise.
+void ComputeSHA1(const u8* data, size_t size, u8* hash);
+
+}  // namespace
@@ -11,6 +11,18 @@
 
 namespace DiscIO
 {
+
+// What IVolume::CheckIntegrity found.
+struct SIntegrityReport
+{
+	u32 clusters_checked;
+	// Clusters that aren't meant to be read by the game, see CheckIntegrity.
+	u32 clusters_skipped;
+	// The first cluster that failed, or -1.
+	s64 bad_cluster;
+	std::string error;
+};
+
 class IVolume
 {
 public:
@@ -31,7 +43,8 @@ public:
 	virtual u32 GetFSTSize() const = 0;
 	virtual std::string GetApploaderDate() const = 0;
 	virtual bool SupportsIntegrityCheck() const { return false; }
-	virtual bool CheckIntegrity() const { return false; }
+	// num_threads <= 0 uses one thread per host CPU. report may be null.
+	virtual bool CheckIntegrity(SIntegrityReport* report = nullptr, int num_threads = 0) const { return false; }
 	virtual bool IsDiscTwo() const { return false; }
 
 	enum ECountry
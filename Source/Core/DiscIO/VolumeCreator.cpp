@@ -2,18 +2,23 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstddef>
 #include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include <polarssl/aes.h>
 
 #include "Common/Common.h"
+#include "Common/StdThread.h"
 #include "Common/StringUtil.h"
 
 #include "DiscIO/Blob.h"
+#include "DiscIO/BlockPipeline.h"
 #include "DiscIO/Volume.h"
+#include "DiscIO/VolumeCreator.h"
 #include "DiscIO/VolumeDirectory.h"
 #include "DiscIO/VolumeGC.h"
 #include "DiscIO/VolumeWad.h"
@@ -126,6 +131,51 @@ IVolume* CreateVolumeFromDirectory(const std::string& _rDirectory, bool _bIsWii,
 	return nullptr;
 }
 
+std::vector<SPartitionIntegrity> CheckWiiDiscIntegrity(const std::string& _rFilename)
+{
+	std::vector<SPartitionIntegrity> results;
+	std::vector<std::unique_ptr<IVolume>> volumes;
+
+	{
+		std::unique_ptr<IBlobReader> reader(CreateBlobReader(_rFilename));
+		if (!reader || GetDiscType(*reader) != DISC_TYPE_WII_CONTAINER)
+			return results;
+	}
+
+	for (u32 group = 0; group < 4; group++)
+	{
+		for (u32 number = 0; ; number++)
+		{
+			IVolume* volume = CreateVolumeFromFilename(_rFilename, group, number);
+			if (!volume)
+				break;
+
+			SPartitionIntegrity result;
+			result.group = group;
+			result.number = number;
+			result.ok = false;
+			results.push_back(result);
+			volumes.emplace_back(volume);
+		}
+	}
+
+	// Most discs have an update partition and a game partition, the game one being
+	// by far the bigger. Splitting the threads evenly keeps it simple.
+	const int num_threads = std::max(1, GetNumPipelineWorkers() / std::max(1, (int)volumes.size()));
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < volumes.size(); i++)
+	{
+		threads.emplace_back([&volumes, &results, i, num_threads] {
+			results[i].ok = volumes[i]->CheckIntegrity(&results[i].report, num_threads);
+		});
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+
+	return results;
+}
+
 bool IsVolumeWiiDisc(const IVolume *_rVolume)
 {
 	u32 MagicWord = 0;
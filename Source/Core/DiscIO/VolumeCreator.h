@@ -5,8 +5,10 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "Common/CommonTypes.h"
+#include "DiscIO/Volume.h"
 
 namespace DiscIO
 {
@@ -18,4 +20,17 @@ IVolume* CreateVolumeFromDirectory(const std::string& _rDirectory, bool _bIsWii,
 bool IsVolumeWiiDisc(const IVolume *_rVolume);
 bool IsVolumeWadFile(const IVolume *_rVolume);
 
+struct SPartitionIntegrity
+{
+	u32 group;
+	u32 number;
+	bool ok;
+	SIntegrityReport report;
+};
+
+// Checks every partition of a Wii disc image. Each partition gets its own reader
+// and the partitions are checked at the same time, sharing out the host threads.
+// Returns nothing for images that aren't Wii discs.
+std::vector<SPartitionIntegrity> CheckWiiDiscIntegrity(const std::string& _rFilename);
+
 } // namespace
@@ -2,15 +2,18 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstddef>
 #include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
-#include <polarssl/aes.h>
-#include <polarssl/sha1.h>
 
 #include "Common/Common.h"
+#include "Common/StringUtil.h"
 #include "DiscIO/Blob.h"
+#include "DiscIO/BlockPipeline.h"
+#include "DiscIO/SHA1.h"
 #include "DiscIO/Volume.h"
 #include "DiscIO/VolumeGC.h"
 #include "DiscIO/VolumeWiiCrypted.h"
@@ -24,11 +27,17 @@ CVolumeWiiCrypted::CVolumeWiiCrypted(IBlobReader* _pReader, u64 _VolumeOffset,
 	m_pBuffer(nullptr),
 	m_VolumeOffset(_VolumeOffset),
 	dataOffset(0x20000),
-	m_LastDecryptedBlockOffset(-1)
+	m_ClusterCacheClock(0)
 {
-	m_AES_ctx = new aes_context;
-	aes_setkey_dec(m_AES_ctx, _pVolumeKey, 128);
-	m_pBuffer = new u8[0x8000];
+	m_AES = new AESCBCDecryptor(_pVolumeKey);
+	memcpy(m_VolumeKey, _pVolumeKey, sizeof(m_VolumeKey));
+	m_pBuffer = new u8[MAX_BATCH_CLUSTERS * 0x8000];
+	m_ClusterCache = new u8[CLUSTER_CACHE_SIZE * 0x7C00];
+	for (int i = 0; i < CLUSTER_CACHE_SIZE; i++)
+	{
+		m_ClusterCacheTags[i] = (u64)(s64) - 1;
+		m_ClusterCacheAge[i] = 0;
+	}
 }
 
 
@@ -38,8 +47,10 @@ CVolumeWiiCrypted::~CVolumeWiiCrypted()
 	m_pReader = nullptr;
 	delete[] m_pBuffer;
 	m_pBuffer = nullptr;
-	delete m_AES_ctx;
-	m_AES_ctx = nullptr;
+	delete[] m_ClusterCache;
+	m_ClusterCache = nullptr;
+	delete m_AES;
+	m_AES = nullptr;
 }
 
 bool CVolumeWiiCrypted::RAWRead( u64 _Offset, u64 _Length, u8* _pBuffer ) const
@@ -54,6 +65,32 @@ bool CVolumeWiiCrypted::RAWRead( u64 _Offset, u64 _Length, u8* _pBuffer ) const
 	return true;
 }
 
+// Returns the decrypted data of a cluster, from the cache if possible.
+// The pointer stays valid until the next call.
+const u8* CVolumeWiiCrypted::GetDecryptedCluster(u64 cluster) const
+{
+	int slot = 0;
+	for (int i = 0; i < CLUSTER_CACHE_SIZE; i++)
+	{
+		if (m_ClusterCacheTags[i] == cluster)
+		{
+			m_ClusterCacheAge[i] = ++m_ClusterCacheClock;
+			return m_ClusterCache + i * 0x7C00;
+		}
+		if (m_ClusterCacheAge[i] < m_ClusterCacheAge[slot])
+			slot = i;
+	}
+
+	if (!m_pReader->Read(m_VolumeOffset + dataOffset + cluster * 0x8000, 0x8000, m_pBuffer))
+		return nullptr;
+
+	u8* decrypted = m_ClusterCache + slot * 0x7C00;
+	m_AES->Decrypt(m_pBuffer + 0x3d0, m_pBuffer + 0x400, decrypted, 0x7C00);
+	m_ClusterCacheTags[slot] = cluster;
+	m_ClusterCacheAge[slot] = ++m_ClusterCacheClock;
+	return decrypted;
+}
+
 bool CVolumeWiiCrypted::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer) const
 {
 	if (m_pReader == nullptr)
@@ -63,30 +100,42 @@ bool CVolumeWiiCrypted::Read(u64 _ReadOffset, u64 _Length, u8* _pBuffer) const
 
 	while (_Length > 0)
 	{
-		static unsigned char IV[16];
-
 		// math block offset
 		u64 Block  = _ReadOffset / 0x7C00;
 		u64 Offset = _ReadOffset % 0x7C00;
 
-		// read current block
-		if (!m_pReader->Read(m_VolumeOffset + dataOffset + Block * 0x8000, 0x8000, m_pBuffer))
+		// Whole clusters are read from the blob in one go and decrypted straight into
+		// the caller's buffer. They are big reads, so there's little point caching them.
+		if (Offset == 0 && _Length >= 0x7C00)
 		{
-			return(false);
+			u64 NumClusters = std::min<u64>(_Length / 0x7C00, MAX_BATCH_CLUSTERS);
+			if (!m_pReader->Read(m_VolumeOffset + dataOffset + Block * 0x8000, NumClusters * 0x8000, m_pBuffer))
+			{
+				return(false);
+			}
+
+			for (u64 i = 0; i < NumClusters; i++)
+			{
+				const u8* Cluster = m_pBuffer + i * 0x8000;
+				m_AES->Decrypt(Cluster + 0x3d0, Cluster + 0x400, _pBuffer + i * 0x7C00, 0x7C00);
+			}
+
+			_Length -= NumClusters * 0x7C00;
+			_pBuffer    += NumClusters * 0x7C00;
+			_ReadOffset += NumClusters * 0x7C00;
+			continue;
 		}
 
-		if (m_LastDecryptedBlockOffset != Block)
+		const u8* Decrypted = GetDecryptedCluster(Block);
+		if (!Decrypted)
 		{
-			memcpy(IV, m_pBuffer + 0x3d0, 16);
-			aes_crypt_cbc(m_AES_ctx, AES_DECRYPT, 0x7C00, IV, m_pBuffer + 0x400, m_LastDecryptedBlock);
-
-			m_LastDecryptedBlockOffset = Block;
+			return(false);
 		}
 
-		// copy the encrypted data
+		// copy the decrypted data
 		u64 MaxSizeToCopy = 0x7C00 - Offset;
 		u64 CopySize = (_Length > MaxSizeToCopy) ? MaxSizeToCopy : _Length;
-		memcpy(_pBuffer, &m_LastDecryptedBlock[Offset], (size_t)CopySize);
+		memcpy(_pBuffer, Decrypted + Offset, (size_t)CopySize);
 
 		// increase buffers
 		_Length -= CopySize;
@@ -240,29 +289,57 @@ u64 CVolumeWiiCrypted::GetRawSize() const
 	}
 }
 
-bool CVolumeWiiCrypted::CheckIntegrity() const
+bool CVolumeWiiCrypted::CheckIntegrity(SIntegrityReport* report, int num_threads) const
 {
+	SIntegrityReport local_report;
+	if (!report)
+		report = &local_report;
+	report->clusters_checked = 0;
+	report->clusters_skipped = 0;
+	report->bad_cluster = -1;
+	report->error.clear();
+
 	// Get partition data size
 	u32 partSizeDiv4;
 	RAWRead(m_VolumeOffset + 0x2BC, 4, (u8*)&partSizeDiv4);
 	u64 partDataSize = (u64)Common::swap32(partSizeDiv4) * 4;
 
 	u32 nClusters = (u32)(partDataSize / 0x8000);
-	for (u32 clusterID = 0; clusterID < nClusters; ++clusterID)
+
+	// Decrypting and hashing are where the time goes, and every cluster can be
+	// checked on its own. Reading stays on this thread, the blob reader isn't
+	// thread-safe.
+	if (num_threads <= 0)
+		num_threads = GetNumPipelineWorkers();
+	std::vector<std::unique_ptr<AESCBCDecryptor>> decryptors;
+	for (int i = 0; i < num_threads; i++)
+		decryptors.emplace_back(new AESCBCDecryptor(m_VolumeKey));
+
+	// Anything else is the index of the first invalid hash.
+	enum { CLUSTER_OK = -1, CLUSTER_SKIPPED = -2 };
+
+	auto read_cluster = [&](u32 clusterID, PipelineSlot& slot)
 	{
 		u64 clusterOff = m_VolumeOffset + dataOffset + (u64)clusterID * 0x8000;
-
-		// Read and decrypt the cluster metadata
-		u8 clusterMDCrypted[0x400];
-		u8 clusterMD[0x400];
-		u8 IV[16] = { 0 };
-		if (!m_pReader->Read(clusterOff, 0x400, clusterMDCrypted))
+		if (!m_pReader->Read(clusterOff, 0x8000, slot.in_buf.data()))
 		{
-			NOTICE_LOG(DISCIO, "Integrity Check: fail at cluster %d: could not read metadata", clusterID);
+			NOTICE_LOG(DISCIO, "Integrity Check: fail at cluster %d: could not read cluster", clusterID);
+			report->bad_cluster = clusterID;
+			report->error = StringFromFormat("Cluster %u could not be read", clusterID);
 			return false;
 		}
-		aes_crypt_cbc(m_AES_ctx, AES_DECRYPT, 0x400, IV, clusterMDCrypted, clusterMD);
+		return true;
+	};
 
+	auto check_cluster = [&](int worker, u32 clusterID, PipelineSlot& slot)
+	{
+		const u8* clusterCrypted = slot.in_buf.data();
+		u8* clusterMD = slot.out_buf.data();
+		u8* clusterData = clusterMD + 0x400;
+
+		// Decrypt the cluster metadata
+		static const u8 IV[16] = { 0 };
+		decryptors[worker]->Decrypt(IV, clusterCrypted, clusterMD, 0x400);
 
 		// Some clusters have invalid data and metadata because they aren't
 		// meant to be read by the game (for example, holes between files). To
@@ -272,37 +349,54 @@ bool CVolumeWiiCrypted::CheckIntegrity() const
 		// This may cause some false negatives though: some bad clusters may be
 		// skipped because they are *too* bad and are not even recognized as
 		// valid clusters. To be improved.
-		bool meaningless = false;
 		for (u32 idx = 0x26C; idx < 0x280; ++idx)
-			if (clusterMD[idx] != 0)
-				meaningless = true;
-
-		if (meaningless)
-			continue;
-
-		u8 clusterData[0x7C00];
-		if (!Read((u64)clusterID * 0x7C00, 0x7C00, clusterData))
 		{
-			NOTICE_LOG(DISCIO, "Integrity Check: fail at cluster %d: could not read data", clusterID);
-			return false;
+			if (clusterMD[idx] != 0)
+			{
+				slot.status = CLUSTER_SKIPPED;
+				return true;
+			}
 		}
 
+		decryptors[worker]->Decrypt(clusterCrypted + 0x3D0, clusterCrypted + 0x400, clusterData, 0x7C00);
+
 		for (u32 hashID = 0; hashID < 31; ++hashID)
 		{
 			u8 hash[20];
 
-			sha1(clusterData + hashID * 0x400, 0x400, hash);
+			ComputeSHA1(clusterData + hashID * 0x400, 0x400, hash);
 
 			// Note that we do not use strncmp here
 			if (memcmp(hash, clusterMD + hashID * 20, 20))
 			{
-				NOTICE_LOG(DISCIO, "Integrity Check: fail at cluster %d: hash %d is invalid", clusterID, hashID);
-				return false;
+				slot.status = hashID;
+				return true;
 			}
 		}
-	}
 
-	return true;
+		slot.status = CLUSTER_OK;
+		return true;
+	};
+
+	auto record_cluster = [&](u32 clusterID, PipelineSlot& slot)
+	{
+		if (slot.status == CLUSTER_SKIPPED)
+		{
+			report->clusters_skipped++;
+			return true;
+		}
+
+		report->clusters_checked++;
+		if (slot.status == CLUSTER_OK)
+			return true;
+
+		NOTICE_LOG(DISCIO, "Integrity Check: fail at cluster %d: hash %d is invalid", clusterID, slot.status);
+		report->bad_cluster = clusterID;
+		report->error = StringFromFormat("Hash %d of cluster %u is invalid", slot.status, clusterID);
+		return false;
+	};
+
+	return RunBlockPipeline(nClusters, 0x8000, num_threads, read_cluster, check_cluster, record_cluster);
 }
 
 } // namespace
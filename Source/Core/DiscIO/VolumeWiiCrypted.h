@@ -6,9 +6,9 @@
 
 #include <string>
 #include <vector>
-#include <polarssl/aes.h>
 
 #include "Common/CommonTypes.h"
+#include "DiscIO/AESCBC.h"
 #include "DiscIO/Volume.h"
 
 // --- this volume type is used for encrypted Wii images ---
@@ -37,19 +37,34 @@ public:
 	u64 GetRawSize() const override;
 
 	bool SupportsIntegrityCheck() const override { return true; }
-	bool CheckIntegrity() const override;
+	bool CheckIntegrity(SIntegrityReport* report = nullptr, int num_threads = 0) const override;
 
 private:
+	enum
+	{
+		// Decrypted clusters kept around for small and unaligned reads.
+		CLUSTER_CACHE_SIZE = 16,
+		// Runs of whole clusters are read from the blob in chunks of this many clusters.
+		MAX_BATCH_CLUSTERS = 16,
+	};
+
+	const u8* GetDecryptedCluster(u64 cluster) const;
+
 	IBlobReader* m_pReader;
 
+	// Raw (encrypted) clusters, room for MAX_BATCH_CLUSTERS of them.
 	u8* m_pBuffer;
-	aes_context* m_AES_ctx;
+	AESCBCDecryptor* m_AES;
+	// Kept for CheckIntegrity, which gives every thread its own decryptor.
+	u8 m_VolumeKey[16];
 
 	u64 m_VolumeOffset;
 	u64 dataOffset;
 
-	mutable u64 m_LastDecryptedBlockOffset;
-	mutable unsigned char m_LastDecryptedBlock[0x8000];
+	mutable u8* m_ClusterCache;
+	mutable u64 m_ClusterCacheTags[CLUSTER_CACHE_SIZE];
+	mutable u64 m_ClusterCacheAge[CLUSTER_CACHE_SIZE];
+	mutable u64 m_ClusterCacheClock;
 };
 
 } // namespace
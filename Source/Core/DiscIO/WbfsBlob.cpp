@@ -69,6 +69,9 @@ bool WbfsFileReader::OpenFiles(const std::string& filename)
 			return 0 != m_total_files;
 		}
 
+		if (GetMappedReads())
+			new_entry->mapping.Open(path);
+
 		new_entry->base_address = m_size;
 		new_entry->size = new_entry->file.GetSize();
 		m_size += new_entry->size;
@@ -127,10 +130,17 @@ bool WbfsFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
 	while (nbytes)
 	{
 		u64 read_size = 0;
-		File::IOFile& data_file = SeekToCluster(offset, &read_size);
+		u64 file_offset = 0;
+		file_entry& data_file = SeekToCluster(offset, &read_size, &file_offset);
 		read_size = (read_size > nbytes) ? nbytes : read_size;
 
-		data_file.ReadBytes(out_ptr, read_size);
+		bool success;
+		if (data_file.mapping.IsOpen())
+			success = data_file.mapping.Read(file_offset, read_size, out_ptr);
+		else
+			success = data_file.file.ReadBytes(out_ptr, read_size);
+		if (!success)
+			return false;
 
 		out_ptr += read_size;
 		nbytes -= read_size;
@@ -140,7 +150,7 @@ bool WbfsFileReader::Read(u64 offset, u64 nbytes, u8* out_ptr)
 	return true;
 }
 
-File::IOFile& WbfsFileReader::SeekToCluster(u64 offset, u64* available)
+WbfsFileReader::file_entry& WbfsFileReader::SeekToCluster(u64 offset, u64* available, u64* file_offset)
 {
 	u64 base_cluster = offset >> wbfs_sector_shift;
 	if (base_cluster < m_blocks_per_disc)
@@ -153,7 +163,9 @@ File::IOFile& WbfsFileReader::SeekToCluster(u64 offset, u64* available)
 		{
 			if (final_address < (m_files[i]->base_address + m_files[i]->size))
 			{
-				m_files[i]->file.Seek(final_address - m_files[i]->base_address, SEEK_SET);
+				*file_offset = final_address - m_files[i]->base_address;
+				if (!m_files[i]->mapping.IsOpen())
+					m_files[i]->file.Seek(*file_offset, SEEK_SET);
 				if (available)
 				{
 					u64 till_end_of_file = m_files[i]->size - (final_address - m_files[i]->base_address);
@@ -161,14 +173,15 @@ File::IOFile& WbfsFileReader::SeekToCluster(u64 offset, u64* available)
 					*available = std::min(till_end_of_file, till_end_of_sector);
 				}
 
-				return m_files[i]->file;
+				return *m_files[i];
 			}
 		}
 	}
 
 	PanicAlert("Read beyond end of disc");
+	*file_offset = 0;
 	m_files[0]->file.Seek(0, SEEK_SET);
-	return m_files[0]->file;
+	return *m_files[0];
 }
 
 WbfsFileReader* WbfsFileReader::Create(const std::string& filename)
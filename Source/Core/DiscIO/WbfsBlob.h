@@ -9,6 +9,7 @@
 
 #include "Common/CommonTypes.h"
 #include "Common/FileUtil.h"
+#include "Common/MappedFile.h"
 #include "DiscIO/Blob.h"
 
 namespace DiscIO
@@ -22,17 +23,20 @@ class WbfsFileReader : public IBlobReader
 	bool OpenFiles(const std::string& filename);
 	bool ReadHeader();
 
-	File::IOFile& SeekToCluster(u64 offset, u64* available);
 	bool IsGood() {return m_good;}
 
 
 	struct file_entry
 	{
 		File::IOFile file;
+		// Only open when mapped reads are enabled and the part could be mapped.
+		File::MappedFile mapping;
 		u64 base_address;
 		u64 size;
 	};
 
+	file_entry& SeekToCluster(u64 offset, u64* available, u64* file_offset);
+
 	std::vector<file_entry*> m_files;
 
 	u32 m_total_files;
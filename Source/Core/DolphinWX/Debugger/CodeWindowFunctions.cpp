@@ -196,6 +196,9 @@ void CCodeWindow::OnProfilerMenu(wxCommandEvent& event)
 				std::string filename = File::GetUserPath(D_DUMP_IDX) + "Debug/profiler.txt";
 				File::CreateFullPath(filename);
 				Profiler::WriteProfileResults(filename);
+				// The same results per function, and everything for scripts to read.
+				Profiler::WriteProfileResults(File::GetUserPath(D_DUMP_IDX) + "Debug/profiler.csv");
+				Profiler::WriteProfileResults(File::GetUserPath(D_DUMP_IDX) + "Debug/profiler.json");
 
 				wxFileType* filetype = nullptr;
 				if (!(filetype = wxTheMimeTypesManager->GetFileTypeFromExtension(_T("txt"))))
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <cstddef>
 #include <cstdio>
@@ -45,8 +46,10 @@
 #include "Common/FileUtil.h"
 #include "Common/MathUtil.h"
 #include "Common/StdMakeUnique.h"
+#include "Common/StdThread.h"
 #include "Common/StringUtil.h"
 #include "Common/SysConf.h"
+#include "Common/Thread.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/CoreParameter.h"
@@ -210,9 +213,12 @@ BEGIN_EVENT_TABLE(CGameListCtrl, wxListCtrl)
 	EVT_MENU(IDM_DELETEGCM, CGameListCtrl::OnDeleteGCM)
 END_EVENT_TABLE()
 
+// Most volumes read at once while scanning
+static const size_t MAX_SCAN_THREADS = 8;
+
 CGameListCtrl::CGameListCtrl(wxWindow* parent, const wxWindowID id, const
 		wxPoint& pos, const wxSize& size, long style)
-	: wxListCtrl(parent, id, pos, size, style), toolTip(nullptr)
+	: wxListCtrl(parent, id, pos, size, style), m_cache_loaded(false), toolTip(nullptr)
 {
 	DragAcceptFiles(true);
 	Connect(wxEVT_DROP_FILES, wxDropFilesEventHandler(CGameListCtrl::OnDropFiles), nullptr, this);
@@ -545,20 +551,60 @@ void CGameListCtrl::ScanForISOs()
 			wxPD_SMOOTH // - makes updates as small as possible (down to 1px)
 			);
 
-		for (u32 i = 0; i < rFilenames.size(); i++)
+		if (!m_cache_loaded)
+		{
+			m_cache.Load();
+			m_cache_loaded = true;
+		}
+
+		// Reading a volume mostly waits for the disk (or the network), so
+		// several are read at once. wx isn't thread safe, so the bitmaps are
+		// only created here afterwards.
+		std::vector<std::unique_ptr<GameListItem>> iso_files(rFilenames.size());
+		std::atomic<u32> next_file(0);
+		std::atomic<u32> files_done(0);
+		std::atomic<bool> cancelled(false);
+
+		const size_t num_threads = std::min<size_t>(MAX_SCAN_THREADS, rFilenames.size());
+		std::vector<std::thread> scan_threads;
+		for (size_t t = 0; t < num_threads; ++t)
+		{
+			scan_threads.emplace_back([&] {
+				Common::SetCurrentThreadName("Game list scanner");
+				u32 i;
+				while (!cancelled && (i = next_file++) < rFilenames.size())
+				{
+					iso_files[i] = std::make_unique<GameListItem>(rFilenames[i], &m_cache);
+					++files_done;
+				}
+			});
+		}
+
+		u32 done;
+		while ((done = files_done) < rFilenames.size())
 		{
 			std::string FileName;
-			SplitPath(rFilenames[i], nullptr, &FileName, nullptr);
+			SplitPath(rFilenames[std::min<u32>(next_file, (u32)rFilenames.size() - 1)], nullptr, &FileName, nullptr);
 
-			// Update with the progress (i) and the message
-			dialog.Update(i, wxString::Format(_("Scanning %s"),
+			// Update with the progress (done) and the message
+			dialog.Update(done, wxString::Format(_("Scanning %s"),
 				StrToWxStr(FileName)));
 			if (dialog.WasCancelled())
+			{
+				cancelled = true;
 				break;
+			}
+			Common::SleepCurrentThread(20);
+		}
 
-			auto iso_file = std::make_unique<GameListItem>(rFilenames[i]);
+		for (auto& thread : scan_threads)
+			thread.join();
 
-			if (iso_file->IsValid())
+		m_cache.Save();
+
+		for (auto& iso_file : iso_files)
+		{
+			if (iso_file && iso_file->IsValid())
 			{
 				bool list = true;
 
@@ -610,7 +656,10 @@ void CGameListCtrl::ScanForISOs()
 				}
 
 				if (list)
+				{
+					iso_file->CreateBitmap();
 					m_ISOFiles.push_back(iso_file.release());
+				}
 			}
 		}
 	}
@@ -624,7 +673,10 @@ void CGameListCtrl::ScanForISOs()
 			auto gli = std::make_unique<GameListItem>(drive);
 
 			if (gli->IsValid())
+			{
+				gli->CreateBitmap();
 				m_ISOFiles.push_back(gli.release());
+			}
 		}
 	}
 
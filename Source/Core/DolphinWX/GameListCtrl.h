@@ -63,6 +63,8 @@ private:
 	std::vector<int> m_PlatformImageIndex;
 	std::vector<int> m_EmuStateImageIndex;
 	std::vector<GameListItem*> m_ISOFiles;
+	GameListCache m_cache;
+	bool m_cache_loaded;
 
 	void ClearIsoFiles()
 	{
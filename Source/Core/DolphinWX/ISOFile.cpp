@@ -2,7 +2,6 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
-#include <cinttypes>
 #include <cstdio>
 #include <cstring>
 #include <string>
@@ -17,7 +16,6 @@
 #include "Common/Common.h"
 #include "Common/CommonPaths.h"
 #include "Common/FileUtil.h"
-#include "Common/Hash.h"
 #include "Common/IniFile.h"
 #include "Common/StringUtil.h"
 
@@ -34,12 +32,12 @@
 #include "DolphinWX/ISOFile.h"
 #include "DolphinWX/WxUtils.h"
 
-static const u32 CACHE_REVISION = 0x115;
+static const u32 CACHE_REVISION = 0x116;
 
 #define DVD_BANNER_WIDTH 96
 #define DVD_BANNER_HEIGHT 32
 
-GameListItem::GameListItem(const std::string& _rFileName)
+GameListItem::GameListItem(const std::string& _rFileName, GameListCache* cache)
 	: m_FileName(_rFileName)
 	, m_emu_state(0)
 	, m_FileSize(0)
@@ -49,7 +47,14 @@ GameListItem::GameListItem(const std::string& _rFileName)
 	, m_ImageWidth(0)
 	, m_ImageHeight(0)
 {
-	if (LoadFromCache())
+	u64 file_size = 0, mtime = 0;
+	if (cache)
+	{
+		file_size = File::GetSize(_rFileName);
+		mtime = File::GetModifiedTime(_rFileName);
+	}
+
+	if (cache && cache->Get(_rFileName, file_size, mtime, this))
 	{
 		m_Valid = true;
 	}
@@ -115,10 +120,10 @@ GameListItem::GameListItem(const std::string& _rFileName)
 
 			m_Valid = true;
 
-			// Create a cache file only if we have an image.
+			// Only cache the item if we have an image.
 			// Wii isos create their images after you have generated the first savegame
-			if (!m_pImage.empty())
-				SaveToCache();
+			if (cache && !m_pImage.empty())
+				cache->Put(_rFileName, file_size, mtime, this);
 		}
 	}
 
@@ -130,7 +135,14 @@ GameListItem::GameListItem(const std::string& _rFileName)
 		ini.Get("EmuState", "EmulationStateId", &m_emu_state);
 		ini.Get("EmuState", "EmulationIssues", &m_issues);
 	}
+}
+
+GameListItem::~GameListItem()
+{
+}
 
+void GameListItem::CreateBitmap()
+{
 	if (!m_pImage.empty())
 	{
 		wxImage Image(m_ImageWidth, m_ImageHeight, &m_pImage[0], true);
@@ -151,25 +163,6 @@ GameListItem::GameListItem(const std::string& _rFileName)
 	}
 }
 
-GameListItem::~GameListItem()
-{
-}
-
-bool GameListItem::LoadFromCache()
-{
-	return CChunkFileReader::Load<GameListItem>(CreateCacheFilename(), CACHE_REVISION, *this);
-}
-
-void GameListItem::SaveToCache()
-{
-	if (!File::IsDirectory(File::GetUserPath(D_CACHE_IDX)))
-	{
-		File::CreateDir(File::GetUserPath(D_CACHE_IDX));
-	}
-
-	CChunkFileReader::Save<GameListItem>(CreateCacheFilename(), CACHE_REVISION, *this);
-}
-
 void GameListItem::DoState(PointerWrap &p)
 {
 	p.Do(m_volume_names);
@@ -189,24 +182,6 @@ void GameListItem::DoState(PointerWrap &p)
 	p.Do(m_Revision);
 }
 
-std::string GameListItem::CreateCacheFilename()
-{
-	std::string Filename, LegalPathname, extension;
-	SplitPath(m_FileName, &LegalPathname, &Filename, &extension);
-
-	if (Filename.empty()) return Filename; // Disc Drive
-
-	// Filename.extension_HashOfFolderPath_Size.cache
-	// Append hash to prevent ISO name-clashing in different folders.
-	Filename.append(StringFromFormat("%s_%x_%" PRIx64 ".cache",
-		extension.c_str(), HashFletcher((const u8 *)LegalPathname.c_str(), LegalPathname.size()),
-		File::GetSize(m_FileName)));
-
-	std::string fullname(File::GetUserPath(D_CACHE_IDX));
-	fullname += Filename;
-	return fullname;
-}
-
 std::string GameListItem::GetCompany() const
 {
 	if (m_company.empty())
@@ -307,3 +282,110 @@ const std::string GameListItem::GetWiiFSPath() const
 	return ret;
 }
 
+GameListCache::GameListCache()
+	: m_dirty(false)
+{
+}
+
+std::string GameListCache::GetFilename() const
+{
+	return File::GetUserPath(D_CACHE_IDX) + "gamelist.cache";
+}
+
+void GameListCache::Load()
+{
+	std::lock_guard<std::mutex> lk(m_lock);
+	m_entries.clear();
+	m_dirty = false;
+
+	if (!CChunkFileReader::Load<GameListCache>(GetFilename(), CACHE_REVISION, *this))
+		m_entries.clear();
+}
+
+void GameListCache::Save()
+{
+	std::lock_guard<std::mutex> lk(m_lock);
+	if (!m_dirty)
+		return;
+
+	// Forget the games that are gone.
+	for (auto it = m_entries.begin(); it != m_entries.end();)
+	{
+		if (!File::Exists(it->first))
+			it = m_entries.erase(it);
+		else
+			++it;
+	}
+
+	if (!File::IsDirectory(File::GetUserPath(D_CACHE_IDX)))
+	{
+		File::CreateDir(File::GetUserPath(D_CACHE_IDX));
+	}
+
+	if (CChunkFileReader::Save<GameListCache>(GetFilename(), CACHE_REVISION, *this))
+		m_dirty = false;
+}
+
+bool GameListCache::Get(const std::string& path, u64 size, u64 mtime, GameListItem* item)
+{
+	std::lock_guard<std::mutex> lk(m_lock);
+
+	auto it = m_entries.find(path);
+	if (it == m_entries.end() || it->second.size != size || it->second.mtime != mtime || it->second.data.empty())
+		return false;
+
+	u8* ptr = &it->second.data[0];
+	PointerWrap p(&ptr, PointerWrap::MODE_READ);
+	item->DoState(p);
+	return true;
+}
+
+void GameListCache::Put(const std::string& path, u64 size, u64 mtime, GameListItem* item)
+{
+	Entry entry;
+	entry.size = size;
+	entry.mtime = mtime;
+
+	u8* ptr = nullptr;
+	PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
+	item->DoState(p);
+	entry.data.resize((size_t)ptr);
+	ptr = &entry.data[0];
+	p.SetMode(PointerWrap::MODE_WRITE);
+	item->DoState(p);
+
+	std::lock_guard<std::mutex> lk(m_lock);
+	m_entries[path] = std::move(entry);
+	m_dirty = true;
+}
+
+void GameListCache::DoState(PointerWrap &p)
+{
+	u32 count = (u32)m_entries.size();
+	p.Do(count);
+
+	if (p.GetMode() == PointerWrap::MODE_READ)
+	{
+		for (; count != 0; --count)
+		{
+			std::string path;
+			Entry entry;
+			p.Do(path);
+			p.Do(entry.size);
+			p.Do(entry.mtime);
+			p.Do(entry.data);
+			m_entries[path] = std::move(entry);
+		}
+	}
+	else
+	{
+		for (auto& entry : m_entries)
+		{
+			std::string path = entry.first;
+			p.Do(path);
+			p.Do(entry.second.size);
+			p.Do(entry.second.mtime);
+			p.Do(entry.second.data);
+		}
+	}
+}
@@ -4,23 +4,33 @@
 
 #pragma once
 
+#include <map>
 #include <string>
 #include <vector>
 
 #include "Common/Common.h"
+#include "Common/StdMutex.h"
 #include "DiscIO/Volume.h"
 
 #if defined(HAVE_WX) && HAVE_WX
 #include <wx/image.h>
 #endif
 
+class GameListCache;
 class PointerWrap;
 class GameListItem : NonCopyable
 {
 public:
-	GameListItem(const std::string& _rFileName);
+	// Reads everything but the bitmap, from the cache if it's given and has an
+	// up to date entry for the file. Doesn't use wx, so it can run on any thread.
+	GameListItem(const std::string& _rFileName, GameListCache* cache = nullptr);
 	~GameListItem();
 
+#if defined(HAVE_WX) && HAVE_WX
+	// Must be called from the main thread before GetBitmap.
+	void CreateBitmap();
+#endif
+
 	bool IsValid() const {return m_Valid;}
 	const std::string& GetFileName() const {return m_FileName;}
 	std::string GetBannerName(int index) const;
@@ -84,9 +94,37 @@ private:
 	std::vector<u8> m_pImage;
 	int m_ImageWidth, m_ImageHeight;
 	bool m_IsDiscTwo;
+};
+
+// The metadata of all scanned games, stored in a single file so that an
+// unchanged library is loaded with one read. Entries are keyed by path and
+// only used while the file's size and modification time still match.
+class GameListCache : NonCopyable
+{
+public:
+	GameListCache();
+
+	void Load();
+	// Writes the cache back if anything changed since it was loaded.
+	void Save();
+
+	// Both can be called from several threads at once.
+	bool Get(const std::string& path, u64 size, u64 mtime, GameListItem* item);
+	void Put(const std::string& path, u64 size, u64 mtime, GameListItem* item);
+
+	void DoState(PointerWrap &p);
+
+private:
+	struct Entry
+	{
+		u64 size;
+		u64 mtime;
+		std::vector<u8> data;
+	};
 
-	bool LoadFromCache();
-	void SaveToCache();
+	std::string GetFilename() const;
 
-	std::string CreateCacheFilename();
+	std::mutex m_lock;
+	std::map<std::string, Entry> m_entries;
+	bool m_dirty;
 };
@@ -11,6 +11,7 @@
 #include <cstdio>
 #include <cstring>
 #include <fstream>
+#include <functional>
 #include <set>
 #include <string>
 #include <type_traits>
@@ -122,6 +123,7 @@ BEGIN_EVENT_TABLE(CISOProperties, wxDialog)
 	EVT_MENU(IDM_EXTRACTAPPLOADER, CISOProperties::OnExtractDataFromHeader)
 	EVT_MENU(IDM_EXTRACTDOL, CISOProperties::OnExtractDataFromHeader)
 	EVT_MENU(IDM_CHECKINTEGRITY, CISOProperties::CheckPartitionIntegrity)
+	EVT_MENU(IDM_CHECKINTEGRITYALL, CISOProperties::CheckDiscIntegrity)
 	EVT_CHOICE(ID_LANG, CISOProperties::OnChangeBannerLang)
 END_EVENT_TABLE()
 
@@ -189,6 +191,7 @@ CISOProperties::CISOProperties(const std::string fileName, wxWindow* parent, wxW
 
 	// Setup GUI
 	OpenGameListItem = new GameListItem(fileName);
+	OpenGameListItem->CreateBitmap();
 
 	bRefreshList = false;
 
@@ -723,6 +726,9 @@ void CISOProperties::OnRightClickOnTree(wxTreeEvent& event)
 		popupMenu->Append(IDM_CHECKINTEGRITY, _("Check Partition Integrity"));
 	}
 
+	if (DiscIO::IsVolumeWiiDisc(OpenISO))
+		popupMenu->Append(IDM_CHECKINTEGRITYALL, _("Check Integrity of All Partitions"));
+
 	PopupMenu(popupMenu);
 
 	event.Skip();
@@ -945,42 +951,30 @@ void CISOProperties::OnExtractDataFromHeader(wxCommandEvent& event)
 class IntegrityCheckThread : public wxThread
 {
 public:
-	IntegrityCheckThread(const WiiPartition& Partition)
-		: wxThread(wxTHREAD_JOINABLE), m_Partition(Partition)
+	IntegrityCheckThread(std::function<void()> Check)
+		: wxThread(wxTHREAD_JOINABLE), m_Check(Check)
 	{
 		Create();
 	}
 
 	virtual ExitCode Entry() override
 	{
-		return (ExitCode)m_Partition.Partition->CheckIntegrity();
+		m_Check();
+		return nullptr;
 	}
 
 private:
-	const WiiPartition& m_Partition;
+	std::function<void()> m_Check;
 };
 
-void CISOProperties::CheckPartitionIntegrity(wxCommandEvent& event)
+void CISOProperties::RunIntegrityCheck(std::function<void()> Check)
 {
-	// Normally we can't enter this function if we aren't analyzing a Wii disc
-	// anyway, but let's still check to be sure.
-	if (!DiscIO::IsVolumeWiiDisc(OpenISO))
-		return;
-
-	wxString PartitionName = m_Treectrl->GetItemText(m_Treectrl->GetSelection());
-	if (!PartitionName)
-		return;
-
-	// Get the partition number from the item text ("Partition N")
-	int PartitionNum = wxAtoi(PartitionName.Mid(PartitionName.find_first_of("0123456789"), 1));
-	const WiiPartition& Partition = WiiDisc[PartitionNum];
-
 	wxProgressDialog* dialog = new wxProgressDialog(
 		_("Checking integrity..."), _("Working..."), 1000, this,
 		wxPD_APP_MODAL | wxPD_ELAPSED_TIME | wxPD_SMOOTH
 	);
 
-	IntegrityCheckThread thread(Partition);
+	IntegrityCheckThread thread(Check);
 	thread.Run();
 
 	while (thread.IsAlive())
@@ -989,21 +983,82 @@ void CISOProperties::CheckPartitionIntegrity(wxCommandEvent& event)
 		wxThread::Sleep(50);
 	}
 
+	thread.Wait();
 	delete dialog;
+}
 
-	if (!thread.Wait())
+void CISOProperties::CheckPartitionIntegrity(wxCommandEvent& event)
+{
+	// Normally we can't enter this function if we aren't analyzing a Wii disc
+	// anyway, but let's still check to be sure.
+	if (!DiscIO::IsVolumeWiiDisc(OpenISO))
+		return;
+
+	wxString PartitionName = m_Treectrl->GetItemText(m_Treectrl->GetSelection());
+	if (!PartitionName)
+		return;
+
+	// Get the partition number from the item text ("Partition N")
+	int PartitionNum = wxAtoi(PartitionName.Mid(PartitionName.find_first_of("0123456789"), 1));
+	const WiiPartition& Partition = WiiDisc[PartitionNum];
+
+	bool ok = false;
+	DiscIO::SIntegrityReport report;
+	RunIntegrityCheck([&] { ok = Partition.Partition->CheckIntegrity(&report); });
+
+	if (!ok)
 	{
 		wxMessageBox(
 			wxString::Format(_("Integrity check for partition %d failed. "
 							   "Your dump is most likely corrupted or has been "
-							   "patched incorrectly."), PartitionNum),
+							   "patched incorrectly.\n\n%s"), PartitionNum, StrToWxStr(report.error).c_str()),
 			_("Integrity Check Error"), wxOK | wxICON_ERROR, this
 		);
 	}
 	else
 	{
-		wxMessageBox(_("Integrity check completed. No errors have been found."),
-					 _("Integrity check completed"), wxOK | wxICON_INFORMATION, this);
+		wxMessageBox(wxString::Format(_("Integrity check completed. No errors have been found.\n\n"
+		                                "%u clusters checked, %u unused clusters skipped."),
+		                              report.clusters_checked, report.clusters_skipped),
+		             _("Integrity check completed"), wxOK | wxICON_INFORMATION, this);
+	}
+}
+
+void CISOProperties::CheckDiscIntegrity(wxCommandEvent& event)
+{
+	if (!DiscIO::IsVolumeWiiDisc(OpenISO))
+		return;
+
+	std::vector<DiscIO::SPartitionIntegrity> results;
+	RunIntegrityCheck([&] { results = DiscIO::CheckWiiDiscIntegrity(OpenGameListItem->GetFileName()); });
+
+	bool ok = !results.empty();
+	wxString details;
+	for (const DiscIO::SPartitionIntegrity& result : results)
+	{
+		ok &= result.ok;
+		if (result.ok)
+		{
+			details += wxString::Format(_("Partition %u:%u: OK, %u clusters checked\n"),
+			                            result.group, result.number, result.report.clusters_checked);
+		}
+		else
+		{
+			details += wxString::Format(_("Partition %u:%u: %s\n"),
+			                            result.group, result.number, StrToWxStr(result.report.error).c_str());
+		}
+	}
+
+	if (!ok)
+	{
+		wxMessageBox(_("Integrity check failed. Your dump is most likely corrupted or has been "
+		               "patched incorrectly.\n\n") + details,
+		             _("Integrity Check Error"), wxOK | wxICON_ERROR, this);
+	}
+	else
+	{
+		wxMessageBox(_("Integrity check completed. No errors have been found.\n\n") + details,
+		             _("Integrity check completed"), wxOK | wxICON_INFORMATION, this);
 	}
 }
 
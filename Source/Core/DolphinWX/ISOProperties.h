@@ -5,6 +5,7 @@
 #pragma once
 
 #include <cstddef>
+#include <functional>
 #include <set>
 #include <string>
 #include <vector>
@@ -171,6 +172,7 @@ private:
 		IDM_EXTRACTAPPLOADER,
 		IDM_EXTRACTDOL,
 		IDM_CHECKINTEGRITY,
+		IDM_CHECKINTEGRITYALL,
 		IDM_BNRSAVEAS
 	};
 
@@ -191,7 +193,9 @@ private:
 	void OnExtractFile(wxCommandEvent& event);
 	void OnExtractDir(wxCommandEvent& event);
 	void OnExtractDataFromHeader(wxCommandEvent& event);
+	void RunIntegrityCheck(std::function<void()> Check);
 	void CheckPartitionIntegrity(wxCommandEvent& event);
+	void CheckDiscIntegrity(wxCommandEvent& event);
 	void SetRefresh(wxCommandEvent& event);
 	void OnChangeBannerLang(wxCommandEvent& event);
 	void PHackButtonClicked(wxCommandEvent& event);
@@ -25,6 +25,7 @@
 
 #include "VideoCommon/AVIDump.h"
 #include "VideoCommon/BPFunctions.h"
+#include "VideoCommon/DLCache.h"
 #include "VideoCommon/EmuWindow.h"
 #include "VideoCommon/Fifo.h"
 #include "VideoCommon/FPSCounter.h"
@@ -949,6 +950,7 @@ void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangl
 	D3D::EndFrame();
 
 	TextureCache::Cleanup();
+	DLCache::ProgressiveCleanup();
 
 	// Enable configuration changes
 	UpdateActiveConfig();
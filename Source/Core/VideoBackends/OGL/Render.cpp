@@ -34,6 +34,7 @@
 
 #include "VideoCommon/BPFunctions.h"
 #include "VideoCommon/BPStructs.h"
+#include "VideoCommon/DLCache.h"
 #include "VideoCommon/DriverDetails.h"
 #include "VideoCommon/Fifo.h"
 #include "VideoCommon/FPSCounter.h"
@@ -1623,6 +1624,7 @@ void Renderer::SwapImpl(u32 xfbAddr, u32 fbWidth, u32 fbHeight,const EFBRectangl
 
 	// Clean out old stuff from caches. It's not worth it to clean out the shader caches.
 	TextureCache::Cleanup();
+	DLCache::ProgressiveCleanup();
 
 	// Render to the framebuffer.
 	FramebufferManager::SetFramebuffer(0);
@@ -24,6 +24,9 @@ void InitBPMemory()
 
 void SWLoadBPReg(u32 value)
 {
+	// queued triangles have to be drawn with the state they were submitted with
+	Rasterizer::Flush();
+
 	//handle the mask register
 	int address = value >> 24;
 	int oldval = ((u32*)&bpmem)[address];
@@ -11,7 +11,6 @@
 #include "VideoBackends/Software/EfbInterface.h"
 
 #include "VideoCommon/LookUpTables.h"
-#include "VideoCommon/PixelEngine.h"
 
 
 u8 efb[EFB_WIDTH*EFB_HEIGHT*6];
@@ -30,11 +29,38 @@ namespace EfbInterface
 		return (x + y * EFB_WIDTH) * 3 + DEPTH_BUFFER_START;
 	}
 
+	// Pixels are packed at 3 bytes each. A 32 bit store would also rewrite the
+	// first byte of the next pixel, which may be in a tile that another
+	// rasterizer thread is drawing, so stores only ever touch these 3 bytes.
+	inline u32 LoadPixel24(u32 offset)
+	{
+		return efb[offset] | (efb[offset + 1] << 8) | (efb[offset + 2] << 16);
+	}
+
+	inline void StorePixel24(u32 offset, u32 val)
+	{
+		efb[offset] = val & 0xff;
+		efb[offset + 1] = (val >> 8) & 0xff;
+		efb[offset + 2] = (val >> 16) & 0xff;
+	}
+
 	void DoState(PointerWrap &p)
 	{
 		p.DoArray(efb, EFB_WIDTH*EFB_HEIGHT*6);
 	}
 
+	void AddPerfCounterPixels(PerfQueryType type, u32 count)
+	{
+		// NOTE: hardware doesn't process individual pixels but quads instead.
+		// Current software renderer architecture works on pixels though, so
+		// we have this "quad" hack here to only increment the registers on
+		// every fourth rendered pixel
+		static u32 quad[PQ_NUM_MEMBERS];
+		quad[type] += count;
+		perf_values[type] += quad[type] / 3;
+		quad[type] %= 3;
+	}
+
 	void SetPixelAlphaOnly(u32 offset, u8 a)
 	{
 		switch (bpmem.zcontrol.pixel_format)
@@ -47,10 +73,9 @@ namespace EfbInterface
 		case PEControl::RGBA6_Z24:
 			{
 				u32 a32 = a;
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xffffffc0;
+				u32 val = LoadPixel24(offset) & 0xffffc0;
 				val |= (a32 >> 2) & 0x0000003f;
-				*dst = val;
+				StorePixel24(offset, val);
 			}
 			break;
 		default:
@@ -66,31 +91,24 @@ namespace EfbInterface
 		case PEControl::Z24:
 			{
 				u32 src = *(u32*)rgb;
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff000000;
-				val |= src >> 8;
-				*dst = val;
+				StorePixel24(offset, src >> 8);
 			}
 			break;
 		case PEControl::RGBA6_Z24:
 			{
 				u32 src = *(u32*)rgb;
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff00003f;
+				u32 val = LoadPixel24(offset) & 0x0000003f;
 				val |= (src >> 4) & 0x00000fc0; // blue
 				val |= (src >> 6) & 0x0003f000; // green
 				val |= (src >> 8) & 0x00fc0000; // red
-				*dst = val;
+				StorePixel24(offset, val);
 			}
 			break;
 		case PEControl::RGB565_Z16:
 			{
 				INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
 				u32 src = *(u32*)rgb;
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff000000;
-				val |= src >> 8;
-				*dst = val;
+				StorePixel24(offset, src >> 8);
 			}
 			break;
 		default:
@@ -106,32 +124,24 @@ namespace EfbInterface
 		case PEControl::Z24:
 			{
 				u32 src = *(u32*)color;
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff000000;
-				val |= src >> 8;
-				*dst = val;
+				StorePixel24(offset, src >> 8);
 			}
 			break;
 		case PEControl::RGBA6_Z24:
 			{
 				u32 src = *(u32*)color;
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff000000;
-				val |= (src >> 2) & 0x0000003f; // alpha
+				u32 val = (src >> 2) & 0x0000003f; // alpha
 				val |= (src >> 4) & 0x00000fc0; // blue
 				val |= (src >> 6) & 0x0003f000; // green
 				val |= (src >> 8) & 0x00fc0000; // red
-				*dst = val;
+				StorePixel24(offset, val);
 			}
 			break;
 		case PEControl::RGB565_Z16:
 			{
 				INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
 				u32 src = *(u32*)color;
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff000000;
-				val |= src >> 8;
-				*dst = val;
+				StorePixel24(offset, src >> 8);
 			}
 			break;
 		default:
@@ -172,6 +182,7 @@ namespace EfbInterface
 			break;
 		default:
 			ERROR_LOG(VIDEO, "Unsupported pixel format: %i", static_cast<int>(bpmem.zcontrol.pixel_format));
+			*(u32*)color = 0;
 		}
 	}
 
@@ -183,19 +194,13 @@ namespace EfbInterface
 		case PEControl::RGBA6_Z24:
 		case PEControl::Z24:
 			{
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff000000;
-				val |= depth & 0x00ffffff;
-				*dst = val;
+				StorePixel24(offset, depth);
 			}
 			break;
 		case PEControl::RGB565_Z16:
 			{
 				INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff000000;
-				val |= depth & 0x00ffffff;
-				*dst = val;
+				StorePixel24(offset, depth);
 			}
 			break;
 		default:
@@ -436,12 +441,6 @@ namespace EfbInterface
 		{
 			SetPixelAlphaOnly(offset, dstClrPtr[ALP_C]);
 		}
-
-		// branchless bounding box update
-		PixelEngine::bbox[0] = std::min(x, PixelEngine::bbox[0]);
-		PixelEngine::bbox[1] = std::max(x, PixelEngine::bbox[1]);
-		PixelEngine::bbox[2] = std::min(y, PixelEngine::bbox[2]);
-		PixelEngine::bbox[3] = std::max(y, PixelEngine::bbox[3]);
 	}
 
 	void SetColor(u16 x, u16 y, u8 *color)
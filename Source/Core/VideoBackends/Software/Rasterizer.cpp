@@ -2,7 +2,16 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include "Common/Common.h"
+#include "Common/CPUDetect.h"
+#include "Common/StdConditionVariable.h"
+#include "Common/StdMutex.h"
+#include "Common/StdThread.h"
+#include "Common/Thread.h"
 
 #include "VideoBackends/Software/BPMemLoader.h"
 #include "VideoBackends/Software/EfbInterface.h"
@@ -16,6 +25,16 @@
 
 #define BLOCK_SIZE 2
 
+// The screen is split into tiles that the rasterizer threads claim one at a
+// time. Each tile is only ever drawn by one thread, which draws the triangles
+// touching it in submission order. Must be a multiple of BLOCK_SIZE.
+#define TILE_SIZE 32
+#define TILES_X ((EFB_WIDTH + TILE_SIZE - 1) / TILE_SIZE)
+#define TILES_Y ((EFB_HEIGHT + TILE_SIZE - 1) / TILE_SIZE)
+
+// Number of triangles queued before they get drawn even without a flush.
+#define MAX_QUEUED_TRIANGLES 4096
+
 #define CLAMP(x, a, b) (x>b)?b:(x<a)?a:x
 
 // returns approximation of log2(f) in s28.4
@@ -31,54 +50,167 @@ static inline s32 FixedLog2(float f)
 
 namespace Rasterizer
 {
-Slope ZSlope;
-Slope WSlope;
-Slope ColorSlopes[2][4];
-Slope TexSlopes[8][3];
+// Everything needed to draw a triangle after DrawTriangleFrontFace returned.
+struct TriangleSetup
+{
+	Slope ZSlope;
+	Slope WSlope;
+	Slope ColorSlopes[2][4];
+	Slope TexSlopes[8][3];
+
+	s32 vertex0X;
+	s32 vertex0Y;
+	float vertexOffsetX;
+	float vertexOffsetY;
+
+	// half-edge constants and deltas in 28.4 fixed point
+	s32 C1, C2, C3;
+	s32 DX12, DX23, DX31;
+	s32 DY12, DY23, DY31;
+
+	// block aligned bounding rectangle, already scissored
+	s32 minx, maxx, miny, maxy;
+};
+
+// Per-thread drawing state
+struct RasterContext
+{
+	Tev tev;
+	RasterBlock rasterBlock;
+	u32 rasterizedPixels;
+};
 
-s32 vertex0X;
-s32 vertex0Y;
-float vertexOffsetX;
-float vertexOffsetY;
+TriangleSetup triangle;
 
 s32 scissorLeft = 0;
 s32 scissorTop = 0;
 s32 scissorRight = 0;
 s32 scissorBottom = 0;
 
-Tev tev;
-RasterBlock rasterBlock;
+// Used when drawing on the video thread. Its tev also holds the registers set
+// through BP writes, which every tile starts out with.
+RasterContext serialContext;
+
+static std::vector<std::thread> s_threads;
+// One context per rasterizer thread, the last one belongs to the video thread.
+static std::vector<std::unique_ptr<RasterContext>> s_contexts;
+
+static std::vector<TriangleSetup> s_triangles;
+static std::vector<u32> s_bins[TILES_X * TILES_Y];
+static std::vector<u32> s_active_tiles;
+static std::atomic<int> s_next_tile;
+
+static std::mutex s_batch_lock;
+static std::condition_variable s_batch_start;
+static std::condition_variable s_batch_done;
+static u32 s_batch_id;
+static int s_busy_threads;
+static bool s_quit;
 
 void DoState(PointerWrap &p)
 {
-	ZSlope.DoState(p);
-	WSlope.DoState(p);
-	for (auto& color_slopes_1d : ColorSlopes)
+	Flush();
+
+	triangle.ZSlope.DoState(p);
+	triangle.WSlope.DoState(p);
+	for (auto& color_slopes_1d : triangle.ColorSlopes)
 		for (Slope& color_slope : color_slopes_1d)
 			color_slope.DoState(p);
-	for (auto& tex_slopes_1d : TexSlopes)
+	for (auto& tex_slopes_1d : triangle.TexSlopes)
 		for (Slope& tex_slope : tex_slopes_1d)
 			tex_slope.DoState(p);
-	p.Do(vertex0X);
-	p.Do(vertex0Y);
-	p.Do(vertexOffsetX);
-	p.Do(vertexOffsetY);
+	p.Do(triangle.vertex0X);
+	p.Do(triangle.vertex0Y);
+	p.Do(triangle.vertexOffsetX);
+	p.Do(triangle.vertexOffsetY);
 	p.Do(scissorLeft);
 	p.Do(scissorTop);
 	p.Do(scissorRight);
 	p.Do(scissorBottom);
-	tev.DoState(p);
-	p.Do(rasterBlock);
+	serialContext.tev.DoState(p);
+	p.Do(serialContext.rasterBlock);
+}
+
+static void DrawTiles(RasterContext& ctx);
+
+static void RasterThread(RasterContext* ctx)
+{
+	Common::SetCurrentThreadName("Rasterizer thread");
+
+	// Init() starts the threads with s_batch_id at 0. Reading it here instead
+	// could already see the first batch and skip it.
+	u32 last_batch = 0;
+
+	std::unique_lock<std::mutex> lk(s_batch_lock);
+
+	while (true)
+	{
+		s_batch_start.wait(lk, [&] { return s_quit || s_batch_id != last_batch; });
+		if (s_quit)
+			break;
+		last_batch = s_batch_id;
+
+		lk.unlock();
+		DrawTiles(*ctx);
+		lk.lock();
+
+		if (--s_busy_threads == 0)
+			s_batch_done.notify_one();
+	}
 }
 
 void Init()
 {
-	tev.Init();
+	serialContext.tev.Init();
+	serialContext.rasterizedPixels = 0;
 
 	// Set initial z reference plane in the unlikely case that zfreeze is enabled when drawing the first primitive.
 	// TODO: This is just a guess!
-	ZSlope.dfdx = ZSlope.dfdy = 0.f;
-	ZSlope.f0 = 1.f;
+	triangle.ZSlope.dfdx = triangle.ZSlope.dfdy = 0.f;
+	triangle.ZSlope.f0 = 1.f;
+
+	int num_threads = g_SWVideoConfig.iRasterizerThreads;
+	if (num_threads <= 0)
+		num_threads = max(cpu_info.num_cores, 1);
+
+	// The video thread draws tiles as well, so it only needs num_threads - 1 helpers.
+	if (num_threads > 1 && !g_SWVideoConfig.bHwRasterizer)
+	{
+		s_quit = false;
+		s_batch_id = 0;
+		s_busy_threads = 0;
+		s_triangles.reserve(MAX_QUEUED_TRIANGLES);
+
+		for (int i = 0; i < num_threads; i++)
+		{
+			s_contexts.emplace_back(new RasterContext);
+			s_contexts.back()->tev.Init();
+			s_contexts.back()->rasterizedPixels = 0;
+		}
+
+		for (int i = 0; i < num_threads - 1; i++)
+			s_threads.emplace_back(RasterThread, s_contexts[i].get());
+
+		INFO_LOG(VIDEO, "Rasterizing on %i threads", num_threads);
+	}
+}
+
+void Shutdown()
+{
+	Flush();
+
+	{
+		std::lock_guard<std::mutex> lk(s_batch_lock);
+		s_quit = true;
+	}
+	s_batch_start.notify_all();
+
+	for (std::thread& thread : s_threads)
+		thread.join();
+
+	s_threads.clear();
+	s_contexts.clear();
+	std::vector<TriangleSetup>().swap(s_triangles);
 }
 
 inline int iround(float x)
@@ -112,31 +244,34 @@ void SetScissor()
 
 void SetTevReg(int reg, int comp, bool konst, s16 color)
 {
-	tev.SetRegColor(reg, comp, konst, color);
+	serialContext.tev.SetRegColor(reg, comp, konst, color);
 }
 
-inline void Draw(s32 x, s32 y, s32 xi, s32 yi)
+inline void Draw(const TriangleSetup& tri, RasterContext& ctx, s32 x, s32 y, s32 xi, s32 yi)
 {
-	INCSTAT(swstats.thisFrame.rasterizedPixels);
+	Tev& tev = ctx.tev;
+	RasterBlock& rasterBlock = ctx.rasterBlock;
 
-	float dx = vertexOffsetX + (float)(x - vertex0X);
-	float dy = vertexOffsetY + (float)(y - vertex0Y);
+	ctx.rasterizedPixels++;
 
-	s32 z = (s32)ZSlope.GetValue(dx, dy);
+	float dx = tri.vertexOffsetX + (float)(x - tri.vertex0X);
+	float dy = tri.vertexOffsetY + (float)(y - tri.vertex0Y);
+
+	s32 z = (s32)tri.ZSlope.GetValue(dx, dy);
 	if (z < 0 || z > 0x00ffffff)
 		return;
 
 	if (bpmem.UseEarlyDepthTest() && g_SWVideoConfig.bZComploc)
 	{
 		// TODO: Test if perf regs are incremented even if test is disabled
-		EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_INPUT_ZCOMPLOC);
+		tev.PerfPixels[PQ_ZCOMP_INPUT_ZCOMPLOC]++;
 		if (bpmem.zmode.testenable)
 		{
 			// early z
 			if (!EfbInterface::ZCompare(x, y, z))
 				return;
 		}
-		EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_OUTPUT_ZCOMPLOC);
+		tev.PerfPixels[PQ_ZCOMP_OUTPUT_ZCOMPLOC]++;
 	}
 
 	RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
@@ -150,7 +285,7 @@ inline void Draw(s32 x, s32 y, s32 xi, s32 yi)
 	{
 		for (int comp = 0; comp < 4; comp++)
 		{
-			u16 color = (u16)ColorSlopes[i][comp].GetValue(dx, dy);
+			u16 color = (u16)tri.ColorSlopes[i][comp].GetValue(dx, dy);
 
 			// clamp color value to 0
 			u16 mask = ~(color >> 8);
@@ -182,16 +317,16 @@ inline void Draw(s32 x, s32 y, s32 xi, s32 yi)
 	tev.Draw();
 }
 
-void InitTriangle(float X1, float Y1, s32 xi, s32 yi)
+void InitTriangle(TriangleSetup& tri, float X1, float Y1, s32 xi, s32 yi)
 {
-	vertex0X = xi;
-	vertex0Y = yi;
+	tri.vertex0X = xi;
+	tri.vertex0Y = yi;
 
 	// adjust a little less than 0.5
 	const float adjust = 0.495f;
 
-	vertexOffsetX = ((float)xi - X1) + adjust;
-	vertexOffsetY = ((float)yi - Y1) + adjust;
+	tri.vertexOffsetX = ((float)xi - X1) + adjust;
+	tri.vertexOffsetY = ((float)yi - Y1) + adjust;
 }
 
 void InitSlope(Slope *slope, float f1, float f2, float f3, float DX31, float DX12, float DY12, float DY31)
@@ -206,7 +341,7 @@ void InitSlope(Slope *slope, float f1, float f2, float f3, float DX31, float DX1
 	slope->f0 = f1;
 }
 
-inline void CalculateLOD(s32 &lod, bool &linear, u32 texmap, u32 texcoord)
+inline void CalculateLOD(const RasterBlock& rasterBlock, s32 &lod, bool &linear, u32 texmap, u32 texcoord)
 {
 	FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
 	u8 subTexmap = texmap & 3;
@@ -219,17 +354,17 @@ inline void CalculateLOD(s32 &lod, bool &linear, u32 texmap, u32 texcoord)
 	float sDelta, tDelta;
 	if (tm0.diag_lod)
 	{
-		float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-		float *uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
+		const float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+		const float *uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
 
 		sDelta = fabsf(uv0[0] - uv1[0]);
 		tDelta = fabsf(uv0[1] - uv1[1]);
 	}
 	else
 	{
-		float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-		float *uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
-		float *uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
+		const float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+		const float *uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
+		const float *uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
 
 		sDelta = max(fabsf(uv0[0] - uv1[0]), fabsf(uv0[0] - uv2[0]));
 		tDelta = max(fabsf(uv0[1] - uv1[1]), fabsf(uv0[1] - uv2[1]));
@@ -252,7 +387,7 @@ inline void CalculateLOD(s32 &lod, bool &linear, u32 texmap, u32 texcoord)
 	lod = CLAMP(lod, (s32)tm1.min_lod, (s32)tm1.max_lod);
 }
 
-void BuildBlock(s32 blockX, s32 blockY)
+void BuildBlock(const TriangleSetup& tri, RasterBlock& rasterBlock, s32 blockX, s32 blockY)
 {
 	for (s32 yi = 0; yi < BLOCK_SIZE; yi++)
 	{
@@ -260,10 +395,10 @@ void BuildBlock(s32 blockX, s32 blockY)
 		{
 			RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
 
-			float dx = vertexOffsetX + (float)(xi + blockX - vertex0X);
-			float dy = vertexOffsetY + (float)(yi + blockY - vertex0Y);
+			float dx = tri.vertexOffsetX + (float)(xi + blockX - tri.vertex0X);
+			float dy = tri.vertexOffsetY + (float)(yi + blockY - tri.vertex0Y);
 
-			float invW = 1.0f / WSlope.GetValue(dx, dy);
+			float invW = 1.0f / tri.WSlope.GetValue(dx, dy);
 			pixel.InvW = invW;
 
 			// tex coords
@@ -272,13 +407,13 @@ void BuildBlock(s32 blockX, s32 blockY)
 				float projection = invW;
 				if (xfmem.texMtxInfo[i].projection)
 				{
-					float q = TexSlopes[i][2].GetValue(dx, dy) * invW;
+					float q = tri.TexSlopes[i][2].GetValue(dx, dy) * invW;
 					if (q != 0.0f)
 						projection = invW / q;
 				}
 
-				pixel.Uv[i][0] = TexSlopes[i][0].GetValue(dx, dy) * projection;
-				pixel.Uv[i][1] = TexSlopes[i][1].GetValue(dx, dy) * projection;
+				pixel.Uv[i][0] = tri.TexSlopes[i][0].GetValue(dx, dy) * projection;
+				pixel.Uv[i][1] = tri.TexSlopes[i][1].GetValue(dx, dy) * projection;
 			}
 		}
 	}
@@ -291,7 +426,7 @@ void BuildBlock(s32 blockX, s32 blockY)
 		u32 texcoord = indref & 3;
 		indref >>= 3;
 
-		CalculateLOD(rasterBlock.IndirectLod[i], rasterBlock.IndirectLinear[i], texmap, texcoord);
+		CalculateLOD(rasterBlock, rasterBlock.IndirectLod[i], rasterBlock.IndirectLinear[i], texmap, texcoord);
 	}
 
 	for (unsigned int i = 0; i <= bpmem.genMode.numtevstages; i++)
@@ -303,9 +438,196 @@ void BuildBlock(s32 blockX, s32 blockY)
 			u32 texmap = order.getTexMap(stageOdd);
 			u32 texcoord = order.getTexCoord(stageOdd);
 
-			CalculateLOD(rasterBlock.TextureLod[i], rasterBlock.TextureLinear[i], texmap, texcoord);
+			CalculateLOD(rasterBlock, rasterBlock.TextureLod[i], rasterBlock.TextureLinear[i], texmap, texcoord);
+		}
+	}
+}
+
+// Draws the part of a triangle that lies within the given block aligned rectangle
+static void DrawTriangleBlocks(const TriangleSetup& tri, RasterContext& ctx, s32 minx, s32 maxx, s32 miny, s32 maxy)
+{
+	const s32 C1 = tri.C1;
+	const s32 C2 = tri.C2;
+	const s32 C3 = tri.C3;
+
+	const s32 DX12 = tri.DX12;
+	const s32 DX23 = tri.DX23;
+	const s32 DX31 = tri.DX31;
+
+	const s32 DY12 = tri.DY12;
+	const s32 DY23 = tri.DY23;
+	const s32 DY31 = tri.DY31;
+
+	// Fixed-pos32 deltas
+	const s32 FDX12 = DX12 << 4;
+	const s32 FDX23 = DX23 << 4;
+	const s32 FDX31 = DX31 << 4;
+
+	const s32 FDY12 = DY12 << 4;
+	const s32 FDY23 = DY23 << 4;
+	const s32 FDY31 = DY31 << 4;
+
+	// Loop through blocks
+	for (s32 y = miny; y < maxy; y += BLOCK_SIZE)
+	{
+		for (s32 x = minx; x < maxx; x += BLOCK_SIZE)
+		{
+			// Corners of block
+			s32 x0 = x << 4;
+			s32 x1 = (x + BLOCK_SIZE - 1) << 4;
+			s32 y0 = y << 4;
+			s32 y1 = (y + BLOCK_SIZE - 1) << 4;
+
+			// Evaluate half-space functions
+			bool a00 = C1 + DX12 * y0 - DY12 * x0 > 0;
+			bool a10 = C1 + DX12 * y0 - DY12 * x1 > 0;
+			bool a01 = C1 + DX12 * y1 - DY12 * x0 > 0;
+			bool a11 = C1 + DX12 * y1 - DY12 * x1 > 0;
+			int a = (a00 << 0) | (a10 << 1) | (a01 << 2) | (a11 << 3);
+
+			bool b00 = C2 + DX23 * y0 - DY23 * x0 > 0;
+			bool b10 = C2 + DX23 * y0 - DY23 * x1 > 0;
+			bool b01 = C2 + DX23 * y1 - DY23 * x0 > 0;
+			bool b11 = C2 + DX23 * y1 - DY23 * x1 > 0;
+			int b = (b00 << 0) | (b10 << 1) | (b01 << 2) | (b11 << 3);
+
+			bool c00 = C3 + DX31 * y0 - DY31 * x0 > 0;
+			bool c10 = C3 + DX31 * y0 - DY31 * x1 > 0;
+			bool c01 = C3 + DX31 * y1 - DY31 * x0 > 0;
+			bool c11 = C3 + DX31 * y1 - DY31 * x1 > 0;
+			int c = (c00 << 0) | (c10 << 1) | (c01 << 2) | (c11 << 3);
+
+			// Skip block when outside an edge
+			if (a == 0x0 || b == 0x0 || c == 0x0)
+				continue;
+
+			BuildBlock(tri, ctx.rasterBlock, x, y);
+
+			// Accept whole block when totally covered
+			if (a == 0xF && b == 0xF && c == 0xF)
+			{
+				for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
+				{
+					for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
+					{
+						Draw(tri, ctx, x + ix, y + iy, ix, iy);
+					}
+				}
+			}
+			else // Partially covered block
+			{
+				s32 CY1 = C1 + DX12 * y0 - DY12 * x0;
+				s32 CY2 = C2 + DX23 * y0 - DY23 * x0;
+				s32 CY3 = C3 + DX31 * y0 - DY31 * x0;
+
+				for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
+				{
+					s32 CX1 = CY1;
+					s32 CX2 = CY2;
+					s32 CX3 = CY3;
+
+					for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
+					{
+						if (CX1 > 0 && CX2 > 0 && CX3 > 0)
+						{
+							Draw(tri, ctx, x + ix, y + iy, ix, iy);
+						}
+
+						CX1 -= FDY12;
+						CX2 -= FDY23;
+						CX3 -= FDY31;
+					}
+
+					CY1 += FDX12;
+					CY2 += FDX23;
+					CY3 += FDX31;
+				}
+			}
+		}
+	}
+}
+
+static void DrawTile(RasterContext& ctx, u32 tile)
+{
+	const s32 left = (tile % TILES_X) * TILE_SIZE;
+	const s32 top = (tile / TILES_X) * TILE_SIZE;
+
+	// Every tile starts from the registers set by the game rather than from
+	// whatever the previous tile on this thread left in them, so the output
+	// doesn't depend on which thread drew which tile.
+	ctx.tev.CopyRegisters(serialContext.tev);
+
+	for (u32 index : s_bins[tile])
+	{
+		const TriangleSetup& tri = s_triangles[index];
+		DrawTriangleBlocks(tri, ctx,
+			max(tri.minx, left), min(tri.maxx, left + TILE_SIZE),
+			max(tri.miny, top), min(tri.maxy, top + TILE_SIZE));
+	}
+}
+
+static void DrawTiles(RasterContext& ctx)
+{
+	const int num_tiles = (int)s_active_tiles.size();
+
+	int i;
+	while ((i = s_next_tile++) < num_tiles)
+		DrawTile(ctx, s_active_tiles[i]);
+}
+
+static void FlushCounters(RasterContext& ctx)
+{
+	ADDSTAT(swstats.thisFrame.rasterizedPixels, ctx.rasterizedPixels);
+	ctx.rasterizedPixels = 0;
+
+	ctx.tev.FlushCounters();
+}
+
+void Flush()
+{
+	if (!s_triangles.empty())
+	{
+		for (u32 tile = 0; tile < TILES_X * TILES_Y; tile++)
+		{
+			if (!s_bins[tile].empty())
+				s_active_tiles.push_back(tile);
+		}
+		s_next_tile = 0;
+
+		{
+			std::lock_guard<std::mutex> lk(s_batch_lock);
+			s_busy_threads = (int)s_threads.size();
+			s_batch_id++;
+		}
+		s_batch_start.notify_all();
+
+		DrawTiles(*s_contexts.back());
+
+		{
+			std::unique_lock<std::mutex> lk(s_batch_lock);
+			s_batch_done.wait(lk, [] { return s_busy_threads == 0; });
 		}
+
+		for (u32 tile : s_active_tiles)
+			s_bins[tile].clear();
+		s_active_tiles.clear();
+		s_triangles.clear();
+
+		for (auto& ctx : s_contexts)
+			FlushCounters(*ctx);
 	}
+
+	FlushCounters(serialContext);
+}
+
+static bool UseThreads()
+{
+	// The tev dumps draw into shared debug buffers, and object dumps need
+	// the EFB to be up to date after every object.
+	return !s_threads.empty() &&
+	       !g_SWVideoConfig.bDumpObjects &&
+	       !g_SWVideoConfig.bDumpTevStages &&
+	       !g_SWVideoConfig.bDumpTevTextureFetches;
 }
 
 void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVertexData *v2)
@@ -339,15 +661,6 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	const s32 DY23 = Y2 - Y3;
 	const s32 DY31 = Y3 - Y1;
 
-	// Fixed-pos32 deltas
-	const s32 FDX12 = DX12 << 4;
-	const s32 FDX23 = DX23 << 4;
-	const s32 FDX31 = DX31 << 4;
-
-	const s32 FDY12 = DY12 << 4;
-	const s32 FDY23 = DY23 << 4;
-	const s32 FDY31 = DY31 << 4;
-
 	// Bounding rectangle
 	s32 minx = (min(min(X1, X2), X3) + 0xF) >> 4;
 	s32 maxx = (max(max(X1, X2), X3) + 0xF) >> 4;
@@ -371,28 +684,28 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	float fltdy12 = flty1 - v1->screenPosition.y;
 	float fltdy31 = v2->screenPosition.y - flty1;
 
-	InitTriangle(fltx1, flty1, (X1 + 0xF) >> 4, (Y1 + 0xF) >> 4);
+	InitTriangle(triangle, fltx1, flty1, (X1 + 0xF) >> 4, (Y1 + 0xF) >> 4);
 
 	float w[3] = { 1.0f / v0->projectedPosition.w, 1.0f / v1->projectedPosition.w, 1.0f / v2->projectedPosition.w };
-	InitSlope(&WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+	InitSlope(&triangle.WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
 
 	// TODO: The zfreeze emulation is not quite correct, yet!
 	// Many things might prevent us from reaching this line (culling, clipping, scissoring).
 	// However, the zslope is always guaranteed to be calculated unless all vertices are trivially rejected during clipping!
 	// We're currently sloppy at this since we abort early if any of the culling/clipping/scissoring tests fail.
 	if (!bpmem.genMode.zfreeze || !g_SWVideoConfig.bZFreeze)
-		InitSlope(&ZSlope, v0->screenPosition[2], v1->screenPosition[2], v2->screenPosition[2], fltdx31, fltdx12, fltdy12, fltdy31);
+		InitSlope(&triangle.ZSlope, v0->screenPosition[2], v1->screenPosition[2], v2->screenPosition[2], fltdx31, fltdx12, fltdy12, fltdy31);
 
 	for (unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
 	{
 		for (int comp = 0; comp < 4; comp++)
-			InitSlope(&ColorSlopes[i][comp], v0->color[i][comp], v1->color[i][comp], v2->color[i][comp], fltdx31, fltdx12, fltdy12, fltdy31);
+			InitSlope(&triangle.ColorSlopes[i][comp], v0->color[i][comp], v1->color[i][comp], v2->color[i][comp], fltdx31, fltdx12, fltdy12, fltdy31);
 	}
 
 	for (unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
 	{
 		for (int comp = 0; comp < 3; comp++)
-			InitSlope(&TexSlopes[i][comp], v0->texCoords[i][comp] * w[0], v1->texCoords[i][comp] * w[1], v2->texCoords[i][comp] * w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+			InitSlope(&triangle.TexSlopes[i][comp], v0->texCoords[i][comp] * w[0], v1->texCoords[i][comp] * w[1], v2->texCoords[i][comp] * w[2], fltdx31, fltdx12, fltdy12, fltdy31);
 	}
 
 	// Start in corner of 8x8 block
@@ -409,85 +722,42 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	if (DY23 < 0 || (DY23 == 0 && DX23 > 0)) C2++;
 	if (DY31 < 0 || (DY31 == 0 && DX31 > 0)) C3++;
 
-	// Loop through blocks
-	for (s32 y = miny; y < maxy; y += BLOCK_SIZE)
+	triangle.C1 = C1;
+	triangle.C2 = C2;
+	triangle.C3 = C3;
+	triangle.DX12 = DX12;
+	triangle.DX23 = DX23;
+	triangle.DX31 = DX31;
+	triangle.DY12 = DY12;
+	triangle.DY23 = DY23;
+	triangle.DY31 = DY31;
+	triangle.minx = minx;
+	triangle.maxx = maxx;
+	triangle.miny = miny;
+	triangle.maxy = maxy;
+
+	if (!UseThreads())
 	{
-		for (s32 x = minx; x < maxx; x += BLOCK_SIZE)
-		{
-			// Corners of block
-			s32 x0 = x << 4;
-			s32 x1 = (x + BLOCK_SIZE - 1) << 4;
-			s32 y0 = y << 4;
-			s32 y1 = (y + BLOCK_SIZE - 1) << 4;
-
-			// Evaluate half-space functions
-			bool a00 = C1 + DX12 * y0 - DY12 * x0 > 0;
-			bool a10 = C1 + DX12 * y0 - DY12 * x1 > 0;
-			bool a01 = C1 + DX12 * y1 - DY12 * x0 > 0;
-			bool a11 = C1 + DX12 * y1 - DY12 * x1 > 0;
-			int a = (a00 << 0) | (a10 << 1) | (a01 << 2) | (a11 << 3);
-
-			bool b00 = C2 + DX23 * y0 - DY23 * x0 > 0;
-			bool b10 = C2 + DX23 * y0 - DY23 * x1 > 0;
-			bool b01 = C2 + DX23 * y1 - DY23 * x0 > 0;
-			bool b11 = C2 + DX23 * y1 - DY23 * x1 > 0;
-			int b = (b00 << 0) | (b10 << 1) | (b01 << 2) | (b11 << 3);
-
-			bool c00 = C3 + DX31 * y0 - DY31 * x0 > 0;
-			bool c10 = C3 + DX31 * y0 - DY31 * x1 > 0;
-			bool c01 = C3 + DX31 * y1 - DY31 * x0 > 0;
-			bool c11 = C3 + DX31 * y1 - DY31 * x1 > 0;
-			int c = (c00 << 0) | (c10 << 1) | (c01 << 2) | (c11 << 3);
-
-			// Skip block when outside an edge
-			if (a == 0x0 || b == 0x0 || c == 0x0)
-				continue;
-
-			BuildBlock(x, y);
-
-			// Accept whole block when totally covered
-			if (a == 0xF && b == 0xF && c == 0xF)
-			{
-				for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
-				{
-					for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
-					{
-						Draw(x + ix, y + iy, ix, iy);
-					}
-				}
-			}
-			else // Partially covered block
-			{
-				s32 CY1 = C1 + DX12 * y0 - DY12 * x0;
-				s32 CY2 = C2 + DX23 * y0 - DY23 * x0;
-				s32 CY3 = C3 + DX31 * y0 - DY31 * x0;
-
-				for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
-				{
-					s32 CX1 = CY1;
-					s32 CX2 = CY2;
-					s32 CX3 = CY3;
-
-					for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
-					{
-						if (CX1 > 0 && CX2 > 0 && CX3 > 0)
-						{
-							Draw(x + ix, y + iy, ix, iy);
-						}
+		// Draw anything queued while the threads were in use first.
+		Flush();
+		DrawTriangleBlocks(triangle, serialContext, minx, maxx, miny, maxy);
+		return;
+	}
 
-						CX1 -= FDY12;
-						CX2 -= FDY23;
-						CX3 -= FDY31;
-					}
+	// Queue the triangle in every tile its bounding rectangle touches.
+	const u32 index = (u32)s_triangles.size();
+	s_triangles.push_back(triangle);
 
-					CY1 += FDX12;
-					CY2 += FDX23;
-					CY3 += FDX31;
-				}
-			}
-		}
+	for (s32 ty = miny / TILE_SIZE; ty <= (maxy - 1) / TILE_SIZE; ty++)
+	{
+		for (s32 tx = minx / TILE_SIZE; tx <= (maxx - 1) / TILE_SIZE; tx++)
+			s_bins[ty * TILES_X + tx].push_back(index);
 	}
+
+	if (s_triangles.size() >= MAX_QUEUED_TRIANGLES)
+		Flush();
 }
 
 
 }
+
@@ -17,6 +17,7 @@
 #include "Core/HW/ProcessorInterface.h"
 
 #include "VideoBackends/Software/OpcodeDecoder.h"
+#include "VideoBackends/Software/Rasterizer.h"
 #include "VideoBackends/Software/SWCommandProcessor.h"
 #include "VideoBackends/Software/VideoBackend.h"
 
@@ -329,6 +330,10 @@ bool RunBuffer()
 		availableBytes = writePos - readPos;
 	}
 
+	// Whoever looks at the EFB or the perf counters next must see everything
+	// decoded so far.
+	Rasterizer::Flush();
+
 	cpreg.status.CommandIdle = 1;
 
 	bool ranDecoder = false;
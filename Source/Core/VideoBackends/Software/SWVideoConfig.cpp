@@ -17,6 +17,8 @@ SWVideoConfig::SWVideoConfig()
 	bHwRasterizer = false;
 	bBypassXFB = false;
 
+	iRasterizerThreads = 0;
+
 	bShowStats = false;
 
 	bDumpTextures = false;
@@ -43,6 +45,7 @@ void SWVideoConfig::Load(const char* ini_file)
 
 	iniFile.Get("Rendering", "HwRasterizer", &bHwRasterizer, false);
 	iniFile.Get("Rendering", "BypassXFB", &bBypassXFB, false);
+	iniFile.Get("Rendering", "RasterizerThreads", &iRasterizerThreads, 0);
 	iniFile.Get("Rendering", "ZComploc", &bZComploc, true);
 	iniFile.Get("Rendering", "ZFreeze", &bZFreeze, true);
 
@@ -68,6 +71,7 @@ void SWVideoConfig::Save(const char* ini_file)
 
 	iniFile.Set("Rendering", "HwRasterizer", bHwRasterizer);
 	iniFile.Set("Rendering", "BypassXFB", bBypassXFB);
+	iniFile.Set("Rendering", "RasterizerThreads", iRasterizerThreads);
 	iniFile.Set("Rendering", "ZComploc", bZComploc);
 	iniFile.Set("Rendering", "ZFreeze", bZFreeze);
 
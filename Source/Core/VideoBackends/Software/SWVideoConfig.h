@@ -23,6 +23,9 @@ struct SWVideoConfig : NonCopyable
 	bool bHwRasterizer;
 	bool bBypassXFB;
 
+	// Number of threads used for rasterization, 0 picks one per core
+	int iRasterizerThreads;
+
 	// Emulation features
 	bool bZComploc;
 	bool bZFreeze;
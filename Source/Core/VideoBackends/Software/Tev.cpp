@@ -2,6 +2,7 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cmath>
 
 #include "Common/Common.h"
@@ -14,6 +15,8 @@
 #include "VideoBackends/Software/TextureSampler.h"
 #include "VideoBackends/Software/XFMemLoader.h"
 
+#include "VideoCommon/PixelEngine.h"
+
 #ifdef _DEBUG
 #define ALLOW_TEV_DUMPS 1
 #else
@@ -121,6 +124,8 @@ void Tev::Init()
 	m_ScaleRShiftLUT[1] = 0;
 	m_ScaleRShiftLUT[2] = 0;
 	m_ScaleRShiftLUT[3] = 1;
+
+	ResetCounters();
 }
 
 inline s16 Clamp255(s16 in)
@@ -506,7 +511,7 @@ void Tev::Draw()
 	_assert_(Position[0] >= 0 && Position[0] < EFB_WIDTH);
 	_assert_(Position[1] >= 0 && Position[1] < EFB_HEIGHT);
 
-	INCSTAT(swstats.thisFrame.tevPixelsIn);
+	TevPixelsIn++;
 
 	for (unsigned int stageNum = 0; stageNum < bpmem.genMode.numindstages; stageNum++)
 	{
@@ -755,12 +760,12 @@ void Tev::Draw()
 	if (late_ztest && bpmem.zmode.testenable)
 	{
 		// TODO: Check against hw if these values get incremented even if depth testing is disabled
-		EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_INPUT);
+		PerfPixels[PQ_ZCOMP_INPUT]++;
 
 		if (!EfbInterface::ZCompare(Position[0], Position[1], Position[2]))
 			return;
 
-		EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_OUTPUT);
+		PerfPixels[PQ_ZCOMP_OUTPUT]++;
 	}
 
 #if ALLOW_TEV_DUMPS
@@ -783,10 +788,16 @@ void Tev::Draw()
 	}
 #endif
 
-	INCSTAT(swstats.thisFrame.tevPixelsOut);
-	EfbInterface::IncPerfCounterQuadCount(PQ_BLEND_INPUT);
+	TevPixelsOut++;
+	PerfPixels[PQ_BLEND_INPUT]++;
 
 	EfbInterface::BlendTev(Position[0], Position[1], output);
+
+	// branchless bounding box update
+	BBox[0] = std::min((u16)Position[0], BBox[0]);
+	BBox[1] = std::max((u16)Position[0], BBox[1]);
+	BBox[2] = std::min((u16)Position[1], BBox[2]);
+	BBox[3] = std::max((u16)Position[1], BBox[3]);
 }
 
 void Tev::SetRegColor(int reg, int comp, bool konst, s16 color)
@@ -801,6 +812,41 @@ void Tev::SetRegColor(int reg, int comp, bool konst, s16 color)
 	}
 }
 
+void Tev::CopyRegisters(const Tev& other)
+{
+	memcpy(Reg, other.Reg, sizeof(Reg));
+	memcpy(KonstantColors, other.KonstantColors, sizeof(KonstantColors));
+}
+
+void Tev::ResetCounters()
+{
+	TevPixelsIn = 0;
+	TevPixelsOut = 0;
+	memset(PerfPixels, 0, sizeof(PerfPixels));
+
+	BBox[0] = BBox[2] = 0xffff;
+	BBox[1] = BBox[3] = 0;
+}
+
+void Tev::FlushCounters()
+{
+	ADDSTAT(swstats.thisFrame.tevPixelsIn, TevPixelsIn);
+	ADDSTAT(swstats.thisFrame.tevPixelsOut, TevPixelsOut);
+
+	for (int i = 0; i < PQ_NUM_MEMBERS; i++)
+	{
+		if (PerfPixels[i])
+			EfbInterface::AddPerfCounterPixels((PerfQueryType)i, PerfPixels[i]);
+	}
+
+	PixelEngine::bbox[0] = std::min(BBox[0], PixelEngine::bbox[0]);
+	PixelEngine::bbox[1] = std::max(BBox[1], PixelEngine::bbox[1]);
+	PixelEngine::bbox[2] = std::min(BBox[2], PixelEngine::bbox[2]);
+	PixelEngine::bbox[3] = std::max(BBox[3], PixelEngine::bbox[3]);
+
+	ResetCounters();
+}
+
 void Tev::DoState(PointerWrap &p)
 {
 	p.DoArray(Reg, sizeof(Reg));
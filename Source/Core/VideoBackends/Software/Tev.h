@@ -6,6 +6,7 @@
 
 #include "Common/ChunkFile.h"
 #include "VideoBackends/Software/BPMemLoader.h"
+#include "VideoCommon/PerfQueryBase.h"
 
 class Tev
 {
@@ -76,12 +77,26 @@ public:
 	s32 TextureLod[16];
 	bool TextureLinear[16];
 
+	// What Draw() would otherwise write to swstats, the perf query counters
+	// and the PE bounding box. Kept per instance so that several Tevs can
+	// draw at once; FlushCounters() publishes and resets them.
+	u32 TevPixelsIn;
+	u32 TevPixelsOut;
+	u32 PerfPixels[PQ_NUM_MEMBERS];
+	u16 BBox[4];
+
 	void Init();
 
 	void Draw();
 
 	void SetRegColor(int reg, int comp, bool konst, s16 color);
 
+	// Takes over the color and konst registers of another instance.
+	void CopyRegisters(const Tev& other);
+
+	void ResetCounters();
+	void FlushCounters();
+
 	enum { ALP_C, BLU_C, GRN_C, RED_C };
 
 	void DoState(PointerWrap &p);
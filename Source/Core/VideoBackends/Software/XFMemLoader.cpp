@@ -5,6 +5,7 @@
 #include "Core/HW/Memmap.h"
 #include "VideoBackends/Software/Clipper.h"
 #include "VideoBackends/Software/CPMemLoader.h"
+#include "VideoBackends/Software/Rasterizer.h"
 #include "VideoBackends/Software/XFMemLoader.h"
 #include "VideoCommon/VideoCommon.h"
 
@@ -61,6 +62,14 @@ void SWLoadXFReg(u32 transferSize, u32 baseAddress, u32 *pData)
 	// write to XF regs
 	if (transferSize > 0)
 	{
+		// The rasterizer reads the viewport and the texgen projection flags, so
+		// queued triangles have to be drawn before those change. Matrix loads
+		// are only used by the transform unit and don't need to wait.
+		u32 end = baseAddress + transferSize;
+		if ((baseAddress < XFMEM_SETPROJECTION && end > XFMEM_SETVIEWPORT) ||
+		    (baseAddress < XFMEM_SETPOSMTXINFO && end > XFMEM_SETTEXMTXINFO))
+			Rasterizer::Flush();
+
 		memcpy_gc((u32*)(&xfmem) + baseAddress, pData, transferSize * 4);
 		XFWritten(transferSize, baseAddress);
 	}
@@ -275,6 +275,8 @@ void RegisterMMIO(MMIO::Mapping* mmio, u32 base)
 			}
 			if (!IsOnThread())
 				RunGpu();
+			else
+				WakeGpuLoop();
 		})
 	);
 	mmio->Register(base | FIFO_READ_POINTER_LO,
@@ -333,6 +335,8 @@ void STACKALIGN GatherPipeBursted()
 
 	if (!IsOnThread())
 		RunGpu();
+	else
+		WakeGpuLoop();
 
 	_assert_msg_(COMMANDPROCESSOR, fifo.CPReadWriteDistance <= fifo.CPEnd - fifo.CPBase,
 	"FIFO is overflowed by GatherPipe !\nCPU thread is too fast!");
@@ -358,6 +362,8 @@ void UpdateInterrupts(u64 userdata)
 		ProcessorInterface::SetInterrupt(INT_CAUSE_CP, false);
 	}
 	interruptWaiting = false;
+	if (IsOnThread())
+		WakeGpuLoop();
 }
 
 void UpdateInterruptsFromVideoBackend(u64 userdata)
@@ -525,6 +531,8 @@ void SetCpControlRegister()
 	else
 	{
 		fifo.bFF_GPReadEnable = m_CPCtrlReg.GPReadEnable;
+		if (fifo.bFF_GPReadEnable && IsOnThread())
+			WakeGpuLoop();
 	}
 
 	DEBUG_LOG(COMMANDPROCESSOR, "\t GPREAD %s | BP %s | Int %s | OvF %s | UndF %s | LINK %s"
@@ -0,0 +1,206 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <unordered_map>
+#include <vector>
+
+#include "Common/Common.h"
+#include "Common/Hash.h"
+
+#include "VideoCommon/CPMemory.h"
+#include "VideoCommon/DataReader.h"
+#include "VideoCommon/DLCache.h"
+#include "VideoCommon/OpcodeDecoding.h"
+#include "VideoCommon/PixelEngine.h"
+#include "VideoCommon/Statistics.h"
+#include "VideoCommon/VertexLoader.h"
+#include "VideoCommon/VertexLoaderManager.h"
+#include "VideoCommon/VertexManagerBase.h"
+#include "VideoCommon/VideoConfig.h"
+
+namespace DLCache
+{
+
+// Lists that haven't been called for this many frames are freed.
+static const u32 MAX_UNUSED_FRAMES = 300;
+// No more vertices are kept once all lists together hold this much.
+static const size_t MAX_CACHED_BYTES = 64 * 1024 * 1024;
+
+struct CachedPrimitive
+{
+	// Position and size of the command in the list
+	u32 offset;
+	u32 command_size;
+
+	int vtx_attr_group;
+	int primitive;
+	int count;
+
+	// The converted vertices are only valid for the loader and the VAT (which
+	// also holds the fraction bits the loader doesn't depend on) they were made with.
+	VertexLoader* loader;
+	u32 vat[3];
+	// Empty if the primitive has to be decoded on every call.
+	std::vector<u8> vertices;
+};
+
+struct CachedList
+{
+	u64 hash;
+	u32 last_frame;
+	size_t bytes;
+	// The next primitive expected while the list is interpreted
+	size_t next;
+	std::vector<CachedPrimitive> primitives;
+};
+
+static std::unordered_map<u64, CachedList> s_lists;
+static size_t s_cached_bytes;
+static u32 s_frame;
+
+void Init()
+{
+	Clear();
+	s_frame = 0;
+}
+
+void Shutdown()
+{
+	Clear();
+}
+
+void Clear()
+{
+	s_lists.clear();
+	s_cached_bytes = 0;
+	SETSTAT(stats.numDListsAlive, 0);
+}
+
+void ProgressiveCleanup()
+{
+	++s_frame;
+
+	for (auto iter = s_lists.begin(); iter != s_lists.end();)
+	{
+		if (s_frame - iter->second.last_frame > MAX_UNUSED_FRAMES)
+		{
+			s_cached_bytes -= iter->second.bytes;
+			iter = s_lists.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+	SETSTAT(stats.numDListsAlive, s_lists.size());
+}
+
+CachedList* Lookup(u32 address, u32 size, const u8* data)
+{
+	// Replayed commands aren't seen by the FIFO recorder.
+	if (!g_ActiveConfig.bDListCacheEnable || g_bRecordFifoData)
+		return nullptr;
+
+	const u64 key = ((u64)address << 32) | size;
+	const u64 hash = GetMurmurHash3(data, size, 0);
+
+	auto result = s_lists.insert(std::make_pair(key, CachedList()));
+	CachedList& list = result.first->second;
+	if (result.second || list.hash != hash)
+	{
+		if (result.second)
+		{
+			INCSTAT(stats.numDListsCreated);
+			SETSTAT(stats.numDListsAlive, s_lists.size());
+		}
+		s_cached_bytes -= list.bytes;
+		list.hash = hash;
+		list.bytes = 0;
+		list.primitives.clear();
+		INCSTAT(stats.thisFrame.numDListCacheMisses);
+	}
+	else
+	{
+		INCSTAT(stats.thisFrame.numDListCacheHits);
+	}
+
+	list.last_frame = s_frame;
+	list.next = 0;
+	return &list;
+}
+
+bool ReplayPrimitive(CachedList* list, u32 offset)
+{
+	if (list->next >= list->primitives.size())
+		return false;
+
+	CachedPrimitive& prim = list->primitives[list->next];
+	if (prim.offset != offset)
+		return false;
+	++list->next;
+
+	// Bounding box emulation needs the loaders to see every vertex.
+	if (prim.vertices.empty() || PixelEngine::bbox_active)
+		return false;
+
+	const int group = prim.vtx_attr_group;
+	if (VertexLoaderManager::GetLoader(group) != prim.loader ||
+	    g_VtxAttr[group].g0.Hex != prim.vat[0] ||
+	    g_VtxAttr[group].g1.Hex != prim.vat[1] ||
+	    g_VtxAttr[group].g2.Hex != prim.vat[2])
+		return false;
+
+	prim.loader->RunConvertedVertices(group, prim.primitive, prim.count, &prim.vertices[0]);
+	DataSkip(prim.command_size);
+	INCSTAT(stats.thisFrame.numDListPrimsReplayed);
+	return true;
+}
+
+void RecordPrimitive(CachedList* list, u32 offset, u32 command_size, int vtx_attr_group, int primitive, int count)
+{
+	CachedPrimitive* prim;
+	if (list->next > 0 && list->primitives[list->next - 1].offset == offset)
+	{
+		// Replaying it failed, record it again.
+		prim = &list->primitives[list->next - 1];
+		list->bytes -= prim->vertices.size();
+		s_cached_bytes -= prim->vertices.size();
+		prim->vertices.clear();
+	}
+	else
+	{
+		list->primitives.push_back(CachedPrimitive());
+		list->next = list->primitives.size();
+		prim = &list->primitives.back();
+	}
+
+	VertexLoader* loader = VertexLoaderManager::GetLoader(vtx_attr_group);
+	prim->offset = offset;
+	prim->command_size = command_size;
+	prim->vtx_attr_group = vtx_attr_group;
+	prim->primitive = primitive;
+	prim->count = count;
+	prim->loader = loader;
+	prim->vat[0] = g_VtxAttr[vtx_attr_group].g0.Hex;
+	prim->vat[1] = g_VtxAttr[vtx_attr_group].g1.Hex;
+	prim->vat[2] = g_VtxAttr[vtx_attr_group].g2.Hex;
+
+	if (!count)
+		return;
+
+	if (!loader->RunVertices(vtx_attr_group, primitive, count))
+		return;
+
+	// Vertices read from the indexed arrays can change without the list changing.
+	const size_t bytes = count * loader->GetNativeVertexStride();
+	if (loader->UsesIndexedArrays() || PixelEngine::bbox_active || s_cached_bytes + bytes > MAX_CACHED_BYTES)
+		return;
+
+	const u8* end = VertexManager::s_pCurBufferPointer;
+	prim->vertices.assign(end - bytes, end);
+	list->bytes += bytes;
+	s_cached_bytes += bytes;
+}
+
+}
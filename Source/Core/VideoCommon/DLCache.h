@@ -0,0 +1,45 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Keeps the converted vertices of the primitives in display lists, so that
+// calling the same list again only has to copy them into the vertex buffer.
+// Register loads in a list are still run on every call since they are cheap
+// and their effect depends on the state they are run in.
+//
+// Lists are looked up by address and size and checked against a hash of
+// their contents on every call, so a list that was written to since it was
+// recorded is simply recorded again.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+namespace DLCache
+{
+
+struct CachedList;
+
+void Init();
+void Shutdown();
+
+// Throws away all recorded lists.
+void Clear();
+
+// Called once per frame, frees the lists that haven't been called for a while.
+void ProgressiveCleanup();
+
+// Returns the entry for the list at address, emptied if its contents changed
+// or it wasn't seen before. Returns nullptr if lists can't be cached right now.
+CachedList* Lookup(u32 address, u32 size, const u8* data);
+
+// If the primitive command at offset in the list was recorded and the vertex
+// format is still the same, sends its vertices on and skips the command in
+// g_pVideoData. Returns false if the command has to be decoded normally.
+bool ReplayPrimitive(CachedList* list, u32 offset);
+
+// Runs the vertices of the primitive command at offset in the list, which
+// g_pVideoData points to, and keeps the result for later calls.
+void RecordPrimitive(CachedList* list, u32 offset, u32 command_size, int vtx_attr_group, int primitive, int count);
+
+}
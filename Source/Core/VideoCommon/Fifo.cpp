@@ -2,11 +2,19 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+
 #include "Common/Atomic.h"
 #include "Common/ChunkFile.h"
 #include "Common/FPURoundMode.h"
+#include "Common/MathUtil.h"
 #include "Common/MemoryUtil.h"
+#include "Common/StdConditionVariable.h"
 #include "Common/Thread.h"
+#include "Common/Timer.h"
 
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
@@ -16,8 +24,15 @@
 #include "VideoCommon/Fifo.h"
 #include "VideoCommon/OpcodeDecoding.h"
 #include "VideoCommon/PixelEngine.h"
+#include "VideoCommon/Statistics.h"
 #include "VideoCommon/VideoConfig.h"
 
+// Longest time the GPU thread spins before going to sleep, in microseconds
+#define GPU_MAX_SPIN_US 200
+// The GPU thread wakes up this often even without work so that window
+// messages keep getting handled
+#define GPU_SLEEP_TIMEOUT_MS 4
+
 volatile bool g_bSkipCurrentFrame = false;
 extern u8* g_pVideoData;
 
@@ -29,6 +44,22 @@ static std::mutex m_csHWVidOccupied;
 // STATE_TO_SAVE
 static u8 *videoBuffer;
 static int size = 0;
+// How many more bytes the command left in videoBuffer needs, 0 if unknown
+static u32 s_missingBytes = 0;
+
+// The GPU thread sleeps on s_wakeupCond while it has nothing to do. Anything
+// that can give it work calls WakeGpuLoop(), which only has to take the lock
+// when the GPU thread is actually asleep.
+static std::mutex s_wakeupLock;
+static std::condition_variable s_wakeupCond;
+static std::atomic<bool> s_gpuSleeping(false);
+static std::atomic<bool> s_wakeupPending(false);
+static u32 s_spinBudgetUs = 0;
+
+// Totals for the whole session, logged when the GPU loop exits
+static u64 s_totalWakeups = 0;
+static u64 s_totalSpinUs = 0;
+static u64 s_totalIdleUs = 0;
 }  // namespace
 
 void Fifo_DoState(PointerWrap &p)
@@ -37,6 +68,8 @@ void Fifo_DoState(PointerWrap &p)
 	p.Do(size);
 	p.DoPointer(g_pVideoData, videoBuffer);
 	p.Do(g_bSkipCurrentFrame);
+	if (p.GetMode() == PointerWrap::MODE_READ)
+		s_missingBytes = 0;
 }
 
 void Fifo_PauseAndLock(bool doLock, bool unpauseOnUnlock)
@@ -99,11 +132,83 @@ void ExitGpuLoop()
 	// Terminate GPU thread loop
 	GpuRunningState = false;
 	EmuRunningState = true;
+	WakeGpuLoop();
 }
 
 void EmulatorState(bool running)
 {
 	EmuRunningState = running;
+	WakeGpuLoop();
+}
+
+void WakeGpuLoop()
+{
+	// Pairs with the store to s_gpuSleeping in WaitForGpuWork(): either the
+	// GPU thread sees the pending wakeup before it sleeps, or we see it sleeping.
+	s_wakeupPending = true;
+	if (s_gpuSleeping)
+	{
+		{
+			std::lock_guard<std::mutex> lk(s_wakeupLock);
+		}
+		s_wakeupCond.notify_one();
+	}
+}
+
+static bool GpuLoopHasWork()
+{
+	SCPFifoStruct &fifo = CommandProcessor::fifo;
+	return !GpuRunningState || !EmuRunningState || s_wakeupPending ||
+	       (!CommandProcessor::interruptWaiting && fifo.bFF_GPReadEnable && fifo.CPReadWriteDistance && !AtBreakpoint());
+}
+
+// Called by the GPU loop once it ran out of work. Spins for a little while,
+// since the CPU thread often sends more data right away, then sleeps until
+// WakeGpuLoop() is called.
+static void WaitForGpuWork()
+{
+	const u64 spinStart = Common::Timer::GetTimeUs();
+	u64 now = spinStart;
+
+	while (now - spinStart < s_spinBudgetUs)
+	{
+		if (GpuLoopHasWork())
+			break;
+		Common::YieldCPU();
+		now = Common::Timer::GetTimeUs();
+	}
+
+	const u64 spinUs = now - spinStart;
+	ADDSTAT(stats.thisFrame.usGpuSpin, (int)spinUs);
+	s_totalSpinUs += spinUs;
+
+	s_gpuSleeping = true;
+	if (GpuLoopHasWork())
+	{
+		s_gpuSleeping = false;
+		s_wakeupPending = false;
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lk(s_wakeupLock);
+		s_wakeupCond.wait_for(lk, std::chrono::milliseconds(GPU_SLEEP_TIMEOUT_MS), GpuLoopHasWork);
+	}
+	s_gpuSleeping = false;
+	s_wakeupPending = false;
+
+	const u64 idleUs = Common::Timer::GetTimeUs() - now;
+	INCSTAT(stats.thisFrame.numGpuWakeups);
+	ADDSTAT(stats.thisFrame.usGpuIdle, (int)idleUs);
+	s_totalWakeups++;
+	s_totalIdleUs += idleUs;
+
+	// Work that arrives right after we fell asleep would have been caught by
+	// spinning a little longer. Long sleeps mean we're idle, so stop spinning.
+	if (idleUs < GPU_MAX_SPIN_US)
+		s_spinBudgetUs = std::min<u32>(s_spinBudgetUs * 2 + 10, GPU_MAX_SPIN_US);
+	else
+		s_spinBudgetUs /= 2;
 }
 
 
@@ -130,6 +235,77 @@ void ResetVideoBuffer()
 {
 	g_pVideoData = videoBuffer;
 	size = 0;
+	s_missingBytes = 0;
+}
+
+// Moves the data between g_pVideoData and 'end' that wasn't decoded yet to the
+// start of videoBuffer.
+static void KeepUndecodedData(u8* end)
+{
+	size = (int)(end - g_pVideoData);
+	memmove(videoBuffer, g_pVideoData, size);
+	g_pVideoData = videoBuffer;
+}
+
+// Runs the commands in the part of the FIFO that can be read in one go, at most
+// maxSize bytes of it. They are decoded straight out of emulated memory; only a
+// command that's cut off at the end gets copied to videoBuffer, and the next call
+// copies just enough to finish that one before going back to decoding in place.
+// Returns the cycles the commands take.
+static u32 RunFifoSpan(u32 maxSize)
+{
+	SCPFifoStruct &fifo = CommandProcessor::fifo;
+	u32 readPtr = fifo.CPReadPointer;
+	u32 distance = fifo.CPReadWriteDistance;
+
+	// The block at CPEnd is read before wrapping around to CPBase
+	u32 len = std::min<u32>(distance, fifo.CPEnd + 32 - readPtr);
+	len = std::min(len, maxSize);
+
+	// Stop at a breakpoint, and as soon as the low watermark gets crossed so the
+	// underflow interrupt is raised at the same point as when reading a block at a time.
+	u32 toBreakpoint = fifo.CPBreakpoint - readPtr;
+	if (fifo.bFF_BPEnable && fifo.CPBreakpoint > readPtr && toBreakpoint < len && toBreakpoint % 32 == 0)
+		len = toBreakpoint;
+	if (fifo.bFF_LoWatermarkInt && distance > fifo.CPLoWatermark)
+		len = std::min<u32>(len, ROUND_UP(distance - fifo.CPLoWatermark + 1, 32));
+
+	u8 *data = Memory::GetPointer(readPtr);
+	u32 cycles = 0;
+	u32 done = 0;
+	while (done < len)
+	{
+		u32 chunk = len - done;
+		u8 *end;
+		if (size)
+		{
+			chunk = std::min<u32>(chunk, ROUND_UP(std::max<u32>(s_missingBytes, 1), 32));
+			ReadDataFromFifo(data + done, chunk);
+			end = GetVideoBufferEndPtr();
+		}
+		else
+		{
+			g_pVideoData = data + done;
+			end = g_pVideoData + chunk;
+		}
+
+		u32 commandSize;
+		cycles += OpcodeDecoder_Run(end, &commandSize, g_bSkipCurrentFrame);
+		KeepUndecodedData(end);
+		s_missingBytes = size ? commandSize - size : 0;
+		done += chunk;
+	}
+
+	readPtr += len;
+	if (readPtr > fifo.CPEnd)
+		readPtr = fifo.CPBase;
+
+	Common::AtomicStore(fifo.CPReadPointer, readPtr);
+	Common::AtomicAdd(fifo.CPReadWriteDistance, -(s32)len);
+	if (size == 0)
+		Common::AtomicStore(fifo.SafeCPReadPointer, fifo.CPReadPointer);
+
+	return cycles;
 }
 
 
@@ -142,6 +318,11 @@ void RunGpuLoop()
 	SCPFifoStruct &fifo = CommandProcessor::fifo;
 	u32 cyclesExecuted = 0;
 
+	s_spinBudgetUs = 0;
+	s_totalWakeups = 0;
+	s_totalSpinUs = 0;
+	s_totalIdleUs = 0;
+
 	while (GpuRunningState)
 	{
 		g_video_backend->PeekMessages();
@@ -160,28 +341,12 @@ void RunGpuLoop()
 
 			if (!Core::g_CoreStartupParameter.bSyncGPU || Common::AtomicLoad(CommandProcessor::VITicks) > CommandProcessor::m_cpClockOrigin)
 			{
-				u32 readPtr = fifo.CPReadPointer;
-				u8 *uData = Memory::GetPointer(readPtr);
-
-				if (readPtr == fifo.CPEnd)
-					readPtr = fifo.CPBase;
-				else
-					readPtr += 32;
-
-				_assert_msg_(COMMANDPROCESSOR, (s32)fifo.CPReadWriteDistance - 32 >= 0 ,
-					"Negative fifo.CPReadWriteDistance = %i in FIFO Loop !\nThat can produce instability in the game. Please report it.", fifo.CPReadWriteDistance - 32);
-
-				ReadDataFromFifo(uData, 32);
-
-				cyclesExecuted = OpcodeDecoder_Run(g_bSkipCurrentFrame);
+				// With SyncGPU the CPU hands out cycles in small amounts, so stick to
+				// a block at a time there.
+				cyclesExecuted = RunFifoSpan(Core::g_CoreStartupParameter.bSyncGPU ? 32 : FIFO_SIZE);
 
 				if (Core::g_CoreStartupParameter.bSyncGPU && Common::AtomicLoad(CommandProcessor::VITicks) > cyclesExecuted)
 					Common::AtomicAdd(CommandProcessor::VITicks, -(s32)cyclesExecuted);
-
-				Common::AtomicStore(fifo.CPReadPointer, readPtr);
-				Common::AtomicAdd(fifo.CPReadWriteDistance, -32);
-				if ((GetVideoBufferEndPtr() - g_pVideoData) == 0)
-					Common::AtomicStore(fifo.SafeCPReadPointer, fifo.CPReadPointer);
 			}
 
 			CommandProcessor::SetCpStatus();
@@ -200,9 +365,9 @@ void RunGpuLoop()
 			// NOTE(jsd): Calling SwitchToThread() on Windows 7 x64 is a hot spot, according to profiler.
 			// See https://docs.google.com/spreadsheet/ccc?key=0Ah4nh0yGtjrgdFpDeF9pS3V6RUotRVE3S3J4TGM1NlE#gid=0
 			// for benchmark details.
-#if 0
-			Common::YieldCPU();
-#endif
+			// So rather than yielding on every empty pass, sleep until there's work.
+			if (GpuRunningState)
+				WaitForGpuWork();
 		}
 		else
 		{
@@ -216,6 +381,9 @@ void RunGpuLoop()
 			}
 		}
 	}
+
+	INFO_LOG(VIDEO, "GPU thread: %" PRIu64 " wakeups, %" PRIu64 " ms spinning, %" PRIu64 " ms idle",
+		s_totalWakeups, s_totalSpinUs / 1000, s_totalIdleUs / 1000);
 }
 
 
@@ -230,22 +398,10 @@ void RunGpu()
 	SCPFifoStruct &fifo = CommandProcessor::fifo;
 	while (fifo.bFF_GPReadEnable && fifo.CPReadWriteDistance && !AtBreakpoint() )
 	{
-		u8 *uData = Memory::GetPointer(fifo.CPReadPointer);
-
 		FPURoundMode::SaveSIMDState();
 		FPURoundMode::LoadDefaultSIMDState();
-		ReadDataFromFifo(uData, 32);
-		OpcodeDecoder_Run(g_bSkipCurrentFrame);
+		RunFifoSpan(FIFO_SIZE);
 		FPURoundMode::LoadSIMDState();
-
-		//DEBUG_LOG(COMMANDPROCESSOR, "Fifo wraps to base");
-
-		if (fifo.CPReadPointer == fifo.CPEnd)
-			fifo.CPReadPointer = fifo.CPBase;
-		else
-			fifo.CPReadPointer += 32;
-
-		fifo.CPReadWriteDistance -= 32;
 	}
 	CommandProcessor::SetCpStatus();
 }
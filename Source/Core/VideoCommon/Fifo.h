@@ -25,6 +25,9 @@ void ReadDataFromFifo(u8* _uData, u32 len);
 void RunGpu();
 void RunGpuLoop();
 void ExitGpuLoop();
+// Wakes the GPU thread up if it's sleeping because it had nothing to do.
+// Must be called after anything that could give it new work.
+void WakeGpuLoop();
 void EmulatorState(bool running);
 bool AtBreakpoint();
 void ResetVideoBuffer();
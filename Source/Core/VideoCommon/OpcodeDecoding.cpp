@@ -22,6 +22,7 @@
 #include "VideoCommon/CommandProcessor.h"
 #include "VideoCommon/CPMemory.h"
 #include "VideoCommon/DataReader.h"
+#include "VideoCommon/DLCache.h"
 #include "VideoCommon/Fifo.h"
 #include "VideoCommon/OpcodeDecoding.h"
 #include "VideoCommon/Statistics.h"
@@ -75,27 +76,40 @@ DataReadU32xNfunc DataReadU32xFuncs[16] = {
 };
 
 extern u8* GetVideoBufferStartPtr();
-extern u8* GetVideoBufferEndPtr();
 
-static void Decode();
+static u32 Decode(u8* end, u32* command_size, bool skipped_frame, bool in_display_list);
+
+// The display list being interpreted, if it is cached.
+static DLCache::CachedList* s_cached_list = nullptr;
+static u8* s_list_start = nullptr;
 
 void InterpretDisplayList(u32 address, u32 size)
 {
 	u8* old_pVideoData = g_pVideoData;
+	DLCache::CachedList* old_cached_list = s_cached_list;
+	u8* old_list_start = s_list_start;
 	u8* startAddress = Memory::GetPointer(address);
 
 	// Avoid the crash if Memory::GetPointer failed ..
 	if (startAddress != nullptr)
 	{
 		g_pVideoData = startAddress;
+		s_cached_list = DLCache::Lookup(address, size, startAddress);
+		s_list_start = startAddress;
 
 		// temporarily swap dl and non-dl (small "hack" for the stats)
 		Statistics::SwapDL();
 
 		u8 *end = g_pVideoData + size;
+		u32 command_size;
 		while (g_pVideoData < end)
 		{
-			Decode();
+			if (s_cached_list && DLCache::ReplayPrimitive(s_cached_list, (u32)(g_pVideoData - startAddress)))
+				continue;
+
+			// A command cut off by the end of the list can't be run.
+			if (!Decode(end, &command_size, false, true))
+				break;
 		}
 		INCSTAT(stats.numDListsCalled);
 		INCSTAT(stats.thisFrame.numDListsCalled);
@@ -106,241 +120,166 @@ void InterpretDisplayList(u32 address, u32 size)
 
 	// reset to the old pointer
 	g_pVideoData = old_pVideoData;
+	s_cached_list = old_cached_list;
+	s_list_start = old_list_start;
 }
 
-u32 FifoCommandRunnable(u32 &command_size)
+static void UnknownOpcode(u8 cmd_byte)
 {
-	u32 cycleTime = 0;
-	u32 buffer_size = (u32)(GetVideoBufferEndPtr() - g_pVideoData);
-	if (buffer_size == 0)
-		return 0;  // can't peek
-
-	u8 cmd_byte = DataPeek8(0);
-
-	switch (cmd_byte)
+	// TODO(Omega): Maybe dump FIFO to file on this error
+	char szTemp[1024];
+	sprintf(szTemp, "GFX FIFO: Unknown Opcode (0x%x).\n"
+		"This means one of the following:\n"
+		"* The emulated GPU got desynced, disabling dual core can help\n"
+		"* Command stream corrupted by some spurious memory bug\n"
+		"* This really is an unknown opcode (unlikely)\n"
+		"* Some other sort of bug\n\n"
+		"Dolphin will now likely crash or hang. Enjoy." , cmd_byte);
+	Host_SysMessage(szTemp);
+	INFO_LOG(VIDEO, "%s", szTemp);
 	{
-	case GX_NOP: // Hm, this means that we scan over nop streams pretty slowly...
-		command_size = 1;
-		cycleTime = 6;
-		break;
-	case GX_CMD_INVL_VC: // Invalidate Vertex Cache - no parameters
-		command_size = 1;
-		cycleTime = 6;
-		break;
-	case GX_CMD_UNKNOWN_METRICS: // zelda 4 swords calls it and checks the metrics registers after that
-		command_size = 1;
-		cycleTime = 6;
-		break;
-
-	case GX_LOAD_BP_REG:
-		command_size = 5;
-		cycleTime = 12;
-		break;
-
-	case GX_LOAD_CP_REG:
-		command_size = 6;
-		cycleTime = 12;
-		break;
-
-	case GX_LOAD_INDX_A:
-	case GX_LOAD_INDX_B:
-	case GX_LOAD_INDX_C:
-	case GX_LOAD_INDX_D:
-		command_size = 5;
-		cycleTime = 6; // TODO
-		break;
-
-	case GX_CMD_CALL_DL:
-		{
-			// FIXME: Calculate the cycle time of the display list.
-			//u32 address = DataPeek32(1);
-			//u32 size = DataPeek32(5);
-			//u8* old_pVideoData = g_pVideoData;
-			//u8* startAddress = Memory::GetPointer(address);
-
-			//// Avoid the crash if Memory::GetPointer failed ..
-			//if (startAddress != 0)
-			//{
-			//	g_pVideoData = startAddress;
-			//	u8 *end = g_pVideoData + size;
-			//	u32 step = 0;
-			//	while (g_pVideoData < end)
-			//	{
-			//		cycleTime += FifoCommandRunnable(step);
-			//		g_pVideoData += step;
-			//	}
-			//}
-			//else
-			//{
-			//	cycleTime = 45;
-			//}
-
-			//// reset to the old pointer
-			//g_pVideoData = old_pVideoData;
-			command_size = 9;
-			cycleTime = 45;  // This is unverified
-		}
-		break;
-
-	case GX_LOAD_XF_REG:
-		{
-			// check if we can read the header
-			if (buffer_size >= 5)
-			{
-				command_size = 1 + 4;
-				u32 Cmd2 = DataPeek32(1);
-				int transfer_size = ((Cmd2 >> 16) & 15) + 1;
-				command_size += transfer_size * 4;
-				cycleTime = 18 + 6 * transfer_size;
-			}
-			else
-			{
-				return 0;
-			}
-		}
-		break;
-
-	default:
-		if ((cmd_byte & 0xC0) == 0x80)
-		{
-			// check if we can read the header
-			if (buffer_size >= 3)
-			{
-				command_size = 1 + 2;
-				u16 numVertices = DataPeek16(1);
-				command_size += numVertices * VertexLoaderManager::GetVertexSize(cmd_byte & GX_VAT_MASK);
-				cycleTime = 1600; // This depends on the number of pixels rendered
-			}
-			else
-			{
-				return 0;
-			}
-		}
-		else
-		{
-			// TODO(Omega): Maybe dump FIFO to file on this error
-			char szTemp[1024];
-			sprintf(szTemp, "GFX FIFO: Unknown Opcode (0x%x).\n"
-				"This means one of the following:\n"
-				"* The emulated GPU got desynced, disabling dual core can help\n"
-				"* Command stream corrupted by some spurious memory bug\n"
-				"* This really is an unknown opcode (unlikely)\n"
-				"* Some other sort of bug\n\n"
-				"Dolphin will now likely crash or hang. Enjoy." , cmd_byte);
-			Host_SysMessage(szTemp);
-			INFO_LOG(VIDEO, "%s", szTemp);
-			{
-				SCPFifoStruct &fifo = CommandProcessor::fifo;
-
-				char szTmp[512];
-				// sprintf(szTmp, "Illegal command %02x (at %08x)",cmd_byte,g_pDataReader->GetPtr());
-				sprintf(szTmp, "Illegal command %02x\n"
-					"CPBase: 0x%08x\n"
-					"CPEnd: 0x%08x\n"
-					"CPHiWatermark: 0x%08x\n"
-					"CPLoWatermark: 0x%08x\n"
-					"CPReadWriteDistance: 0x%08x\n"
-					"CPWritePointer: 0x%08x\n"
-					"CPReadPointer: 0x%08x\n"
-					"CPBreakpoint: 0x%08x\n"
-					"bFF_GPReadEnable: %s\n"
-					"bFF_BPEnable: %s\n"
-					"bFF_BPInt: %s\n"
-					"bFF_Breakpoint: %s\n"
-					,cmd_byte, fifo.CPBase, fifo.CPEnd, fifo.CPHiWatermark, fifo.CPLoWatermark, fifo.CPReadWriteDistance
-					,fifo.CPWritePointer, fifo.CPReadPointer, fifo.CPBreakpoint, fifo.bFF_GPReadEnable ? "true" : "false"
-					,fifo.bFF_BPEnable ? "true" : "false" ,fifo.bFF_BPInt ? "true" : "false"
-					,fifo.bFF_Breakpoint ? "true" : "false");
-
-				Host_SysMessage(szTmp);
-				INFO_LOG(VIDEO, "%s", szTmp);
-			}
-		}
-		break;
+		SCPFifoStruct &fifo = CommandProcessor::fifo;
+
+		char szTmp[512];
+		// sprintf(szTmp, "Illegal command %02x (at %08x)",cmd_byte,g_pDataReader->GetPtr());
+		sprintf(szTmp, "Illegal command %02x\n"
+			"CPBase: 0x%08x\n"
+			"CPEnd: 0x%08x\n"
+			"CPHiWatermark: 0x%08x\n"
+			"CPLoWatermark: 0x%08x\n"
+			"CPReadWriteDistance: 0x%08x\n"
+			"CPWritePointer: 0x%08x\n"
+			"CPReadPointer: 0x%08x\n"
+			"CPBreakpoint: 0x%08x\n"
+			"bFF_GPReadEnable: %s\n"
+			"bFF_BPEnable: %s\n"
+			"bFF_BPInt: %s\n"
+			"bFF_Breakpoint: %s\n"
+			,cmd_byte, fifo.CPBase, fifo.CPEnd, fifo.CPHiWatermark, fifo.CPLoWatermark, fifo.CPReadWriteDistance
+			,fifo.CPWritePointer, fifo.CPReadPointer, fifo.CPBreakpoint, fifo.bFF_GPReadEnable ? "true" : "false"
+			,fifo.bFF_BPEnable ? "true" : "false" ,fifo.bFF_BPInt ? "true" : "false"
+			,fifo.bFF_Breakpoint ? "true" : "false");
+
+		Host_SysMessage(szTmp);
+		INFO_LOG(VIDEO, "%s", szTmp);
 	}
-
-	if (command_size > buffer_size)
-		return 0;
-
-	// INFO_LOG("OP detected: cmd_byte 0x%x  size %i  buffer %i",cmd_byte, command_size, buffer_size);
-	if (cycleTime == 0)
-		cycleTime = 6;
-
-	return cycleTime;
 }
 
-u32 FifoCommandRunnable()
-{
-	u32 command_size = 0;
-	return FifoCommandRunnable(command_size);
-}
-
-static void Decode()
+// Runs the command at g_pVideoData and returns the number of cycles it takes.
+// Each case first works out the size of its command; if that goes past 'end',
+// nothing is read, 0 is returned and command_size tells how many bytes are
+// needed before trying again (only the header's size if that's incomplete).
+// When skipping a frame only the commands that change state are run. An
+// unknown opcode in the FIFO is reported to the user, one in a display list is
+// only logged.
+static u32 Decode(u8* end, u32* command_size, bool skipped_frame, bool in_display_list)
 {
 	u8 *opcodeStart = g_pVideoData;
+	u32 available = (u32)(end - opcodeStart);
+	u32 size = 1;
+	u32 cycles = 0;
 
-	int cmd_byte = DataReadU8();
+	if (available == 0)
+	{
+		*command_size = size;
+		return 0;
+	}
+
+	int cmd_byte = DataPeek8(0);
 	switch (cmd_byte)
 	{
-	case GX_NOP:
+	case GX_NOP: // Hm, this means that we scan over nop streams pretty slowly...
+		DataSkip(1);
+		cycles = 6;
 		break;
 
 	case GX_LOAD_CP_REG: //0x08
+		// We have to let CP writes through even when skipping because they determine the size of vertices.
+		size = 6;
+		if (available >= size)
 		{
+			DataSkip(1);
 			u8 sub_cmd = DataReadU8();
 			u32 value = DataReadU32();
 			LoadCPReg(sub_cmd, value);
 			INCSTAT(stats.thisFrame.numCPLoads);
+			cycles = 12;
 		}
 		break;
 
 	case GX_LOAD_XF_REG:
+		size = 5;
+		if (available >= size)
 		{
-			u32 Cmd2 = DataReadU32();
-			int transfer_size = ((Cmd2 >> 16) & 15) + 1;
-			u32 xf_address = Cmd2 & 0xFFFF;
-			GC_ALIGNED128(u32 data_buffer[16]);
-			DataReadU32xFuncs[transfer_size-1](data_buffer);
-			LoadXFReg(transfer_size, xf_address, data_buffer);
-
-			INCSTAT(stats.thisFrame.numXFLoads);
+			int transfer_size = ((DataPeek32(1) >> 16) & 15) + 1;
+			size += transfer_size * 4;
+			if (available >= size)
+			{
+				DataSkip(1);
+				u32 Cmd2 = DataReadU32();
+				u32 xf_address = Cmd2 & 0xFFFF;
+				GC_ALIGNED128(u32 data_buffer[16]);
+				DataReadU32xFuncs[transfer_size-1](data_buffer);
+				LoadXFReg(transfer_size, xf_address, data_buffer);
+				INCSTAT(stats.thisFrame.numXFLoads);
+				cycles = 18 + 6 * transfer_size;
+			}
 		}
 		break;
 
 	case GX_LOAD_INDX_A: //used for position matrices
-		LoadIndexedXF(DataReadU32(), 0xC);
-		break;
 	case GX_LOAD_INDX_B: //used for normal matrices
-		LoadIndexedXF(DataReadU32(), 0xD);
-		break;
 	case GX_LOAD_INDX_C: //used for postmatrices
-		LoadIndexedXF(DataReadU32(), 0xE);
-		break;
 	case GX_LOAD_INDX_D: //used for lights
-		LoadIndexedXF(DataReadU32(), 0xF);
+		size = 5;
+		if (available >= size)
+		{
+			DataSkip(1);
+			// 0xC for INDX_A up to 0xF for INDX_D
+			LoadIndexedXF(DataReadU32(), 0xC + ((cmd_byte - GX_LOAD_INDX_A) >> 3));
+			cycles = 6; // TODO
+		}
 		break;
 
 	case GX_CMD_CALL_DL:
+		size = 9;
+		if (available >= size)
 		{
+			DataSkip(1);
 			u32 address = DataReadU32();
 			u32 count = DataReadU32();
-			InterpretDisplayList(address, count);
+			// Hm, wonder if any games put tokens in display lists - in that case,
+			// we'll have to run them even when skipping.
+			if (!skipped_frame)
+				InterpretDisplayList(address, count);
+			// FIXME: Calculate the cycle time of the display list.
+			cycles = 45;  // This is unverified
 		}
 		break;
 
 	case GX_CMD_UNKNOWN_METRICS: // zelda 4 swords calls it and checks the metrics registers after that
+		DataSkip(1);
 		DEBUG_LOG(VIDEO, "GX 0x44: %08x", cmd_byte);
+		cycles = 6;
 		break;
 
 	case GX_CMD_INVL_VC: // Invalidate Vertex Cache
+		DataSkip(1);
 		DEBUG_LOG(VIDEO, "Invalidate (vertex cache?)");
+		cycles = 6;
 		break;
 
 	case GX_LOAD_BP_REG: //0x61
+		// We have to let BP writes through even when skipping because they set tokens and stuff.
+		// TODO: Call a much simplified LoadBPReg instead.
+		size = 5;
+		if (available >= size)
 		{
+			DataSkip(1);
 			u32 bp_cmd = DataReadU32();
 			LoadBPReg(bp_cmd);
 			INCSTAT(stats.thisFrame.numBPLoads);
+			cycles = 12;
 		}
 		break;
 
@@ -348,108 +287,59 @@ static void Decode()
 	default:
 		if ((cmd_byte & 0xC0) == 0x80)
 		{
-			// load vertices (use computed vertex size from FifoCommandRunnable above)
-			u16 numVertices = DataReadU16();
-
-			VertexLoaderManager::RunVertices(
-				cmd_byte & GX_VAT_MASK,   // Vertex loader index (0 - 7)
-				(cmd_byte & GX_PRIMITIVE_MASK) >> GX_PRIMITIVE_SHIFT,
-				numVertices);
+			size = 3;
+			if (available >= size)
+			{
+				u16 numVertices = DataPeek16(1);
+				u32 vertexBytes = numVertices * VertexLoaderManager::GetVertexSize(cmd_byte & GX_VAT_MASK);
+				size += vertexBytes;
+				if (available >= size)
+				{
+					DataSkip(3);
+					if (skipped_frame)
+					{
+						DataSkip(vertexBytes);
+					}
+					else if (s_cached_list)
+					{
+						DLCache::RecordPrimitive(s_cached_list, (u32)(opcodeStart - s_list_start), size,
+							cmd_byte & GX_VAT_MASK,
+							(cmd_byte & GX_PRIMITIVE_MASK) >> GX_PRIMITIVE_SHIFT,
+							numVertices);
+					}
+					else
+					{
+						VertexLoaderManager::RunVertices(
+							cmd_byte & GX_VAT_MASK,   // Vertex loader index (0 - 7)
+							(cmd_byte & GX_PRIMITIVE_MASK) >> GX_PRIMITIVE_SHIFT,
+							numVertices);
+					}
+					cycles = 1600; // This depends on the number of pixels rendered
+				}
+			}
 		}
 		else
 		{
+			if (!in_display_list)
+				UnknownOpcode(cmd_byte);
 			ERROR_LOG(VIDEO, "OpcodeDecoding::Decode: Illegal command %02x", cmd_byte);
-			break;
+			DataSkip(1);
+			cycles = 6;
 		}
 		break;
 	}
 
-	// Display lists get added directly into the FIFO stream
-	if (g_bRecordFifoData && cmd_byte != GX_CMD_CALL_DL)
-		FifoRecorder::GetInstance().WriteGPCommand(opcodeStart, u32(g_pVideoData - opcodeStart));
-}
-
-static void DecodeSemiNop()
-{
-	u8 *opcodeStart = g_pVideoData;
-
-	int cmd_byte = DataReadU8();
-	switch (cmd_byte)
+	if (!cycles)
 	{
-	case GX_CMD_UNKNOWN_METRICS: // zelda 4 swords calls it and checks the metrics registers after that
-	case GX_CMD_INVL_VC: // Invalidate Vertex Cache
-	case GX_NOP:
-		break;
-
-	case GX_LOAD_CP_REG: //0x08
-		// We have to let CP writes through because they determine the size of vertices.
-		{
-			u8 sub_cmd = DataReadU8();
-			u32 value = DataReadU32();
-			LoadCPReg(sub_cmd, value);
-			INCSTAT(stats.thisFrame.numCPLoads);
-		}
-		break;
-
-	case GX_LOAD_XF_REG:
-		{
-			u32 Cmd2 = DataReadU32();
-			int transfer_size = ((Cmd2 >> 16) & 15) + 1;
-			u32 address = Cmd2 & 0xFFFF;
-			GC_ALIGNED128(u32 data_buffer[16]);
-			DataReadU32xFuncs[transfer_size-1](data_buffer);
-			LoadXFReg(transfer_size, address, data_buffer);
-			INCSTAT(stats.thisFrame.numXFLoads);
-		}
-		break;
-
-	case GX_LOAD_INDX_A: //used for position matrices
-		LoadIndexedXF(DataReadU32(), 0xC);
-		break;
-	case GX_LOAD_INDX_B: //used for normal matrices
-		LoadIndexedXF(DataReadU32(), 0xD);
-		break;
-	case GX_LOAD_INDX_C: //used for postmatrices
-		LoadIndexedXF(DataReadU32(), 0xE);
-		break;
-	case GX_LOAD_INDX_D: //used for lights
-		LoadIndexedXF(DataReadU32(), 0xF);
-		break;
-
-	case GX_CMD_CALL_DL:
-		// Hm, wonder if any games put tokens in display lists - in that case,
-		// we'll have to parse them too.
-		DataSkip(8);
-		break;
-
-	case GX_LOAD_BP_REG: //0x61
-		// We have to let BP writes through because they set tokens and stuff.
-		// TODO: Call a much simplified LoadBPReg instead.
-		{
-			u32 bp_cmd = DataReadU32();
-			LoadBPReg(bp_cmd);
-			INCSTAT(stats.thisFrame.numBPLoads);
-		}
-		break;
-
-	// draw primitives
-	default:
-		if ((cmd_byte & 0xC0) == 0x80)
-		{
-			// load vertices (use computed vertex size from FifoCommandRunnable above)
-			u16 numVertices = DataReadU16();
-			DataSkip(numVertices * VertexLoaderManager::GetVertexSize(cmd_byte & GX_VAT_MASK));
-		}
-		else
-		{
-			ERROR_LOG(VIDEO, "OpcodeDecoding::Decode: Illegal command %02x", cmd_byte);
-			break;
-		}
-		break;
+		*command_size = size;
+		return 0;
 	}
 
+	// Display lists get added directly into the FIFO stream
 	if (g_bRecordFifoData && cmd_byte != GX_CMD_CALL_DL)
 		FifoRecorder::GetInstance().WriteGPCommand(opcodeStart, u32(g_pVideoData - opcodeStart));
+
+	return cycles;
 }
 
 void OpcodeDecoder_Init()
@@ -463,22 +353,21 @@ void OpcodeDecoder_Init()
 			DataReadU32xFuncs[i] = DataReadU32xFuncs_SSSE3[i];
 	}
 #endif
+
+	DLCache::Init();
 }
 
 
 void OpcodeDecoder_Shutdown()
 {
+	DLCache::Shutdown();
 }
 
-u32 OpcodeDecoder_Run(bool skipped_frame)
+u32 OpcodeDecoder_Run(u8* end, u32* command_size, bool skipped_frame)
 {
 	u32 totalCycles = 0;
-	u32 cycles = FifoCommandRunnable();
-	while (cycles > 0)
-	{
-		skipped_frame ? DecodeSemiNop() : Decode();
+	u32 cycles;
+	while ((cycles = Decode(end, command_size, skipped_frame, false)) != 0)
 		totalCycles += cycles;
-		cycles = FifoCommandRunnable();
-	}
 	return totalCycles;
 }
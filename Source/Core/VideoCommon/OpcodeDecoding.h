@@ -38,5 +38,9 @@ extern bool g_bRecordFifoData;
 
 void OpcodeDecoder_Init();
 void OpcodeDecoder_Shutdown();
-u32 OpcodeDecoder_Run(bool skipped_frame);
+// Runs the commands from g_pVideoData up to 'end' and returns the cycles they
+// take. Stops at the first command that doesn't entirely fit, leaving
+// g_pVideoData pointing at it and setting command_size to the number of bytes
+// it needs.
+u32 OpcodeDecoder_Run(u8* end, u32* command_size, bool skipped_frame);
 void InterpretDisplayList(u32 address, u32 size);
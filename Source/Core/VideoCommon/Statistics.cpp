@@ -36,6 +36,9 @@ char *Statistics::ToString(char *ptr)
 	ptr+=sprintf(ptr,"dlists called:    %i\n",stats.numDListsCalled);
 	ptr+=sprintf(ptr,"dlists called(f): %i\n",stats.thisFrame.numDListsCalled);
 	ptr+=sprintf(ptr,"dlists alive:     %i\n",stats.numDListsAlive);
+	ptr+=sprintf(ptr,"dlist cache hits: %i / %i\n",stats.thisFrame.numDListCacheHits,
+		stats.thisFrame.numDListCacheHits + stats.thisFrame.numDListCacheMisses);
+	ptr+=sprintf(ptr,"dlist primitives replayed: %i\n",stats.thisFrame.numDListPrimsReplayed);
 	ptr+=sprintf(ptr,"Primitive joins: %i\n",stats.thisFrame.numPrimitiveJoins);
 	ptr+=sprintf(ptr,"Draw calls:       %i\n",stats.thisFrame.numDrawCalls);
 	ptr+=sprintf(ptr,"Indexed draw calls: %i\n",stats.thisFrame.numIndexedDrawCalls);
@@ -51,6 +54,13 @@ char *Statistics::ToString(char *ptr)
 	ptr+=sprintf(ptr,"Vertex streamed: %i kB\n",stats.thisFrame.bytesVertexStreamed/1024);
 	ptr+=sprintf(ptr,"Index streamed: %i kB\n",stats.thisFrame.bytesIndexStreamed/1024);
 	ptr+=sprintf(ptr,"Uniform streamed: %i kB\n",stats.thisFrame.bytesUniformStreamed/1024);
+	ptr+=sprintf(ptr,"Texture cache hits: %i / %i\n",stats.thisFrame.numTextureCacheHits,
+		stats.thisFrame.numTextureCacheHits + stats.thisFrame.numTextureCacheMisses);
+	ptr+=sprintf(ptr,"Texture hashing: %i us\n",stats.thisFrame.usTextureHashing);
+	ptr+=sprintf(ptr,"Texture uploads: %i kB\n",stats.thisFrame.bytesTextureUploaded/1024);
+	ptr+=sprintf(ptr,"GPU thread wakeups: %i\n",stats.thisFrame.numGpuWakeups);
+	ptr+=sprintf(ptr,"GPU thread spin: %i us\n",stats.thisFrame.usGpuSpin);
+	ptr+=sprintf(ptr,"GPU thread idle: %i us\n",stats.thisFrame.usGpuIdle);
 	ptr+=sprintf(ptr,"Vertex Loaders: %i\n",stats.numVertexLoaders);
 
 	std::string text1;
@@ -60,10 +60,22 @@ struct Statistics
 		int numBufferSplits;
 
 		int numDListsCalled;
+		int numDListCacheHits;
+		int numDListCacheMisses;
+		int numDListPrimsReplayed;
 
 		int bytesVertexStreamed;
 		int bytesIndexStreamed;
 		int bytesUniformStreamed;
+
+		int numTextureCacheHits;
+		int numTextureCacheMisses;
+		int bytesTextureUploaded;
+		int usTextureHashing;
+
+		int numGpuWakeups;
+		int usGpuSpin;
+		int usGpuIdle;
 	};
 	ThisFrame thisFrame;
 	void ResetFrame();
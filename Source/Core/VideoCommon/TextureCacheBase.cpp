@@ -2,8 +2,11 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <vector>
+
 #include "Common/FileUtil.h"
 #include "Common/MemoryUtil.h"
+#include "Common/Timer.h"
 
 #include "Core/ConfigManager.h"
 #include "Core/HW/Memmap.h"
@@ -21,6 +24,8 @@ extern int frameCount;
 enum
 {
 	TEXTURE_KILL_THRESHOLD = 200,
+	// Cleanup visits all of the cache once over this many frames
+	TEXTURE_CLEANUP_FRAMES = 16,
 };
 
 TextureCache *g_texture_cache;
@@ -29,6 +34,9 @@ GC_ALIGNED16(u8 *TextureCache::temp) = nullptr;
 unsigned int TextureCache::temp_size;
 
 TextureCache::TexCache TextureCache::textures;
+TextureCache::TexAddressIndex TextureCache::textures_by_address;
+u32 TextureCache::max_texture_size;
+size_t TextureCache::cleanup_bucket;
 
 TextureCache::BackupConfig TextureCache::backup_config;
 
@@ -66,6 +74,35 @@ void TextureCache::Invalidate()
 		delete tex.second;
 	}
 	textures.clear();
+	textures_by_address.clear();
+	max_texture_size = 0;
+	cleanup_bucket = 0;
+}
+
+void TextureCache::LinkToAddressIndex(u32 texID, TCacheEntryBase* entry)
+{
+	textures_by_address.insert(std::make_pair(entry->addr, texID));
+	max_texture_size = std::max(max_texture_size, entry->size_in_bytes);
+}
+
+void TextureCache::UnlinkFromAddressIndex(u32 texID, TCacheEntryBase* entry)
+{
+	auto range = textures_by_address.equal_range(entry->addr);
+	for (auto iter = range.first; iter != range.second; ++iter)
+	{
+		if (iter->second == texID)
+		{
+			textures_by_address.erase(iter);
+			return;
+		}
+	}
+}
+
+TextureCache::TexCache::iterator TextureCache::FreeTexture(TexCache::iterator iter)
+{
+	UnlinkFromAddressIndex(iter->first, iter->second);
+	delete iter->second;
+	return textures.erase(iter);
 }
 
 TextureCache::~TextureCache()
@@ -121,69 +158,80 @@ void TextureCache::OnConfigChanged(VideoConfig& config)
 
 void TextureCache::Cleanup()
 {
-	TexCache::iterator iter = textures.begin();
-	TexCache::iterator tcend = textures.end();
-	while (iter != tcend)
+	// Only sweep a slice of the cache every frame. Entries have to sit unused for
+	// TEXTURE_KILL_THRESHOLD frames before they go anyway, so it doesn't matter if
+	// one is noticed a few frames late.
+	const size_t num_buckets = textures.bucket_count();
+	size_t buckets_left = num_buckets / TEXTURE_CLEANUP_FRAMES + 1;
+
+	static std::vector<u32> dead_textures;
+	for (; buckets_left != 0; --buckets_left, ++cleanup_bucket)
 	{
-		if (frameCount > TEXTURE_KILL_THRESHOLD + iter->second->frameCount &&
-            // EFB copies living on the host GPU are unrecoverable and thus shouldn't be deleted
-		    !iter->second->IsEfbCopy())
-		{
-			delete iter->second;
-			textures.erase(iter++);
-		}
-		else
+		if (cleanup_bucket >= num_buckets)
+			cleanup_bucket = 0;
+
+		for (auto iter = textures.begin(cleanup_bucket); iter != textures.end(cleanup_bucket); ++iter)
 		{
-			++iter;
+			if (frameCount > TEXTURE_KILL_THRESHOLD + iter->second->frameCount &&
+				// EFB copies living on the host GPU are unrecoverable and thus shouldn't be deleted
+				!iter->second->IsEfbCopy())
+			{
+				dead_textures.push_back(iter->first);
+			}
 		}
 	}
+
+	for (u32 texID : dead_textures)
+		FreeTexture(textures.find(texID));
+	dead_textures.clear();
 }
 
-void TextureCache::InvalidateRange(u32 start_address, u32 size)
+void TextureCache::GetTexturesInRange(u32 start_address, u32 size, std::vector<u32>* texIDs)
 {
-	TexCache::iterator
-		iter = textures.begin(),
-		tcend = textures.end();
-	while (iter != tcend)
+	// An entry can only reach into the range if it starts at most max_texture_size bytes before it
+	const u32 first = start_address > max_texture_size ? start_address - max_texture_size : 0;
+	auto iter = textures_by_address.lower_bound(first);
+	for (; iter != textures_by_address.end() && iter->first < start_address + size; ++iter)
 	{
-		const int rangePosition = iter->second->IntersectsMemoryRange(start_address, size);
-		if (0 == rangePosition)
-		{
-			delete iter->second;
-			textures.erase(iter++);
-		}
-		else
-		{
-			++iter;
-		}
+		auto tex = textures.find(iter->second);
+		if (tex != textures.end() && tex->second->IntersectsMemoryRange(start_address, size) == 0)
+			texIDs->push_back(iter->second);
 	}
 }
 
-void TextureCache::MakeRangeDynamic(u32 start_address, u32 size)
+void TextureCache::InvalidateRange(u32 start_address, u32 size)
 {
-	TexCache::iterator
-		iter = textures.lower_bound(start_address),
-		tcend = textures.upper_bound(start_address + size);
+	static std::vector<u32> dead_textures;
+	GetTexturesInRange(start_address, size, &dead_textures);
 
-	if (iter != textures.begin())
-		--iter;
+	for (u32 texID : dead_textures)
+		FreeTexture(textures.find(texID));
+	dead_textures.clear();
+}
+
+void TextureCache::MakeRangeDynamic(u32 start_address, u32 size)
+{
+	static std::vector<u32> texIDs;
+	GetTexturesInRange(start_address, size, &texIDs);
 
-	for (; iter != tcend; ++iter)
+	for (u32 texID : texIDs)
 	{
-		const int rangePosition = iter->second->IntersectsMemoryRange(start_address, size);
-		if (0 == rangePosition)
-		{
-			iter->second->SetHashes(TEXHASH_INVALID);
-		}
+		auto tex = textures.find(texID);
+		if (tex != textures.end())
+			tex->second->SetHashes(TEXHASH_INVALID);
 	}
+	texIDs.clear();
 }
 
 bool TextureCache::Find(u32 start_address, u64 hash)
 {
-	TexCache::iterator iter = textures.lower_bound(start_address);
-
-	if (iter->second->hash == hash)
-		return true;
+	auto range = textures_by_address.equal_range(start_address);
+	for (auto iter = range.first; iter != range.second; ++iter)
+	{
+		auto tex = textures.find(iter->second);
+		if (tex != textures.end() && tex->second->hash == hash)
+			return true;
+	}
 
 	return false;
 }
@@ -201,21 +249,13 @@ int TextureCache::TCacheEntryBase::IntersectsMemoryRange(u32 range_address, u32
 
 void TextureCache::ClearRenderTargets()
 {
-	TexCache::iterator
-		iter = textures.begin(),
-		tcend = textures.end();
-
-	while (iter != tcend)
+	TexCache::iterator iter = textures.begin();
+	while (iter != textures.end())
 	{
 		if (iter->second->type == TCET_EC_VRAM)
-		{
-			delete iter->second;
-			textures.erase(iter++);
-		}
+			iter = FreeTexture(iter);
 		else
-		{
 			++iter;
-		}
 	}
 }
 
@@ -317,6 +357,28 @@ static u32 CalculateLevelSize(u32 level_0_size, u32 level)
 	return (level_0_size + ((1 << level) - 1)) >> level;
 }
 
+// Size of a decoded texture level as handed to the backend, for statistics
+static int GetUploadSize(PC_TexFormat pcfmt, u32 width, u32 height)
+{
+	switch (pcfmt)
+	{
+	case PC_TEX_FMT_BGRA32:
+	case PC_TEX_FMT_RGBA32:
+		return width * height * 4;
+	case PC_TEX_FMT_IA4_AS_IA8:
+	case PC_TEX_FMT_IA8:
+	case PC_TEX_FMT_RGB565:
+		return width * height * 2;
+	case PC_TEX_FMT_I4_AS_I8:
+	case PC_TEX_FMT_I8:
+		return width * height;
+	case PC_TEX_FMT_DXT1:
+		return width * height / 2;
+	default:
+		return 0;
+	}
+}
+
 // Used by TextureCache::Load
 static TextureCache::TCacheEntryBase* ReturnEntry(unsigned int stage, TextureCache::TCacheEntryBase* entry)
 {
@@ -364,6 +426,10 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 	else
 		src_data = Memory::GetPointer(address);
 
+	// Only worth the two timer reads when the statistics are on screen.
+	const bool time_hashing = g_ActiveConfig.bOverlayStats;
+	const u64 hash_start_time = time_hashing ? Common::Timer::GetTimeUs() : 0;
+
 	// TODO: This doesn't hash GB tiles for preloaded RGBA8 textures (instead, it's hashing more data from the low tmem bank than it should)
 	tex_hash = GetHash64(src_data, texture_size, g_ActiveConfig.iSafeTextureCache_ColorSamples);
 	if (isPaletteTexture)
@@ -384,12 +450,16 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 		tex_hash ^= tlut_hash;
 	}
 
+	if (time_hashing)
+		ADDSTAT(stats.thisFrame.usTextureHashing, (int)(Common::Timer::GetTimeUs() - hash_start_time));
+
 	// D3D doesn't like when the specified mipmap count would require more than one 1x1-sized LOD in the mipmap chain
 	// e.g. 64x64 with 7 LODs would have the mipmap chain 64x64,32x32,16x16,8x8,4x4,2x2,1x1,1x1, so we limit the mipmap count to 6 there
 	while (g_ActiveConfig.backend_info.bUseMinimalMipCount && max(expandedWidth, expandedHeight) >> maxlevel == 0)
 		--maxlevel;
 
-	TCacheEntryBase *entry = textures[texID];
+	TexCache::iterator iter = textures.find(texID);
+	TCacheEntryBase *entry = (iter != textures.end()) ? iter->second : nullptr;
 	if (entry)
 	{
 		// 1. Calculate reference hash:
@@ -405,6 +475,7 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 			// TODO: Print a warning if the format changes! In this case,
 			// we could reinterpret the internal texture object data to the new pixel format
 			// (similar to what is already being done in Renderer::ReinterpretPixelFormat())
+			INCSTAT(stats.thisFrame.numTextureCacheHits);
 			return ReturnEntry(stage, entry);
 		}
 
@@ -412,6 +483,7 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 		if (address == entry->addr && tex_hash == entry->hash && full_format == entry->format &&
 			entry->num_mipmaps > maxlevel && entry->native_width == nativeW && entry->native_height == nativeH)
 		{
+			INCSTAT(stats.thisFrame.numTextureCacheHits);
 			return ReturnEntry(stage, entry);
 		}
 
@@ -434,11 +506,13 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 		else
 		{
 			// delete the texture and make a new one
-			delete entry;
+			FreeTexture(iter);
 			entry = nullptr;
 		}
 	}
 
+	INCSTAT(stats.thisFrame.numTextureCacheMisses);
+
 	bool using_custom_texture = false;
 
 	if (g_ActiveConfig.bHiresTextures)
@@ -455,7 +529,7 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 				// If we thought we could reuse the texture before, make sure to pool it now!
 				if (entry)
 				{
-					delete entry;
+					FreeTexture(textures.find(texID));
 					entry = nullptr;
 				}
 			}
@@ -504,9 +578,14 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 	{
 		// load texture (CreateTexture also loads level 0)
 		entry->Load(width, height, expandedWidth, 0);
+
+		// the entry's address and size may change below
+		UnlinkFromAddressIndex(texID, entry);
 	}
+	ADDSTAT(stats.thisFrame.bytesTextureUploaded, GetUploadSize(pcfmt, expandedWidth, expandedHeight));
 
 	entry->SetGeneralParameters(address, texture_size, full_format, entry->num_mipmaps);
+	LinkToAddressIndex(texID, entry);
 	entry->SetDimensions(nativeW, nativeH, width, height);
 	entry->hash = tex_hash;
 
@@ -548,6 +627,7 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 				mip_src_data += TexDecoder_GetTextureSizeInBytes(expanded_mip_width, expanded_mip_height, texformat);
 
 				entry->Load(mip_width, mip_height, expanded_mip_width, level);
+				ADDSTAT(stats.thisFrame.bytesTextureUploaded, GetUploadSize(pcfmt, expanded_mip_width, expanded_mip_height));
 
 				if (g_ActiveConfig.bDumpTextures)
 					DumpTexture(entry, level);
@@ -562,6 +642,7 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 
 				LoadCustomTexture(tex_hash, texformat, level, mip_width, mip_height);
 				entry->Load(mip_width, mip_height, mip_width, level);
+				ADDSTAT(stats.thisFrame.bytesTextureUploaded, GetUploadSize(pcfmt, mip_width, mip_height));
 			}
 		}
 	}
@@ -854,7 +935,8 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 	unsigned int scaled_tex_h = g_ActiveConfig.bCopyEFBScaled ? Renderer::EFBToScaledY(tex_h) : tex_h;
 
 
-	TCacheEntryBase *entry = textures[dstAddr];
+	TexCache::iterator iter = textures.find(dstAddr);
+	TCacheEntryBase *entry = (iter != textures.end()) ? iter->second : nullptr;
 	if (entry)
 	{
 		if (entry->type == TCET_EC_DYNAMIC && entry->native_width == tex_w && entry->native_height == tex_h)
@@ -865,7 +947,7 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 		else if (!(entry->type == TCET_EC_VRAM && entry->virtual_width == scaled_tex_w && entry->virtual_height == scaled_tex_h))
 		{
 			// remove it and recreate it as a render target
-			delete entry;
+			FreeTexture(iter);
 			entry = nullptr;
 		}
 	}
@@ -877,6 +959,7 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 
 		// TODO: Using the wrong dstFormat, dumb...
 		entry->SetGeneralParameters(dstAddr, 0, dstFormat, 1);
+		LinkToAddressIndex(dstAddr, entry);
 		entry->SetDimensions(tex_w, tex_h, scaled_tex_w, scaled_tex_h);
 		entry->SetHashes(TEXHASH_INVALID);
 		entry->type = TCET_EC_VRAM;
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <map>
+#include <unordered_map>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/Thread.h"
@@ -119,9 +121,22 @@ private:
 	static PC_TexFormat LoadCustomTexture(u64 tex_hash, int texformat, unsigned int level, unsigned int& width, unsigned int& height);
 	static void DumpTexture(TCacheEntryBase* entry, unsigned int level);
 
-	typedef std::map<u32, TCacheEntryBase*> TexCache;
+	typedef std::unordered_map<u32, TCacheEntryBase*> TexCache;
+	// Maps the RAM address an entry's data was loaded from to its key in textures,
+	// so that range invalidations only have to look at nearby entries
+	typedef std::multimap<u32, u32> TexAddressIndex;
+
+	static void LinkToAddressIndex(u32 texID, TCacheEntryBase* entry);
+	static void UnlinkFromAddressIndex(u32 texID, TCacheEntryBase* entry);
+	static void GetTexturesInRange(u32 start_address, u32 size, std::vector<u32>* texIDs);
+	static TexCache::iterator FreeTexture(TexCache::iterator iter);
 
 	static TexCache textures;
+	static TexAddressIndex textures_by_address;
+	// size_in_bytes of the largest entry in textures_by_address
+	static u32 max_texture_size;
+	// bucket of textures at which the next Cleanup call continues
+	static size_t cleanup_bucket;
 
 	// Backup configuration values
 	static struct BackupConfig
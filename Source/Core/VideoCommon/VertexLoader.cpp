@@ -3,6 +3,8 @@
 // Refer to the license.txt file included.
 
 #include "Common/Common.h"
+#include "Common/CPUDetect.h"
+#include "Common/JitRegister.h"
 #include "Common/MemoryUtil.h"
 #include "Common/StringUtil.h"
 #include "Common/x64ABI.h"
@@ -29,7 +31,7 @@
 //BBox
 #include "VideoCommon/XFMemory.h"
 
-#define COMPILED_CODE_SIZE 4096
+#define COMPILED_CODE_SIZE 8192
 
 NativeVertexFormat *g_nativeVertexFmt;
 
@@ -84,6 +86,45 @@ static const float fractionTable[32] = {
 
 using namespace Gen;
 
+#ifdef USE_INLINE_VERTEX_LOADER_JIT
+// The inlined loaders keep the source and destination pointers and the vertex
+// counter in callee saved registers for the whole batch.
+static const X64Reg SRC_REG = R12;
+static const X64Reg DST_REG = R13;
+static const X64Reg COUNT_REG = R14;
+
+static const int s_formatSizes[5] = { 1, 1, 2, 2, 4 };
+
+static const float s_normalScales[5] = {
+	1.0f / (1U << 7), 1.0f / (1U << 6), 1.0f / (1U << 15), 1.0f / (1U << 14), 1.0f
+};
+
+// PSHUFB masks that byteswap 1-3 big endian values of each format into the top
+// of their own 32-bit lane, so a single shift sign- or zero-extends them all.
+static GC_ALIGNED16(u8 s_swapMasks[5][3][16]);
+
+static void InitSwapMasks()
+{
+	for (int format = 0; format < 5; ++format)
+	{
+		const int size = s_formatSizes[format];
+		for (int count = 1; count <= 3; ++count)
+		{
+			u8* mask = s_swapMasks[format][count - 1];
+			for (int i = 0; i < 16; ++i)
+			{
+				const int lane = i / 4;
+				const int byte = i % 4;
+				if (lane < count && byte >= 4 - size)
+					mask[i] = lane * size + (3 - byte);
+				else
+					mask[i] = 0x80;
+			}
+		}
+	}
+}
+#endif
+
 void LOADERDECL PosMtx_ReadDirect_UByte()
 {
 	s_curposmtx = DataReadU8() & 0x3f;
@@ -468,6 +509,9 @@ VertexLoader::VertexLoader(const TVtxDesc &vtx_desc, const VAT &vtx_attr)
 	VertexLoader_Normal::Init();
 	VertexLoader_Position::Init();
 	VertexLoader_TextCoord::Init();
+#ifdef USE_INLINE_VERTEX_LOADER_JIT
+	InitSwapMasks();
+#endif
 
 	m_VtxDesc = vtx_desc;
 	SetVAT(vtx_attr.g0.Hex, vtx_attr.g1.Hex, vtx_attr.g2.Hex);
@@ -496,6 +540,12 @@ void VertexLoader::CompileVertexTranslator()
 	m_VertexSize = 0;
 	const TVtxAttr &vtx_attr = m_VtxAttr;
 
+#ifdef USE_INLINE_VERTEX_LOADER_JIT
+	m_inlineJit = CanInlineJit();
+#else
+	m_inlineJit = false;
+#endif
+
 #ifdef USE_VERTEX_LOADER_JIT
 	if (m_compiledCode)
 		PanicAlert("Trying to recompile a vertex translator");
@@ -503,24 +553,40 @@ void VertexLoader::CompileVertexTranslator()
 	m_compiledCode = GetCodePtr();
 	ABI_PushAllCalleeSavedRegsAndAdjustStack();
 
+#ifdef USE_INLINE_VERTEX_LOADER_JIT
+	if (m_inlineJit)
+	{
+		MOV(64, R(RAX), Imm64((u64)&g_pVideoData));
+		MOV(64, R(SRC_REG), MatR(RAX));
+		MOV(64, R(RAX), Imm64((u64)&VertexManager::s_pCurBufferPointer));
+		MOV(64, R(DST_REG), MatR(RAX));
+		MOV(64, R(RAX), Imm64((u64)&loop_counter));
+		MOV(32, R(COUNT_REG), MatR(RAX));
+	}
+#endif
+
 	// Start loop here
 	const u8 *loop_start = GetCodePtr();
 
 	// Reset component counters if present in vertex format only.
-	if (m_VtxDesc.Tex0Coord || m_VtxDesc.Tex1Coord || m_VtxDesc.Tex2Coord || m_VtxDesc.Tex3Coord ||
-		m_VtxDesc.Tex4Coord || m_VtxDesc.Tex5Coord || m_VtxDesc.Tex6Coord || m_VtxDesc.Tex7Coord)
-	{
-		WriteSetVariable(32, &tcIndex, Imm32(0));
-	}
-	if (m_VtxDesc.Color0 || m_VtxDesc.Color1)
+	// The inlined loaders work these out while compiling instead.
+	if (!m_inlineJit)
 	{
-		WriteSetVariable(32, &colIndex, Imm32(0));
-	}
-	if (m_VtxDesc.Tex0MatIdx || m_VtxDesc.Tex1MatIdx || m_VtxDesc.Tex2MatIdx || m_VtxDesc.Tex3MatIdx ||
-		m_VtxDesc.Tex4MatIdx || m_VtxDesc.Tex5MatIdx || m_VtxDesc.Tex6MatIdx || m_VtxDesc.Tex7MatIdx)
-	{
-		WriteSetVariable(32, &s_texmtxwrite, Imm32(0));
-		WriteSetVariable(32, &s_texmtxread, Imm32(0));
+		if (m_VtxDesc.Tex0Coord || m_VtxDesc.Tex1Coord || m_VtxDesc.Tex2Coord || m_VtxDesc.Tex3Coord ||
+			m_VtxDesc.Tex4Coord || m_VtxDesc.Tex5Coord || m_VtxDesc.Tex6Coord || m_VtxDesc.Tex7Coord)
+		{
+			WriteSetVariable(32, &tcIndex, Imm32(0));
+		}
+		if (m_VtxDesc.Color0 || m_VtxDesc.Color1)
+		{
+			WriteSetVariable(32, &colIndex, Imm32(0));
+		}
+		if (m_VtxDesc.Tex0MatIdx || m_VtxDesc.Tex1MatIdx || m_VtxDesc.Tex2MatIdx || m_VtxDesc.Tex3MatIdx ||
+			m_VtxDesc.Tex4MatIdx || m_VtxDesc.Tex5MatIdx || m_VtxDesc.Tex6MatIdx || m_VtxDesc.Tex7MatIdx)
+		{
+			WriteSetVariable(32, &s_texmtxwrite, Imm32(0));
+			WriteSetVariable(32, &s_texmtxread, Imm32(0));
+		}
 	}
 #else
 	// Reset pipeline
@@ -545,22 +611,33 @@ void VertexLoader::CompileVertexTranslator()
 	PortableVertexDeclaration vtx_decl;
 	memset(&vtx_decl, 0, sizeof(vtx_decl));
 
+	// Where the matrix indices are in the GC vertex, for the inlined loaders
+	int texmtx_offset[8] = {};
+
 	// Position Matrix Index
 	if (m_VtxDesc.PosMatIdx)
 	{
-		WriteCall(PosMtx_ReadDirect_UByte);
+		if (!m_inlineJit)
+			WriteCall(PosMtx_ReadDirect_UByte);
 		components |= VB_HAS_POSMTXIDX;
 		m_VertexSize += 1;
 	}
 
-	if (m_VtxDesc.Tex0MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX0; WriteCall(TexMtx_ReadDirect_UByte); }
-	if (m_VtxDesc.Tex1MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX1; WriteCall(TexMtx_ReadDirect_UByte); }
-	if (m_VtxDesc.Tex2MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX2; WriteCall(TexMtx_ReadDirect_UByte); }
-	if (m_VtxDesc.Tex3MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX3; WriteCall(TexMtx_ReadDirect_UByte); }
-	if (m_VtxDesc.Tex4MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX4; WriteCall(TexMtx_ReadDirect_UByte); }
-	if (m_VtxDesc.Tex5MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX5; WriteCall(TexMtx_ReadDirect_UByte); }
-	if (m_VtxDesc.Tex6MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX6; WriteCall(TexMtx_ReadDirect_UByte); }
-	if (m_VtxDesc.Tex7MatIdx) {m_VertexSize += 1; components |= VB_HAS_TEXMTXIDX7; WriteCall(TexMtx_ReadDirect_UByte); }
+	const u32 texmtx[8] = {
+		m_VtxDesc.Tex0MatIdx, m_VtxDesc.Tex1MatIdx, m_VtxDesc.Tex2MatIdx, m_VtxDesc.Tex3MatIdx,
+		m_VtxDesc.Tex4MatIdx, m_VtxDesc.Tex5MatIdx, m_VtxDesc.Tex6MatIdx, m_VtxDesc.Tex7MatIdx
+	};
+	for (int i = 0; i < 8; i++)
+	{
+		if (texmtx[i])
+		{
+			texmtx_offset[i] = m_VertexSize;
+			m_VertexSize += 1;
+			components |= VB_HAS_TEXMTXIDX0 << i;
+			if (!m_inlineJit)
+				WriteCall(TexMtx_ReadDirect_UByte);
+		}
+	}
 
 	// Write vertex position loader
 	if (g_ActiveConfig.bUseBBox)
@@ -569,6 +646,15 @@ void VertexLoader::CompileVertexTranslator()
 		WriteCall(VertexLoader_Position::GetFunction(m_VtxDesc.Position, m_VtxAttr.PosFormat, m_VtxAttr.PosElements));
 		WriteCall(UpdateBoundingBox);
 	}
+	else if (m_inlineJit)
+	{
+#ifdef USE_INLINE_VERTEX_LOADER_JIT
+		OpArg data = m_VtxDesc.Position == DIRECT ? MDisp(SRC_REG, m_VertexSize) :
+			WriteIndexedAddress(ARRAY_POSITION, m_VtxDesc.Position, m_VertexSize, 0);
+		WriteLoadValues(data, m_VtxAttr.PosFormat, m_VtxAttr.PosElements ? 3 : 2, &posScale);
+		WriteStoreValues(0, 3);
+#endif
+	}
 	else
 	{
 		WriteCall(VertexLoader_Position::GetFunction(m_VtxDesc.Position, m_VtxAttr.PosFormat, m_VtxAttr.PosElements));
@@ -584,20 +670,29 @@ void VertexLoader::CompileVertexTranslator()
 	// Normals
 	if (m_VtxDesc.Normal != NOT_PRESENT)
 	{
-		m_VertexSize += VertexLoader_Normal::GetSize(m_VtxDesc.Normal,
-			m_VtxAttr.NormalFormat, m_VtxAttr.NormalElements, m_VtxAttr.NormalIndex3);
-
-		TPipelineFunction pFunc = VertexLoader_Normal::GetFunction(m_VtxDesc.Normal,
-			m_VtxAttr.NormalFormat, m_VtxAttr.NormalElements, m_VtxAttr.NormalIndex3);
-
-		if (pFunc == nullptr)
+		if (m_inlineJit)
+		{
+#ifdef USE_INLINE_VERTEX_LOADER_JIT
+			WriteInlineNormal(m_VertexSize, nat_offset);
+#endif
+		}
+		else
 		{
-			Host_SysMessage(
-				StringFromFormat("VertexLoader_Normal::GetFunction(%i %i %i %i) returned zero!",
-				m_VtxDesc.Normal, m_VtxAttr.NormalFormat,
-				m_VtxAttr.NormalElements, m_VtxAttr.NormalIndex3).c_str());
+			TPipelineFunction pFunc = VertexLoader_Normal::GetFunction(m_VtxDesc.Normal,
+				m_VtxAttr.NormalFormat, m_VtxAttr.NormalElements, m_VtxAttr.NormalIndex3);
+
+			if (pFunc == nullptr)
+			{
+				Host_SysMessage(
+					StringFromFormat("VertexLoader_Normal::GetFunction(%i %i %i %i) returned zero!",
+					m_VtxDesc.Normal, m_VtxAttr.NormalFormat,
+					m_VtxAttr.NormalElements, m_VtxAttr.NormalIndex3).c_str());
+			}
+			WriteCall(pFunc);
 		}
-		WriteCall(pFunc);
+
+		m_VertexSize += VertexLoader_Normal::GetSize(m_VtxDesc.Normal,
+			m_VtxAttr.NormalFormat, m_VtxAttr.NormalElements, m_VtxAttr.NormalIndex3);
 
 		for (int i = 0; i < (vtx_attr.NormalElements ? 3 : 1); i++)
 		{
@@ -614,12 +709,26 @@ void VertexLoader::CompileVertexTranslator()
 			components |= VB_HAS_NRM1 | VB_HAS_NRM2;
 	}
 
+	// The C loaders count the colors as they go and pick the array and element
+	// count by that, not by which color it is.
+	int col_index = 0;
 	for (int i = 0; i < 2; i++)
 	{
 		vtx_decl.colors[i].components = 4;
 		vtx_decl.colors[i].type = VAR_UNSIGNED_BYTE;
 		vtx_decl.colors[i].integer = false;
-		switch (col[i])
+
+		if (col[i] != NOT_PRESENT && m_inlineJit)
+		{
+#ifdef USE_INLINE_VERTEX_LOADER_JIT
+			static const int direct_sizes[6] = { 2, 3, 4, 2, 3, 4 };
+
+			WriteInlineColor(m_VtxAttr.color[i].Comp, col[i], ARRAY_COLOR + col_index,
+				m_VtxAttr.color[col_index].Elements, m_VertexSize, nat_offset);
+			m_VertexSize += col[i] == DIRECT ? direct_sizes[m_VtxAttr.color[i].Comp] : (col[i] == INDEX8 ? 1 : 2);
+#endif
+		}
+		else switch (col[i])
 		{
 		case NOT_PRESENT:
 			break;
@@ -669,6 +778,7 @@ void VertexLoader::CompileVertexTranslator()
 			vtx_decl.colors[i].offset = nat_offset;
 			vtx_decl.colors[i].enable = true;
 			nat_offset += 4;
+			col_index++;
 		}
 	}
 
@@ -693,7 +803,19 @@ void VertexLoader::CompileVertexTranslator()
 			_assert_msg_(VIDEO, 0 <= elements && elements <= 1, "Invalid number of texture coordinates elements!\n(elements = %d)", elements);
 
 			components |= VB_HAS_UV0 << i;
-			WriteCall(VertexLoader_TextCoord::GetFunction(tc[i], format, elements));
+			if (m_inlineJit)
+			{
+#ifdef USE_INLINE_VERTEX_LOADER_JIT
+				OpArg data = tc[i] == DIRECT ? MDisp(SRC_REG, m_VertexSize) :
+					WriteIndexedAddress(ARRAY_TEXCOORD0 + i, tc[i], m_VertexSize, 0);
+				WriteLoadValues(data, format, elements ? 2 : 1, &tcScale[i]);
+				WriteStoreValues(nat_offset, elements ? 2 : 1);
+#endif
+			}
+			else
+			{
+				WriteCall(VertexLoader_TextCoord::GetFunction(tc[i], format, elements));
+			}
 			m_VertexSize += VertexLoader_TextCoord::GetSize(tc[i], format, elements);
 		}
 
@@ -704,15 +826,38 @@ void VertexLoader::CompileVertexTranslator()
 			{
 				// if texmtx is included, texcoord will always be 3 floats, z will be the texmtx index
 				vtx_decl.texcoords[i].components = 3;
+				if (m_inlineJit)
+				{
+#ifdef USE_INLINE_VERTEX_LOADER_JIT
+					if (!elements)
+						MOV(32, MDisp(DST_REG, nat_offset + 4), Imm32(0));
+					WriteInlineTexMtx(texmtx_offset[i], nat_offset + 8);
+#endif
+				}
+				else
+				{
+					WriteCall(m_VtxAttr.texCoord[i].Elements ? TexMtx_Write_Float : TexMtx_Write_Float2);
+				}
 				nat_offset += 12;
-				WriteCall(m_VtxAttr.texCoord[i].Elements ? TexMtx_Write_Float : TexMtx_Write_Float2);
 			}
 			else
 			{
 				components |= VB_HAS_UV0 << i; // have to include since using now
 				vtx_decl.texcoords[i].components = 4;
+				if (m_inlineJit)
+				{
+#ifdef USE_INLINE_VERTEX_LOADER_JIT
+					MOV(32, MDisp(DST_REG, nat_offset), Imm32(0));
+					MOV(32, MDisp(DST_REG, nat_offset + 4), Imm32(0));
+					WriteInlineTexMtx(texmtx_offset[i], nat_offset + 8);
+					MOV(32, MDisp(DST_REG, nat_offset + 12), Imm32(0));
+#endif
+				}
+				else
+				{
+					WriteCall(TexMtx_Write_Float4);
+				}
 				nat_offset += 16; // still include the texture coordinate, but this time as 6 + 2 bytes
-				WriteCall(TexMtx_Write_Float4);
 			}
 		}
 		else
@@ -733,7 +878,8 @@ void VertexLoader::CompileVertexTranslator()
 			{
 				if (tc[j] != NOT_PRESENT)
 				{
-					WriteCall(VertexLoader_TextCoord::GetDummyFunction()); // important to get indices right!
+					if (!m_inlineJit)
+						WriteCall(VertexLoader_TextCoord::GetDummyFunction()); // important to get indices right!
 					break;
 				}
 			}
@@ -748,7 +894,19 @@ void VertexLoader::CompileVertexTranslator()
 
 	if (m_VtxDesc.PosMatIdx)
 	{
-		WriteCall(PosMtx_Write);
+		if (m_inlineJit)
+		{
+#ifdef USE_INLINE_VERTEX_LOADER_JIT
+			// The index is the first byte of the vertex
+			MOVZX(32, 8, EAX, MatR(SRC_REG));
+			AND(32, R(EAX), Imm8(0x3f));
+			MOV(32, MDisp(DST_REG, nat_offset), R(EAX));
+#endif
+		}
+		else
+		{
+			WriteCall(PosMtx_Write);
+		}
 		vtx_decl.posmtx.components = 4;
 		vtx_decl.posmtx.enable = true;
 		vtx_decl.posmtx.offset = nat_offset;
@@ -762,16 +920,40 @@ void VertexLoader::CompileVertexTranslator()
 
 #ifdef USE_VERTEX_LOADER_JIT
 	// End loop here
+	if (m_inlineJit)
+	{
+#ifdef USE_INLINE_VERTEX_LOADER_JIT
+		ADD(64, R(SRC_REG), Imm32(m_VertexSize));
+		ADD(64, R(DST_REG), Imm32(native_stride));
+		SUB(32, R(COUNT_REG), Imm8(1));
+		J_CC(CC_NZ, loop_start, true);
+
+		MOV(64, R(RAX), Imm64((u64)&g_pVideoData));
+		MOV(64, MatR(RAX), R(SRC_REG));
+		MOV(64, R(RAX), Imm64((u64)&VertexManager::s_pCurBufferPointer));
+		MOV(64, MatR(RAX), R(DST_REG));
+#endif
+	}
+	else
+	{
 #if _M_X86_64
-	MOV(64, R(RAX), Imm64((u64)&loop_counter));
-	SUB(32, MatR(RAX), Imm8(1));
+		MOV(64, R(RAX), Imm64((u64)&loop_counter));
+		SUB(32, MatR(RAX), Imm8(1));
 #else
-	SUB(32, M(&loop_counter), Imm8(1));
+		SUB(32, M(&loop_counter), Imm8(1));
 #endif
+		J_CC(CC_NZ, loop_start, true);
+	}
 
-	J_CC(CC_NZ, loop_start, true);
 	ABI_PopAllCalleeSavedRegsAndAdjustStack();
 	RET();
+
+	if (JitRegister::IsEnabled())
+	{
+		std::string name;
+		AppendToString(&name);
+		JitRegister::Register(m_compiledCode, (u32)(GetCodePtr() - m_compiledCode), "JIT_VertexLoader %s", name.c_str());
+	}
 #endif
 	m_NativeFmt = g_vertex_manager->CreateNativeVertexFormat();
 	m_NativeFmt->m_components = components;
@@ -791,6 +973,224 @@ void VertexLoader::WriteCall(TPipelineFunction func)
 	m_PipelineStages[m_numPipelineStages++] = func;
 #endif
 }
+#ifdef USE_INLINE_VERTEX_LOADER_JIT
+bool VertexLoader::CanInlineJit() const
+{
+	// Bounding box emulation hooks into the position loader, so it keeps the calls.
+	if (!cpu_info.bSSSE3 || g_ActiveConfig.bUseBBox)
+		return false;
+
+	if (m_VtxDesc.Position == NOT_PRESENT || m_VtxAttr.PosFormat > FORMAT_FLOAT)
+		return false;
+
+	if (m_VtxDesc.Normal != NOT_PRESENT && m_VtxAttr.NormalFormat > FORMAT_FLOAT)
+		return false;
+
+	const u32 col[2] = {m_VtxDesc.Color0, m_VtxDesc.Color1};
+	for (int i = 0; i < 2; i++)
+	{
+		if (col[i] != NOT_PRESENT && m_VtxAttr.color[i].Comp > FORMAT_32B_8888)
+			return false;
+	}
+
+	const u32 tc[8] = {
+		m_VtxDesc.Tex0Coord, m_VtxDesc.Tex1Coord, m_VtxDesc.Tex2Coord, m_VtxDesc.Tex3Coord,
+		m_VtxDesc.Tex4Coord, m_VtxDesc.Tex5Coord, m_VtxDesc.Tex6Coord, (u32)((m_VtxDesc.Hex >> 31) & 3)
+	};
+	for (int i = 0; i < 8; i++)
+	{
+		if (tc[i] != NOT_PRESENT && m_VtxAttr.texCoord[i].Format > FORMAT_FLOAT)
+			return false;
+	}
+
+	return true;
+}
+
+// Leaves the address of the indexed array element in RCX and returns it plus data_offset.
+OpArg VertexLoader::WriteIndexedAddress(int array, int index_type, int src_offset, int data_offset)
+{
+	if (index_type == INDEX8)
+	{
+		MOVZX(32, 8, EAX, MDisp(SRC_REG, src_offset));
+	}
+	else
+	{
+		MOVZX(32, 16, EAX, MDisp(SRC_REG, src_offset));
+		ROL(16, R(EAX), Imm8(8));
+	}
+	MOV(64, R(RCX), Imm64((u64)&arraystrides[array]));
+	IMUL(32, EAX, MatR(RCX));
+	MOV(64, R(RCX), Imm64((u64)&cached_arraybases[array]));
+	MOV(64, R(RCX), MatR(RCX));
+	ADD(64, R(RCX), R(RAX));
+	return MDisp(RCX, data_offset);
+}
+
+// Loads count big endian values into XMM0 as floats, multiplied by *scale unless
+// they already are floats. Only uses RAX, so a base address in RCX survives.
+// Values narrower than 4 bytes may read up to 3 bytes past the attribute.
+void VertexLoader::WriteLoadValues(OpArg data, int format, int count, const float *scale)
+{
+	const int size = s_formatSizes[format];
+	const int bytes = size * count;
+
+	if (bytes <= 4)
+	{
+		MOVD_xmm(XMM0, data);
+	}
+	else if (bytes <= 8)
+	{
+		MOVQ_xmm(XMM0, data);
+	}
+	else
+	{
+		MOVQ_xmm(XMM0, data);
+		data.offset += 8;
+		MOVSS(XMM1, data);
+		UNPCKLPD(XMM0, R(XMM1));
+	}
+
+	MOV(64, R(RAX), Imm64((u64)s_swapMasks[format][count - 1]));
+	PSHUFB(XMM0, MatR(RAX));
+
+	if (format != FORMAT_FLOAT)
+	{
+		const int shift = 32 - 8 * size;
+		if (format == FORMAT_BYTE || format == FORMAT_SHORT)
+			PSRAD(XMM0, shift);
+		else
+			PSRLD(XMM0, shift);
+		CVTDQ2PS(XMM0, R(XMM0));
+
+		MOV(64, R(RAX), Imm64((u64)scale));
+		MOVSS(XMM1, MatR(RAX));
+		SHUFPS(XMM1, R(XMM1), 0);
+		MULPS(XMM0, R(XMM1));
+	}
+}
+
+void VertexLoader::WriteStoreValues(int dst_offset, int count)
+{
+	if (count == 1)
+	{
+		MOVSS(MDisp(DST_REG, dst_offset), XMM0);
+	}
+	else
+	{
+		MOVQ_xmm(MDisp(DST_REG, dst_offset), XMM0);
+		if (count == 3)
+		{
+			SHUFPS(XMM0, R(XMM0), 2);
+			MOVSS(MDisp(DST_REG, dst_offset + 8), XMM0);
+		}
+	}
+}
+
+void VertexLoader::WriteInlineNormal(int src_offset, int dst_offset)
+{
+	const int format = m_VtxAttr.NormalFormat;
+	const int size = s_formatSizes[format];
+	const int index_size = m_VtxDesc.Normal == INDEX16 ? 2 : 1;
+	const bool nbt3 = m_VtxAttr.NormalElements != 0;
+	const bool indices3 = nbt3 && m_VtxAttr.NormalIndex3;
+
+	// Without separate indices all three normals come from one array element.
+	if (m_VtxDesc.Normal != DIRECT && !indices3)
+		WriteIndexedAddress(ARRAY_NORMAL, m_VtxDesc.Normal, src_offset, 0);
+
+	for (int i = 0; i < (nbt3 ? 3 : 1); i++)
+	{
+		OpArg data;
+		if (m_VtxDesc.Normal == DIRECT)
+			data = MDisp(SRC_REG, src_offset + i * 3 * size);
+		else if (indices3)
+			data = WriteIndexedAddress(ARRAY_NORMAL, m_VtxDesc.Normal, src_offset + i * index_size, i * 3 * size);
+		else
+			data = MDisp(RCX, i * 3 * size);
+
+		WriteLoadValues(data, format, 3, &s_normalScales[format]);
+		WriteStoreValues(dst_offset + i * 12, 3);
+	}
+}
+
+// dest |= (src << shift) & mask, negative shifts go right. Clobbers EDX.
+void VertexLoader::WriteShiftMaskOr(X64Reg dest, X64Reg src, int shift, u32 mask)
+{
+	MOV(32, R(EDX), R(src));
+	if (shift > 0)
+		SHL(32, R(EDX), Imm8(shift));
+	else if (shift < 0)
+		SHR(32, R(EDX), Imm8(-shift));
+	if (mask != 0xFFFFFFFF)
+		AND(32, R(EDX), Imm32(mask));
+	OR(32, R(dest), R(EDX));
+}
+
+// Same conversions as VertexLoader_Color, computed in EAX.
+void VertexLoader::WriteInlineColor(int comp, int mode, int array, int elements, int src_offset, int dst_offset)
+{
+	// 6666 is read as a big endian word that ends with the color
+	const int data_offset = comp == FORMAT_24B_6666 ? -1 : 0;
+	OpArg data = mode == DIRECT ? MDisp(SRC_REG, src_offset + data_offset) :
+		WriteIndexedAddress(array, mode, src_offset, data_offset);
+
+	switch (comp)
+	{
+	case FORMAT_16B_565:
+		MOVZX(32, 16, ECX, data);
+		ROL(16, R(ECX), Imm8(8));
+		XOR(32, R(EAX), R(EAX));
+		WriteShiftMaskOr(EAX, ECX, -8, 0xF8);
+		WriteShiftMaskOr(EAX, ECX, 5, 0xFC00);
+		WriteShiftMaskOr(EAX, ECX, 19, 0xF80000);
+		WriteShiftMaskOr(EAX, EAX, -5, 0x070007);
+		WriteShiftMaskOr(EAX, EAX, -6, 0x000300);
+		OR(32, R(EAX), Imm32(0xFF000000));
+		break;
+	case FORMAT_24B_888:
+	case FORMAT_32B_888x:
+		MOV(32, R(EAX), data);
+		OR(32, R(EAX), Imm32(0xFF000000));
+		break;
+	case FORMAT_16B_4444:
+		MOVZX(32, 16, ECX, data);
+		XOR(32, R(EAX), R(EAX));
+		WriteShiftMaskOr(EAX, ECX, 0, 0xF0);
+		WriteShiftMaskOr(EAX, ECX, 12, 0xF000);
+		WriteShiftMaskOr(EAX, ECX, 8, 0xF00000);
+		WriteShiftMaskOr(EAX, ECX, 20, 0xF0000000);
+		WriteShiftMaskOr(EAX, EAX, -4, 0xFFFFFFFF);
+		break;
+	case FORMAT_24B_6666:
+		MOV(32, R(ECX), data);
+		BSWAP(32, ECX);
+		XOR(32, R(EAX), R(EAX));
+		WriteShiftMaskOr(EAX, ECX, -16, 0xFC);
+		WriteShiftMaskOr(EAX, ECX, -2, 0xFC00);
+		WriteShiftMaskOr(EAX, ECX, 12, 0xFC0000);
+		WriteShiftMaskOr(EAX, ECX, 26, 0xFC000000);
+		WriteShiftMaskOr(EAX, EAX, -6, 0x03030303);
+		break;
+	case FORMAT_32B_8888:
+		MOV(32, R(EAX), data);
+		// only the direct loader "kills" the alpha
+		if (mode == DIRECT && !elements)
+			OR(32, R(EAX), Imm32(0xFF000000));
+		break;
+	}
+
+	MOV(32, MDisp(DST_REG, dst_offset), R(EAX));
+}
+
+void VertexLoader::WriteInlineTexMtx(int texmtx_offset, int dst_offset)
+{
+	MOVZX(32, 8, EAX, MDisp(SRC_REG, texmtx_offset));
+	AND(32, R(EAX), Imm8(0x3f));
+	MOVD_xmm(XMM0, R(EAX));
+	CVTDQ2PS(XMM0, R(XMM0));
+	MOVSS(MDisp(DST_REG, dst_offset), XMM0);
+}
+#endif
 // ARMTODO: This should be done in a better way
 #ifndef _M_GENERIC
 void VertexLoader::WriteGetVariable(int bits, OpArg dest, void *address)
@@ -879,13 +1279,13 @@ void VertexLoader::ConvertVertices ( int count )
 #endif
 }
 
-void VertexLoader::RunVertices(int vtx_attr_group, int primitive, int const count)
+bool VertexLoader::RunVertices(int vtx_attr_group, int primitive, int const count)
 {
 	if (bpmem.genMode.cullmode == 3 && primitive < 5)
 	{
 		// if cull mode is none, ignore triangles and quads
 		DataSkip(count * m_VertexSize);
-		return;
+		return false;
 	}
 	SetupRunVertices(vtx_attr_group, primitive, count);
 	VertexManager::PrepareForAdditionalData(primitive, count, native_stride);
@@ -894,6 +1294,37 @@ void VertexLoader::RunVertices(int vtx_attr_group, int primitive, int const coun
 
 	ADDSTAT(stats.thisFrame.numPrims, count);
 	INCSTAT(stats.thisFrame.numPrimitiveJoins);
+	return true;
+}
+
+void VertexLoader::RunConvertedVertices(int vtx_attr_group, int primitive, int const count, const u8* data)
+{
+	if (bpmem.genMode.cullmode == 3 && primitive < 5)
+		return;
+	SetupRunVertices(vtx_attr_group, primitive, count);
+	VertexManager::PrepareForAdditionalData(primitive, count, native_stride);
+	memcpy(VertexManager::s_pCurBufferPointer, data, count * native_stride);
+	VertexManager::s_pCurBufferPointer += count * native_stride;
+	IndexGenerator::AddIndices(primitive, count);
+
+	ADDSTAT(stats.thisFrame.numPrims, count);
+	INCSTAT(stats.thisFrame.numPrimitiveJoins);
+}
+
+bool VertexLoader::UsesIndexedArrays() const
+{
+	// Tex7Coord straddles the 32 bit boundary, see CompileVertexTranslator.
+	const u32 attributes[12] = {
+		m_VtxDesc.Position, m_VtxDesc.Normal, m_VtxDesc.Color0, m_VtxDesc.Color1,
+		m_VtxDesc.Tex0Coord, m_VtxDesc.Tex1Coord, m_VtxDesc.Tex2Coord, m_VtxDesc.Tex3Coord,
+		m_VtxDesc.Tex4Coord, m_VtxDesc.Tex5Coord, m_VtxDesc.Tex6Coord, (u32)((m_VtxDesc.Hex >> 31) & 3)
+	};
+	for (u32 attribute : attributes)
+	{
+		if (attribute == INDEX8 || attribute == INDEX16)
+			return true;
+	}
+	return false;
 }
 
 void VertexLoader::SetVAT(u32 _group0, u32 _group1, u32 _group2)
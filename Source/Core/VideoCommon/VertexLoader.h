@@ -23,6 +23,12 @@
 #endif
 #endif
 
+// On x86-64 the JIT can load all attributes with straight-line SSSE3 code
+// instead of calling the per-attribute loaders.
+#if defined(USE_VERTEX_LOADER_JIT) && _M_X86_64
+#define USE_INLINE_VERTEX_LOADER_JIT
+#endif
+
 class VertexLoaderUID
 {
 	u32 vid[5];
@@ -99,8 +105,19 @@ public:
 
 	int GetVertexSize() const {return m_VertexSize;}
 
+	int GetNativeVertexStride() const {return native_stride;}
+
+	// Whether any attribute is read from the indexed arrays rather than from
+	// the vertex itself, which makes the converted vertices depend on memory
+	// outside the command stream.
+	bool UsesIndexedArrays() const;
+
 	void SetupRunVertices(int vtx_attr_group, int primitive, int const count);
-	void RunVertices(int vtx_attr_group, int primitive, int count);
+	// Returns false if the primitives were culled and nothing was written.
+	bool RunVertices(int vtx_attr_group, int primitive, int count);
+	// Like RunVertices, but copies vertices this loader converted earlier
+	// instead of reading them from g_pVideoData.
+	void RunConvertedVertices(int vtx_attr_group, int primitive, int count, const u8* data);
 
 	// For debugging / profiling
 	void AppendToString(std::string *dest) const;
@@ -127,6 +144,10 @@ private:
 
 	int m_numLoadedVertices;
 
+	// Whether the attributes are converted by code generated inline rather than
+	// by calls to the C loaders.
+	bool m_inlineJit;
+
 	void SetVAT(u32 _group0, u32 _group1, u32 _group2);
 
 	void CompileVertexTranslator();
@@ -138,4 +159,17 @@ private:
 	void WriteGetVariable(int bits, Gen::OpArg dest, void *address);
 	void WriteSetVariable(int bits, void *address, Gen::OpArg dest);
 #endif
+
+#ifdef USE_INLINE_VERTEX_LOADER_JIT
+	// Inline code generation. Offsets are relative to the start of the current
+	// GC vertex (src) and the current native vertex (dst).
+	bool CanInlineJit() const;
+	Gen::OpArg WriteIndexedAddress(int array, int index_type, int src_offset, int data_offset);
+	void WriteLoadValues(Gen::OpArg data, int format, int count, const float *scale);
+	void WriteStoreValues(int dst_offset, int count);
+	void WriteInlineNormal(int src_offset, int dst_offset);
+	void WriteInlineColor(int comp, int mode, int array, int elements, int src_offset, int dst_offset);
+	void WriteShiftMaskOr(Gen::X64Reg dest, Gen::X64Reg src, int shift, u32 mask);
+	void WriteInlineTexMtx(int texmtx_offset, int dst_offset);
+#endif
 };
@@ -126,6 +126,11 @@ void RunVertices(int vtx_attr_group, int primitive, int count)
 	RefreshLoader(vtx_attr_group)->RunVertices(vtx_attr_group, primitive, count);
 }
 
+VertexLoader* GetLoader(int vtx_attr_group)
+{
+	return RefreshLoader(vtx_attr_group);
+}
+
 int GetVertexSize(int vtx_attr_group)
 {
 	return RefreshLoader(vtx_attr_group)->GetVertexSize();
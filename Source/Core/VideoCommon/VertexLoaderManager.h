@@ -8,6 +8,8 @@
 
 #include "Common/Common.h"
 
+class VertexLoader;
+
 namespace VertexLoaderManager
 {
 	void Init();
@@ -15,6 +17,8 @@ namespace VertexLoaderManager
 
 	void MarkAllDirty();
 
+	// The loader for the current vertex format of the group.
+	VertexLoader* GetLoader(int vtx_attr_group);
 	int GetVertexSize(int vtx_attr_group);
 	void RunVertices(int vtx_attr_group, int primitive, int count);
 
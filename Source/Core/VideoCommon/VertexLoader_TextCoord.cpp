@@ -2,6 +2,8 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <limits>
+
 #include "Common/Common.h"
 #include "Common/CPUDetect.h"
 
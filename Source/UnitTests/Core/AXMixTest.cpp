@@ -0,0 +1,393 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Core/HW/DSPHLE/UCodes/AXMix.h"
+
+#define AX_GC
+#include "Core/HW/DSPHLE/UCodes/AXVoice.h"
+
+namespace
+{
+
+// Backing store for the PB list fixture below. AXVoice.h reads PBs from main
+// memory and samples from ARAM, these stand in for both.
+const u32 FIXTURE_MRAM_SIZE = 0x4000;
+const u32 FIXTURE_ARAM_SIZE = 0x10000;
+u8 s_mram[FIXTURE_MRAM_SIZE];
+u8 s_aram[FIXTURE_ARAM_SIZE];
+
+}
+
+namespace DSP
+{
+u8 ReadARAM(u32 address) { return s_aram[address & (FIXTURE_ARAM_SIZE - 1)]; }
+}
+
+namespace Memory
+{
+u8* GetPointer(u32 address)
+{
+	address &= 0x3FFFFFFF;
+	return address < FIXTURE_MRAM_SIZE ? &s_mram[address] : nullptr;
+}
+}
+
+namespace
+{
+
+// The loops AXMix replaced, as they were in AXVoice.h.
+void ReferenceApplyVolume(s16* samples, u32 count, u16* volume, u16 volume_delta)
+{
+	for (u32 i = 0; i < count; ++i)
+	{
+		samples[i] = ((s32)samples[i] * *volume) >> 15;
+		*volume += volume_delta;
+	}
+}
+
+void ReferenceMixAdd(int* out, const s16* input, u32 count, u16* volume, u16 volume_delta, s16* last_sample)
+{
+	for (u32 i = 0; i < count; ++i)
+	{
+		s64 sample = input[i];
+		sample *= *volume;
+		sample >>= 15;
+
+		out[i] += (s16)sample;
+		*volume += volume_delta;
+
+		*last_sample = (s16)sample;
+	}
+}
+
+// What a voice of a frame looks like to the mixing code.
+struct Voice
+{
+	std::vector<s16> samples;
+	u16 volume;
+	u16 volume_delta;
+};
+
+std::vector<Voice> MakeVoices(u32 num_voices, u32 count, u32 seed)
+{
+	std::mt19937 rng(seed);
+	std::vector<Voice> voices(num_voices);
+	for (Voice& voice : voices)
+	{
+		voice.samples.resize(count);
+		for (s16& sample : voice.samples)
+			sample = (s16)rng();
+		voice.volume = (u16)rng();
+		// Mostly small ramps, like games use, but any delta has to work.
+		voice.volume_delta = rng() % 4 ? (u16)(rng() % 64 - 32) : (u16)rng();
+	}
+	// The extremes.
+	voices[0].samples.assign(count, -0x8000);
+	voices[0].volume = 0xFFFF;
+	voices[0].volume_delta = 0;
+	voices[1].samples.assign(count, 0x7FFF);
+	voices[1].volume = 0xFFF0;
+	voices[1].volume_delta = 1;
+	return voices;
+}
+
+// A PB list the way a game hands it to AX GC: an ADPCM voice that loops, a
+// 16-bit one-shot that ends during the second frame, an 8-bit voice whose
+// envelope wraps through zero, a stopped voice and a 16-bit voice at an exact
+// 1.0 ratio with a huge mixer ramp. Samples are generated, everything else is
+// spelled out so that a change in the output can only come from the mixing
+// code.
+const u32 FIXTURE_PB_ADDR = 0x80001000;
+const u32 FIXTURE_NUM_PBS = 5;
+const int FIXTURE_NUM_FRAMES = 8;
+
+void SetAddr(u16* hi, u16* lo, u32 addr)
+{
+	*hi = (u16)(addr >> 16);
+	*lo = (u16)addr;
+}
+
+void SetAudio(AXPB& pb, u16 format, bool looping, u32 loop_addr, u32 end_addr, u32 cur_addr)
+{
+	pb.audio_addr.sample_format = format;
+	pb.audio_addr.looping = looping;
+	SetAddr(&pb.audio_addr.loop_addr_hi, &pb.audio_addr.loop_addr_lo, loop_addr);
+	SetAddr(&pb.audio_addr.end_addr_hi, &pb.audio_addr.end_addr_lo, end_addr);
+	SetAddr(&pb.audio_addr.cur_addr_hi, &pb.audio_addr.cur_addr_lo, cur_addr);
+}
+
+void SetSRC(AXPB& pb, u16 src_type, u32 ratio)
+{
+	pb.src_type = src_type;
+	SetAddr(&pb.src.ratio_hi, &pb.src.ratio_lo, ratio);
+}
+
+void LoadFixture(u32 mctrl[FIXTURE_NUM_PBS])
+{
+	std::mt19937 rng(0xA0);
+
+	// ADPCM frames at 0x0000, with headers picking one of the coefficient
+	// pairs and a small scale, 16-bit PCM at 0x4000 and 8-bit PCM at 0x8000.
+	for (u32 i = 0; i < 0x4000; i++)
+		s_aram[i] = (i % 8) ? (u8)rng() : (u8)((rng() % 8) << 4 | rng() % 12);
+	for (u32 i = 0x4000; i < 0x8000; i += 2)
+	{
+		s16 sample = (s16)((i & 0x1FF) * 0x80 - 0x8000 + (s16)(rng() % 0x800));
+		s_aram[i] = (u8)(sample >> 8);
+		s_aram[i + 1] = (u8)sample;
+	}
+	for (u32 i = 0x8000; i < FIXTURE_ARAM_SIZE; i++)
+		s_aram[i] = (u8)rng();
+	// Where the one-shot voice lands when it ends.
+	memset(&s_aram[0x5000], 0, 0x100);
+
+	AXPB pbs[FIXTURE_NUM_PBS];
+	memset(pbs, 0, sizeof(pbs));
+	for (u32 i = 0; i < FIXTURE_NUM_PBS; i++)
+	{
+		u32 addr = FIXTURE_PB_ADDR + i * sizeof(AXPB);
+		SetAddr(&pbs[i].this_pb_hi, &pbs[i].this_pb_lo, addr);
+		if (i + 1 < FIXTURE_NUM_PBS)
+			SetAddr(&pbs[i].next_pb_hi, &pbs[i].next_pb_lo, addr + sizeof(AXPB));
+		pbs[i].running = 1;
+	}
+
+	AXPB& adpcm = pbs[0];
+	SetAudio(adpcm, AUDIOFORMAT_ADPCM, true, 0x0100, 0x02FF, 0x0000);
+	SetSRC(adpcm, SRCTYPE_LINEAR, 0xB000);
+	for (u32 i = 0; i < 16; i++)
+		adpcm.adpcm.coefs[i] = (s16)((i % 2) ? -0x400 * (i / 2) : 0x800 + 0x100 * i);
+	adpcm.adpcm_loop_info.pred_scale = s_aram[0x0100 / 2];
+	adpcm.vol_env.cur_volume = 0x6000;
+	adpcm.vol_env.cur_volume_delta = 3;
+	adpcm.mixer.left = 0x7000;
+	adpcm.mixer.left_delta = (u16)-5;
+	adpcm.mixer.right = 0x3000;
+	adpcm.mixer.right_delta = 7;
+	mctrl[0] = MIX_L | MIX_L_RAMP | MIX_R | MIX_R_RAMP;
+
+	AXPB& oneshot = pbs[1];
+	SetAudio(oneshot, AUDIOFORMAT_PCM16, false, 0x2800, 0x2000 + 300, 0x2000);
+	SetSRC(oneshot, SRCTYPE_NEAREST, 0x10000);
+	oneshot.vol_env.cur_volume = 0xFFFF;
+	oneshot.mixer.left = 0x8000;
+	oneshot.mixer.right = 0x4000;
+	oneshot.mixer.surround = 0xFFFF;
+	oneshot.mixer.surround_delta = 0x100;
+	mctrl[1] = MIX_L | MIX_R | MIX_S;
+
+	AXPB& pcm8 = pbs[2];
+	SetAudio(pcm8, AUDIOFORMAT_PCM8, true, 0x8100, 0x83FF, 0x8000);
+	SetSRC(pcm8, SRCTYPE_POLYPHASE, 0x18000);
+	pcm8.vol_env.cur_volume = 0x1000;
+	pcm8.vol_env.cur_volume_delta = -7;
+	pcm8.mixer.auxA_left = 0x4000;
+	pcm8.mixer.auxA_left_delta = 0x10;
+	pcm8.mixer.auxA_right = 0x5000;
+	pcm8.mixer.auxA_right_delta = (u16)-0x10;
+	pcm8.mixer.auxA_surround = 0x0100;
+	pcm8.mixer.auxA_surround_delta = (u16)-1;
+	pcm8.mixer.auxB_left = 0x2000;
+	pcm8.mixer.auxB_right = 0x2000;
+	pcm8.mixer.auxB_surround = 0x2000;
+	mctrl[2] = MIX_AUXA_L | MIX_AUXA_L_RAMP | MIX_AUXA_R | MIX_AUXA_R_RAMP |
+	           MIX_AUXA_S | MIX_AUXA_S_RAMP | MIX_AUXB_L | MIX_AUXB_R | MIX_AUXB_S;
+
+	AXPB& stopped = pbs[3];
+	SetAudio(stopped, AUDIOFORMAT_PCM16, true, 0x2000, 0x3FFF, 0x2000);
+	stopped.running = 0;
+	stopped.vol_env.cur_volume = 0x8000;
+	stopped.mixer.left = 0x8000;
+	mctrl[3] = MIX_L;
+
+	AXPB& unity = pbs[4];
+	SetAudio(unity, AUDIOFORMAT_PCM16, true, 0x3000, 0x30FF, 0x3000);
+	SetSRC(unity, SRCTYPE_LINEAR, 0x10000);
+	unity.vol_env.cur_volume = 0xFFF0;
+	unity.vol_env.cur_volume_delta = 1;
+	unity.mixer.surround = 0xFFFF;
+	unity.mixer.surround_delta = 0x8001;
+	unity.mixer.auxB_surround = 0x8000;
+	unity.mixer.auxB_surround_delta = 0x7FFF;
+	mctrl[4] = MIX_S | MIX_S_RAMP | MIX_AUXB_S | MIX_AUXB_S_RAMP;
+
+	memset(s_mram, 0, sizeof(s_mram));
+	for (u32 i = 0; i < FIXTURE_NUM_PBS; i++)
+		WritePB(FIXTURE_PB_ADDR + i * sizeof(AXPB), pbs[i]);
+}
+
+u32 Hash(u32 hash, const void* data, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ ((const u8*)data)[i]) * 16777619;
+	return hash;
+}
+
+// Runs the fixture for a few frames the way AXUCode::ProcessPBList does,
+// without parameter updates, and hashes each of the output buffers over all
+// frames and the PB list it leaves behind.
+void ReplayFixture(u32 output_hashes[9], u32* pb_hash)
+{
+	const u32 spms = 32;
+	u32 mctrl[FIXTURE_NUM_PBS];
+	LoadFixture(mctrl);
+
+	std::vector<int> out[9];
+	for (u32 i = 0; i < 9; i++)
+		output_hashes[i] = 2166136261;
+
+	for (int frame = 0; frame < FIXTURE_NUM_FRAMES; frame++)
+	{
+		for (std::vector<int>& buffer : out)
+			buffer.assign(spms * 5, 0);
+
+		u32 pb_addr = FIXTURE_PB_ADDR;
+		for (u32 voice = 0; pb_addr; voice++)
+		{
+			AXBuffers buffers;
+			for (u32 i = 0; i < 9; i++)
+				buffers.ptrs[i] = out[i].data();
+
+			AXPB pb;
+			ASSERT_TRUE(ReadPB(pb_addr, pb));
+			for (int curr_ms = 0; curr_ms < 5; ++curr_ms)
+			{
+				ProcessVoice(pb, buffers, spms, (AXMixControl)mctrl[voice], nullptr);
+				for (u32 i = 0; i < 9; i++)
+					buffers.ptrs[i] += spms;
+			}
+			WritePB(pb_addr, pb);
+			pb_addr = HILO_TO_32(pb.next_pb);
+		}
+
+		for (u32 i = 0; i < 9; i++)
+			output_hashes[i] = Hash(output_hashes[i], out[i].data(), out[i].size() * sizeof(int));
+	}
+
+	*pb_hash = Hash(2166136261, Memory::GetPointer(FIXTURE_PB_ADDR), FIXTURE_NUM_PBS * sizeof(AXPB));
+}
+
+}
+
+TEST(AXMix, ApplyVolumeMatchesReference)
+{
+	for (u32 count = 0; count <= 100; count++)
+	{
+		for (const Voice& voice : MakeVoices(16, count, count))
+		{
+			std::vector<s16> expected = voice.samples;
+			std::vector<s16> actual = voice.samples;
+			u16 expected_volume = voice.volume;
+			u16 actual_volume = voice.volume;
+
+			ReferenceApplyVolume(expected.data(), count, &expected_volume, voice.volume_delta);
+			AXMix::ApplyVolume(actual.data(), count, &actual_volume, voice.volume_delta);
+
+			EXPECT_EQ(expected, actual) << count;
+			EXPECT_EQ(expected_volume, actual_volume) << count;
+		}
+	}
+}
+
+TEST(AXMix, MixAddMatchesReference)
+{
+	for (u32 count = 0; count <= 100; count++)
+	{
+		std::vector<int> expected(count, 0x1234);
+		std::vector<int> actual(count, 0x1234);
+
+		for (const Voice& voice : MakeVoices(16, count, count + 1000))
+		{
+			u16 expected_volume = voice.volume;
+			u16 actual_volume = voice.volume;
+			s16 expected_last = 0x5555;
+			s16 actual_last = 0x5555;
+
+			ReferenceMixAdd(expected.data(), voice.samples.data(), count, &expected_volume, voice.volume_delta, &expected_last);
+			AXMix::MixAdd(actual.data(), voice.samples.data(), count, &actual_volume, voice.volume_delta, &actual_last);
+
+			EXPECT_EQ(expected_volume, actual_volume) << count;
+			EXPECT_EQ(expected_last, actual_last) << count;
+		}
+		EXPECT_EQ(expected, actual) << count;
+	}
+}
+
+TEST(AXMix, PBListReplayIsBitExact)
+{
+	// Recorded with the scalar loops AXVoice.h had before AXMix, in the order
+	// of AXBuffers: left, right, surround, auxA left/right/surround, auxB
+	// left/right/surround.
+	const u32 expected_output[9] = {
+		2276812142u, 4196554198u, 1957311718u,
+		2250364695u, 601441727u, 3573544088u,
+		4076871667u, 4076871667u, 3426745685u
+	};
+	const u32 expected_pbs = 3004185714u;
+
+	u32 output_hashes[9];
+	u32 pb_hash;
+	ReplayFixture(output_hashes, &pb_hash);
+
+	for (u32 i = 0; i < 9; i++)
+		EXPECT_EQ(expected_output[i], output_hashes[i]) << "buffer " << i;
+	EXPECT_EQ(expected_pbs, pb_hash);
+}
+
+// A made-up frame of 64 voices, each mixed into all 9 AX GC buffers, through the
+// old loops and through AXMix. Both have to end up with the same buffers.
+TEST(AXMix, DISABLED_FrameOf64Voices)
+{
+	const u32 count = 32 * 5;
+	const u32 num_buffers = 9;
+	const int num_frames = 500;
+	const std::vector<Voice> voices = MakeVoices(64, count, 1);
+	std::vector<int> reference_out(count * num_buffers);
+	std::vector<int> out(count * num_buffers);
+
+	auto measure = [&](std::vector<int>* buffers, bool reference)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int frame = 0; frame < num_frames; frame++)
+		{
+			for (const Voice& voice : voices)
+			{
+				std::vector<s16> samples = voice.samples;
+				u16 volume = voice.volume;
+				if (reference)
+					ReferenceApplyVolume(samples.data(), count, &volume, voice.volume_delta);
+				else
+					AXMix::ApplyVolume(samples.data(), count, &volume, voice.volume_delta);
+
+				for (u32 buffer = 0; buffer < num_buffers; buffer++)
+				{
+					u16 mix_volume = (u16)(voice.volume + buffer * 0x1000);
+					s16 last_sample;
+					if (reference)
+						ReferenceMixAdd(&(*buffers)[buffer * count], samples.data(), count, &mix_volume, voice.volume_delta, &last_sample);
+					else
+						AXMix::MixAdd(&(*buffers)[buffer * count], samples.data(), count, &mix_volume, voice.volume_delta, &last_sample);
+				}
+			}
+		}
+		std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start;
+		return (double)num_frames * voices.size() / time.count() / 1000000;
+	};
+
+	const double reference = measure(&reference_out, true);
+	const double current = measure(&out, false);
+	EXPECT_EQ(reference_out, out);
+
+	printf("old loops: %6.2f M voice frames/s\n", reference);
+	printf("AXMix:     %6.2f M voice frames/s\n", current);
+}
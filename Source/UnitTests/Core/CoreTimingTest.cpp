@@ -0,0 +1,377 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/ChunkFile.h"
+#include "Common/CommonTypes.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/IPC_HLE/WII_IPC_HLE.h"
+#include "VideoCommon/VideoBackendBase.h"
+
+// CoreTiming.cpp is built into this test on its own; these are the only other
+// parts of the core it needs.
+VideoBackend* g_video_backend;
+namespace Core
+{
+bool IsCPUThread() { return true; }
+}
+
+namespace
+{
+
+std::vector<u64> s_fired;
+
+void RecordEvent(u64 userdata, int cyclesLate)
+{
+	s_fired.push_back(userdata);
+}
+
+std::vector<s64> s_fired_ticks;
+
+// Also records the tick the event was scheduled for.
+void RecordTick(u64 userdata, int cyclesLate)
+{
+	s_fired.push_back(userdata);
+	s_fired_ticks.push_back((s64)CoreTiming::GetTicks() - cyclesLate);
+}
+
+// Runs the scheduler for cycles cycles, as if the CPU had executed them.
+void RunCycles(int cycles)
+{
+	CoreTiming::downcount = CoreTiming::slicelength - cycles;
+	CoreTiming::Advance();
+}
+
+class CoreTimingTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		CoreTiming::Init();
+		m_record = CoreTiming::RegisterEvent("Record", RecordEvent);
+		s_fired.clear();
+	}
+
+	void TearDown() override
+	{
+		CoreTiming::Shutdown();
+	}
+
+	int m_record;
+};
+
+}
+
+TEST_F(CoreTimingTest, FiresInTimeThenScheduleOrder)
+{
+	CoreTiming::ScheduleEvent(300, m_record, 3);
+	CoreTiming::ScheduleEvent(100, m_record, 1);
+	CoreTiming::ScheduleEvent(200, m_record, 2);
+	CoreTiming::ScheduleEvent(100, m_record, 10);
+	CoreTiming::ScheduleEvent(200, m_record, 20);
+
+	RunCycles(150);
+	EXPECT_EQ(std::vector<u64>({ 1, 10 }), s_fired);
+	RunCycles(1000);
+	EXPECT_EQ(std::vector<u64>({ 1, 10, 2, 20, 3 }), s_fired);
+}
+
+TEST_F(CoreTimingTest, CancelEvent)
+{
+	CoreTiming::EventHandle first = CoreTiming::ScheduleEvent(100, m_record, 1);
+	CoreTiming::EventHandle second = CoreTiming::ScheduleEvent(100, m_record, 2);
+	CoreTiming::ScheduleEvent(100, m_record, 3);
+
+	EXPECT_TRUE(CoreTiming::CancelEvent(second));
+	EXPECT_FALSE(CoreTiming::CancelEvent(second));
+	RunCycles(200);
+	EXPECT_EQ(std::vector<u64>({ 1, 3 }), s_fired);
+
+	// The slot of an event that ran gets reused, but its handle must not cancel the new event.
+	EXPECT_FALSE(CoreTiming::CancelEvent(first));
+	CoreTiming::ScheduleEvent(100, m_record, 4);
+	EXPECT_FALSE(CoreTiming::CancelEvent(first));
+	RunCycles(200);
+	EXPECT_EQ(std::vector<u64>({ 1, 3, 4 }), s_fired);
+}
+
+// Random schedules, cancels and removals against a plain sorted list.
+TEST_F(CoreTimingTest, MatchesSortedList)
+{
+	struct Pending
+	{
+		s64 time;
+		u64 order;
+		u64 id;
+		int type;
+		CoreTiming::EventHandle handle;
+	};
+
+	int other = CoreTiming::RegisterEvent("Other", RecordEvent);
+	std::mt19937 rng(42);
+	std::vector<Pending> pending;
+	std::vector<u64> expected;
+	s64 now = 0;
+	u64 order = 0;
+
+	for (int step = 0; step < 20000; step++)
+	{
+		const u32 op = rng() % 16;
+		if (op < 9)
+		{
+			const int delay = rng() % 1000;
+			const int type = rng() % 4 ? m_record : other;
+			const u64 id = step;
+			pending.push_back({ now + delay, order++, id, type, CoreTiming::ScheduleEvent(delay, type, id) });
+		}
+		else if (op < 12 && !pending.empty())
+		{
+			const size_t index = rng() % pending.size();
+			EXPECT_TRUE(CoreTiming::CancelEvent(pending[index].handle));
+			pending.erase(pending.begin() + index);
+		}
+		else if (op == 12)
+		{
+			CoreTiming::RemoveEvent(other);
+			pending.erase(std::remove_if(pending.begin(), pending.end(),
+				[other](const Pending& e) { return e.type == other; }), pending.end());
+		}
+		else
+		{
+			const int cycles = rng() % 500;
+			now += cycles;
+			std::stable_sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) {
+				return a.time != b.time ? a.time < b.time : a.order < b.order;
+			});
+			auto due = std::find_if(pending.begin(), pending.end(), [now](const Pending& e) { return e.time > now; });
+			for (auto it = pending.begin(); it != due; ++it)
+				expected.push_back(it->id);
+			pending.erase(pending.begin(), due);
+			RunCycles(cycles);
+		}
+	}
+
+	EXPECT_EQ(expected, s_fired);
+}
+
+TEST_F(CoreTimingTest, DoStateKeepsOrder)
+{
+	for (u64 i = 0; i < 50; i++)
+		CoreTiming::ScheduleEvent((int)(i * 37 % 11) * 10, m_record, i);
+	RunCycles(25);
+	const size_t fired_before_save = s_fired.size();
+	s_fired.clear();
+
+	std::vector<u8> state;
+	u8* ptr = nullptr;
+	PointerWrap measure(&ptr, PointerWrap::MODE_MEASURE);
+	CoreTiming::DoState(measure);
+	state.resize(ptr - (u8*)nullptr);
+	ptr = state.data();
+	PointerWrap write(&ptr, PointerWrap::MODE_WRITE);
+	CoreTiming::DoState(write);
+
+	RunCycles(1000);
+	const std::vector<u64> expected = s_fired;
+	EXPECT_EQ(50u, fired_before_save + expected.size());
+
+	s_fired.clear();
+	ptr = state.data();
+	PointerWrap read(&ptr, PointerWrap::MODE_READ);
+	CoreTiming::DoState(read);
+	RunCycles(1000);
+	EXPECT_EQ(expected, s_fired);
+}
+
+// A DI read is copied to memory by an event DVDThread::StartRead schedules while the
+// command runs. Keeping IPC replies in order used to be able to send the reply sooner.
+TEST_F(CoreTimingTest, IPCReplyNotBeforeDVDRead)
+{
+	enum { COPY = 1, REPLY = 2 };
+	const int copy_event = CoreTiming::RegisterEvent("Copy", RecordTick);
+	const int reply_event = CoreTiming::RegisterEvent("Reply", RecordTick);
+	const int read_delay = 40000;
+
+	for (s64 ticks_til_last_reply : { 0, 1000, 39999, 40000, 90000 })
+	{
+		s_fired.clear();
+		s_fired_ticks.clear();
+		const s64 now = (s64)CoreTiming::GetTicks();
+
+		// What ExecuteCommand does for a DVDLowRead, whose GetCmdDelay and
+		// GetCmdMinDelay are both the read delay.
+		CoreTiming::ScheduleEvent(read_delay, copy_event, COPY);
+		const int reply_delay = WII_IPC_HLE_Interface::GetReplyDelay(read_delay, read_delay, ticks_til_last_reply);
+		CoreTiming::ScheduleEvent(reply_delay, reply_event, REPLY);
+		RunCycles(200000);
+
+		ASSERT_EQ(std::vector<u64>({ COPY, REPLY }), s_fired) << ticks_til_last_reply;
+		EXPECT_GE(s_fired_ticks[1], s_fired_ticks[0]) << ticks_til_last_reply;
+		EXPECT_GE(s_fired_ticks[1], now + ticks_til_last_reply) << ticks_til_last_reply;
+	}
+}
+
+namespace
+{
+
+// The sorted singly linked list CoreTiming used before the heap, with its node pool.
+class ListScheduler
+{
+public:
+	typedef void (*Callback)(ListScheduler& scheduler, u64 userdata, int cyclesLate);
+
+	ListScheduler() : m_first(-1), m_free(-1), m_now(0) {}
+
+	void Schedule(int cycles, Callback callback, u64 userdata)
+	{
+		int node;
+		if (m_free >= 0)
+		{
+			node = m_free;
+			m_free = m_nodes[node].next;
+		}
+		else
+		{
+			node = (int)m_nodes.size();
+			m_nodes.emplace_back();
+		}
+		m_nodes[node].time = m_now + cycles;
+		m_nodes[node].callback = callback;
+		m_nodes[node].userdata = userdata;
+
+		int* link = &m_first;
+		while (*link >= 0 && m_nodes[*link].time <= m_nodes[node].time)
+			link = &m_nodes[*link].next;
+		m_nodes[node].next = *link;
+		*link = node;
+	}
+
+	void Run(int cycles)
+	{
+		m_now += cycles;
+		while (m_first >= 0 && m_nodes[m_first].time <= m_now)
+		{
+			const int node = m_first;
+			m_first = m_nodes[node].next;
+			m_nodes[node].next = m_free;
+			m_free = node;
+			m_nodes[node].callback(*this, m_nodes[node].userdata, (int)(m_now - m_nodes[node].time));
+		}
+	}
+
+private:
+	struct Node
+	{
+		s64 time;
+		Callback callback;
+		u64 userdata;
+		int next;
+	};
+
+	std::vector<Node> m_nodes;
+	int m_first;
+	int m_free;
+	s64 m_now;
+};
+
+// A schedule like the one a game produces: timers that reschedule themselves
+// from their callbacks (userdata is the period), and a stream of one-shot events
+// such as DMA completions and interrupts in between.
+struct ScheduleTrace
+{
+	std::vector<int> timer_periods;
+	// One-shot delays, one of them scheduled per slice.
+	std::vector<int> one_shots;
+	int slice;
+};
+
+ScheduleTrace MakeTrace(int num_timers, int pending_one_shots)
+{
+	std::mt19937 rng(7);
+	ScheduleTrace trace;
+	for (int i = 0; i < num_timers; i++)
+		trace.timer_periods.push_back(2000 + rng() % 200000);
+	for (int i = 0; i < 200000; i++)
+		trace.one_shots.push_back(rng() % (pending_one_shots * 2 * 1000));
+	trace.slice = 1000;
+	return trace;
+}
+
+void ListTimer(ListScheduler& scheduler, u64 period, int cyclesLate)
+{
+	scheduler.Schedule((int)period - cyclesLate, ListTimer, period);
+}
+
+void ListOneShot(ListScheduler& scheduler, u64 userdata, int cyclesLate)
+{
+}
+
+int s_timer_event;
+int s_one_shot_event;
+
+void HeapTimer(u64 period, int cyclesLate)
+{
+	CoreTiming::ScheduleEvent((int)period - cyclesLate, s_timer_event, period);
+}
+
+void HeapOneShot(u64 userdata, int cyclesLate)
+{
+}
+
+double ReplayList(const ScheduleTrace& trace)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	ListScheduler scheduler;
+	for (int period : trace.timer_periods)
+		scheduler.Schedule(period, ListTimer, period);
+	for (int delay : trace.one_shots)
+	{
+		scheduler.Schedule(delay, ListOneShot, 0);
+		scheduler.Run(trace.slice);
+	}
+	std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start;
+	return time.count();
+}
+
+double ReplayHeap(const ScheduleTrace& trace)
+{
+	CoreTiming::Init();
+	s_timer_event = CoreTiming::RegisterEvent("Timer", HeapTimer);
+	s_one_shot_event = CoreTiming::RegisterEvent("OneShot", HeapOneShot);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int period : trace.timer_periods)
+		CoreTiming::ScheduleEvent(period, s_timer_event, period);
+	for (int delay : trace.one_shots)
+	{
+		CoreTiming::ScheduleEvent(delay, s_one_shot_event);
+		RunCycles(trace.slice);
+	}
+	std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start;
+
+	CoreTiming::Shutdown();
+	return time.count();
+}
+
+}
+
+// How long the heap and the old sorted list each take to replay the same schedules.
+TEST(CoreTimingBenchmark, DISABLED_Replay)
+{
+	for (int pending : { 10, 100, 1000 })
+	{
+		const ScheduleTrace trace = MakeTrace(12, pending);
+		const double list = ReplayList(trace);
+		const double heap = ReplayHeap(trace);
+		printf("~%4d pending one-shots: list %6.1f ms, heap %6.1f ms\n", pending, list * 1000, heap * 1000);
+	}
+}
@@ -0,0 +1,180 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <initializer_list>
+#include <map>
+#include <random>
+
+#include "Common/CommonTypes.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/PPCSymbolDB.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+#include "Core/PowerPC/JitCommon/JitCache.h"
+
+// After the emitter headers, whose XEmitter::TEST clashes with the gtest macro.
+#include <gtest/gtest.h>
+
+// JitCache.cpp is built into this test on its own; these are the only other
+// parts of the core it needs.
+JitBase *jit;
+namespace PowerPC
+{
+InstructionCache::InstructionCache() {}
+PowerPCState ppcState;
+}
+PPCSymbolDB g_symbolDB;
+PPCSymbolDB::PPCSymbolDB() : debugger(nullptr) {}
+PPCSymbolDB::~PPCSymbolDB() {}
+Symbol *PPCSymbolDB::AddFunction(u32 startAddr) { return nullptr; }
+Symbol *PPCSymbolDB::GetSymbolFromAddr(u32 addr) { return nullptr; }
+
+namespace
+{
+
+// Records the links instead of emitting jumps. The code pointers are never run.
+class TestBlockCache : public JitBaseBlockCache
+{
+public:
+	std::map<const u8*, const u8*> jumps; // exit -> where it jumps to
+	bool record_jumps = true;
+
+private:
+	void WriteLinkBlock(u8* location, const u8* address) override
+	{
+		if (record_jumps)
+			jumps[location] = address;
+	}
+	void WriteDestroyBlock(const u8* location, u32 address) override {}
+};
+
+uintptr_t s_next_code = 0x1000;
+
+u8 *FakeCode()
+{
+	s_next_code += 0x10;
+	return (u8 *)s_next_code;
+}
+
+int CompileBlock(TestBlockCache &cache, u32 address, std::initializer_list<u32> exits)
+{
+	int block_num = cache.AllocateBlock(address);
+	JitBlock *b = cache.GetBlock(block_num);
+	b->checkedEntry = FakeCode();
+	b->normalEntry = b->checkedEntry;
+	b->codeSize = 0x10;
+	b->originalSize = 4;
+	for (u32 exit : exits)
+	{
+		JitBlock::LinkData linkData;
+		linkData.exitAddress = exit;
+		linkData.exitPtrs = FakeCode();
+		linkData.linkStatus = false;
+		b->linkData.push_back(linkData);
+	}
+	cache.FinalizeBlock(block_num, true, b->normalEntry);
+	return block_num;
+}
+
+class JitCacheTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		cache.Init();
+	}
+	void TearDown() override
+	{
+		cache.Shutdown();
+	}
+
+	const u8 *ExitPtr(int block_num, int exit)
+	{
+		return cache.GetBlock(block_num)->linkData[exit].exitPtrs;
+	}
+
+	TestBlockCache cache;
+};
+
+}  // namespace
+
+TEST_F(JitCacheTest, LinksExitsToLaterAndEarlierBlocks)
+{
+	int a = CompileBlock(cache, 0x80001000, { 0x80002000 });
+	EXPECT_TRUE(cache.jumps.empty());
+
+	int b = CompileBlock(cache, 0x80002000, { 0x80001000 });
+	EXPECT_EQ(cache.GetBlock(b)->checkedEntry, cache.jumps[ExitPtr(a, 0)]);
+	EXPECT_EQ(cache.GetBlock(a)->checkedEntry, cache.jumps[ExitPtr(b, 0)]);
+	EXPECT_TRUE(cache.GetBlock(a)->linkData[0].linkStatus);
+	EXPECT_TRUE(cache.GetBlock(b)->linkData[0].linkStatus);
+}
+
+TEST_F(JitCacheTest, RelinksRecompiledBlock)
+{
+	int a = CompileBlock(cache, 0x80001000, { 0x80002000 });
+	int c = CompileBlock(cache, 0x80003000, { 0x80002000 });
+	CompileBlock(cache, 0x80002000, {});
+
+	cache.InvalidateICache(0x80002000, 32);
+	EXPECT_FALSE(cache.GetBlock(a)->linkData[0].linkStatus);
+	EXPECT_FALSE(cache.GetBlock(c)->linkData[0].linkStatus);
+
+	int b = CompileBlock(cache, 0x80002000, {});
+	EXPECT_EQ(cache.GetBlock(b)->checkedEntry, cache.jumps[ExitPtr(a, 0)]);
+	EXPECT_EQ(cache.GetBlock(b)->checkedEntry, cache.jumps[ExitPtr(c, 0)]);
+}
+
+TEST_F(JitCacheTest, DoesNotLinkDestroyedBlocks)
+{
+	CompileBlock(cache, 0x80001000, { 0x80002000 });
+	int c = CompileBlock(cache, 0x80003000, { 0x80002000 });
+	cache.InvalidateICache(0x80001000, 32);
+
+	CompileBlock(cache, 0x80002000, {});
+	EXPECT_EQ(1u, cache.jumps.size());
+	EXPECT_EQ(1u, cache.jumps.count(ExitPtr(c, 0)));
+}
+
+TEST_F(JitCacheTest, ClearDropsLinks)
+{
+	CompileBlock(cache, 0x80001000, { 0x80002000 });
+	cache.Clear();
+	cache.jumps.clear();
+
+	CompileBlock(cache, 0x80002000, {});
+	EXPECT_TRUE(cache.jumps.empty());
+}
+
+// Compiles, links and invalidates blocks the way a game that keeps reloading code
+// does.
+TEST(JitCacheBenchmark, DISABLED_Churn)
+{
+	const int NUM_ADDRESSES = 20000;
+	const int NUM_OPS = 1000000;
+
+	TestBlockCache cache;
+	cache.record_jumps = false;
+	cache.Init();
+
+	std::mt19937 rng(1);
+	std::uniform_int_distribution<int> pick(0, NUM_ADDRESSES - 1);
+	auto address = [](int i) { return 0x80000000 + 0x40 * (u32)i; };
+
+	auto start = std::chrono::steady_clock::now();
+	for (int op = 0; op < NUM_OPS; op++)
+	{
+		if (cache.IsFull())
+			cache.Clear();
+		u32 em_address = address(pick(rng));
+		if (cache.GetBlockNumberFromStartAddress(em_address) != -1)
+			cache.InvalidateICache(em_address, 32);
+		CompileBlock(cache, em_address, { address(pick(rng)), address(pick(rng)) });
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	printf("%d compiles over %d addresses: %.1f ms\n", NUM_OPS, NUM_ADDRESSES, ms);
+
+	cache.Shutdown();
+}
@@ -0,0 +1,132 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <random>
+#include <vector>
+#include <lzo/lzo1x.h>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Core/RewindDelta.h"
+
+namespace
+{
+
+const size_t STATE_SIZE = 1024 * 1024 + 13;
+
+std::vector<u8> MakeState(size_t size, u32 seed)
+{
+	std::vector<u8> state(size);
+	std::mt19937 rng(seed);
+	for (u8& byte : state)
+		byte = (u8)rng();
+	return state;
+}
+
+// What a few frames of emulation do to a state: a handful of scattered writes.
+std::vector<u8> NextState(const std::vector<u8>& state, u32 seed)
+{
+	std::vector<u8> next = state;
+	std::mt19937 rng(seed);
+	for (int i = 0; i < 200; i++)
+		next[rng() % next.size()] = (u8)rng();
+	return next;
+}
+
+class RewindDeltaTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		ASSERT_EQ(LZO_E_OK, lzo_init());
+	}
+
+	Rewind::DeltaEncoder encoder;
+};
+
+}  // namespace
+
+using namespace Rewind;
+
+TEST_F(RewindDeltaTest, RoundTrip)
+{
+	const std::vector<u8> older = MakeState(STATE_SIZE, 1);
+	const std::vector<u8> newer = NextState(older, 2);
+
+	std::vector<u8> scratch = older;
+	Delta delta;
+	ASSERT_TRUE(encoder.Encode(scratch, newer, delta));
+	EXPECT_EQ(older.size(), delta.size);
+	// Mostly zeros, so far smaller than the state.
+	EXPECT_LT(delta.data.size(), older.size() / 50);
+
+	std::vector<u8> decoded;
+	ASSERT_TRUE(DecodeDelta(delta, newer, decoded));
+	EXPECT_TRUE(decoded == older);
+}
+
+TEST_F(RewindDeltaTest, SizeChanges)
+{
+	// A state's size can change between snapshots, e.g. when a device is added.
+	const std::vector<u8> base = MakeState(STATE_SIZE, 3);
+	for (size_t newer_size : { STATE_SIZE - 1000, STATE_SIZE + 1000, (size_t)7 })
+	{
+		std::vector<u8> newer = NextState(base, 4);
+		newer.resize(newer_size, 0x55);
+
+		std::vector<u8> scratch = base;
+		Delta delta;
+		ASSERT_TRUE(encoder.Encode(scratch, newer, delta)) << newer_size;
+
+		std::vector<u8> decoded;
+		ASSERT_TRUE(DecodeDelta(delta, newer, decoded)) << newer_size;
+		EXPECT_TRUE(decoded == base) << newer_size;
+	}
+}
+
+TEST_F(RewindDeltaTest, StepsBackThroughChain)
+{
+	// Build the history the way Rewind does, then walk it back from the newest.
+	std::vector<std::vector<u8>> states(1, MakeState(STATE_SIZE, 5));
+	for (u32 i = 1; i < 10; i++)
+		states.push_back(NextState(states.back(), 5 + i));
+
+	std::vector<Delta> deltas;
+	for (size_t i = 0; i + 1 < states.size(); i++)
+	{
+		std::vector<u8> scratch = states[i];
+		Delta delta;
+		ASSERT_TRUE(encoder.Encode(scratch, states[i + 1], delta));
+		deltas.push_back(delta);
+	}
+
+	std::vector<u8> current = states.back();
+	for (size_t i = deltas.size(); i-- > 0;)
+	{
+		std::vector<u8> older;
+		ASSERT_TRUE(DecodeDelta(deltas[i], current, older)) << i;
+		ASSERT_TRUE(older == states[i]) << i;
+		current.swap(older);
+	}
+}
+
+TEST_F(RewindDeltaTest, RejectsCorruptDelta)
+{
+	const std::vector<u8> older = MakeState(STATE_SIZE, 20);
+	const std::vector<u8> newer = NextState(older, 21);
+
+	std::vector<u8> scratch = older;
+	Delta delta;
+	ASSERT_TRUE(encoder.Encode(scratch, newer, delta));
+
+	std::vector<u8> decoded;
+	Delta truncated = delta;
+	truncated.data.resize(truncated.data.size() / 2);
+	EXPECT_FALSE(DecodeDelta(truncated, newer, decoded));
+
+	Delta wrong_size = delta;
+	wrong_size.size += 16;
+	EXPECT_FALSE(DecodeDelta(wrong_size, newer, decoded));
+}
@@ -0,0 +1,137 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include <lzo/lzo1x.h>
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Core/StateCompression.h"
+
+namespace
+{
+
+const char STATE_PATH[] = "StateCompressionTest.sav";
+const u32 LEGACY_IN_LEN = 128 * 1024;
+
+// Half noise, half runs, so that some chunks compress and some are stored.
+std::vector<u8> MakeState(size_t size)
+{
+	std::vector<u8> data(size);
+	std::mt19937 rng((u32)size);
+	for (size_t i = 0; i < size; i++)
+		data[i] = ((i / 4096) % 2) ? (u8)rng() : (u8)(i / 512);
+	return data;
+}
+
+// The writer from before the frame header: a 32-bit length and an LZO1X-1 block per
+// LEGACY_IN_LEN bytes. A state that is a multiple of that ends with the compressed
+// form of an empty block.
+void WriteLegacyState(File::IOFile& f, const std::vector<u8>& data, bool zero_length_tail)
+{
+	std::vector<lzo_align_t> wrkmem((LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t));
+	std::vector<u8> out(LEGACY_IN_LEN + LEGACY_IN_LEN / 16 + 64 + 3);
+
+	size_t i = 0;
+	while (true)
+	{
+		const lzo_uint cur_len = (lzo_uint)std::min<size_t>(LEGACY_IN_LEN, data.size() - i);
+		lzo_uint out_len = 0;
+		ASSERT_EQ(LZO_E_OK, lzo1x_1_compress(data.data() + i, cur_len, &out[0], &out_len, &wrkmem[0]));
+
+		const u32 len = (u32)out_len;
+		f.WriteArray(&len, 1);
+		f.WriteBytes(&out[0], out_len);
+
+		if (cur_len != LEGACY_IN_LEN)
+			break;
+		i += cur_len;
+	}
+
+	if (zero_length_tail)
+	{
+		const u32 len = 0;
+		f.WriteArray(&len, 1);
+	}
+}
+
+class StateCompressionTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		ASSERT_EQ(LZO_E_OK, lzo_init());
+	}
+
+	void TearDown() override
+	{
+		File::Delete(STATE_PATH);
+	}
+
+	bool ReadBack(size_t size, std::vector<u8>& buffer)
+	{
+		File::IOFile f(STATE_PATH, "rb");
+		buffer.assign(size, 0);
+		return State::DecompressState(f, buffer);
+	}
+};
+
+}  // namespace
+
+using namespace State;
+
+TEST_F(StateCompressionTest, FramedRoundTrip)
+{
+	for (size_t size : { (size_t)1, (size_t)LEGACY_IN_LEN, (size_t)(5 * LEGACY_IN_LEN + 123) })
+	{
+		const std::vector<u8> data = MakeState(size);
+		{
+			File::IOFile f(STATE_PATH, "wb");
+			ASSERT_TRUE(CompressStateChunks(f, data.data(), data.size()));
+		}
+
+		std::vector<u8> buffer;
+		ASSERT_TRUE(ReadBack(size, buffer)) << size;
+		EXPECT_TRUE(buffer == data) << size;
+	}
+}
+
+TEST_F(StateCompressionTest, LegacyRoundTrip)
+{
+	// Multiples of the chunk size end with an empty chunk, which must still load.
+	for (size_t size : { (size_t)1000, (size_t)LEGACY_IN_LEN, (size_t)(3 * LEGACY_IN_LEN),
+	                     (size_t)(3 * LEGACY_IN_LEN + 77) })
+	{
+		for (bool zero_length_tail : { false, true })
+		{
+			const std::vector<u8> data = MakeState(size);
+			{
+				File::IOFile f(STATE_PATH, "wb");
+				WriteLegacyState(f, data, zero_length_tail);
+			}
+
+			std::vector<u8> buffer;
+			ASSERT_TRUE(ReadBack(size, buffer)) << size << " " << zero_length_tail;
+			EXPECT_TRUE(buffer == data) << size << " " << zero_length_tail;
+		}
+	}
+}
+
+TEST_F(StateCompressionTest, LegacyRejectsExtraData)
+{
+	const std::vector<u8> data = MakeState(2 * LEGACY_IN_LEN + 5);
+	{
+		File::IOFile f(STATE_PATH, "wb");
+		WriteLegacyState(f, data, false);
+	}
+
+	// A buffer smaller than what the state holds can't take the last chunk.
+	std::vector<u8> buffer;
+	EXPECT_FALSE(ReadBack(2 * LEGACY_IN_LEN, buffer));
+}
@@ -0,0 +1,263 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/CompressedBlob.h"
+#include "DiscIO/FileBlob.h"
+
+// The compressed reader brings in the volume code, and CVolumeGC::Read tells FileMon
+// about every read, which would pull in the whole core.
+namespace FileMon
+{
+void FindFilename(u64 offset) {}
+}
+
+using namespace DiscIO;
+
+static const char IMAGE_PATH[] = "BlobReaderTest.iso";
+static const char COMPRESSED_IMAGE_PATH[] = "BlobReaderTest.gcz";
+static const u64 IMAGE_SIZE = 32 * 1024 * 1024;
+
+class BlobReaderTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		s_data.resize(IMAGE_SIZE);
+		std::mt19937 rng(1234);
+		for (u64 i = 0; i < IMAGE_SIZE; i += 4)
+		{
+			u32 value = rng();
+			memcpy(&s_data[i], &value, 4);
+		}
+
+		File::IOFile f(IMAGE_PATH, "wb");
+		ASSERT_TRUE(f.WriteBytes(&s_data[0], s_data.size()));
+		f.Close();
+
+		ASSERT_TRUE(CompressFileToBlob(IMAGE_PATH, COMPRESSED_IMAGE_PATH, 0, 16384,
+		                               [](const char*, float, void*) {}));
+	}
+
+	static void TearDownTestCase()
+	{
+		File::Delete(IMAGE_PATH);
+		File::Delete(COMPRESSED_IMAGE_PATH);
+		std::vector<u8>().swap(s_data);
+	}
+
+	struct NamedReader
+	{
+		const char* name;
+		std::unique_ptr<IBlobReader> reader;
+	};
+
+	std::vector<NamedReader> CreateReaders()
+	{
+		std::vector<NamedReader> readers(3);
+		readers[0].name = "plain";
+		readers[0].reader.reset(PlainFileReader::Create(IMAGE_PATH));
+		readers[1].name = "mapped";
+		readers[1].reader.reset(MappedFileReader::Create(IMAGE_PATH));
+		readers[2].name = "compressed";
+		readers[2].reader.reset(CompressedBlobReader::Create(COMPRESSED_IMAGE_PATH));
+		for (const NamedReader& r : readers)
+			EXPECT_TRUE(r.reader != nullptr) << r.name;
+		return readers;
+	}
+
+	static std::vector<u8> s_data;
+};
+
+std::vector<u8> BlobReaderTest::s_data;
+
+TEST_F(BlobReaderTest, SameData)
+{
+	std::mt19937 rng(5678);
+	std::vector<u8> buffer(0x10000);
+
+	for (NamedReader& r : CreateReaders())
+	{
+		ASSERT_TRUE(r.reader != nullptr);
+		EXPECT_EQ(IMAGE_SIZE, r.reader->GetDataSize()) << r.name;
+
+		u64 next_offset = 0;
+		for (int i = 0; i < 1000; ++i)
+		{
+			u64 size = rng() % buffer.size() + 1;
+			// Most reads continue the previous one, to exercise read-ahead.
+			u64 offset = rng() % (IMAGE_SIZE - size + 1);
+			if (i % 4 != 0 && next_offset + size <= IMAGE_SIZE)
+				offset = next_offset;
+			next_offset = offset + size;
+			ASSERT_TRUE(r.reader->Read(offset, size, &buffer[0])) << r.name;
+			ASSERT_EQ(0, memcmp(&buffer[0], &s_data[offset], (size_t)size)) << r.name << " at " << offset;
+		}
+
+		// Up to the very end, in sequence.
+		for (u64 offset = IMAGE_SIZE - 0x100000; offset < IMAGE_SIZE; offset += 0x8000)
+		{
+			ASSERT_TRUE(r.reader->Read(offset, 0x8000, &buffer[0])) << r.name;
+			ASSERT_EQ(0, memcmp(&buffer[0], &s_data[offset], 0x8000)) << r.name << " at " << offset;
+		}
+	}
+}
+
+TEST_F(BlobReaderTest, MappedReadPastEnd)
+{
+	std::unique_ptr<IBlobReader> reader(MappedFileReader::Create(IMAGE_PATH));
+	ASSERT_TRUE(reader != nullptr);
+
+	u8 buffer[0x20];
+	EXPECT_TRUE(reader->Read(IMAGE_SIZE - sizeof(buffer), sizeof(buffer), buffer));
+	EXPECT_FALSE(reader->Read(IMAGE_SIZE - sizeof(buffer) + 1, sizeof(buffer), buffer));
+	EXPECT_FALSE(reader->Read(IMAGE_SIZE + 0x1000, 1, buffer));
+}
+
+// Latency of streaming 32 KiB reads (one Wii sector) and scattered 2 KiB reads
+// (one GC sector) through each reader. The image was just written, so it's
+// usually still in the page cache and this times the read path, not the disk.
+TEST_F(BlobReaderTest, DISABLED_ReadLatency)
+{
+	std::vector<u8> buffer(0x8000);
+
+	for (NamedReader& r : CreateReaders())
+	{
+		ASSERT_TRUE(r.reader != nullptr);
+
+		const int passes = 4;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int pass = 0; pass < passes; ++pass)
+			for (u64 offset = 0; offset < IMAGE_SIZE; offset += buffer.size())
+				r.reader->Read(offset, buffer.size(), &buffer[0]);
+		std::chrono::duration<double> sequential = std::chrono::high_resolution_clock::now() - start;
+		const double sequential_reads = (double)passes * IMAGE_SIZE / buffer.size();
+
+		std::mt19937 rng(42);
+		const int random_reads = 100000;
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < random_reads; ++i)
+			r.reader->Read((rng() % (IMAGE_SIZE / 0x800)) * 0x800, 0x800, &buffer[0]);
+		std::chrono::duration<double> random = std::chrono::high_resolution_clock::now() - start;
+
+		printf("%-10s sequential 32 KiB: %7.2f us/read   random 2 KiB: %7.2f us/read\n", r.name,
+		       sequential.count() / sequential_reads * 1e6, random.count() / random_reads * 1e6);
+	}
+}
+
+static const char BENCH_PLAIN_PATH[] = "CompressedBlobBenchmark.iso";
+static const char BENCH_COMPRESSED_PATH[] = "CompressedBlobBenchmark.gcz";
+static const char BENCH_OUT_PATH[] = "CompressedBlobBenchmark.out";
+static const u64 BENCH_SIZE = 128 * 1024 * 1024;
+static const u32 BENCH_BLOCK_SIZE = 16384;
+
+// Throughput of the GCZ conversions in both directions, each measured against doing the
+// same zlib work block by block on one thread. These only print numbers, so they're
+// disabled; pass --gtest_also_run_disabled_tests to get them.
+class CompressedBlobBenchmark : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		// Runs of repeated words with some noise, so that zlib has real work to do,
+		// plus a stretch of zeroes like the padding on most discs.
+		s_data.resize(BENCH_SIZE);
+		std::mt19937 rng(99);
+		for (u64 i = 0; i < BENCH_SIZE * 3 / 4; i += 4)
+		{
+			u32 value = (rng() % 8 == 0) ? rng() : (u32)(i / 256);
+			memcpy(&s_data[i], &value, 4);
+		}
+
+		File::IOFile f(BENCH_PLAIN_PATH, "wb");
+		ASSERT_TRUE(f.WriteBytes(&s_data[0], s_data.size()));
+	}
+
+	static void TearDownTestCase()
+	{
+		File::Delete(BENCH_PLAIN_PATH);
+		File::Delete(BENCH_COMPRESSED_PATH);
+		File::Delete(BENCH_OUT_PATH);
+		std::vector<u8>().swap(s_data);
+	}
+
+	static double MBPerSecond(std::chrono::duration<double> elapsed)
+	{
+		return BENCH_SIZE / elapsed.count() / 1e6;
+	}
+
+	static std::vector<u8> s_data;
+};
+
+std::vector<u8> CompressedBlobBenchmark::s_data;
+
+static void NoProgress(const char*, float, void*) {}
+
+TEST_F(CompressedBlobBenchmark, DISABLED_Compress)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	ASSERT_TRUE(CompressFileToBlob(BENCH_PLAIN_PATH, BENCH_COMPRESSED_PATH, 0, BENCH_BLOCK_SIZE, NoProgress));
+	std::chrono::duration<double> pipelined = std::chrono::high_resolution_clock::now() - start;
+
+	// What CompressFileToBlob used to do per block: deflate at level 9, with no file I/O.
+	std::vector<u8> out(compressBound(BENCH_BLOCK_SIZE));
+	start = std::chrono::high_resolution_clock::now();
+	for (u64 offset = 0; offset < BENCH_SIZE; offset += BENCH_BLOCK_SIZE)
+	{
+		uLongf out_size = (uLongf)out.size();
+		ASSERT_EQ(Z_OK, compress2(&out[0], &out_size, &s_data[offset], BENCH_BLOCK_SIZE, 9));
+	}
+	std::chrono::duration<double> serial = std::chrono::high_resolution_clock::now() - start;
+
+	std::unique_ptr<IBlobReader> reader(CreateBlobReader(BENCH_COMPRESSED_PATH));
+	ASSERT_TRUE(reader != nullptr);
+	ASSERT_EQ(BENCH_SIZE, reader->GetDataSize());
+	std::vector<u8> readback(BENCH_SIZE);
+	ASSERT_TRUE(reader->Read(0, BENCH_SIZE, &readback[0]));
+	EXPECT_TRUE(readback == s_data);
+
+	printf("CompressFileToBlob:   %7.1f MB/s   deflate on one thread: %7.1f MB/s\n",
+	       MBPerSecond(pipelined), MBPerSecond(serial));
+}
+
+TEST_F(CompressedBlobBenchmark, DISABLED_Decompress)
+{
+	ASSERT_TRUE(CompressFileToBlob(BENCH_PLAIN_PATH, BENCH_COMPRESSED_PATH, 0, BENCH_BLOCK_SIZE, NoProgress));
+
+	auto start = std::chrono::high_resolution_clock::now();
+	ASSERT_TRUE(DecompressBlobToFile(BENCH_COMPRESSED_PATH, BENCH_OUT_PATH, NoProgress));
+	std::chrono::duration<double> pipelined = std::chrono::high_resolution_clock::now() - start;
+
+	std::unique_ptr<CompressedBlobReader> reader(CompressedBlobReader::Create(BENCH_COMPRESSED_PATH, false));
+	ASSERT_TRUE(reader != nullptr);
+	const CompressedBlobHeader &header = reader->GetHeader();
+	std::vector<u8> block(header.block_size);
+	start = std::chrono::high_resolution_clock::now();
+	for (u32 i = 0; i < header.num_blocks; i++)
+		reader->GetBlock(i, &block[0]);
+	std::chrono::duration<double> serial = std::chrono::high_resolution_clock::now() - start;
+
+	std::vector<u8> out(BENCH_SIZE);
+	{
+		File::IOFile f(BENCH_OUT_PATH, "rb");
+		ASSERT_TRUE(f.ReadBytes(&out[0], out.size()));
+	}
+	EXPECT_TRUE(out == s_data);
+
+	printf("DecompressBlobToFile: %7.1f MB/s   one thread, no writes: %7.1f MB/s\n",
+	       MBPerSecond(pipelined), MBPerSecond(serial));
+}
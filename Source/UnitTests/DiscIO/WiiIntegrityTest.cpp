@@ -0,0 +1,179 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <polarssl/aes.h>
+#include <polarssl/sha1.h>
+
+#include "Common/Common.h"
+#include "Common/CPUDetect.h"
+#include "DiscIO/Blob.h"
+#include "DiscIO/SHA1.h"
+#include "DiscIO/VolumeWiiCrypted.h"
+
+using namespace DiscIO;
+
+// CVolumeGC::Read tells FileMon about every read, which would pull in the whole core.
+namespace FileMon
+{
+void FindFilename(u64 offset) {}
+}
+
+namespace
+{
+
+class MemoryReader : public IBlobReader
+{
+public:
+	MemoryReader(const std::vector<u8>& data) : m_data(data) {}
+
+	u64 GetRawSize() const override { return m_data.size(); }
+	u64 GetDataSize() const override { return m_data.size(); }
+	bool Read(u64 offset, u64 size, u8* out_ptr) override
+	{
+		if (offset + size > m_data.size())
+			return false;
+		memcpy(out_ptr, &m_data[offset], (size_t)size);
+		return true;
+	}
+
+private:
+	const std::vector<u8>& m_data;
+};
+
+const u8 VOLUME_KEY[16] = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE };
+const u64 DATA_OFFSET = 0x20000;
+const u32 NUM_CLUSTERS = 256;
+
+// Every 16th cluster is left as garbage, like the holes between files on real discs.
+bool IsUnusedCluster(u32 cluster)
+{
+	return cluster % 16 == 15;
+}
+
+}
+
+class WiiIntegrityTest : public testing::Test
+{
+protected:
+	// A partition with just enough of a header for CheckIntegrity, followed by
+	// NUM_CLUSTERS clusters with valid H0 hashes.
+	static void SetUpTestCase()
+	{
+		s_image.assign(DATA_OFFSET + (u64)NUM_CLUSTERS * 0x8000, 0);
+		const u32 size_div4 = Common::swap32((u32)((u64)NUM_CLUSTERS * 0x8000 / 4));
+		memcpy(&s_image[0x2BC], &size_div4, 4);
+
+		aes_context aes;
+		aes_setkey_enc(&aes, VOLUME_KEY, 128);
+
+		std::mt19937 rng(1234);
+		u8 md[0x400];
+		u8 data[0x7C00];
+		for (u32 cluster = 0; cluster < NUM_CLUSTERS; cluster++)
+		{
+			for (u8& b : data)
+				b = (u8)rng();
+			memset(md, 0, sizeof(md));
+			for (u32 i = 0; i < 31; i++)
+				sha1(data + i * 0x400, 0x400, md + i * 20);
+			if (IsUnusedCluster(cluster))
+				md[0x270] = 0xFF;
+
+			u8* raw = &s_image[DATA_OFFSET + (u64)cluster * 0x8000];
+			u8 iv[16] = {};
+			aes_crypt_cbc(&aes, AES_ENCRYPT, sizeof(md), iv, md, raw);
+			memcpy(iv, raw + 0x3D0, 16);
+			aes_crypt_cbc(&aes, AES_ENCRYPT, sizeof(data), iv, data, raw + 0x400);
+		}
+	}
+
+	static void TearDownTestCase()
+	{
+		std::vector<u8>().swap(s_image);
+	}
+
+	static std::unique_ptr<CVolumeWiiCrypted> CreateVolume(const std::vector<u8>& image)
+	{
+		return std::unique_ptr<CVolumeWiiCrypted>(new CVolumeWiiCrypted(new MemoryReader(image), 0, VOLUME_KEY));
+	}
+
+	static std::vector<u8> s_image;
+};
+
+std::vector<u8> WiiIntegrityTest::s_image;
+
+TEST_F(WiiIntegrityTest, SHA1MatchesPolarSSL)
+{
+	std::vector<u8> data(0x1000);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = (u8)(i * 7 + 3);
+
+	for (size_t size : { 0, 1, 55, 56, 63, 64, 65, 0x400, 0x1000 })
+	{
+		u8 expected[20];
+		u8 actual[20];
+		sha1(data.data(), size, expected);
+		ComputeSHA1(data.data(), size, actual);
+		EXPECT_EQ(0, memcmp(expected, actual, 20)) << size;
+	}
+}
+
+TEST_F(WiiIntegrityTest, CleanPartition)
+{
+	for (int threads : { 1, 4 })
+	{
+		SIntegrityReport report;
+		EXPECT_TRUE(CreateVolume(s_image)->CheckIntegrity(&report, threads));
+		EXPECT_EQ(-1, report.bad_cluster);
+		EXPECT_EQ(NUM_CLUSTERS / 16, report.clusters_skipped);
+		EXPECT_EQ(NUM_CLUSTERS - NUM_CLUSTERS / 16, report.clusters_checked);
+	}
+}
+
+TEST_F(WiiIntegrityTest, CorruptCluster)
+{
+	std::vector<u8> image = s_image;
+	// The last 1 KiB block of cluster 100, so hash 30 fails.
+	image[DATA_OFFSET + 100 * 0x8000 + 0x7C00] ^= 1;
+	// Cluster 200 is broken as well, but the check stops at the first bad one.
+	image[DATA_OFFSET + 200 * 0x8000 + 0x400] ^= 1;
+
+	for (int threads : { 1, 4 })
+	{
+		SIntegrityReport report;
+		EXPECT_FALSE(CreateVolume(image)->CheckIntegrity(&report, threads));
+		EXPECT_EQ(100, report.bad_cluster);
+		EXPECT_FALSE(report.error.empty());
+	}
+}
+
+// Checks the partition the old way, on one thread with PolarSSL's SHA-1, then
+// on every thread with the SHA extensions if the CPU has them.
+TEST_F(WiiIntegrityTest, DISABLED_CheckThroughput)
+{
+	const bool has_sha = cpu_info.bSHA;
+	auto measure = [](int threads)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		EXPECT_TRUE(CreateVolume(s_image)->CheckIntegrity(nullptr, threads));
+		std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start;
+		return (double)NUM_CLUSTERS * 0x8000 / time.count() / (1024 * 1024);
+	};
+
+	cpu_info.bSHA = false;
+	const double serial = measure(1);
+	cpu_info.bSHA = has_sha;
+	const double parallel = measure(0);
+
+	printf("serial, no SHA extensions: %7.1f MiB/s\n", serial);
+	printf("all threads%s: %7.1f MiB/s\n", has_sha ? ", SHA extensions" : "", parallel);
+}
@@ -0,0 +1,383 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+
+#include "VideoCommon/CPMemory.h"
+#include "VideoCommon/DataReader.h"
+#include "VideoCommon/IndexGenerator.h"
+#include "VideoCommon/NativeVertexFormat.h"
+#include "VideoCommon/OpcodeDecoding.h"
+#include "VideoCommon/Statistics.h"
+#include "VideoCommon/VertexLoader.h"
+#include "VideoCommon/VertexManagerBase.h"
+#include "VideoCommon/VideoConfig.h"
+
+// After the emitter, which has a TEST instruction of its own.
+#include <gtest/gtest.h>
+
+// Compares the vertex loader JIT against the C loaders it is built from. On
+// CPUs without SSSE3 both sides end up calling the C loaders.
+//
+// The loaders are compiled straight into this test rather than linking all of
+// VideoCommon, which would drag in the rest of the emulator. What they use from
+// elsewhere is defined here.
+
+extern NativeVertexFormat *g_nativeVertexFmt;
+
+u8* g_pVideoData;
+
+namespace PixelEngine
+{
+u16 bbox[4];
+bool bbox_active;
+}
+
+Statistics stats;
+
+VideoConfig::VideoConfig() {}
+VideoConfig g_Config;
+VideoConfig g_ActiveConfig;
+
+void Host_SysMessage(const char *fmt, ...) {}
+
+static std::vector<u8> s_vertex_buffer;
+static std::vector<u16> s_index_buffer;
+
+VertexManager *g_vertex_manager;
+u8 *VertexManager::s_pCurBufferPointer;
+u8 *VertexManager::s_pBaseBufferPointer;
+u8 *VertexManager::s_pEndBufferPointer;
+
+VertexManager::VertexManager() {}
+VertexManager::~VertexManager() {}
+void VertexManager::Flush() {}
+
+// Every batch starts at the beginning of the buffers.
+void VertexManager::PrepareForAdditionalData(int primitive, u32 count, u32 stride)
+{
+	s_pBaseBufferPointer = s_pCurBufferPointer = &s_vertex_buffer[0];
+	s_pEndBufferPointer = s_pBaseBufferPointer + s_vertex_buffer.size();
+	IndexGenerator::Start(&s_index_buffer[0]);
+}
+
+namespace
+{
+
+class TestVertexFormat : public NativeVertexFormat
+{
+public:
+	void Initialize(const PortableVertexDeclaration &vtx_decl) override { vertex_stride = vtx_decl.stride; }
+	void SetupVertexPointers() override {}
+};
+
+class TestVertexManager : public VertexManager
+{
+public:
+	NativeVertexFormat* CreateNativeVertexFormat() override { return new TestVertexFormat; }
+
+protected:
+	void ResetBuffer(u32 stride) override {}
+
+private:
+	void vFlush(bool useDstAlpha) override {}
+};
+
+class VertexLoaderTest : public testing::Test
+{
+protected:
+	static const int NUM_VERTICES = 64;
+
+	void SetUp() override
+	{
+		m_rng.seed(1234);
+
+		s_vertex_buffer.assign(VertexManager::MAXVBUFFERSIZE, 0);
+		s_index_buffer.assign(VertexManager::MAXIBUFFERSIZE, 0);
+		IndexGenerator::Init();
+		m_manager.reset(new TestVertexManager);
+		g_vertex_manager = m_manager.get();
+
+		// Large enough for any 16-bit index with strides up to 16 bytes,
+		// including the byte before the array that 6666 colors read.
+		m_arrays.resize((1 << 20) + 64);
+		for (u8& b : m_arrays)
+			b = (u8)m_rng();
+		for (int i = 0; i < 16; ++i)
+		{
+			cached_arraybases[i] = &m_arrays[16];
+			arraystrides[i] = m_rng() % 17;
+		}
+
+		m_has_ssse3 = cpu_info.bSSSE3;
+	}
+
+	void TearDown() override
+	{
+		cpu_info.bSSSE3 = m_has_ssse3;
+		g_vertex_manager = nullptr;
+		g_nativeVertexFmt = nullptr;
+	}
+
+	// Runs count vertices of src through the loader, returns the native vertices.
+	std::vector<u8> Run(VertexLoader* loader, const VAT& vat, u8* src, int count)
+	{
+		g_VtxAttr[0] = vat;
+		g_nativeVertexFmt = nullptr;
+
+		g_pVideoData = src;
+		loader->RunVertices(0, GX_DRAW_POINTS, count);
+		EXPECT_EQ(src + count * loader->GetVertexSize(), g_pVideoData);
+
+		return std::vector<u8>(&s_vertex_buffer[0], VertexManager::s_pCurBufferPointer);
+	}
+
+	void Compare(TVtxDesc desc, VAT vat)
+	{
+		// Position is mandatory, the loaders don't handle it missing.
+		if (desc.Position == NOT_PRESENT)
+			desc.Position = DIRECT;
+
+		// Keep the fractional bits out of the loader construction, the same as
+		// VertexLoaderManager does, so the scales have to be picked up at run time.
+		VAT uid_vat = vat;
+		uid_vat.g0.Hex &= ~VAT_0_FRACBITS;
+		uid_vat.g1.Hex &= ~VAT_1_FRACBITS;
+		uid_vat.g2.Hex &= ~VAT_2_FRACBITS;
+
+		cpu_info.bSSSE3 = false;
+		std::unique_ptr<VertexLoader> reference(new VertexLoader(desc, uid_vat));
+		cpu_info.bSSSE3 = m_has_ssse3;
+		std::unique_ptr<VertexLoader> jit(new VertexLoader(desc, uid_vat));
+
+		// One spare byte in front for the 6666 colors, which read a word that
+		// starts one byte before the attribute.
+		std::vector<u8> src(1 + NUM_VERTICES * reference->GetVertexSize() + 16);
+		for (u8& b : src)
+			b = (u8)m_rng();
+
+		std::vector<u8> expected = Run(reference.get(), vat, &src[1], NUM_VERTICES);
+		std::vector<u8> actual = Run(jit.get(), vat, &src[1], NUM_VERTICES);
+
+		ASSERT_EQ(expected.size(), actual.size());
+		for (size_t i = 0; i < expected.size(); ++i)
+		{
+			if (expected[i] != actual[i])
+			{
+				ADD_FAILURE() << "Mismatch at byte " << i << " of " << expected.size()
+				              << " (desc " << std::hex << desc.Hex
+				              << ", vat " << vat.g0.Hex << " " << vat.g1.Hex << " " << vat.g2.Hex << ")";
+				return;
+			}
+		}
+	}
+
+	std::mt19937 m_rng;
+	std::vector<u8> m_arrays;
+	std::unique_ptr<TestVertexManager> m_manager;
+	bool m_has_ssse3;
+};
+
+}
+
+TEST_F(VertexLoaderTest, Position)
+{
+	for (u32 mode = DIRECT; mode <= INDEX16; ++mode)
+	{
+		for (u32 format = FORMAT_UBYTE; format <= FORMAT_FLOAT; ++format)
+		{
+			for (u32 elements = 0; elements < 2; ++elements)
+			{
+				TVtxDesc desc;
+				desc.Hex = 0;
+				desc.Position = mode;
+				VAT vat;
+				vat.g0.Hex = vat.g1.Hex = vat.g2.Hex = 0;
+				vat.g0.PosFormat = format;
+				vat.g0.PosElements = elements;
+				vat.g0.PosFrac = m_rng() % 32;
+				Compare(desc, vat);
+			}
+		}
+	}
+}
+
+TEST_F(VertexLoaderTest, Normal)
+{
+	for (u32 mode = DIRECT; mode <= INDEX16; ++mode)
+	{
+		for (u32 format = FORMAT_UBYTE; format <= FORMAT_FLOAT; ++format)
+		{
+			for (u32 variant = 0; variant < 4; ++variant)
+			{
+				TVtxDesc desc;
+				desc.Hex = 0;
+				desc.Position = DIRECT;
+				desc.Normal = mode;
+				VAT vat;
+				vat.g0.Hex = vat.g1.Hex = vat.g2.Hex = 0;
+				vat.g0.NormalFormat = format;
+				vat.g0.NormalElements = variant & 1;
+				vat.g0.NormalIndex3 = variant >> 1;
+				Compare(desc, vat);
+			}
+		}
+	}
+}
+
+TEST_F(VertexLoaderTest, Color)
+{
+	for (u32 mode = DIRECT; mode <= INDEX16; ++mode)
+	{
+		for (u32 comp = FORMAT_16B_565; comp <= FORMAT_32B_8888; ++comp)
+		{
+			for (u32 variant = 0; variant < 8; ++variant)
+			{
+				TVtxDesc desc;
+				desc.Hex = 0;
+				desc.Position = DIRECT;
+				VAT vat;
+				vat.g0.Hex = vat.g1.Hex = vat.g2.Hex = 0;
+				// Either color alone, or both with the other one in a random format.
+				if (variant & 1)
+				{
+					desc.Color0 = mode;
+					vat.g0.Color0Comp = comp;
+				}
+				else
+				{
+					desc.Color0 = (variant & 2) ? mode : NOT_PRESENT;
+					vat.g0.Color0Comp = m_rng() % 6;
+				}
+				desc.Color1 = (variant & 1) ? ((variant & 2) ? mode : NOT_PRESENT) : mode;
+				vat.g0.Color1Comp = (variant & 1) ? m_rng() % 6 : comp;
+				vat.g0.Color0Elements = (variant >> 2) & 1;
+				vat.g0.Color1Elements = m_rng() % 2;
+				Compare(desc, vat);
+			}
+		}
+	}
+}
+
+TEST_F(VertexLoaderTest, TexCoord)
+{
+	for (u32 i = 0; i < 8; ++i)
+	{
+		for (u32 mode = DIRECT; mode <= INDEX16; ++mode)
+		{
+			for (u32 format = FORMAT_UBYTE; format <= FORMAT_FLOAT; ++format)
+			{
+				for (u32 variant = 0; variant < 4; ++variant)
+				{
+					TVtxDesc desc;
+					desc.Hex = 0;
+					desc.Position = DIRECT;
+					desc.Hex |= (u64)mode << (17 + 2 * i);
+					// texture matrix index for this and the next coordinate
+					if (variant & 2)
+						desc.Hex |= (i < 7 ? 3ull : 1ull) << (1 + i);
+					VAT vat;
+					vat.g0.Hex = m_rng();
+					vat.g1.Hex = m_rng();
+					vat.g2.Hex = m_rng();
+					vat.g0.PosFormat %= 5;
+					const u32 elements = variant & 1;
+					switch (i)
+					{
+					case 0: vat.g0.Tex0CoordFormat = format; vat.g0.Tex0CoordElements = elements; break;
+					case 1: vat.g1.Tex1CoordFormat = format; vat.g1.Tex1CoordElements = elements; break;
+					case 2: vat.g1.Tex2CoordFormat = format; vat.g1.Tex2CoordElements = elements; break;
+					case 3: vat.g1.Tex3CoordFormat = format; vat.g1.Tex3CoordElements = elements; break;
+					case 4: vat.g1.Tex4CoordFormat = format; vat.g1.Tex4CoordElements = elements; break;
+					case 5: vat.g2.Tex5CoordFormat = format; vat.g2.Tex5CoordElements = elements; break;
+					case 6: vat.g2.Tex6CoordFormat = format; vat.g2.Tex6CoordElements = elements; break;
+					case 7: vat.g2.Tex7CoordFormat = format; vat.g2.Tex7CoordElements = elements; break;
+					}
+					Compare(desc, vat);
+				}
+			}
+		}
+	}
+}
+
+TEST_F(VertexLoaderTest, RandomFormats)
+{
+	for (int n = 0; n < 2000; ++n)
+	{
+		TVtxDesc desc;
+		desc.Hex = ((u64)m_rng() << 32 | m_rng()) & ((1ull << 33) - 1);
+
+		VAT vat;
+		vat.g0.Hex = m_rng();
+		vat.g1.Hex = m_rng();
+		vat.g2.Hex = m_rng();
+		vat.g0.PosFormat %= 5;
+		vat.g0.NormalFormat %= 5;
+		vat.g0.Color0Comp %= 6;
+		vat.g0.Color1Comp %= 6;
+		vat.g0.Tex0CoordFormat %= 5;
+		vat.g1.Tex1CoordFormat %= 5;
+		vat.g1.Tex2CoordFormat %= 5;
+		vat.g1.Tex3CoordFormat %= 5;
+		vat.g1.Tex4CoordFormat %= 5;
+		vat.g2.Tex5CoordFormat %= 5;
+		vat.g2.Tex6CoordFormat %= 5;
+		vat.g2.Tex7CoordFormat %= 5;
+
+		Compare(desc, vat);
+		if (HasFailure())
+			return;
+	}
+}
+
+// Millions of vertices per second for a skinned, textured vertex (indexed
+// position, normal and texcoord, direct color), C loaders against the inline JIT.
+TEST_F(VertexLoaderTest, DISABLED_SkinnedVertexThroughput)
+{
+	TVtxDesc desc;
+	desc.Hex = 0;
+	desc.PosMatIdx = 1;
+	desc.Position = INDEX16;
+	desc.Normal = INDEX16;
+	desc.Color0 = DIRECT;
+	desc.Tex0Coord = INDEX16;
+	VAT vat;
+	vat.g0.Hex = vat.g1.Hex = vat.g2.Hex = 0;
+	vat.g0.PosElements = 1;
+	vat.g0.PosFormat = FORMAT_SHORT;
+	vat.g0.PosFrac = 8;
+	vat.g0.NormalFormat = FORMAT_BYTE;
+	vat.g0.Color0Comp = FORMAT_32B_8888;
+	vat.g0.Tex0CoordElements = 1;
+	vat.g0.Tex0CoordFormat = FORMAT_SHORT;
+	vat.g0.Tex0Frac = 10;
+
+	const int count = 50000;
+	const int iterations = 40;
+
+	for (int ssse3 = 0; ssse3 < 2; ++ssse3)
+	{
+		cpu_info.bSSSE3 = ssse3 && m_has_ssse3;
+		VertexLoader loader(desc, vat);
+		std::vector<u8> src(1 + count * loader.GetVertexSize() + 16);
+		for (u8& b : src)
+			b = (u8)m_rng();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < iterations; ++i)
+			Run(&loader, vat, &src[1], count);
+		std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+		printf("%s: %.1f million vertices/s\n", cpu_info.bSSSE3 ? "inline JIT" : "C loaders",
+		       (double)count * iterations / elapsed.count() / 1e6);
+	}
+}